@@ -4,10 +4,12 @@
 
 #include <bench/bench.h>
 #include <coins.h>
+#include <crypto/common.h>
 #include <policy/policy.h>
 #include <script/signingprovider.h>
 #include <test/util/transaction_utils.h>
 
+#include <deque>
 #include <vector>
 
 // Microbenchmark for simple accesses to a CCoinsViewCache database. Note from
@@ -52,3 +54,54 @@ static void CCoinsCaching(benchmark::Bench& bench)
 }
 
 BENCHMARK(CCoinsCaching);
+
+// Churn on a layered coins cache, shaped roughly like block connection on
+// mainnet: a large UTXO set with the common scriptPubKey sizes, each "block"
+// spending its oldest coins and creating as many new ones in a child cache
+// that is then flushed into the parent, which periodically flushes into the
+// backing view. Mostly measures allocation and release of cache entries.
+static void CCoinsCacheChurn(benchmark::Bench& bench)
+{
+    static constexpr int UTXO_COUNT = 200000;
+    static constexpr int COINS_PER_BLOCK = 2000;
+    static constexpr int BLOCKS_PER_FLUSH = 50;
+    // P2PKH, P2WPKH, P2SH, P2WSH
+    static const size_t SCRIPT_SIZES[] = {25, 25, 25, 22, 22, 23, 34};
+
+    CCoinsView coins_dummy;
+    CCoinsViewCache coins_db(&coins_dummy);
+    CCoinsViewCache coins_tip(&coins_db);
+
+    std::deque<COutPoint> utxos;
+    uint32_t counter = 0;
+    const auto add_coins = [&](CCoinsViewCache& view, int count) {
+        for (int i = 0; i < count; ++i, ++counter) {
+            uint256 txid;
+            WriteLE32(txid.begin(), counter);
+            const COutPoint outpoint(txid, counter % 3);
+            CTxOut out(counter, CScript());
+            out.scriptPubKey.resize(SCRIPT_SIZES[counter % (sizeof(SCRIPT_SIZES) / sizeof(SCRIPT_SIZES[0]))]);
+            view.AddCoin(outpoint, Coin(std::move(out), 1, false, false), false);
+            utxos.push_back(outpoint);
+        }
+    };
+    add_coins(coins_tip, UTXO_COUNT);
+    coins_tip.Flush();
+
+    int blocks = 0;
+    bench.run([&] {
+        CCoinsViewCache block_view(&coins_tip);
+        for (int i = 0; i < COINS_PER_BLOCK; ++i) {
+            bool spent = block_view.SpendCoin(utxos.front());
+            assert(spent);
+            utxos.pop_front();
+        }
+        add_coins(block_view, COINS_PER_BLOCK);
+        block_view.Flush();
+        if (++blocks % BLOCKS_PER_FLUSH == 0) {
+            coins_tip.Flush();
+        }
+    });
+}
+
+BENCHMARK(CCoinsCacheChurn);
@@ -4,6 +4,7 @@
 
 #include <bench/bench.h>
 #include <checkqueue.h>
+#include <crypto/sha256.h>
 #include <key.h>
 #include <prevector.h>
 #include <pubkey.h>
@@ -18,6 +19,8 @@ static const size_t BATCHES = 101;
 static const size_t BATCH_SIZE = 30;
 static const int PREVECTOR_SIZE = 28;
 static const unsigned int QUEUE_BATCH_SIZE = 128;
+static const size_t SCALING_BATCHES = 1000;
+static const size_t SCALING_BATCH_SIZE = 3;
 
 // This Benchmark tests the CheckQueue with a slightly realistic workload,
 // where checks all contain a prevector that is indirect 50% of the time
@@ -75,3 +78,56 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::Bench& bench)
     ECC_Stop();
 }
 BENCHMARK(CCheckQueueSpeedPrevectorJob);
+
+/** A check doing a little hashing, roughly the cost of a cheap script check */
+struct HashJob {
+    unsigned char data[64] = {};
+    bool operator()()
+    {
+        unsigned char out[CSHA256::OUTPUT_SIZE];
+        for (int i = 0; i < 8; ++i) {
+            CSHA256().Write(data, sizeof(data)).Finalize(out);
+            data[0] ^= out[0];
+        }
+        return true;
+    }
+    void swap(HashJob& x) { std::swap(data, x.data); }
+};
+
+// Blocks add their checks a few at a time (per transaction), which is where
+// the shared lock of CCheckQueue contends as the number of threads grows.
+template <typename Queue>
+static void CheckQueueScaling(benchmark::Bench& bench, int threads)
+{
+    Queue queue{QUEUE_BATCH_SIZE};
+    boost::thread_group tg;
+    // The master is one of the threads
+    for (int x = 0; x < threads - 1; ++x) {
+       tg.create_thread([&]{queue.Thread();});
+    }
+
+    bench.batch(SCALING_BATCHES * SCALING_BATCH_SIZE).unit("job").run([&] {
+        CCheckQueueControl<HashJob, Queue> control(&queue);
+        for (size_t i = 0; i < SCALING_BATCHES; ++i) {
+            std::vector<HashJob> vChecks(SCALING_BATCH_SIZE);
+            control.Add(vChecks);
+        }
+        control.Wait();
+    });
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+#define CHECKQUEUE_SCALING_BENCH(n) \
+    static void CCheckQueueScaling_##n(benchmark::Bench& bench) { CheckQueueScaling<CCheckQueue<HashJob>>(bench, n); } \
+    static void WorkStealingQueueScaling_##n(benchmark::Bench& bench) { CheckQueueScaling<CWorkStealingCheckQueue<HashJob>>(bench, n); } \
+    BENCHMARK(CCheckQueueScaling_##n); \
+    BENCHMARK(WorkStealingQueueScaling_##n);
+
+CHECKQUEUE_SCALING_BENCH(1)
+CHECKQUEUE_SCALING_BENCH(2)
+CHECKQUEUE_SCALING_BENCH(4)
+CHECKQUEUE_SCALING_BENCH(8)
+CHECKQUEUE_SCALING_BENCH(16)
+CHECKQUEUE_SCALING_BENCH(32)
+CHECKQUEUE_SCALING_BENCH(64)
@@ -10,6 +10,7 @@
 #include <crypto/sha3.h>
 #include <crypto/sha512.h>
 #include <crypto/siphash.h>
+#include <crypto/x11_aes.h>
 #include <hash.h>
 #include <random.h>
 #include <uint256.h>
@@ -71,6 +72,36 @@ static void SHA256D64_1024(benchmark::Bench& bench)
     });
 }
 
+static void X11AES_64b(benchmark::Bench& bench)
+{
+    uint512 x;
+    bench.batch(3).unit("hash").run([&] {
+        Groestl512_64(x.begin(), x.begin());
+        Shavite512_64(x.begin(), x.begin());
+        Echo512_64(x.begin(), x.begin());
+    });
+}
+
+static void X22I_80b(benchmark::Bench& bench)
+{
+    std::vector<uint8_t> in(80, 0);
+    uint256 hash;
+    bench.run([&] {
+        hash = HashX22I(in.begin(), in.end());
+        in[0] ^= hash.begin()[0];
+    });
+}
+
+static void X25X_80b(benchmark::Bench& bench)
+{
+    std::vector<uint8_t> in(80, 0);
+    uint256 hash;
+    bench.run([&] {
+        hash = HashX25X(in.begin(), in.end());
+        in[0] ^= hash.begin()[0];
+    });
+}
+
 static void SHA512(benchmark::Bench& bench)
 {
     uint8_t hash[CSHA512::OUTPUT_SIZE];
@@ -114,5 +145,8 @@ BENCHMARK(SHA3_256_1M);
 BENCHMARK(SHA256_32b);
 BENCHMARK(SipHash_32b);
 BENCHMARK(SHA256D64_1024);
+BENCHMARK(X11AES_64b);
+BENCHMARK(X22I_80b);
+BENCHMARK(X25X_80b);
 BENCHMARK(FastRandom_32bit);
 BENCHMARK(FastRandom_1bit);
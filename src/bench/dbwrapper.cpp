@@ -0,0 +1,106 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <dbwrapper.h>
+#include <primitives/transaction.h>
+#include <random.h>
+
+#include <deque>
+#include <vector>
+
+static constexpr size_t UTXO_COUNT = 200000;
+static constexpr size_t SPENDS_PER_BLOCK = 2000;
+static constexpr size_t MISSES_PER_BLOCK = 1000;
+
+//! Keyed like the coins in chainstate/
+static std::pair<char, COutPoint> CoinKey(const COutPoint& outpoint)
+{
+    return {'C', outpoint};
+}
+
+// Replays the chainstate access pattern against one LevelDB configuration:
+// a large set of small coins, and per block random point reads of the coins
+// being spent, lookups of outputs that do not exist (new outputs, BIP30),
+// and one batch that erases the spent coins and writes the created ones.
+// Reads are random and mostly miss the block cache, which is what the
+// block size and the bloom filter trade against.
+static void DBCoinsAccess(benchmark::Bench& bench, const DBOptions& db_options)
+{
+    CDBWrapper db("bench_chainstate", 8 << 20, /*fMemory*/ true, /*fWipe*/ false, /*obfuscate*/ true, db_options);
+    FastRandomContext rng(uint256(std::vector<unsigned char>(32, 7)));
+    const std::vector<unsigned char> value(40, 0x5a);
+
+    std::vector<COutPoint> utxos;
+    utxos.reserve(UTXO_COUNT);
+    CDBBatch batch(db);
+    for (size_t i = 0; i < UTXO_COUNT; ++i) {
+        utxos.emplace_back(rng.rand256(), rng.randrange(4));
+        batch.Write(CoinKey(utxos.back()), value);
+        if (batch.SizeEstimate() > (1 << 20)) {
+            db.WriteBatch(batch);
+            batch.Clear();
+        }
+    }
+    db.WriteBatch(batch);
+    batch.Clear();
+
+    std::vector<unsigned char> read;
+    bench.run([&] {
+        for (size_t i = 0; i < SPENDS_PER_BLOCK; ++i) {
+            const size_t pos = rng.randrange(utxos.size());
+            bool found = db.Read(CoinKey(utxos[pos]), read);
+            assert(found);
+            batch.Erase(CoinKey(utxos[pos]));
+            utxos[pos] = COutPoint(rng.rand256(), 0);
+            batch.Write(CoinKey(utxos[pos]), value);
+        }
+        for (size_t i = 0; i < MISSES_PER_BLOCK; ++i) {
+            bool found = db.Exists(CoinKey(COutPoint(rng.rand256(), 0)));
+            assert(!found);
+        }
+        db.WriteBatch(batch);
+        batch.Clear();
+    });
+}
+
+static void DBCoinsAccessDefault(benchmark::Bench& bench)
+{
+    DBCoinsAccess(bench, DBOptions{});
+}
+
+static void DBCoinsAccessNoBloom(benchmark::Bench& bench)
+{
+    DBOptions db_options;
+    db_options.bloom_bits = 0;
+    DBCoinsAccess(bench, db_options);
+}
+
+static void DBCoinsAccessBlock1K(benchmark::Bench& bench)
+{
+    DBOptions db_options;
+    db_options.block_size = 1 << 10;
+    DBCoinsAccess(bench, db_options);
+}
+
+static void DBCoinsAccessBlock16K(benchmark::Bench& bench)
+{
+    DBOptions db_options;
+    db_options.block_size = 16 << 10;
+    DBCoinsAccess(bench, db_options);
+}
+
+static void DBCoinsAccessLargeFiles(benchmark::Bench& bench)
+{
+    DBOptions db_options;
+    db_options.max_file_size = 32 << 20;
+    db_options.write_buffer_size = 4 << 20;
+    DBCoinsAccess(bench, db_options);
+}
+
+BENCHMARK(DBCoinsAccessDefault);
+BENCHMARK(DBCoinsAccessNoBloom);
+BENCHMARK(DBCoinsAccessBlock1K);
+BENCHMARK(DBCoinsAccessBlock16K);
+BENCHMARK(DBCoinsAccessLargeFiles);
@@ -0,0 +1,66 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <key_io.h>
+#include <random.h>
+#include <sinovate/infinitynode.h>
+#include <sinovate/flat-database.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+
+#include <map>
+
+static constexpr size_t NUM_NODES = 5000;
+
+static std::map<COutPoint, CInfinitynode> CreateNodes()
+{
+    FastRandomContext rng(uint256(std::vector<unsigned char>(32, 42)));
+    std::map<COutPoint, CInfinitynode> nodes;
+    for (size_t i = 0; i < NUM_NODES; ++i) {
+        const COutPoint outpoint(rng.rand256(), rng.randrange(4));
+        CInfinitynode node(PROTOCOL_VERSION, outpoint);
+        node.setHeight(250000 + rng.randrange(500000));
+        node.setLastRewardHeight(node.getHeight() + rng.randrange(10000));
+        node.nNextRewardHeight = node.nLastRewardHeight + 1440;
+        node.setBurnValue((100000 + rng.randrange(900000)) * COIN);
+        node.setSINType(CInfinitynode::SINNODE_10);
+        const PKHash collateral(uint160(rng.randbytes(20)));
+        node.setScriptPublicKey(GetScriptForDestination(collateral));
+        node.setCollateralAddress(EncodeDestination(collateral));
+        node.setBackupAddress(EncodeDestination(PKHash(uint160(rng.randbytes(20)))));
+        nodes.emplace(outpoint, node);
+    }
+    return nodes;
+}
+
+static void FlatDBLoad(benchmark::Bench& bench, int nVersion)
+{
+    const BasicTestingSetup test_setup{CBaseChainParams::MAIN};
+
+    CDataStream ss(SER_DISK, nVersion);
+    ss << CreateNodes();
+
+    // Report the serialized size of the cache alongside the load time
+    bench.name(strprintf("%s (%u bytes)", bench.name(), ss.size()));
+    bench.batch(NUM_NODES).unit("node").run([&] {
+        CDataStream ssIn(ss.begin(), ss.end(), SER_DISK, nVersion);
+        std::map<COutPoint, CInfinitynode> nodes;
+        ssIn >> nodes;
+        assert(nodes.size() == NUM_NODES);
+    });
+}
+
+static void FlatDBLoadLegacy(benchmark::Bench& bench)
+{
+    FlatDBLoad(bench, CLIENT_VERSION);
+}
+
+static void FlatDBLoadCompact(benchmark::Bench& bench)
+{
+    FlatDBLoad(bench, CLIENT_VERSION | FLATDB_COMPACT_FORMAT);
+}
+
+BENCHMARK(FlatDBLoadLegacy);
+BENCHMARK(FlatDBLoadCompact);
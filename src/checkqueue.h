@@ -5,15 +5,23 @@
 #ifndef BITCOIN_CHECKQUEUE_H
 #define BITCOIN_CHECKQUEUE_H
 
+#include <crypto/common.h>
 #include <sync.h>
 
 #include <algorithm>
+#include <array>
+#include <assert.h>
+#include <atomic>
+#include <memory>
 #include <vector>
 
 #include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
 
 template <typename T>
+class CCheckQueue;
+
+template <typename T, typename Queue = CCheckQueue<T>>
 class CCheckQueueControl;
 
 /**
@@ -162,22 +170,222 @@ public:
 
 };
 
+/**
+ * Check queue with the interface of CCheckQueue in which the workers do not
+ * share a lock while working.
+ *
+ * The checks added while one CCheckQueueControl is held form a round. The
+ * master spreads them over one lane per thread (itself included); each lane
+ * is an append-only array with a single writer, from which any thread claims
+ * runs of checks with a compare-and-swap on its read position. Threads drain
+ * their own lane first and then steal half of what is left in the others, so
+ * the mutex is only taken to sleep, to wake up and to hand the round over.
+ */
+template <typename T>
+class CWorkStealingCheckQueue
+{
+private:
+    //! Checks in the first segment of a lane; each further segment doubles,
+    //! so a lane holds up to SEGMENT_BASE * (2^MAX_SEGMENTS - 1) checks
+    static constexpr uint64_t SEGMENT_BASE = 16;
+    static constexpr size_t MAX_SEGMENTS = 32;
+
+    struct Lane {
+        //! Next check to be claimed, advanced by any thread
+        alignas(64) std::atomic<uint64_t> top{0};
+        //! Number of checks published by the master
+        alignas(64) std::atomic<uint64_t> bottom{0};
+        std::array<std::unique_ptr<T[]>, MAX_SEGMENTS> segments;
+
+        T& At(uint64_t i)
+        {
+            const unsigned int seg = CountBits(i / SEGMENT_BASE + 1) - 1;
+            return segments[seg][i - SEGMENT_BASE * ((uint64_t{1} << seg) - 1)];
+        }
+
+        //! Master only: make room for check i
+        void Reserve(uint64_t i)
+        {
+            const unsigned int seg = CountBits(i / SEGMENT_BASE + 1) - 1;
+            assert(seg < MAX_SEGMENTS);
+            if (!segments[seg]) segments[seg].reset(new T[SEGMENT_BASE << seg]);
+        }
+    };
+
+    struct Round {
+        std::vector<Lane> lanes;
+        //! Checks added and not finished yet
+        std::atomic<uint64_t> todo{0};
+        std::atomic<bool> all_ok{true};
+
+        explicit Round(size_t num_lanes) : lanes(num_lanes) {}
+
+        bool HasWork() const
+        {
+            for (const Lane& lane : lanes) {
+                if (lane.top.load(std::memory_order_acquire) < lane.bottom.load(std::memory_order_acquire)) return true;
+            }
+            return false;
+        }
+    };
+
+    //! Protects m_round and the sleeping of threads
+    boost::mutex mutex;
+    boost::condition_variable condWorker;
+    boost::condition_variable condMaster;
+
+    //! The round being processed, if any
+    std::shared_ptr<Round> m_round;
+    //! Number of worker threads (excluding the master), used to size rounds
+    std::atomic<int> m_workers{0};
+    //! Master only: lane that receives the next added checks
+    size_t m_next_lane{0};
+
+    //! The maximum number of checks claimed at once
+    const unsigned int nBatchSize;
+
+    /** Claim and run checks from all lanes of round, starting with lane own. */
+    void Drain(Round& round, size_t own)
+    {
+        const size_t num_lanes = round.lanes.size();
+        bool found;
+        do {
+            found = false;
+            for (size_t n = 0; n < num_lanes; ++n) {
+                Lane& lane = round.lanes[(own + n) % num_lanes];
+                uint64_t t = lane.top.load(std::memory_order_acquire);
+                while (true) {
+                    const uint64_t b = lane.bottom.load(std::memory_order_acquire);
+                    if (t >= b) break;
+                    // Take a batch from the own lane; leave half of the rest
+                    // to other thieves when stealing.
+                    const uint64_t avail = b - t;
+                    const uint64_t count = std::min<uint64_t>(nBatchSize, n == 0 ? avail : std::max<uint64_t>(1, avail / 2));
+                    if (!lane.top.compare_exchange_weak(t, t + count, std::memory_order_acq_rel, std::memory_order_acquire)) continue;
+                    found = true;
+                    Run(round, lane, t, count);
+                    t = lane.top.load(std::memory_order_acquire);
+                }
+            }
+        } while (found);
+    }
+
+    void Run(Round& round, Lane& lane, uint64_t first, uint64_t count)
+    {
+        for (uint64_t i = first; i < first + count; ++i) {
+            // Move the check out so it is destroyed before the round can end
+            T check;
+            check.swap(lane.At(i));
+            if (round.all_ok.load(std::memory_order_relaxed) && !check()) {
+                round.all_ok.store(false, std::memory_order_relaxed);
+            }
+        }
+        if (round.todo.fetch_sub(count, std::memory_order_acq_rel) == count) {
+            // We finished the last checks; wake up the master
+            boost::unique_lock<boost::mutex> lock(mutex);
+            condMaster.notify_one();
+        }
+    }
+
+public:
+    //! Mutex to ensure only one concurrent CCheckQueueControl
+    boost::mutex ControlMutex;
+
+    //! Create a new check queue
+    explicit CWorkStealingCheckQueue(unsigned int nBatchSizeIn) : nBatchSize(std::max(1U, nBatchSizeIn)) {}
+
+    //! Worker thread
+    void Thread()
+    {
+        const size_t worker = m_workers.fetch_add(1) + 1;
+        struct Leave {
+            std::atomic<int>& workers;
+            ~Leave() { workers.fetch_sub(1); }
+        } leave{m_workers};
+        while (true) {
+            std::shared_ptr<Round> round;
+            {
+                boost::unique_lock<boost::mutex> lock(mutex);
+                while (!m_round || !m_round->HasWork()) {
+                    condWorker.wait(lock);
+                }
+                round = m_round;
+            }
+            Drain(*round, worker % round->lanes.size());
+        }
+    }
+
+    //! Wait until execution finishes, and return whether all evaluations were successful.
+    bool Wait()
+    {
+        std::shared_ptr<Round> round;
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            round = m_round;
+        }
+        if (!round) return true;
+        Drain(*round, 0);
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while (round->todo.load(std::memory_order_acquire) != 0) {
+            condMaster.wait(lock);
+        }
+        m_round.reset();
+        return round->all_ok.load(std::memory_order_relaxed);
+    }
+
+    //! Add a batch of checks to the queue
+    void Add(std::vector<T>& vChecks)
+    {
+        if (vChecks.empty()) return;
+        std::shared_ptr<Round> round;
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            if (!m_round) {
+                m_round = std::make_shared<Round>(1 + m_workers.load());
+                m_next_lane = 0;
+            }
+            round = m_round;
+        }
+
+        const size_t num_lanes = round->lanes.size();
+        const size_t chunk = std::max<size_t>(1, std::min<size_t>(nBatchSize, vChecks.size() / num_lanes));
+        round->todo.fetch_add(vChecks.size(), std::memory_order_acq_rel);
+        for (size_t pos = 0; pos < vChecks.size(); pos += chunk) {
+            const size_t end = std::min(vChecks.size(), pos + chunk);
+            Lane& lane = round->lanes[m_next_lane];
+            m_next_lane = (m_next_lane + 1) % num_lanes;
+            uint64_t b = lane.bottom.load(std::memory_order_relaxed);
+            for (size_t i = pos; i < end; ++i, ++b) {
+                lane.Reserve(b);
+                lane.At(b).swap(vChecks[i]);
+            }
+            lane.bottom.store(b, std::memory_order_release);
+        }
+
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (vChecks.size() == 1)
+            condWorker.notify_one();
+        else
+            condWorker.notify_all();
+    }
+};
+
 /**
  * RAII-style controller object for a CCheckQueue that guarantees the passed
  * queue is finished before continuing.
  */
-template <typename T>
+template <typename T, typename Queue>
 class CCheckQueueControl
 {
 private:
-    CCheckQueue<T> * const pqueue;
+    Queue * const pqueue;
     bool fDone;
 
 public:
     CCheckQueueControl() = delete;
     CCheckQueueControl(const CCheckQueueControl&) = delete;
     CCheckQueueControl& operator=(const CCheckQueueControl&) = delete;
-    explicit CCheckQueueControl(CCheckQueue<T> * const pqueueIn) : pqueue(pqueueIn), fDone(false)
+    explicit CCheckQueueControl(Queue * const pqueueIn) : pqueue(pqueueIn), fDone(false)
     {
         // passed queue is supposed to be unused, or nullptr
         if (pqueue != nullptr) {
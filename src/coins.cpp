@@ -11,6 +11,8 @@
 #include <random.h>
 #include <version.h>
 
+#include <map>
+
 bool CCoinsView::GetCoin(const COutPoint &outpoint, Coin &coin) const { return false; }
 uint256 CCoinsView::GetBestBlock() const { return uint256(); }
 std::vector<uint256> CCoinsView::GetHeadBlocks() const { return std::vector<uint256>(); }
@@ -35,25 +37,45 @@ size_t CCoinsViewBacked::EstimateSize() const { return base->EstimateSize(); }
 
 SaltedOutpointHasher::SaltedOutpointHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
 
-CCoinsViewCache::CCoinsViewCache(CCoinsView *baseIn) : CCoinsViewBacked(baseIn), cachedCoinsUsage(0) {}
+CCoinsViewCache::CCoinsViewCache(CCoinsView *baseIn) : CCoinsViewBacked(baseIn),
+    cacheCoins(0, SaltedOutpointHasher(), CCoinsMap::key_equal(), &m_cache_coins_memory_resource), cachedCoinsUsage(0) {}
 
 size_t CCoinsViewCache::DynamicMemoryUsage() const {
     return memusage::DynamicUsage(cacheCoins) + cachedCoinsUsage;
 }
 
+//! Memory of one cacheCoins node, as handed out by the pool
+static constexpr size_t CACHE_ENTRY_USAGE = sizeof(memusage::unordered_node<CCoinsMap::value_type>);
+
+size_t CCoinsViewCache::ResidentMemoryUsage() const {
+    return CACHE_ENTRY_USAGE * cacheCoins.size() + memusage::MallocUsage(sizeof(void*) * cacheCoins.bucket_count()) + cachedCoinsUsage;
+}
+
 CCoinsMap::iterator CCoinsViewCache::FetchCoin(const COutPoint &outpoint) const {
     CCoinsMap::iterator it = cacheCoins.find(outpoint);
-    if (it != cacheCoins.end())
+    if (it != cacheCoins.end()) {
+        it->second.last_used = m_epoch;
         return it;
+    }
     Coin tmp;
     if (!base->GetCoin(outpoint, tmp))
         return cacheCoins.end();
-    CCoinsMap::iterator ret = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::forward_as_tuple(std::move(tmp))).first;
+    return InsertFetchedCoin(outpoint, std::move(tmp));
+}
+
+void CCoinsViewCache::WarmCoin(const COutPoint& outpoint, Coin&& coin) {
+    if (cacheCoins.count(outpoint)) return;
+    InsertFetchedCoin(outpoint, std::move(coin));
+}
+
+CCoinsMap::iterator CCoinsViewCache::InsertFetchedCoin(const COutPoint& outpoint, Coin&& coin) const {
+    CCoinsMap::iterator ret = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::forward_as_tuple(std::move(coin))).first;
     if (ret->second.coin.IsSpent()) {
         // The parent only has an empty entry for this outpoint; we can consider our
         // version as fresh.
         ret->second.flags = CCoinsCacheEntry::FRESH;
     }
+    ret->second.last_used = m_epoch;
     cachedCoinsUsage += ret->second.coin.DynamicMemoryUsage();
     return ret;
 }
@@ -98,6 +120,7 @@ void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin&& coin, bool possi
     }
     it->second.coin = std::move(coin);
     it->second.flags |= CCoinsCacheEntry::DIRTY | (fresh ? CCoinsCacheEntry::FRESH : 0);
+    it->second.last_used = m_epoch;
     cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
 }
 
@@ -158,6 +181,7 @@ uint256 CCoinsViewCache::GetBestBlock() const {
 
 void CCoinsViewCache::SetBestBlock(const uint256 &hashBlockIn) {
     hashBlock = hashBlockIn;
+    ++m_epoch;
 }
 
 bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn) {
@@ -177,6 +201,7 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn
                 entry.coin = std::move(it->second.coin);
                 cachedCoinsUsage += entry.coin.DynamicMemoryUsage();
                 entry.flags = CCoinsCacheEntry::DIRTY;
+                entry.last_used = m_epoch;
                 // We can mark it FRESH in the parent if it was FRESH in the child
                 // Otherwise it might have just been flushed from the parent's cache
                 // and already exist in the grandparent
@@ -205,6 +230,7 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn
                 itUs->second.coin = std::move(it->second.coin);
                 cachedCoinsUsage += itUs->second.coin.DynamicMemoryUsage();
                 itUs->second.flags |= CCoinsCacheEntry::DIRTY;
+                itUs->second.last_used = m_epoch;
                 // NOTE: It isn't safe to mark the coin as FRESH in the parent
                 // cache. If it already existed and was spent in the parent
                 // cache then marking it FRESH would prevent that spentness
@@ -213,6 +239,7 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn
         }
     }
     hashBlock = hashBlockIn;
+    ++m_epoch;
     return true;
 }
 
@@ -220,9 +247,71 @@ bool CCoinsViewCache::Flush() {
     bool fOk = base->BatchWrite(cacheCoins, hashBlock);
     cacheCoins.clear();
     cachedCoinsUsage = 0;
+    // hand the node pool back to the system in one go
+    ReallocateCache();
     return fOk;
 }
 
+bool CCoinsViewCache::Sync() {
+    // The base consumes what it is given, so hand it copies of the dirty
+    // entries and keep ours, now clean. Spent entries have nothing left to
+    // keep once their spentness is written. A background base holds on to the
+    // copies until they are written; callers budgeting memory must count
+    // them, see CChainState::FlushStateToDisk().
+    CCoinsMapMemoryResource resource;
+    CCoinsMap dirty{0, SaltedOutpointHasher(), CCoinsMap::key_equal(), &resource};
+    for (CCoinsMap::iterator it = cacheCoins.begin(); it != cacheCoins.end();) {
+        if (!(it->second.flags & CCoinsCacheEntry::DIRTY)) {
+            ++it;
+            continue;
+        }
+        CCoinsCacheEntry& entry = dirty[it->first];
+        entry.flags = it->second.flags;
+        if (it->second.coin.IsSpent()) {
+            cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
+            it = cacheCoins.erase(it);
+        } else {
+            entry.coin = it->second.coin;
+            it->second.flags = 0;
+            ++it;
+        }
+    }
+    return base->BatchWrite(dirty, hashBlock);
+}
+
+size_t CCoinsViewCache::Evict(size_t max_usage) {
+    const size_t usage = ResidentMemoryUsage();
+    if (usage <= max_usage) return 0;
+
+    // Total up the clean entries per epoch, and drop whole epochs, oldest
+    // first, until enough would be freed.
+    std::map<uint32_t, size_t> epoch_usage;
+    for (const auto& entry : cacheCoins) {
+        if (entry.second.flags & CCoinsCacheEntry::DIRTY) continue;
+        epoch_usage[entry.second.last_used] += CACHE_ENTRY_USAGE + entry.second.coin.DynamicMemoryUsage();
+    }
+    if (epoch_usage.empty()) return 0;
+    uint32_t cutoff = 0;
+    size_t freed = 0;
+    for (const auto& epoch : epoch_usage) {
+        cutoff = epoch.first;
+        freed += epoch.second;
+        if (usage - freed <= max_usage) break;
+    }
+
+    size_t evicted = 0;
+    for (CCoinsMap::iterator it = cacheCoins.begin(); it != cacheCoins.end();) {
+        if (!(it->second.flags & CCoinsCacheEntry::DIRTY) && it->second.last_used <= cutoff) {
+            cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
+            it = cacheCoins.erase(it);
+            ++evicted;
+        } else {
+            ++it;
+        }
+    }
+    return evicted;
+}
+
 void CCoinsViewCache::Uncache(const COutPoint& hash)
 {
     CCoinsMap::iterator it = cacheCoins.find(hash);
@@ -265,7 +354,9 @@ void CCoinsViewCache::ReallocateCache()
     // Cache should be empty when we're calling this.
     assert(cacheCoins.size() == 0);
     cacheCoins.~CCoinsMap();
-    ::new (&cacheCoins) CCoinsMap();
+    m_cache_coins_memory_resource.~CCoinsMapMemoryResource();
+    ::new (&m_cache_coins_memory_resource) CCoinsMapMemoryResource();
+    ::new (&cacheCoins) CCoinsMap(0, SaltedOutpointHasher(), CCoinsMap::key_equal(), &m_cache_coins_memory_resource);
 }
 
 static const size_t MIN_TRANSACTION_OUTPUT_WEIGHT = WITNESS_SCALE_FACTOR * ::GetSerializeSize(CTxOut(), PROTOCOL_VERSION);
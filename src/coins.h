@@ -14,6 +14,7 @@
 #include <memusage.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
+#include <support/allocators/pool.h>
 #include <uint256.h>
 
 #include <assert.h>
@@ -139,6 +140,8 @@ struct CCoinsCacheEntry
 {
     Coin coin; // The actual cached data.
     unsigned char flags;
+    //! Epoch of the owning cache in which this entry was last used (see CCoinsViewCache::Evict)
+    uint32_t last_used;
 
     enum Flags {
         /**
@@ -161,11 +164,26 @@ struct CCoinsCacheEntry
         FRESH = (1 << 1),
     };
 
-    CCoinsCacheEntry() : flags(0) {}
-    explicit CCoinsCacheEntry(Coin&& coin_) : coin(std::move(coin_)), flags(0) {}
+    CCoinsCacheEntry() : flags(0), last_used(0) {}
+    explicit CCoinsCacheEntry(Coin&& coin_) : coin(std::move(coin_)), flags(0), last_used(0) {}
 };
 
-typedef std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> CCoinsMap;
+/**
+ * Coins cache nodes are allocated from a PoolResource. The node layout of
+ * std::unordered_map is implementation defined; besides the value a node
+ * holds one or two links and sometimes the hash, so four extra pointers
+ * cover all implementations.
+ *
+ * The allocator cannot be default-constructed, so neither can a CCoinsMap:
+ * create a CCoinsMapMemoryResource that outlives the map and pass it in, as
+ * in CCoinsMap map{0, SaltedOutpointHasher{}, CCoinsMap::key_equal{}, &resource}.
+ */
+typedef std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher, std::equal_to<COutPoint>,
+                           PoolAllocator<std::pair<const COutPoint, CCoinsCacheEntry>,
+                                         sizeof(std::pair<const COutPoint, CCoinsCacheEntry>) + sizeof(void*) * 4,
+                                         alignof(void*)>>
+    CCoinsMap;
+typedef CCoinsMap::allocator_type::ResourceType CCoinsMapMemoryResource;
 
 /** Cursor for iterating over CoinsView state */
 class CCoinsViewCursor
@@ -252,11 +270,17 @@ protected:
      * declared as "const".
      */
     mutable uint256 hashBlock;
+    //! Backs the nodes of cacheCoins; released in bulk by Flush()
+    mutable CCoinsMapMemoryResource m_cache_coins_memory_resource{};
     mutable CCoinsMap cacheCoins;
 
     /* Cached dynamic memory usage for the inner Coin objects. */
     mutable size_t cachedCoinsUsage;
 
+    //! Advances with every change of the best block; entries remember the
+    //! epoch they were last used in, so that Evict() can find the cold ones.
+    uint32_t m_epoch{0};
+
 public:
     CCoinsViewCache(CCoinsView *baseIn);
 
@@ -282,6 +306,13 @@ public:
      */
     bool HaveCoinInCache(const COutPoint &outpoint) const;
 
+    /**
+     * Cache a coin that the caller read from the backing view itself (e.g. on
+     * another thread), exactly as a lookup through this cache would have.
+     * Does nothing if the outpoint is already cached.
+     */
+    void WarmCoin(const COutPoint& outpoint, Coin&& coin);
+
     /**
      * Return a reference to Coin in the cache, or coinEmpty if not found. This is
      * more efficient than GetCoin.
@@ -314,6 +345,22 @@ public:
      */
     bool Flush();
 
+    /**
+     * Push the modifications applied to this cache to its base like Flush(),
+     * but keep the unspent coins cached (no longer dirty), so that lookups
+     * right after the write-back still hit memory.
+     * If false is returned, the state of this cache (and its backing view) will be undefined.
+     */
+    bool Sync();
+
+    /**
+     * Uncache the least recently used coins that are not dirty until
+     * ResidentMemoryUsage() is at most max_usage, or no clean coins are left.
+     * Dirty coins are never evicted; Sync() first to make all of them
+     * evictable. Returns the number of coins removed.
+     */
+    size_t Evict(size_t max_usage);
+
     /**
      * Removes the UTXO with the given outpoint from the cache, if it is
      * not modified.
@@ -326,6 +373,11 @@ public:
     //! Calculate the size of the cache (in bytes)
     size_t DynamicMemoryUsage() const;
 
+    //! Calculate the memory held by the cached coins (in bytes). Unlike
+    //! DynamicMemoryUsage() this shrinks when coins are removed: their
+    //! memory stays with the cache's pool, but is reused before it grows.
+    size_t ResidentMemoryUsage() const;
+
     //! Return the value going IN to a transaction as CAmount
     CAmount GetValueIn(const CTransaction& tx) const;
 
@@ -345,6 +397,8 @@ private:
      * memory usage.
      */
     CCoinsMap::iterator FetchCoin(const COutPoint &outpoint) const;
+    //! Add a coin read from base to the cache (not dirty)
+    CCoinsMap::iterator InsertFetchedCoin(const COutPoint& outpoint, Coin&& coin) const;
 };
 
 //! Utility function to add all of a transaction's outputs to a cache.
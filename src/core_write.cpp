@@ -11,6 +11,7 @@
 #include <script/standard.h>
 #include <serialize.h>
 #include <streams.h>
+#include <undo.h>
 #include <univalue.h>
 #include <util/system.h>
 #include <util/strencodings.h>
@@ -177,7 +178,7 @@ void ScriptPubKeyToUniv(const CScript& scriptPubKey,
     out.pushKV("addresses", a);
 }
 
-void TxToUniv(const CTransaction& tx, const uint256& hashBlock, UniValue& entry, bool include_hex, int serialize_flags)
+void TxToUniv(const CTransaction& tx, const uint256& hashBlock, UniValue& entry, bool include_hex, int serialize_flags, const CTxUndo* txundo)
 {
     entry.pushKV("txid", tx.GetHash().GetHex());
     entry.pushKV("hash", tx.GetWitnessHash().GetHex());
@@ -189,6 +190,11 @@ void TxToUniv(const CTransaction& tx, const uint256& hashBlock, UniValue& entry,
     entry.pushKV("weight", GetTransactionWeight(tx));
     entry.pushKV("locktime", (int64_t)tx.nLockTime);
 
+    // If available, use Undo data to report the spent outputs and the fee
+    const bool have_undo = txundo != nullptr && !tx.IsCoinBase() && txundo->vprevout.size() == tx.vin.size();
+    CAmount amt_total_in = 0;
+    CAmount amt_total_out = 0;
+
     UniValue vin(UniValue::VARR);
     for (unsigned int i = 0; i < tx.vin.size(); i++) {
         const CTxIn& txin = tx.vin[i];
@@ -205,6 +211,19 @@ void TxToUniv(const CTransaction& tx, const uint256& hashBlock, UniValue& entry,
             o.pushKV("hex", HexStr(txin.scriptSig));
             in.pushKV("scriptSig", o);
         }
+        if (have_undo) {
+            const Coin& prev_coin = txundo->vprevout[i];
+            const CTxOut& prev_txout = prev_coin.out;
+            amt_total_in += prev_txout.nValue;
+            UniValue o_prevout(UniValue::VOBJ);
+            o_prevout.pushKV("generated", prev_coin.IsCoinBase() || prev_coin.IsCoinStake());
+            o_prevout.pushKV("height", (uint64_t)prev_coin.nHeight);
+            o_prevout.pushKV("value", ValueFromAmount(prev_txout.nValue));
+            UniValue o_script(UniValue::VOBJ);
+            ScriptPubKeyToUniv(prev_txout.scriptPubKey, o_script, true);
+            o_prevout.pushKV("scriptPubKey", o_script);
+            in.pushKV("prevout", o_prevout);
+        }
         if (!tx.vin[i].scriptWitness.IsNull()) {
             UniValue txinwitness(UniValue::VARR);
             for (const auto& item : tx.vin[i].scriptWitness.stack) {
@@ -223,6 +242,7 @@ void TxToUniv(const CTransaction& tx, const uint256& hashBlock, UniValue& entry,
 
         UniValue out(UniValue::VOBJ);
 
+        amt_total_out += txout.nValue;
         out.pushKV("value", ValueFromAmount(txout.nValue));
         out.pushKV("n", (int64_t)i);
 
@@ -233,6 +253,10 @@ void TxToUniv(const CTransaction& tx, const uint256& hashBlock, UniValue& entry,
     }
     entry.pushKV("vout", vout);
 
+    if (have_undo && !tx.IsCoinStake()) {
+        entry.pushKV("fee", ValueFromAmount(amt_total_in - amt_total_out));
+    }
+
     if (!hashBlock.IsNull())
         entry.pushKV("blockhash", hashBlock.GetHex());
 
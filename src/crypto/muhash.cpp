@@ -0,0 +1,305 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/muhash.h>
+
+#include <crypto/chacha20.h>
+#include <crypto/common.h>
+#include <crypto/sha256.h>
+
+#include <limits>
+
+namespace {
+
+using limb_t = Num3072::limb_t;
+using double_limb_t = Num3072::double_limb_t;
+constexpr int LIMB_SIZE = Num3072::LIMB_SIZE;
+/** 2^3072 - 1103717 is the largest 3072-bit safe prime number, is used as the modulus. */
+constexpr limb_t MAX_PRIME_DIFF = 1103717;
+constexpr int LIMBS = Num3072::LIMBS;
+
+/* Helpers on fixed-size little-endian limb arrays, for the modular inverse. */
+
+bool IsZero(const limb_t* a)
+{
+    for (int i = 0; i < LIMBS; ++i) {
+        if (a[i] != 0) return false;
+    }
+    return true;
+}
+
+bool IsOne(const limb_t* a)
+{
+    if (a[0] != 1) return false;
+    for (int i = 1; i < LIMBS; ++i) {
+        if (a[i] != 0) return false;
+    }
+    return true;
+}
+
+bool IsEven(const limb_t* a) { return (a[0] & 1) == 0; }
+
+int Compare(const limb_t* a, const limb_t* b)
+{
+    for (int i = LIMBS - 1; i >= 0; --i) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+/** a += b, returning the carry out. */
+limb_t Add(limb_t* a, const limb_t* b)
+{
+    limb_t carry = 0;
+    for (int i = 0; i < LIMBS; ++i) {
+        const double_limb_t acc = (double_limb_t)a[i] + b[i] + carry;
+        a[i] = (limb_t)acc;
+        carry = (limb_t)(acc >> LIMB_SIZE);
+    }
+    return carry;
+}
+
+/** a -= b, returning the borrow out. */
+limb_t Sub(limb_t* a, const limb_t* b)
+{
+    limb_t borrow = 0;
+    for (int i = 0; i < LIMBS; ++i) {
+        const double_limb_t acc = (double_limb_t)a[i] - b[i] - borrow;
+        a[i] = (limb_t)acc;
+        borrow = (limb_t)(acc >> LIMB_SIZE) & 1;
+    }
+    return borrow;
+}
+
+/** a = (top_bit * 2^3072 + a) / 2 */
+void ShiftRight(limb_t* a, limb_t top_bit)
+{
+    for (int i = 0; i < LIMBS - 1; ++i) {
+        a[i] = (a[i] >> 1) | (a[i + 1] << (LIMB_SIZE - 1));
+    }
+    a[LIMBS - 1] = (a[LIMBS - 1] >> 1) | (top_bit << (LIMB_SIZE - 1));
+}
+
+/** a = a / 2 (mod p), for a < p. */
+void HalveModP(limb_t* a, const limb_t* p)
+{
+    limb_t carry = 0;
+    if (!IsEven(a)) carry = Add(a, p);
+    ShiftRight(a, carry);
+}
+
+/** a = a - b (mod p), for a, b < p. */
+void SubModP(limb_t* a, const limb_t* b, const limb_t* p)
+{
+    if (Sub(a, b)) Add(a, p);
+}
+
+} // namespace
+
+/** Whether this number is at least the modulus, i.e. not fully reduced. */
+bool Num3072::IsOverflow() const
+{
+    if (this->limbs[0] <= std::numeric_limits<limb_t>::max() - MAX_PRIME_DIFF) return false;
+    for (int i = 1; i < LIMBS; ++i) {
+        if (this->limbs[i] != std::numeric_limits<limb_t>::max()) return false;
+    }
+    return true;
+}
+
+/** Subtract the modulus once, which is the same as adding MAX_PRIME_DIFF and dropping the top carry. */
+void Num3072::FullReduce()
+{
+    limb_t carry = MAX_PRIME_DIFF;
+    for (int i = 0; i < LIMBS && carry != 0; ++i) {
+        const double_limb_t acc = (double_limb_t)this->limbs[i] + carry;
+        this->limbs[i] = (limb_t)acc;
+        carry = (limb_t)(acc >> LIMB_SIZE);
+    }
+}
+
+/** Add carry * 2^3072, which modulo the prime equals carry * MAX_PRIME_DIFF. */
+void Num3072::AddCarry(uint64_t carry)
+{
+    while (carry != 0) {
+        double_limb_t acc = (double_limb_t)carry * MAX_PRIME_DIFF;
+        for (int i = 0; i < LIMBS; ++i) {
+            acc += this->limbs[i];
+            this->limbs[i] = (limb_t)acc;
+            acc >>= LIMB_SIZE;
+        }
+        carry = (uint64_t)acc;
+    }
+}
+
+void Num3072::Multiply(const Num3072& a)
+{
+    // Schoolbook product into 2 * LIMBS limbs.
+    limb_t product[LIMBS * 2] = {0};
+    for (int i = 0; i < LIMBS; ++i) {
+        limb_t carry = 0;
+        for (int j = 0; j < LIMBS; ++j) {
+            const double_limb_t acc = (double_limb_t)this->limbs[i] * a.limbs[j] + product[i + j] + carry;
+            product[i + j] = (limb_t)acc;
+            carry = (limb_t)(acc >> LIMB_SIZE);
+        }
+        product[i + LIMBS] = carry;
+    }
+
+    // Fold the high half back in: lo + hi * 2^3072 = lo + hi * MAX_PRIME_DIFF (mod p).
+    limb_t carry = 0;
+    for (int i = 0; i < LIMBS; ++i) {
+        const double_limb_t acc = (double_limb_t)product[i + LIMBS] * MAX_PRIME_DIFF + product[i] + carry;
+        this->limbs[i] = (limb_t)acc;
+        carry = (limb_t)(acc >> LIMB_SIZE);
+    }
+    AddCarry(carry);
+
+    if (IsOverflow()) FullReduce();
+}
+
+Num3072 Num3072::GetInverse() const
+{
+    // Binary extended Euclid: keep x1 * this = u and x2 * this = v (mod p)
+    // while driving u or v down to 1. The operands are public (hashes of
+    // UTXO set elements), so this does not need to run in constant time,
+    // and it is much cheaper than computing this^(p - 2).
+    limb_t u[LIMBS], v[LIMBS], x1[LIMBS], x2[LIMBS], p[LIMBS];
+    for (int i = 0; i < LIMBS; ++i) {
+        u[i] = this->limbs[i];
+        v[i] = p[i] = std::numeric_limits<limb_t>::max();
+        x1[i] = x2[i] = 0;
+    }
+    v[0] = p[0] = (limb_t)(0 - MAX_PRIME_DIFF);
+    x1[0] = 1;
+
+    Num3072 out;
+    if (IsZero(u)) {
+        // Zero has no inverse; it cannot occur for hashed elements.
+        for (int i = 0; i < LIMBS; ++i) out.limbs[i] = 0;
+        return out;
+    }
+
+    while (!IsOne(u) && !IsOne(v)) {
+        while (IsEven(u)) {
+            ShiftRight(u, 0);
+            HalveModP(x1, p);
+        }
+        while (IsEven(v)) {
+            ShiftRight(v, 0);
+            HalveModP(x2, p);
+        }
+        if (Compare(u, v) >= 0) {
+            Sub(u, v);
+            SubModP(x1, x2, p);
+        } else {
+            Sub(v, u);
+            SubModP(x2, x1, p);
+        }
+    }
+
+    const limb_t* inverse = IsOne(u) ? x1 : x2;
+    for (int i = 0; i < LIMBS; ++i) out.limbs[i] = inverse[i];
+    return out;
+}
+
+void Num3072::SetToOne()
+{
+    this->limbs[0] = 1;
+    for (int i = 1; i < LIMBS; ++i) {
+        this->limbs[i] = 0;
+    }
+}
+
+void Num3072::Divide(const Num3072& a)
+{
+    if (this->IsOverflow()) this->FullReduce();
+
+    Num3072 inv{};
+    if (a.IsOverflow()) {
+        Num3072 b = a;
+        b.FullReduce();
+        inv = b.GetInverse();
+    } else {
+        inv = a.GetInverse();
+    }
+
+    this->Multiply(inv);
+    if (this->IsOverflow()) this->FullReduce();
+}
+
+Num3072::Num3072(const unsigned char (&data)[BYTE_SIZE])
+{
+    for (int i = 0; i < LIMBS; ++i) {
+        if (sizeof(limb_t) == 4) {
+            this->limbs[i] = ReadLE32(data + 4 * i);
+        } else if (sizeof(limb_t) == 8) {
+            this->limbs[i] = ReadLE64(data + 8 * i);
+        }
+    }
+}
+
+void Num3072::ToBytes(unsigned char (&out)[BYTE_SIZE]) const
+{
+    for (int i = 0; i < LIMBS; ++i) {
+        if (sizeof(limb_t) == 4) {
+            WriteLE32(out + i * 4, this->limbs[i]);
+        } else if (sizeof(limb_t) == 8) {
+            WriteLE64(out + i * 8, this->limbs[i]);
+        }
+    }
+}
+
+Num3072 MuHash3072::ToNum3072(Span<const unsigned char> in)
+{
+    unsigned char tmp[Num3072::BYTE_SIZE];
+
+    uint256 hashed_in;
+    CSHA256().Write(in.data(), in.size()).Finalize(hashed_in.begin());
+    ChaCha20(hashed_in.begin(), hashed_in.size()).Keystream(tmp, Num3072::BYTE_SIZE);
+    Num3072 out{tmp};
+
+    return out;
+}
+
+MuHash3072::MuHash3072(Span<const unsigned char> in) noexcept
+{
+    m_numerator = ToNum3072(in);
+}
+
+void MuHash3072::Finalize(uint256& out) noexcept
+{
+    m_numerator.Divide(m_denominator);
+    m_denominator.SetToOne();  // Needed to keep the MuHash object valid
+
+    unsigned char data[Num3072::BYTE_SIZE];
+    m_numerator.ToBytes(data);
+
+    CSHA256().Write(data, Num3072::BYTE_SIZE).Finalize(out.begin());
+}
+
+MuHash3072& MuHash3072::operator*=(const MuHash3072& mul) noexcept
+{
+    m_numerator.Multiply(mul.m_numerator);
+    m_denominator.Multiply(mul.m_denominator);
+    return *this;
+}
+
+MuHash3072& MuHash3072::operator/=(const MuHash3072& div) noexcept
+{
+    m_numerator.Multiply(div.m_denominator);
+    m_denominator.Multiply(div.m_numerator);
+    return *this;
+}
+
+MuHash3072& MuHash3072::Insert(Span<const unsigned char> in) noexcept
+{
+    m_numerator.Multiply(ToNum3072(in));
+    return *this;
+}
+
+MuHash3072& MuHash3072::Remove(Span<const unsigned char> in) noexcept
+{
+    m_denominator.Multiply(ToNum3072(in));
+    return *this;
+}
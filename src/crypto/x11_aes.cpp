@@ -0,0 +1,128 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/x11_aes.h>
+#include <crypto/common.h>
+
+#include <crypto/sph_echo.h>
+#include <crypto/sph_groestl.h>
+#include <crypto/sph_shavite.h>
+
+#include <assert.h>
+#include <string.h>
+
+#include <compat/cpuid.h>
+
+namespace groestl512_aesni
+{
+void Hash64(unsigned char* out, const unsigned char* in);
+}
+
+namespace echo512_aesni
+{
+void Hash64(unsigned char* out, const unsigned char* in);
+}
+
+namespace shavite512_aesni
+{
+void Hash64(unsigned char* out, const unsigned char* in);
+}
+
+namespace {
+
+void Groestl512Portable(unsigned char* out, const unsigned char* in)
+{
+    sph_groestl512_context ctx;
+    sph_groestl512_init(&ctx);
+    sph_groestl512(&ctx, in, 64);
+    sph_groestl512_close(&ctx, out);
+}
+
+void Echo512Portable(unsigned char* out, const unsigned char* in)
+{
+    sph_echo512_context ctx;
+    sph_echo512_init(&ctx);
+    sph_echo512(&ctx, in, 64);
+    sph_echo512_close(&ctx, out);
+}
+
+void Shavite512Portable(unsigned char* out, const unsigned char* in)
+{
+    sph_shavite512_context ctx;
+    sph_shavite512_init(&ctx);
+    sph_shavite512(&ctx, in, 64);
+    sph_shavite512_close(&ctx, out);
+}
+
+typedef void (*HashFn)(unsigned char* out, const unsigned char* in);
+
+HashFn Groestl = Groestl512Portable;
+HashFn Echo = Echo512Portable;
+HashFn Shavite = Shavite512Portable;
+
+#if defined(USE_ASM) && defined(HAVE_GETCPUID) && defined(ENABLE_AESNI) && !defined(BUILD_BITCOIN_INTERNAL)
+/** Check a candidate implementation against the portable one. */
+bool SelfTest(HashFn candidate, HashFn reference)
+{
+    unsigned char in[64];
+    for (int i = 0; i < 64; ++i) in[i] = (unsigned char)(i * 73 + 11);
+
+    for (int i = 0; i < 4; ++i) {
+        unsigned char expected[64], actual[64];
+        reference(expected, in);
+        candidate(actual, in);
+        if (memcmp(expected, actual, 64) != 0) return false;
+        memcpy(in, expected, 64);
+    }
+    return true;
+}
+#endif
+
+} // namespace
+
+std::string X11AESAutoDetect()
+{
+    std::string ret = "standard";
+#if defined(USE_ASM) && defined(HAVE_GETCPUID)
+    bool have_sse41 = false;
+    bool have_aesni = false;
+
+    (void)have_sse41;
+    (void)have_aesni;
+
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    have_sse41 = (ecx >> 19) & 1;
+    have_aesni = (ecx >> 25) & 1;
+
+#if defined(ENABLE_AESNI) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (have_sse41 && have_aesni) {
+        assert(SelfTest(groestl512_aesni::Hash64, Groestl512Portable));
+        assert(SelfTest(echo512_aesni::Hash64, Echo512Portable));
+        assert(SelfTest(shavite512_aesni::Hash64, Shavite512Portable));
+        Groestl = groestl512_aesni::Hash64;
+        Echo = echo512_aesni::Hash64;
+        Shavite = shavite512_aesni::Hash64;
+        ret = "aesni";
+    }
+#endif
+#endif
+
+    return ret;
+}
+
+void Groestl512_64(unsigned char* output, const unsigned char* input)
+{
+    Groestl(output, input);
+}
+
+void Echo512_64(unsigned char* output, const unsigned char* input)
+{
+    Echo(output, input);
+}
+
+void Shavite512_64(unsigned char* output, const unsigned char* input)
+{
+    Shavite(output, input);
+}
@@ -0,0 +1,25 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_X11_AES_H
+#define BITCOIN_CRYPTO_X11_AES_H
+
+#include <string>
+
+/** Autodetect the best available implementation of the AES-based X22I/X25X
+ *  stages (Groestl-512, ECHO-512, SHAvite-3-512).
+ *  Returns the name of the implementation.
+ */
+std::string X11AESAutoDetect();
+
+/** Compute Groestl-512 of a 64-byte input into a 64-byte output. */
+void Groestl512_64(unsigned char* output, const unsigned char* input);
+
+/** Compute ECHO-512 of a 64-byte input into a 64-byte output. */
+void Echo512_64(unsigned char* output, const unsigned char* input);
+
+/** Compute SHAvite-3-512 of a 64-byte input into a 64-byte output. */
+void Shavite512_64(unsigned char* output, const unsigned char* input);
+
+#endif // BITCOIN_CRYPTO_X11_AES_H
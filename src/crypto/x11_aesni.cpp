@@ -0,0 +1,313 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// AES-NI versions of the Groestl-512, ECHO-512 and SHAvite-3-512 stages of
+// the X22I/X25X chains. All three are built from AES rounds, so SubBytes and
+// MixColumns map directly onto AESENC/AESENCLAST. Only the fixed 64-byte
+// input used between chain stages is supported; the sph_* implementations
+// remain the reference and are used for everything else.
+
+#ifdef ENABLE_AESNI
+
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+namespace {
+
+/** Multiply every byte by x in GF(2^8) modulo the AES polynomial. */
+inline __m128i XTime(__m128i x)
+{
+    const __m128i carry = _mm_and_si128(_mm_cmplt_epi8(x, _mm_setzero_si128()), _mm_set1_epi8(0x1b));
+    return _mm_xor_si128(_mm_add_epi8(x, x), carry);
+}
+
+/**
+ * Groestl-512.
+ *
+ * The 8x16 byte state is kept as one register per row. SubBytes and
+ * ShiftBytes are combined into a single PSHUFB followed by AESENCLAST with a
+ * zero key; the shuffle undoes the AES ShiftRows that AESENCLAST applies and
+ * performs the row rotation required by Groestl at the same time.
+ */
+namespace groestl {
+
+/** PSHUFB masks for a rotation of a row by 0..15 bytes, pre-compensated for AES ShiftRows. */
+alignas(__m128i) const uint8_t ROTATE[16][16] = {
+    { 0, 13, 10,  7,  4,  1, 14, 11,  8,  5,  2, 15, 12,  9,  6,  3},
+    { 1, 14, 11,  8,  5,  2, 15, 12,  9,  6,  3,  0, 13, 10,  7,  4},
+    { 2, 15, 12,  9,  6,  3,  0, 13, 10,  7,  4,  1, 14, 11,  8,  5},
+    { 3,  0, 13, 10,  7,  4,  1, 14, 11,  8,  5,  2, 15, 12,  9,  6},
+    { 4,  1, 14, 11,  8,  5,  2, 15, 12,  9,  6,  3,  0, 13, 10,  7},
+    { 5,  2, 15, 12,  9,  6,  3,  0, 13, 10,  7,  4,  1, 14, 11,  8},
+    { 6,  3,  0, 13, 10,  7,  4,  1, 14, 11,  8,  5,  2, 15, 12,  9},
+    { 7,  4,  1, 14, 11,  8,  5,  2, 15, 12,  9,  6,  3,  0, 13, 10},
+    { 8,  5,  2, 15, 12,  9,  6,  3,  0, 13, 10,  7,  4,  1, 14, 11},
+    { 9,  6,  3,  0, 13, 10,  7,  4,  1, 14, 11,  8,  5,  2, 15, 12},
+    {10,  7,  4,  1, 14, 11,  8,  5,  2, 15, 12,  9,  6,  3,  0, 13},
+    {11,  8,  5,  2, 15, 12,  9,  6,  3,  0, 13, 10,  7,  4,  1, 14},
+    {12,  9,  6,  3,  0, 13, 10,  7,  4,  1, 14, 11,  8,  5,  2, 15},
+    {13, 10,  7,  4,  1, 14, 11,  8,  5,  2, 15, 12,  9,  6,  3,  0},
+    {14, 11,  8,  5,  2, 15, 12,  9,  6,  3,  0, 13, 10,  7,  4,  1},
+    {15, 12,  9,  6,  3,  0, 13, 10,  7,  4,  1, 14, 11,  8,  5,  2},
+};
+
+const int SHIFT_P[8] = {0, 1, 2, 3, 4, 5, 6, 11};
+const int SHIFT_Q[8] = {1, 3, 5, 11, 0, 2, 4, 6};
+
+/** Column index shifted into the high nibble, for the round constants. */
+alignas(__m128i) const uint8_t COLUMN[16] = {
+    0x00, 0x10, 0x20, 0x30, 0x40, 0x50, 0x60, 0x70, 0x80, 0x90, 0xa0, 0xb0, 0xc0, 0xd0, 0xe0, 0xf0
+};
+
+/** MixBytes with the circulant matrix circ(2, 2, 3, 4, 5, 3, 5, 7), split by coefficient bit. */
+inline void MixBytes(__m128i a[8])
+{
+    __m128i b[8];
+    for (int i = 0; i < 8; ++i) {
+        const __m128i s1 = _mm_xor_si128(_mm_xor_si128(a[(i + 2) & 7], a[(i + 4) & 7]), _mm_xor_si128(_mm_xor_si128(a[(i + 5) & 7], a[(i + 6) & 7]), a[(i + 7) & 7]));
+        const __m128i s2 = _mm_xor_si128(_mm_xor_si128(a[i], a[(i + 1) & 7]), _mm_xor_si128(_mm_xor_si128(a[(i + 2) & 7], a[(i + 5) & 7]), a[(i + 7) & 7]));
+        const __m128i s4 = _mm_xor_si128(_mm_xor_si128(a[(i + 3) & 7], a[(i + 4) & 7]), _mm_xor_si128(a[(i + 6) & 7], a[(i + 7) & 7]));
+        b[i] = _mm_xor_si128(s1, XTime(_mm_xor_si128(s2, XTime(s4))));
+    }
+    for (int i = 0; i < 8; ++i) a[i] = b[i];
+}
+
+inline void SubShiftBytes(__m128i a[8], const int shift[8])
+{
+    const __m128i zero = _mm_setzero_si128();
+    for (int i = 0; i < 8; ++i) {
+        const __m128i mask = _mm_load_si128((const __m128i*)ROTATE[shift[i]]);
+        a[i] = _mm_aesenclast_si128(_mm_shuffle_epi8(a[i], mask), zero);
+    }
+}
+
+void PermP(__m128i a[8])
+{
+    const __m128i column = _mm_load_si128((const __m128i*)COLUMN);
+    for (int r = 0; r < 14; ++r) {
+        a[0] = _mm_xor_si128(a[0], _mm_xor_si128(column, _mm_set1_epi8((char)r)));
+        SubShiftBytes(a, SHIFT_P);
+        MixBytes(a);
+    }
+}
+
+void PermQ(__m128i a[8])
+{
+    const __m128i column = _mm_load_si128((const __m128i*)COLUMN);
+    const __m128i ones = _mm_set1_epi8((char)0xff);
+    for (int r = 0; r < 14; ++r) {
+        for (int i = 0; i < 7; ++i) a[i] = _mm_xor_si128(a[i], ones);
+        a[7] = _mm_xor_si128(a[7], _mm_xor_si128(ones, _mm_xor_si128(column, _mm_set1_epi8((char)r))));
+        SubShiftBytes(a, SHIFT_Q);
+        MixBytes(a);
+    }
+}
+
+/** Load a column-major 128-byte block into row registers. */
+inline void LoadRows(__m128i a[8], const unsigned char in[128])
+{
+    alignas(__m128i) uint8_t rows[8][16];
+    for (int j = 0; j < 16; ++j) {
+        for (int i = 0; i < 8; ++i) rows[i][j] = in[8 * j + i];
+    }
+    for (int i = 0; i < 8; ++i) a[i] = _mm_load_si128((const __m128i*)rows[i]);
+}
+
+void Hash64(unsigned char* out, const unsigned char* in)
+{
+    unsigned char block[128] = {0};
+    memcpy(block, in, 64);
+    block[64] = 0x80;
+    block[127] = 0x01; // one block, big-endian
+
+    // The IV is all zeros except for the output size (512, big-endian) in
+    // the last two bytes, i.e. row 6 of the last column.
+    __m128i h[8], m[8], p[8];
+    for (int i = 0; i < 8; ++i) h[i] = _mm_setzero_si128();
+    h[6] = _mm_insert_epi8(h[6], 0x02, 15);
+
+    LoadRows(m, block);
+    for (int i = 0; i < 8; ++i) p[i] = _mm_xor_si128(h[i], m[i]);
+    PermP(p);
+    PermQ(m);
+    for (int i = 0; i < 8; ++i) h[i] = _mm_xor_si128(h[i], _mm_xor_si128(p[i], m[i]));
+
+    // Output transformation: truncate P(h) ^ h to its last eight columns.
+    for (int i = 0; i < 8; ++i) p[i] = h[i];
+    PermP(p);
+    alignas(__m128i) uint8_t rows[8][16];
+    for (int i = 0; i < 8; ++i) _mm_store_si128((__m128i*)rows[i], _mm_xor_si128(p[i], h[i]));
+    for (int j = 0; j < 8; ++j) {
+        for (int i = 0; i < 8; ++i) out[8 * j + i] = rows[i][8 + j];
+    }
+}
+
+} // namespace groestl
+
+/**
+ * ECHO-512.
+ *
+ * The state is sixteen 128-bit words; BIG.SubWords is two AES rounds per word
+ * keyed by the running counter and the (zero) salt.
+ */
+namespace echo {
+
+inline void MixColumn(__m128i& a, __m128i& b, __m128i& c, __m128i& d)
+{
+    const __m128i ab = _mm_xor_si128(a, b);
+    const __m128i bc = _mm_xor_si128(b, c);
+    const __m128i cd = _mm_xor_si128(c, d);
+    const __m128i abx = XTime(ab);
+    const __m128i bcx = XTime(bc);
+    const __m128i cdx = XTime(cd);
+    const __m128i na = _mm_xor_si128(_mm_xor_si128(abx, bc), d);
+    const __m128i nb = _mm_xor_si128(_mm_xor_si128(bcx, a), cd);
+    const __m128i nc = _mm_xor_si128(_mm_xor_si128(cdx, ab), d);
+    const __m128i nd = _mm_xor_si128(_mm_xor_si128(_mm_xor_si128(abx, bcx), _mm_xor_si128(cdx, ab)), c);
+    a = na;
+    b = nb;
+    c = nc;
+    d = nd;
+}
+
+void Hash64(unsigned char* out, const unsigned char* in)
+{
+    unsigned char block[128] = {0};
+    memcpy(block, in, 64);
+    block[64] = 0x80;
+    block[110] = 0x00; // output size (512), little-endian
+    block[111] = 0x02;
+    block[112] = 0x00; // message length in bits (512), little-endian
+    block[113] = 0x02;
+
+    const __m128i iv = _mm_cvtsi32_si128(512);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i w[16], m[8];
+    for (int i = 0; i < 8; ++i) {
+        m[i] = _mm_loadu_si128((const __m128i*)(block + 16 * i));
+        w[i] = iv;
+        w[i + 8] = m[i];
+    }
+
+    uint32_t k = 512;
+    for (int r = 0; r < 10; ++r) {
+        // BIG.SubWords
+        for (int i = 0; i < 16; ++i) {
+            w[i] = _mm_aesenc_si128(_mm_aesenc_si128(w[i], _mm_cvtsi32_si128((int)k)), zero);
+            ++k;
+        }
+        // BIG.ShiftRows
+        __m128i t;
+        t = w[1]; w[1] = w[5]; w[5] = w[9]; w[9] = w[13]; w[13] = t;
+        t = w[2]; w[2] = w[10]; w[10] = t;
+        t = w[6]; w[6] = w[14]; w[14] = t;
+        t = w[3]; w[3] = w[15]; w[15] = w[11]; w[11] = w[7]; w[7] = t;
+        // BIG.MixColumns
+        for (int c = 0; c < 16; c += 4) MixColumn(w[c], w[c + 1], w[c + 2], w[c + 3]);
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        const __m128i v = _mm_xor_si128(_mm_xor_si128(iv, m[i]), _mm_xor_si128(w[i], w[i + 8]));
+        _mm_storeu_si128((__m128i*)(out + 16 * i), v);
+    }
+}
+
+} // namespace echo
+
+/**
+ * SHAvite-3-512.
+ *
+ * The message expansion and the round function both use unkeyed AES rounds,
+ * which are a single AESENC with a zero key.
+ */
+namespace shavite {
+
+alignas(__m128i) const uint32_t IV[16] = {
+    0x72FCCDD8, 0x79CA4727, 0x128A077B, 0x40D55AEC,
+    0xD1901A06, 0x430AE307, 0xB29F5CD1, 0xDF07FBFC,
+    0x8E45D73D, 0x681AB538, 0xBDE86578, 0xDD577E47,
+    0xE275EADE, 0x502D9FCD, 0xB9357178, 0x022A4B9A
+};
+
+void Hash64(unsigned char* out, const unsigned char* in)
+{
+    unsigned char block[128] = {0};
+    memcpy(block, in, 64);
+    block[64] = 0x80;
+    block[110] = 0x00; // message length in bits (512), little-endian
+    block[111] = 0x02;
+    block[126] = 0x00; // output size (512), little-endian
+    block[127] = 0x02;
+
+    // Counter words are (512, 0, 0, 0); each injection permutes them and
+    // complements the last one.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i cnt0 = _mm_set_epi32(~0, 0, 0, 512);
+    const __m128i cnt1 = _mm_set_epi32(~512, 0, 0, 0);
+    const __m128i cnt2 = _mm_set_epi32(~0, 512, 0, 0);
+    const __m128i cnt3 = _mm_set_epi32(~0, 0, 512, 0);
+
+    __m128i rk[112];
+    for (int i = 0; i < 8; ++i) rk[i] = _mm_loadu_si128((const __m128i*)(block + 16 * i));
+    int k = 8;
+    for (;;) {
+        for (int s = 0; s < 8; ++s, ++k) {
+            rk[k] = _mm_xor_si128(_mm_aesenc_si128(_mm_shuffle_epi32(rk[k - 8], 0x39), zero), rk[k - 1]);
+            if (k == 8) {
+                rk[k] = _mm_xor_si128(rk[k], cnt0);
+            } else if (k == 41) {
+                rk[k] = _mm_xor_si128(rk[k], cnt1);
+            } else if (k == 79) {
+                rk[k] = _mm_xor_si128(rk[k], cnt2);
+            } else if (k == 110) {
+                rk[k] = _mm_xor_si128(rk[k], cnt3);
+            }
+        }
+        if (k == 112) break;
+        for (int s = 0; s < 8; ++s, ++k) {
+            rk[k] = _mm_xor_si128(rk[k - 8], _mm_alignr_epi8(rk[k - 1], rk[k - 2], 4));
+        }
+    }
+
+    __m128i h[4], p[4];
+    for (int i = 0; i < 4; ++i) h[i] = p[i] = _mm_load_si128((const __m128i*)(IV + 4 * i));
+
+    const __m128i* key = rk;
+    for (int r = 0; r < 14; ++r) {
+        for (int half = 0; half < 4; half += 2) {
+            __m128i x = _mm_xor_si128(p[half + 1], *key++);
+            x = _mm_aesenc_si128(x, zero);
+            x = _mm_aesenc_si128(_mm_xor_si128(x, *key++), zero);
+            x = _mm_aesenc_si128(_mm_xor_si128(x, *key++), zero);
+            x = _mm_aesenc_si128(_mm_xor_si128(x, *key++), zero);
+            p[half] = _mm_xor_si128(p[half], x);
+        }
+        const __m128i t = p[3];
+        p[3] = p[2];
+        p[2] = p[1];
+        p[1] = p[0];
+        p[0] = t;
+    }
+
+    for (int i = 0; i < 4; ++i) _mm_storeu_si128((__m128i*)(out + 16 * i), _mm_xor_si128(h[i], p[i]));
+}
+
+} // namespace shavite
+
+} // namespace
+
+namespace groestl512_aesni {
+void Hash64(unsigned char* out, const unsigned char* in) { groestl::Hash64(out, in); }
+}
+
+namespace echo512_aesni {
+void Hash64(unsigned char* out, const unsigned char* in) { echo::Hash64(out, in); }
+}
+
+namespace shavite512_aesni {
+void Hash64(unsigned char* out, const unsigned char* in) { shavite::Hash64(out, in); }
+}
+
+#endif
@@ -97,13 +97,59 @@ static void SetMaxOpenFiles(leveldb::Options *options) {
              options->max_open_files, default_open_files);
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+bool ApplyDBOptionArgs(const ArgsManager& args, const std::string& db, DBOptions& options, std::string& error)
+{
+    for (const std::string& arg : args.GetArgs("-dboption")) {
+        const size_t colon = arg.find(':');
+        const size_t equals = arg.find('=', colon == std::string::npos ? 0 : colon);
+        if (colon == std::string::npos || equals == std::string::npos) {
+            error = strprintf("Invalid -dboption '%s', expected <db>:<key>=<value>", arg);
+            return false;
+        }
+        if (arg.substr(0, colon) != db) continue;
+        const std::string key = arg.substr(colon + 1, equals - colon - 1);
+        const std::string value = arg.substr(equals + 1);
+        uint64_t n;
+        if (!ParseUInt64(value, &n)) {
+            error = strprintf("Invalid value in -dboption '%s'", arg);
+            return false;
+        }
+        if (key == "blocksize" && n > 0) {
+            options.block_size = n;
+        } else if (key == "bloombits" && n <= 64) {
+            options.bloom_bits = n;
+        } else if (key == "writebuffer") {
+            options.write_buffer_size = n;
+        } else if (key == "compression" && n <= 1) {
+            options.compression = n;
+        } else if (key == "maxfilesize" && n > 0) {
+            options.max_file_size = n;
+        } else {
+            error = strprintf("Invalid -dboption '%s', keys are blocksize, bloombits (0-64), writebuffer, compression (0 or 1) and maxfilesize", arg);
+            return false;
+        }
+    }
+    return true;
+}
+
+DBOptions GetDBOptions(const std::string& db)
+{
+    DBOptions options;
+    std::string error;
+    ApplyDBOptionArgs(gArgs, db, options, error);
+    return options;
+}
+
+static leveldb::Options GetOptions(size_t nCacheSize, const DBOptions& db_options)
 {
     leveldb::Options options;
     options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
-    options.compression = leveldb::kNoCompression;
+    // up to two write buffers may be held in memory simultaneously
+    options.write_buffer_size = db_options.write_buffer_size ? db_options.write_buffer_size : nCacheSize / 4;
+    options.block_size = db_options.block_size;
+    options.max_file_size = db_options.max_file_size;
+    options.filter_policy = db_options.bloom_bits ? leveldb::NewBloomFilterPolicy(db_options.bloom_bits) : nullptr;
+    options.compression = db_options.compression ? leveldb::kSnappyCompression : leveldb::kNoCompression;
     options.info_log = new CBitcoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
         // LevelDB versions before 1.16 consider short writes to be corruption. Only trigger error
@@ -114,7 +160,7 @@ static leveldb::Options GetOptions(size_t nCacheSize)
     return options;
 }
 
-CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate)
+CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate, const DBOptions& db_options)
     : m_name{path.stem().string()}
 {
     penv = nullptr;
@@ -122,7 +168,7 @@ CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bo
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    options = GetOptions(nCacheSize, db_options);
     options.create_if_missing = true;
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -139,6 +185,8 @@ CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bo
     leveldb::Status status = leveldb::DB::Open(options, path.string(), &pdb);
     dbwrapper_private::HandleError(status);
     LogPrintf("Opened LevelDB successfully\n");
+    LogPrint(BCLog::LEVELDB, "LevelDB options for %s: blocksize=%u bloombits=%d writebuffer=%u compression=%d maxfilesize=%u\n",
+             m_name, options.block_size, db_options.bloom_bits, options.write_buffer_size, db_options.compression, options.max_file_size);
 
     if (gArgs.GetBoolArg("-forcecompactdb", false)) {
         LogPrintf("Starting database compaction of %s\n", path.string());
@@ -26,6 +26,39 @@ public:
 
 class CDBWrapper;
 
+/**
+ * LevelDB tuning for one database. The defaults are what every database
+ * used before the settings became adjustable; -dboption overrides them per
+ * database.
+ */
+struct DBOptions {
+    //! Approximate amount of data packed into one table block (bytes).
+    //! Smaller blocks make point lookups read and decode less.
+    size_t block_size{4 << 10};
+    //! Bloom filter bits per key; 0 disables the filter
+    int bloom_bits{10};
+    //! Size of the write buffer (bytes); 0 for a quarter of the cache size
+    size_t write_buffer_size{0};
+    //! Compress table blocks with snappy (a no-op when leveldb is built
+    //! without snappy, as the bundled copy is)
+    bool compression{false};
+    //! Table file size at which leveldb starts a new file (bytes)
+    size_t max_file_size{2 << 20};
+};
+
+/**
+ * Apply the -dboption=<db>:<key>=<value> arguments that name db to options.
+ * Arguments for other databases are skipped. Returns false, with a message
+ * in error, if one of the arguments for db is malformed.
+ */
+bool ApplyDBOptionArgs(const ArgsManager& args, const std::string& db, DBOptions& options, std::string& error);
+
+/**
+ * DBOptions for db from the defaults and -dboption. Malformed arguments are
+ * rejected at startup, so they are ignored here.
+ */
+DBOptions GetDBOptions(const std::string& db);
+
 /** These should be considered an implementation detail of the specific database.
  */
 namespace dbwrapper_private {
@@ -219,8 +252,9 @@ public:
      * @param[in] fWipe       If true, remove all existing data.
      * @param[in] obfuscate   If true, store data obfuscated via simple XOR. If false, XOR
      *                        with a zero'd byte array.
+     * @param[in] db_options  LevelDB tuning for this database.
      */
-    CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false);
+    CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false, const DBOptions& db_options = {});
     ~CDBWrapper();
 
     CDBWrapper(const CDBWrapper&) = delete;
@@ -40,6 +40,7 @@
 #include "crypto/sph_panama.h"
 #include "crypto/lane.h"
 #include "crypto/blake2s.h"
+#include "crypto/x11_aes.h"
 
 #include <string>
 #include <vector>
@@ -280,15 +281,12 @@ inline uint256 HashX22I(const T1 pbegin, const T1 pend)
 {
     sph_blake512_context      ctx_blake;
     sph_bmw512_context        ctx_bmw;
-    sph_groestl512_context    ctx_groestl;
     sph_jh512_context         ctx_jh;
     sph_keccak512_context     ctx_keccak;
     sph_skein512_context      ctx_skein;
     sph_luffa512_context      ctx_luffa;
     sph_cubehash512_context   ctx_cubehash;
-    sph_shavite512_context    ctx_shavite;
     sph_simd512_context       ctx_simd;
-    sph_echo512_context       ctx_echo;
     sph_hamsi512_context      ctx_hamsi;
     sph_fugue512_context      ctx_fugue;
     sph_shabal512_context     ctx_shabal;
@@ -309,9 +307,7 @@ inline uint256 HashX22I(const T1 pbegin, const T1 pend)
     sph_bmw512 (&ctx_bmw, static_cast<const void*>(&hash[0]), 64);
     sph_bmw512_close(&ctx_bmw, static_cast<void*>(&hash[1]));
 
-    sph_groestl512_init(&ctx_groestl);
-        sph_groestl512 (&ctx_groestl, static_cast<const void*>(&hash[1]), 64);
-    sph_groestl512_close(&ctx_groestl, static_cast<void*>(&hash[2]));
+    Groestl512_64(hash[2].begin(), hash[1].begin());
 
     sph_skein512_init(&ctx_skein);
     sph_skein512 (&ctx_skein, static_cast<const void*>(&hash[2]), 64);
@@ -333,17 +329,13 @@ inline uint256 HashX22I(const T1 pbegin, const T1 pend)
     sph_cubehash512 (&ctx_cubehash, static_cast<const void*>(&hash[6]), 64);
     sph_cubehash512_close(&ctx_cubehash, static_cast<void*>(&hash[7]));
 
-    sph_shavite512_init(&ctx_shavite);
-    sph_shavite512(&ctx_shavite, static_cast<const void*>(&hash[7]), 64);
-    sph_shavite512_close(&ctx_shavite, static_cast<void*>(&hash[8]));
+    Shavite512_64(hash[8].begin(), hash[7].begin());
 
     sph_simd512_init(&ctx_simd);
     sph_simd512 (&ctx_simd, static_cast<const void*>(&hash[8]), 64);
     sph_simd512_close(&ctx_simd, static_cast<void*>(&hash[9]));
 
-    sph_echo512_init(&ctx_echo);
-    sph_echo512 (&ctx_echo, static_cast<const void*>(&hash[9]), 64);
-    sph_echo512_close(&ctx_echo, static_cast<void*>(&hash[10]));
+    Echo512_64(hash[10].begin(), hash[9].begin());
 
     sph_hamsi512_init(&ctx_hamsi);
     sph_hamsi512 (&ctx_hamsi, static_cast<const void*>(&hash[10]), 64);
@@ -399,15 +391,12 @@ inline uint256 HashX25X(const T1 pbegin, const T1 pend)
 {
     sph_blake512_context      ctx_blake;
     sph_bmw512_context        ctx_bmw;
-    sph_groestl512_context    ctx_groestl;
     sph_jh512_context         ctx_jh;
     sph_keccak512_context     ctx_keccak;
     sph_skein512_context      ctx_skein;
     sph_luffa512_context      ctx_luffa;
     sph_cubehash512_context   ctx_cubehash;
-    sph_shavite512_context    ctx_shavite;
     sph_simd512_context       ctx_simd;
-    sph_echo512_context       ctx_echo;
     sph_hamsi512_context      ctx_hamsi;
     sph_fugue512_context      ctx_fugue;
     sph_shabal512_context     ctx_shabal;
@@ -429,9 +418,7 @@ inline uint256 HashX25X(const T1 pbegin, const T1 pend)
     sph_bmw512 (&ctx_bmw, static_cast<const void*>(&hash[0]), 64);
     sph_bmw512_close(&ctx_bmw, static_cast<void*>(&hash[1]));
 
-    sph_groestl512_init(&ctx_groestl);
-        sph_groestl512 (&ctx_groestl, static_cast<const void*>(&hash[1]), 64);
-    sph_groestl512_close(&ctx_groestl, static_cast<void*>(&hash[2]));
+    Groestl512_64(hash[2].begin(), hash[1].begin());
 
     sph_skein512_init(&ctx_skein);
     sph_skein512 (&ctx_skein, static_cast<const void*>(&hash[2]), 64);
@@ -453,17 +440,13 @@ inline uint256 HashX25X(const T1 pbegin, const T1 pend)
     sph_cubehash512 (&ctx_cubehash, static_cast<const void*>(&hash[6]), 64);
     sph_cubehash512_close(&ctx_cubehash, static_cast<void*>(&hash[7]));
 
-    sph_shavite512_init(&ctx_shavite);
-    sph_shavite512(&ctx_shavite, static_cast<const void*>(&hash[7]), 64);
-    sph_shavite512_close(&ctx_shavite, static_cast<void*>(&hash[8]));
+    Shavite512_64(hash[8].begin(), hash[7].begin());
 
     sph_simd512_init(&ctx_simd);
     sph_simd512 (&ctx_simd, static_cast<const void*>(&hash[8]), 64);
     sph_simd512_close(&ctx_simd, static_cast<void*>(&hash[9]));
 
-    sph_echo512_init(&ctx_echo);
-    sph_echo512 (&ctx_echo, static_cast<const void*>(&hash[9]), 64);
-    sph_echo512_close(&ctx_echo, static_cast<void*>(&hash[10]));
+    Echo512_64(hash[10].begin(), hash[9].begin());
 
     sph_hamsi512_init(&ctx_hamsi);
     sph_hamsi512 (&ctx_hamsi, static_cast<const void*>(&hash[10]), 64);
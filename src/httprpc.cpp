@@ -7,6 +7,8 @@
 #include <chainparams.h>
 #include <crypto/hmac_sha256.h>
 #include <httpserver.h>
+#include <node/ui_interface.h>
+#include <rpc/jsonstream.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <util/strencodings.h>
@@ -71,6 +73,12 @@ static std::unique_ptr<HTTPRPCTimerInterface> httpRPCTimerInterface;
 /* RPC Auth Whitelist */
 static std::map<std::string, std::set<std::string>> g_rpc_whitelist;
 static bool g_rpc_whitelist_default = false;
+/* Number of extra worker threads a batch may use for parallel_safe calls */
+static size_t g_rpc_batch_threads = 0;
+/* Work queue priority of the methods that are not NORMAL */
+static std::map<std::string, HTTPWorkPriority> g_rpc_method_priority;
+/* Longest request body that is parsed to pick a priority */
+static const size_t MAX_CLASSIFIED_BODY_SIZE = 16 * 1024;
 
 static void JSONErrorReply(HTTPRequest* req, const UniValue& objError, const UniValue& id)
 {
@@ -204,10 +212,52 @@ static bool HTTPReq_JSONRPC(const util::Ref& context, HTTPRequest* req)
                 req->WriteReply(HTTP_FORBIDDEN);
                 return false;
             }
-            UniValue result = tableRPC.execute(jreq);
+            // Methods that support it write large results to a stream instead
+            // of returning them. Once the stream outgrows its buffer, the
+            // reply is sent in chunks while the result is still being written.
+            bool chunked = false;
+            JSONStreamWriter stream([req, &chunked](Span<const unsigned char> chunk) {
+                if (!chunked) {
+                    req->WriteHeader("Content-Type", "application/json");
+                    req->StartChunkedReply(HTTP_OK);
+                    chunked = true;
+                }
+                req->WriteChunk(chunk);
+            });
+            stream.BeginObject();
+            stream.Key("result");
+            jreq.result_stream = &stream;
+
+            UniValue result;
+            try {
+                result = tableRPC.execute(jreq);
+            } catch (...) {
+                // Once part of the result has been sent, an error can no
+                // longer be reported; the client sees an incomplete body.
+                if (chunked) {
+                    LogPrintf("RPC method %s failed while streaming its result\n", jreq.strMethod);
+                    req->EndChunkedReply();
+                    return false;
+                }
+                throw;
+            }
 
-            // Send reply
-            strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            if (stream.ExpectsValue()) {
+                // Send reply
+                strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            } else {
+                stream.KeyValue("error", NullUniValue);
+                stream.KeyValue("id", jreq.id);
+                stream.EndObject();
+                if (chunked) {
+                    stream.Flush();
+                    const std::string newline{"\n"};
+                    req->WriteChunk(MakeUCharSpan(newline));
+                    req->EndChunkedReply();
+                    return true;
+                }
+                strReply = stream.Buffer() + "\n";
+            }
 
         // array of requests
         } else if (valRequest.isArray()) {
@@ -227,7 +277,8 @@ static bool HTTPReq_JSONRPC(const util::Ref& context, HTTPRequest* req)
                     }
                 }
             }
-            strReply = JSONRPCExecBatch(jreq, valRequest.get_array());
+            const auto dispatcher = [req](std::function<void()> task) { return HTTPEnqueueWork(std::move(task), req->GetPriority()); };
+            strReply = JSONRPCExecBatch(jreq, valRequest.get_array(), dispatcher, g_rpc_batch_threads);
         }
         else
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
@@ -284,16 +335,88 @@ static bool InitRPCAuthentication()
     return true;
 }
 
+bool ParseRPCMethodPriorities(const std::vector<std::string>& specs, std::map<std::string, HTTPWorkPriority>& priorities, std::string& invalid)
+{
+    priorities.clear();
+    // Cheap status calls that monitoring polls, and calls that walk the
+    // whole chain or UTXO set.
+    for (const char* method : {"getbestblockhash", "getblockchaininfo", "getblockcount", "getconnectioncount", "getmempoolinfo", "getnetworkinfo", "getrpcinfo", "ping", "uptime"}) {
+        priorities[method] = HTTPWorkPriority::HIGH;
+    }
+    for (const char* method : {"dumptxoutset", "getblockstats", "gettxoutsetinfo", "rescanblockchain", "scantxoutset", "verifychain"}) {
+        priorities[method] = HTTPWorkPriority::LOW;
+    }
+
+    for (const std::string& spec : specs) {
+        const auto pos = spec.find(':');
+        HTTPWorkPriority priority;
+        if (pos == std::string::npos || !ParseHTTPWorkPriority(spec.substr(0, pos), priority)) {
+            invalid = spec;
+            return false;
+        }
+        const std::string method_list = spec.substr(pos + 1);
+        std::vector<std::string> methods;
+        boost::split(methods, method_list, boost::is_any_of(", "));
+        for (const std::string& method : methods) {
+            if (!method.empty()) priorities[method] = priority;
+        }
+    }
+    return true;
+}
+
+static bool InitRPCMethodPriorities()
+{
+    std::string invalid;
+    if (!ParseRPCMethodPriorities(gArgs.GetArgs("-rpcmethodpriority"), g_rpc_method_priority, invalid)) {
+        uiInterface.ThreadSafeMessageBox(
+            strprintf(Untranslated("Invalid -rpcmethodpriority specification: %s. Expected <priority>:<method>,... with priority high, normal or low."), invalid),
+            "", CClientUIInterface::MSG_ERROR);
+        return false;
+    }
+    return true;
+}
+
+static HTTPWorkPriority RPCMethodPriority(const UniValue& request)
+{
+    const UniValue& method = find_value(request, "method");
+    if (!method.isStr()) return HTTPWorkPriority::NORMAL;
+    const auto it = g_rpc_method_priority.find(method.get_str());
+    return it == g_rpc_method_priority.end() ? HTTPWorkPriority::NORMAL : it->second;
+}
+
+/** Queue a request by the priority of its method. A batch takes the least
+ * urgent priority of its calls. Large bodies are not parsed here, on the event
+ * loop thread, and are queued as NORMAL. */
+static HTTPWorkPriority ClassifyJSONRPC(HTTPRequest* req)
+{
+    UniValue request;
+    if (!request.read(req->PeekBody(MAX_CLASSIFIED_BODY_SIZE))) return HTTPWorkPriority::NORMAL;
+    if (request.isObject()) return RPCMethodPriority(request);
+    if (!request.isArray() || request.empty()) return HTTPWorkPriority::NORMAL;
+    HTTPWorkPriority priority = HTTPWorkPriority::HIGH;
+    for (size_t i = 0; i < request.size(); ++i) {
+        priority = std::max(priority, RPCMethodPriority(request[i]));
+    }
+    return priority;
+}
+
 bool StartHTTPRPC(const util::Ref& context)
 {
     LogPrint(BCLog::RPC, "Starting HTTP RPC server\n");
     if (!InitRPCAuthentication())
         return false;
+    if (!InitRPCMethodPriorities())
+        return false;
+
+    g_rpc_batch_threads = std::max<int64_t>(gArgs.GetArg("-rpcbatchthreads", DEFAULT_RPC_BATCH_THREADS), 0);
+    if (g_rpc_batch_threads > 0) {
+        LogPrintf("Executing read-only calls in JSON-RPC batches on up to %u additional threads\n", g_rpc_batch_threads);
+    }
 
     auto handle_rpc = [&context](HTTPRequest* req, const std::string&) { return HTTPReq_JSONRPC(context, req); };
-    RegisterHTTPHandler("/", true, handle_rpc);
+    RegisterHTTPHandler("/", true, handle_rpc, ClassifyJSONRPC);
     if (g_wallet_init_interface.HasWalletSupport()) {
-        RegisterHTTPHandler("/wallet/", false, handle_rpc);
+        RegisterHTTPHandler("/wallet/", false, handle_rpc, ClassifyJSONRPC);
     }
     struct event_base* eventBase = EventBase();
     assert(eventBase);
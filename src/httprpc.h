@@ -5,10 +5,26 @@
 #ifndef BITCOIN_HTTPRPC_H
 #define BITCOIN_HTTPRPC_H
 
+#include <map>
+#include <string>
+#include <vector>
+
+/** Default number of extra HTTP worker threads a JSON-RPC batch may use */
+static const int DEFAULT_RPC_BATCH_THREADS = 0;
+
+enum class HTTPWorkPriority;
+
 namespace util {
 class Ref;
 } // namespace util
 
+/** Work queue priority of each JSON-RPC method that is not NORMAL: defaults
+ * for cheap status calls and for calls that walk the chain or UTXO set, with
+ * -rpcmethodpriority specifications (<priority>:<method>,...) applied.
+ * Returns false with the offending specification in invalid.
+ */
+bool ParseRPCMethodPriorities(const std::vector<std::string>& specs, std::map<std::string, HTTPWorkPriority>& priorities, std::string& invalid);
+
 /** Start HTTP RPC subsystem.
  * Precondition; HTTP and RPC has been started.
  */
@@ -6,6 +6,7 @@
 
 #include <chainparamsbase.h>
 #include <compat.h>
+#include <httpworkqueue.h>
 #include <netbase.h>
 #include <node/ui_interface.h>
 #include <rpc/protocol.h> // For HTTP status codes
@@ -14,8 +15,10 @@
 #include <util/strencodings.h>
 #include <util/system.h>
 #include <util/threadnames.h>
+#include <util/time.h>
 #include <util/translation.h>
 
+#include <algorithm>
 #include <deque>
 #include <memory>
 #include <stdio.h>
@@ -63,76 +66,32 @@ private:
     HTTPRequestHandler func;
 };
 
-/** Simple work queue for distributing work over multiple threads.
- * Work items are simply callable objects.
- */
-template <typename WorkItem>
-class WorkQueue
+/** Work item for a task queued by a request handler */
+class HTTPWorkFunction final : public HTTPClosure
 {
-private:
-    /** Mutex protects entire object */
-    Mutex cs;
-    std::condition_variable cond;
-    std::deque<std::unique_ptr<WorkItem>> queue;
-    bool running;
-    size_t maxDepth;
-
 public:
-    explicit WorkQueue(size_t _maxDepth) : running(true),
-                                 maxDepth(_maxDepth)
-    {
-    }
-    /** Precondition: worker threads have all stopped (they have been joined).
-     */
-    ~WorkQueue()
+    explicit HTTPWorkFunction(std::function<void()> _func) : func(std::move(_func))
     {
     }
-    /** Enqueue a work item */
-    bool Enqueue(WorkItem* item)
-    {
-        LOCK(cs);
-        if (queue.size() >= maxDepth) {
-            return false;
-        }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
-        cond.notify_one();
-        return true;
-    }
-    /** Thread function */
-    void Run()
-    {
-        while (true) {
-            std::unique_ptr<WorkItem> i;
-            {
-                WAIT_LOCK(cs, lock);
-                while (running && queue.empty())
-                    cond.wait(lock);
-                if (!running)
-                    break;
-                i = std::move(queue.front());
-                queue.pop_front();
-            }
-            (*i)();
-        }
-    }
-    /** Interrupt and exit loops */
-    void Interrupt()
+    void operator()() override
     {
-        LOCK(cs);
-        running = false;
-        cond.notify_all();
+        func();
     }
+
+private:
+    std::function<void()> func;
 };
 
 struct HTTPPathHandler
 {
-    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler):
-        prefix(_prefix), exactMatch(_exactMatch), handler(_handler)
+    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler, HTTPPriorityClassifier _classifier):
+        prefix(_prefix), exactMatch(_exactMatch), handler(_handler), classifier(_classifier)
     {
     }
     std::string prefix;
     bool exactMatch;
     HTTPRequestHandler handler;
+    HTTPPriorityClassifier classifier;
 };
 
 /** HTTP module state */
@@ -210,6 +169,60 @@ std::string RequestMethodString(HTTPRequest::RequestMethod m)
     }
 }
 
+std::string HTTPWorkPriorityName(HTTPWorkPriority priority)
+{
+    switch (priority) {
+    case HTTPWorkPriority::HIGH: return "high";
+    case HTTPWorkPriority::NORMAL: return "normal";
+    case HTTPWorkPriority::LOW: return "low";
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
+bool ParseHTTPWorkPriority(const std::string& name, HTTPWorkPriority& priority)
+{
+    for (size_t i = 0; i < NUM_HTTP_WORK_PRIORITIES; ++i) {
+        if (name == HTTPWorkPriorityName(static_cast<HTTPWorkPriority>(i))) {
+            priority = static_cast<HTTPWorkPriority>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseHTTPWorkThreads(size_t rpc_threads, const std::vector<std::string>& specs, HTTPWorkThreadLimits& limits, std::string& invalid)
+{
+    auto& max_threads = limits.per_class;
+    max_threads[static_cast<size_t>(HTTPWorkPriority::HIGH)] = rpc_threads;
+    max_threads[static_cast<size_t>(HTTPWorkPriority::NORMAL)] = std::max<size_t>(rpc_threads - 1, 1);
+    max_threads[static_cast<size_t>(HTTPWorkPriority::LOW)] = std::max<size_t>(rpc_threads / 2, 1);
+    limits.below_high = std::max<size_t>(rpc_threads - 1, 1);
+    for (const std::string& spec : specs) {
+        const auto pos = spec.find(':');
+        HTTPWorkPriority priority;
+        int64_t n;
+        if (pos == std::string::npos || !ParseHTTPWorkPriority(spec.substr(0, pos), priority) || !ParseInt64(spec.substr(pos + 1), &n) || n < 1) {
+            invalid = spec;
+            return false;
+        }
+        max_threads[static_cast<size_t>(priority)] = std::min<size_t>(n, rpc_threads);
+    }
+    return true;
+}
+
+static bool InitHTTPWorkThreads(HTTPWorkThreadLimits& limits)
+{
+    const size_t rpc_threads = std::max((long)gArgs.GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
+    std::string invalid;
+    if (!ParseHTTPWorkThreads(rpc_threads, gArgs.GetArgs("-rpcworkthreads"), limits, invalid)) {
+        uiInterface.ThreadSafeMessageBox(
+            strprintf(Untranslated("Invalid -rpcworkthreads specification: %s. Expected <priority>:<n> with priority high, normal or low, and n at least 1."), invalid),
+            "", CClientUIInterface::MSG_ERROR);
+        return false;
+    }
+    return true;
+}
+
 /** HTTP request callback */
 static void http_request_cb(struct evhttp_request* req, void* arg)
 {
@@ -263,12 +276,14 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
 
     // Dispatch to worker thread
     if (i != iend) {
+        const HTTPWorkPriority priority = i->classifier ? i->classifier(hreq.get()) : HTTPWorkPriority::NORMAL;
+        hreq->SetPriority(priority);
         std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler));
         assert(workQueue);
-        if (workQueue->Enqueue(item.get()))
+        if (workQueue->Enqueue(item.get(), priority))
             item.release(); /* if true, queue took ownership */
         else {
-            LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
+            LogPrintf("WARNING: request rejected because http work queue depth exceeded for %s priority, it can be increased with the -rpcworkqueue= setting\n", HTTPWorkPriorityName(priority));
             item->req->WriteReply(HTTP_INTERNAL_SERVER_ERROR, "Work queue depth exceeded");
         }
     } else {
@@ -361,6 +376,10 @@ bool InitHTTPServer()
     if (!InitHTTPAllowList())
         return false;
 
+    HTTPWorkThreadLimits thread_limits;
+    if (!InitHTTPWorkThreads(thread_limits))
+        return false;
+
     // Redirect libevent's logging to our own log
     event_set_log_callback(&libevent_log_cb);
     // Update libevent's log handling. Returns false if our version of
@@ -400,7 +419,11 @@ bool InitHTTPServer()
     int workQueueDepth = std::max((long)gArgs.GetArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
     LogPrintf("HTTP: creating work queue of depth %d\n", workQueueDepth);
 
-    workQueue = new WorkQueue<HTTPClosure>(workQueueDepth);
+    workQueue = new WorkQueue<HTTPClosure>(workQueueDepth, thread_limits);
+    for (size_t i = 0; i < NUM_HTTP_WORK_PRIORITIES; ++i) {
+        LogPrint(BCLog::HTTP, "HTTP: %s priority work may use %d threads\n", HTTPWorkPriorityName(static_cast<HTTPWorkPriority>(i)), thread_limits.per_class[i]);
+    }
+    LogPrint(BCLog::HTTP, "HTTP: normal and low priority work may use %d threads together\n", thread_limits.below_high);
     // transfer ownership to eventBase/HTTP via .release()
     eventBase = base_ctr.release();
     eventHTTP = http_ctr.release();
@@ -480,6 +503,21 @@ void StopHTTPServer()
     LogPrint(BCLog::HTTP, "Stopped HTTP server\n");
 }
 
+bool HTTPEnqueueWork(std::function<void()> work, HTTPWorkPriority priority)
+{
+    assert(workQueue);
+    std::unique_ptr<HTTPWorkFunction> item(new HTTPWorkFunction(std::move(work)));
+    if (!workQueue->Enqueue(item.get(), priority)) return false;
+    item.release(); /* queue took ownership */
+    return true;
+}
+
+std::vector<HTTPWorkQueueStats> GetHTTPWorkQueueStats()
+{
+    if (!workQueue) return {};
+    return workQueue->Stats();
+}
+
 struct event_base* EventBase()
 {
     return eventBase;
@@ -517,7 +555,11 @@ HTTPRequest::HTTPRequest(struct evhttp_request* _req, bool _replySent) : req(_re
 
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (!replySent && m_chunked) {
+        // A chunked reply that was not finished; the body is incomplete.
+        LogPrintf("%s: Unfinished chunked reply\n", __func__);
+        EndChunkedReply();
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL_SERVER_ERROR, "Unhandled request");
@@ -556,6 +598,20 @@ std::string HTTPRequest::ReadBody()
     return rv;
 }
 
+std::string HTTPRequest::PeekBody(size_t max_size) const
+{
+    struct evbuffer* buf = evhttp_request_get_input_buffer(req);
+    if (!buf)
+        return "";
+    const size_t size = evbuffer_get_length(buf);
+    if (size > max_size)
+        return "";
+    std::string rv(size, '\0');
+    if (evbuffer_copyout(buf, &rv[0], size) != (ev_ssize_t)size)
+        return "";
+    return rv;
+}
+
 void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
 {
     struct evkeyvalq* headers = evhttp_request_get_output_headers(req);
@@ -568,16 +624,16 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
  * Replies must be sent in the main loop in the main http thread,
  * this cannot be done from worker threads.
  */
-void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
+void HTTPRequest::WriteReply(int nStatus, Span<const unsigned char> reply)
 {
-    assert(!replySent && req);
+    assert(!replySent && !m_chunked && req);
     if (ShutdownRequested()) {
         WriteHeader("Connection", "close");
     }
     // Send event to main http thread to send reply message
     struct evbuffer* evb = evhttp_request_get_output_buffer(req);
     assert(evb);
-    evbuffer_add(evb, strReply.data(), strReply.size());
+    evbuffer_add(evb, reply.data(), reply.size());
     auto req_copy = req;
     HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
@@ -598,6 +654,60 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = nullptr; // transferred back to main thread
 }
 
+void HTTPRequest::StartChunkedReply(int nStatus)
+{
+    assert(!replySent && !m_chunked && req);
+    if (ShutdownRequested()) {
+        WriteHeader("Connection", "close");
+    }
+    m_chunked = true;
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
+        evhttp_send_reply_start(req_copy, nStatus, nullptr);
+    });
+    ev->trigger(nullptr);
+}
+
+void HTTPRequest::WriteChunk(Span<const unsigned char> chunk)
+{
+    assert(m_chunked && req);
+    if (chunk.empty()) return;
+    // The data is copied here, in the worker thread; the buffer is passed on
+    // to the main http thread and freed there. Events run in the order they
+    // were triggered, so chunks arrive in order.
+    struct evbuffer* evb = evbuffer_new();
+    assert(evb);
+    evbuffer_add(evb, chunk.data(), chunk.size());
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, evb]{
+        evhttp_send_reply_chunk(req_copy, evb);
+        evbuffer_free(evb);
+    });
+    ev->trigger(nullptr);
+}
+
+void HTTPRequest::EndChunkedReply()
+{
+    assert(m_chunked && req);
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy]{
+        evhttp_send_reply_end(req_copy);
+        // Re-enable reading from the socket, see WriteReply.
+        if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
+            evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+            if (conn) {
+                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+                if (bev) {
+                    bufferevent_enable(bev, EV_READ | EV_WRITE);
+                }
+            }
+        }
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
 CService HTTPRequest::GetPeer() const
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
@@ -638,10 +748,10 @@ HTTPRequest::RequestMethod HTTPRequest::GetRequestMethod() const
     }
 }
 
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPPriorityClassifier& classifier)
 {
     LogPrint(BCLog::HTTP, "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
-    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler));
+    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler, classifier));
 }
 
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
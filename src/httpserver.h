@@ -5,8 +5,13 @@
 #ifndef BITCOIN_HTTPSERVER_H
 #define BITCOIN_HTTPSERVER_H
 
-#include <string>
+#include <span.h>
+
+#include <array>
 #include <functional>
+#include <stdint.h>
+#include <string>
+#include <vector>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
@@ -35,16 +40,76 @@ void StopHTTPServer();
  * libevent doesn't support debug logging.*/
 bool UpdateHTTPServerLogging(bool enable);
 
+/** Priority class of queued HTTP work. Each class has its own queue of depth
+ * -rpcworkqueue and a limit on how many worker threads may run it at once. An
+ * idle worker takes the oldest item of the most urgent class below its limit,
+ * so cheap calls are not stuck behind, or rejected because of, slow ones.
+ */
+enum class HTTPWorkPriority {
+    HIGH,
+    NORMAL,
+    LOW,
+};
+static constexpr size_t NUM_HTTP_WORK_PRIORITIES = 3;
+
+/** Thread limits of the HTTP work queue */
+struct HTTPWorkThreadLimits {
+    /** How many threads may run each priority class at once */
+    std::array<size_t, NUM_HTTP_WORK_PRIORITIES> per_class;
+    /** How many threads may run NORMAL and LOW work at once, together */
+    size_t below_high;
+};
+
+std::string HTTPWorkPriorityName(HTTPWorkPriority priority);
+bool ParseHTTPWorkPriority(const std::string& name, HTTPWorkPriority& priority);
+
+/** Thread limits for rpc_threads worker threads, with -rpcworkthreads
+ * specifications (<priority>:<n>) applied. By default HIGH may use every
+ * thread, NORMAL all but one and LOW half. NORMAL and LOW together never use
+ * more than all but one either, so with two or more threads one is always
+ * left for HIGH. Returns false with the offending specification in invalid.
+ */
+bool ParseHTTPWorkThreads(size_t rpc_threads, const std::vector<std::string>& specs, HTTPWorkThreadLimits& limits, std::string& invalid);
+
 /** Handler for requests to a certain HTTP path */
 typedef std::function<bool(HTTPRequest* req, const std::string &)> HTTPRequestHandler;
+/** Picks the priority of a request before it is queued. This runs on the
+ * event loop thread, so it has to be cheap.
+ */
+typedef std::function<HTTPWorkPriority(HTTPRequest* req)> HTTPPriorityClassifier;
 /** Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
- * be invoked.
+ * be invoked. Requests are queued as NORMAL unless a classifier is given.
  */
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler);
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPPriorityClassifier& classifier = nullptr);
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
+/** Queue a task on the HTTP worker threads, for handlers that split up their
+ * own work. Returns false if the work queue is full.
+ */
+bool HTTPEnqueueWork(std::function<void()> work, HTTPWorkPriority priority = HTTPWorkPriority::NORMAL);
+
+/** Upper bounds, in microseconds, of the queue wait time histogram buckets.
+ * The last bucket counts everything that waited longer. */
+static constexpr std::array<int64_t, 6> HTTP_WORK_WAIT_BUCKETS_US{100, 1000, 10000, 100000, 1000000, 10000000};
+
+/** Snapshot of one priority class of the HTTP work queue */
+struct HTTPWorkQueueStats {
+    HTTPWorkPriority priority;
+    size_t max_threads;
+    size_t max_depth;
+    size_t running;
+    size_t queued;
+    uint64_t rejected;
+    /** Time between queueing and starting each item, over HTTP_WORK_WAIT_BUCKETS_US */
+    std::array<uint64_t, HTTP_WORK_WAIT_BUCKETS_US.size() + 1> wait_histogram;
+    int64_t total_wait_us;
+};
+
+/** Statistics for each priority class, most urgent first. Empty if the HTTP server is not running. */
+std::vector<HTTPWorkQueueStats> GetHTTPWorkQueueStats();
+
 /** Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
  */
@@ -58,6 +123,8 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    bool m_chunked{false};
+    HTTPWorkPriority m_priority{HTTPWorkPriority::NORMAL};
 
 public:
     explicit HTTPRequest(struct evhttp_request* req, bool replySent = false);
@@ -97,6 +164,16 @@ public:
      */
     std::string ReadBody();
 
+    /**
+     * Read request body without consuming it. Returns an empty string if the
+     * body is longer than max_size.
+     */
+    std::string PeekBody(size_t max_size) const;
+
+    /** Priority class the request was queued with. */
+    HTTPWorkPriority GetPriority() const { return m_priority; }
+    void SetPriority(HTTPWorkPriority priority) { m_priority = priority; }
+
     /**
      * Write output header.
      *
@@ -107,12 +184,28 @@ public:
     /**
      * Write HTTP reply.
      * nStatus is the HTTP status code to send.
-     * strReply is the body of the reply. Keep it empty to send a standard message.
+     * strReply or reply is the body of the reply. Keep it empty to send a standard message.
      *
      * @note Can be called only once. As this will give the request back to the
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
-    void WriteReply(int nStatus, const std::string& strReply = "");
+    void WriteReply(int nStatus, const std::string& strReply = "")
+    {
+        WriteReply(nStatus, MakeUCharSpan(strReply));
+    }
+    void WriteReply(int nStatus, Span<const unsigned char> reply);
+
+    /**
+     * Start a reply whose body is sent in chunks, with chunked transfer
+     * encoding where the client supports it. The body is handed over with
+     * WriteChunk and the reply is finished with EndChunkedReply, which gives
+     * the request back to the main thread like WriteReply does.
+     *
+     * @note Use either this or WriteReply, once.
+     */
+    void StartChunkedReply(int nStatus);
+    void WriteChunk(Span<const unsigned char> chunk);
+    void EndChunkedReply();
 };
 
 /** Event handler closure.
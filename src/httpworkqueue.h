@@ -0,0 +1,135 @@
+// Copyright (c) 2015-2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_HTTPWORKQUEUE_H
+#define BITCOIN_HTTPWORKQUEUE_H
+
+#include <httpserver.h>
+#include <sync.h>
+#include <util/time.h>
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <vector>
+
+/** Work queue for distributing work over multiple threads, with one FIFO
+ * per priority class. Work items are simply callable objects.
+ */
+template <typename WorkItem>
+class WorkQueue
+{
+private:
+    struct Entry {
+        std::unique_ptr<WorkItem> item;
+        int64_t enqueued_us;
+    };
+    struct PriorityClass {
+        std::deque<Entry> queue;
+        size_t max_running{0};
+        size_t running{0};
+        uint64_t rejected{0};
+        std::array<uint64_t, HTTP_WORK_WAIT_BUCKETS_US.size() + 1> wait_histogram{};
+        int64_t total_wait_us{0};
+    };
+
+    /** Mutex protects entire object */
+    Mutex cs;
+    std::condition_variable cond;
+    std::array<PriorityClass, NUM_HTTP_WORK_PRIORITIES> classes;
+    bool running;
+    size_t maxDepth;
+    /** Limit on, and number of, threads running work other than HIGH */
+    size_t max_running_below_high;
+    size_t running_below_high{0};
+
+    /** Most urgent class with queued work and a free thread, if any */
+    PriorityClass* NextClass() EXCLUSIVE_LOCKS_REQUIRED(cs)
+    {
+        for (size_t i = 0; i < NUM_HTTP_WORK_PRIORITIES; ++i) {
+            PriorityClass& c = classes[i];
+            if (c.queue.empty() || c.running >= c.max_running) continue;
+            if (i != static_cast<size_t>(HTTPWorkPriority::HIGH) && running_below_high >= max_running_below_high) continue;
+            return &c;
+        }
+        return nullptr;
+    }
+
+public:
+    WorkQueue(size_t _maxDepth, const HTTPWorkThreadLimits& limits) : running(true),
+                                 maxDepth(_maxDepth), max_running_below_high(limits.below_high)
+    {
+        for (size_t i = 0; i < NUM_HTTP_WORK_PRIORITIES; ++i) {
+            classes[i].max_running = limits.per_class[i];
+        }
+    }
+    /** Precondition: worker threads have all stopped (they have been joined).
+     */
+    ~WorkQueue()
+    {
+    }
+    /** Enqueue a work item */
+    bool Enqueue(WorkItem* item, HTTPWorkPriority priority)
+    {
+        LOCK(cs);
+        PriorityClass& c = classes[static_cast<size_t>(priority)];
+        if (c.queue.size() >= maxDepth) {
+            ++c.rejected;
+            return false;
+        }
+        c.queue.push_back({std::unique_ptr<WorkItem>(item), GetTimeMicros()});
+        cond.notify_one();
+        return true;
+    }
+    /** Thread function */
+    void Run()
+    {
+        while (true) {
+            std::unique_ptr<WorkItem> i;
+            PriorityClass* c{nullptr};
+            {
+                WAIT_LOCK(cs, lock);
+                while (running && (c = NextClass()) == nullptr)
+                    cond.wait(lock);
+                if (!running)
+                    break;
+                const int64_t wait_us = GetTimeMicros() - c->queue.front().enqueued_us;
+                const auto bucket = std::lower_bound(HTTP_WORK_WAIT_BUCKETS_US.begin(), HTTP_WORK_WAIT_BUCKETS_US.end(), wait_us);
+                ++c->wait_histogram[bucket - HTTP_WORK_WAIT_BUCKETS_US.begin()];
+                c->total_wait_us += wait_us;
+                i = std::move(c->queue.front().item);
+                c->queue.pop_front();
+                ++c->running;
+                if (c != &classes[static_cast<size_t>(HTTPWorkPriority::HIGH)]) ++running_below_high;
+            }
+            (*i)();
+            // No need to wake anyone: this thread goes on to the next item,
+            // including one of a class that was at its thread limit.
+            LOCK(cs);
+            --c->running;
+            if (c != &classes[static_cast<size_t>(HTTPWorkPriority::HIGH)]) --running_below_high;
+        }
+    }
+    /** Interrupt and exit loops */
+    void Interrupt()
+    {
+        LOCK(cs);
+        running = false;
+        cond.notify_all();
+    }
+    std::vector<HTTPWorkQueueStats> Stats()
+    {
+        LOCK(cs);
+        std::vector<HTTPWorkQueueStats> stats;
+        for (size_t i = 0; i < NUM_HTTP_WORK_PRIORITIES; ++i) {
+            const PriorityClass& c = classes[i];
+            stats.push_back({static_cast<HTTPWorkPriority>(i), c.max_running, maxDepth, c.running, c.queue.size(), c.rejected, c.wait_histogram, c.total_wait_us});
+        }
+        return stats;
+    }
+};
+
+#endif // BITCOIN_HTTPWORKQUEUE_H
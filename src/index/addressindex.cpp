@@ -0,0 +1,327 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <crypto/sha256.h>
+#include <index/addressindex.h>
+#include <undo.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <map>
+
+/* The address index database stores three sets of records per script, all keyed
+ * by the SHA256 of the script so all records of one script are adjacent:
+ *
+ * - History: one entry per output paying to the script and per input spending
+ *   such an output, ordered by height so that paging walks it oldest first.
+ *   'h' || script hash || height (BE) || txid || index (BE) || spending -> value
+ *
+ * - Unspent: the outputs paying to the script that are currently unspent.
+ *   'u' || script hash || txid || vout (BE) -> (value, height)
+ *
+ * - Balance: the running totals over the two sets above, kept up to date as
+ *   blocks are connected and rewound. Erased once all totals are back to zero.
+ *   'b' || script hash -> (balance, received, utxos)
+ */
+constexpr char DB_ADDRESS_HISTORY = 'h';
+constexpr char DB_ADDRESS_UNSPENT = 'u';
+constexpr char DB_ADDRESS_BALANCE = 'b';
+
+std::unique_ptr<AddressIndex> g_addressindex;
+
+namespace {
+
+struct DBHistoryKey {
+    uint256 script_hash;
+    int height;
+    uint256 txid;
+    uint32_t index;
+    bool spending;
+
+    DBHistoryKey() : height(0), index(0), spending(false) {}
+    DBHistoryKey(const uint256& script_hash_in, int height_in, const uint256& txid_in, uint32_t index_in, bool spending_in) :
+        script_hash(script_hash_in), height(height_in), txid(txid_in), index(index_in), spending(spending_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_ADDRESS_HISTORY);
+        s << script_hash;
+        ser_writedata32be(s, height);
+        s << txid;
+        ser_writedata32be(s, index);
+        ser_writedata8(s, spending);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        char prefix = ser_readdata8(s);
+        if (prefix != DB_ADDRESS_HISTORY) {
+            throw std::ios_base::failure("Invalid format for address index DB history key");
+        }
+        s >> script_hash;
+        height = ser_readdata32be(s);
+        s >> txid;
+        index = ser_readdata32be(s);
+        spending = ser_readdata8(s) != 0;
+    }
+};
+
+struct DBUnspentKey {
+    uint256 script_hash;
+    COutPoint outpoint;
+
+    DBUnspentKey() {}
+    DBUnspentKey(const uint256& script_hash_in, const COutPoint& outpoint_in) :
+        script_hash(script_hash_in), outpoint(outpoint_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_ADDRESS_UNSPENT);
+        s << script_hash;
+        s << outpoint.hash;
+        ser_writedata32be(s, outpoint.n);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        char prefix = ser_readdata8(s);
+        if (prefix != DB_ADDRESS_UNSPENT) {
+            throw std::ios_base::failure("Invalid format for address index DB unspent key");
+        }
+        s >> script_hash;
+        s >> outpoint.hash;
+        outpoint.n = ser_readdata32be(s);
+    }
+};
+
+struct DBUnspentValue {
+    CAmount value;
+    int height;
+
+    SERIALIZE_METHODS(DBUnspentValue, obj) { READWRITE(obj.value, obj.height); }
+};
+
+/** The change to the totals of one script over a block or a rewound range. */
+struct BalanceDelta {
+    CAmount balance{0};
+    CAmount received{0};
+    int64_t utxos{0};
+};
+
+using BalanceDeltas = std::map<uint256, BalanceDelta>;
+
+} // namespace
+
+static uint256 ScriptHash(const CScript& script)
+{
+    uint256 hash;
+    CSHA256().Write(script.data(), script.size()).Finalize(hash.begin());
+    return hash;
+}
+
+/** Empty scripts (e.g. the marker output of a coinstake) and provably unspendable ones are not indexed. */
+static bool IsIndexed(const CScript& script)
+{
+    return !script.empty() && !script.IsUnspendable();
+}
+
+/** Add the deltas to the stored totals and queue the results in the batch. */
+static bool ApplyBalanceDeltas(const CDBWrapper& db, CDBBatch& batch, const BalanceDeltas& deltas)
+{
+    for (const auto& [script_hash, delta] : deltas) {
+        const auto key = std::make_pair(DB_ADDRESS_BALANCE, script_hash);
+        AddressBalance balance;
+        if (db.Exists(key) && !db.Read(key, balance)) {
+            return error("%s: Cannot read balance of script %s", __func__, script_hash.ToString());
+        }
+        if (delta.utxos < 0 && balance.utxos < (uint64_t)-delta.utxos) {
+            return error("%s: Balance of script %s would become negative", __func__, script_hash.ToString());
+        }
+        balance.balance += delta.balance;
+        balance.received += delta.received;
+        balance.utxos += delta.utxos;
+        if (balance.balance == 0 && balance.received == 0 && balance.utxos == 0) {
+            batch.Erase(key);
+        } else {
+            batch.Write(key, balance);
+        }
+    }
+    return true;
+}
+
+AddressIndex::AddressIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<BaseIndex::DB>(GetDataDir() / "indexes" / "addressindex", n_cache_size, f_memory, f_wipe,
+                                     false, GetDBOptions("addressindex")))
+{}
+
+bool AddressIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // Exclude genesis block transaction because outputs are not spendable.
+    if (pindex->nHeight == 0) return true;
+
+    CBlockUndo block_undo;
+    if (!UndoReadFromDisk(block_undo, pindex)) {
+        return error("%s: Failed to read undo data for block %s", __func__, pindex->GetBlockHash().ToString());
+    }
+    if (block_undo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: Undo data for block %s does not match the block", __func__, pindex->GetBlockHash().ToString());
+    }
+
+    CDBBatch batch(*m_db);
+    BalanceDeltas deltas;
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        const CTransaction& tx = *block.vtx[i];
+        const uint256& txid = tx.GetHash();
+
+        if (!tx.IsCoinBase()) {
+            const CTxUndo& tx_undo = block_undo.vtxundo[i - 1];
+            for (size_t j = 0; j < tx.vin.size(); ++j) {
+                const CTxOut& prev_out = tx_undo.vprevout[j].out;
+                if (!IsIndexed(prev_out.scriptPubKey)) continue;
+                const uint256 script_hash = ScriptHash(prev_out.scriptPubKey);
+                batch.Write(DBHistoryKey(script_hash, pindex->nHeight, txid, j, true), -prev_out.nValue);
+                batch.Erase(DBUnspentKey(script_hash, tx.vin[j].prevout));
+                BalanceDelta& delta = deltas[script_hash];
+                delta.balance -= prev_out.nValue;
+                --delta.utxos;
+            }
+        }
+
+        for (size_t j = 0; j < tx.vout.size(); ++j) {
+            const CTxOut& out = tx.vout[j];
+            if (!IsIndexed(out.scriptPubKey)) continue;
+            const uint256 script_hash = ScriptHash(out.scriptPubKey);
+            batch.Write(DBHistoryKey(script_hash, pindex->nHeight, txid, j, false), out.nValue);
+            batch.Write(DBUnspentKey(script_hash, COutPoint(txid, j)), DBUnspentValue{out.nValue, pindex->nHeight});
+            BalanceDelta& delta = deltas[script_hash];
+            delta.balance += out.nValue;
+            delta.received += out.nValue;
+            ++delta.utxos;
+        }
+    }
+    if (!ApplyBalanceDeltas(*m_db, batch, deltas)) return false;
+    return m_db->WriteBatch(batch);
+}
+
+bool AddressIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    // Undo the disconnected blocks newest first, and their transactions in
+    // reverse order, so that an output created and spent within the rewound
+    // range ends up neither spent nor unspent.
+    CDBBatch batch(*m_db);
+    BalanceDeltas deltas;
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        CBlockUndo block_undo;
+        if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
+            return error("%s: Failed to read block %s from disk", __func__, pindex->GetBlockHash().ToString());
+        }
+        if (!UndoReadFromDisk(block_undo, pindex)) {
+            return error("%s: Failed to read undo data for block %s", __func__, pindex->GetBlockHash().ToString());
+        }
+        if (block_undo.vtxundo.size() + 1 != block.vtx.size()) {
+            return error("%s: Undo data for block %s does not match the block", __func__, pindex->GetBlockHash().ToString());
+        }
+
+        for (size_t i = block.vtx.size(); i-- > 0;) {
+            const CTransaction& tx = *block.vtx[i];
+            const uint256& txid = tx.GetHash();
+
+            for (size_t j = 0; j < tx.vout.size(); ++j) {
+                const CScript& script = tx.vout[j].scriptPubKey;
+                if (!IsIndexed(script)) continue;
+                const uint256 script_hash = ScriptHash(script);
+                batch.Erase(DBHistoryKey(script_hash, pindex->nHeight, txid, j, false));
+                batch.Erase(DBUnspentKey(script_hash, COutPoint(txid, j)));
+                BalanceDelta& delta = deltas[script_hash];
+                delta.balance -= tx.vout[j].nValue;
+                delta.received -= tx.vout[j].nValue;
+                --delta.utxos;
+            }
+
+            if (tx.IsCoinBase()) continue;
+            const CTxUndo& tx_undo = block_undo.vtxundo[i - 1];
+            for (size_t j = 0; j < tx.vin.size(); ++j) {
+                const Coin& coin = tx_undo.vprevout[j];
+                if (!IsIndexed(coin.out.scriptPubKey)) continue;
+                const uint256 script_hash = ScriptHash(coin.out.scriptPubKey);
+                batch.Erase(DBHistoryKey(script_hash, pindex->nHeight, txid, j, true));
+                batch.Write(DBUnspentKey(script_hash, tx.vin[j].prevout), DBUnspentValue{coin.out.nValue, (int)coin.nHeight});
+                BalanceDelta& delta = deltas[script_hash];
+                delta.balance += coin.out.nValue;
+                ++delta.utxos;
+            }
+        }
+    }
+    if (!ApplyBalanceDeltas(*m_db, batch, deltas)) return false;
+    if (!m_db->WriteBatch(batch)) return false;
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+bool AddressIndex::FindHistory(const CScript& script, size_t skip, size_t count, std::vector<AddressHistoryEntry>& entries) const
+{
+    const uint256 script_hash = ScriptHash(script);
+
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    db_it->Seek(std::make_pair(DB_ADDRESS_HISTORY, script_hash));
+    for (; db_it->Valid(); db_it->Next()) {
+        DBHistoryKey key;
+        if (!db_it->GetKey(key) || key.script_hash != script_hash) break;
+        if (skip > 0) {
+            --skip;
+            continue;
+        }
+        CAmount value;
+        if (!db_it->GetValue(value)) {
+            return error("%s: Cannot read history entry of %s; index may be corrupted", __func__, GetName());
+        }
+        const bool spent = !key.spending && !m_db->Exists(DBUnspentKey(script_hash, COutPoint(key.txid, key.index)));
+        entries.push_back({key.height, key.txid, key.index, value, key.spending, spent});
+        if (count != 0 && entries.size() == count) break;
+    }
+    return true;
+}
+
+bool AddressIndex::FindUnspent(const CScript& script, const COutPoint& after, size_t count, std::vector<AddressUnspentEntry>& entries) const
+{
+    const uint256 script_hash = ScriptHash(script);
+
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    if (after.IsNull()) {
+        db_it->Seek(std::make_pair(DB_ADDRESS_UNSPENT, script_hash));
+    } else {
+        db_it->Seek(DBUnspentKey(script_hash, after));
+    }
+    for (; db_it->Valid(); db_it->Next()) {
+        DBUnspentKey key;
+        if (!db_it->GetKey(key) || key.script_hash != script_hash) break;
+        if (key.outpoint == after) continue;
+        DBUnspentValue value;
+        if (!db_it->GetValue(value)) {
+            return error("%s: Cannot read unspent entry of %s; index may be corrupted", __func__, GetName());
+        }
+        entries.push_back({key.outpoint, value.value, value.height});
+        if (count != 0 && entries.size() == count) break;
+    }
+    return true;
+}
+
+bool AddressIndex::FindBalance(const CScript& script, AddressBalance& balance) const
+{
+    const auto key = std::make_pair(DB_ADDRESS_BALANCE, ScriptHash(script));
+    balance = AddressBalance{};
+    if (!m_db->Exists(key)) return true;
+    if (!m_db->Read(key, balance)) {
+        return error("%s: Cannot read balance entry of %s; index may be corrupted", __func__, GetName());
+    }
+    return true;
+}
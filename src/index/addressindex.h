@@ -0,0 +1,104 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_ADDRESSINDEX_H
+#define BITCOIN_INDEX_ADDRESSINDEX_H
+
+#include <amount.h>
+#include <index/base.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <vector>
+
+static constexpr bool DEFAULT_ADDRESSINDEX{false};
+
+/** One credit or debit of a script, as recorded by the address index. */
+struct AddressHistoryEntry {
+    int height;
+    uint256 txid;
+    /// Output index for a credit, input index for a debit.
+    uint32_t index;
+    /// Positive for a credit, negative for a debit.
+    CAmount value;
+    /// Whether this entry is an input spending a previous output of the script.
+    bool spending;
+    /// For a credit, whether the output has been spent since.
+    bool spent;
+};
+
+/** An unspent output paying to a script, as recorded by the address index. */
+struct AddressUnspentEntry {
+    COutPoint outpoint;
+    CAmount value;
+    int height;
+};
+
+/** The running totals of a script, as recorded by the address index. */
+struct AddressBalance {
+    /// Sum of the unspent outputs paying to the script.
+    CAmount balance{0};
+    /// Sum of all outputs ever paying to the script.
+    CAmount received{0};
+    /// Number of unspent outputs paying to the script.
+    uint64_t utxos{0};
+
+    SERIALIZE_METHODS(AddressBalance, obj) { READWRITE(obj.balance, obj.received, obj.utxos); }
+};
+
+/**
+ * AddressIndex records, per output script, every transaction output paying to
+ * it and every input spending such an output, ordered by block height, and the
+ * subset of those outputs that is currently unspent, along with running
+ * totals so that a balance lookup does not walk the history. Scripts are keyed by
+ * their SHA256, so any script (not only ones with an address encoding) can be
+ * looked up. Outputs that are provably unspendable are not indexed.
+ */
+class AddressIndex final : public BaseIndex
+{
+private:
+    std::unique_ptr<BaseIndex::DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override { return *m_db; }
+
+    const char* GetName() const override { return "addressindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit AddressIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Look up the history of a script, oldest first.
+    ///
+    /// @param[in]   script  The output script to look up.
+    /// @param[in]   skip    Number of leading entries to skip.
+    /// @param[in]   count   Maximum number of entries to return, 0 for no limit.
+    /// @param[out]  entries The history entries found.
+    /// @return  false if the database could not be read
+    bool FindHistory(const CScript& script, size_t skip, size_t count, std::vector<AddressHistoryEntry>& entries) const;
+
+    /// Look up the unspent outputs paying to a script, in outpoint order.
+    ///
+    /// @param[in]   script  The output script to look up.
+    /// @param[in]   after   Return the outputs following this one, or from the first one if null.
+    /// @param[in]   count   Maximum number of entries to return, 0 for no limit.
+    /// @param[out]  entries The unspent entries found.
+    /// @return  false if the database could not be read
+    bool FindUnspent(const CScript& script, const COutPoint& after, size_t count, std::vector<AddressUnspentEntry>& entries) const;
+
+    /// Look up the running totals of a script. A script that was never paid
+    /// to has all totals zero.
+    bool FindBalance(const CScript& script, AddressBalance& balance) const;
+};
+
+/// The global address index. May be null.
+extern std::unique_ptr<AddressIndex> g_addressindex;
+
+#endif // BITCOIN_INDEX_ADDRESSINDEX_H
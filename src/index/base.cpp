@@ -4,6 +4,7 @@
 
 #include <chainparams.h>
 #include <index/base.h>
+#include <node/blockprefetch.h>
 #include <node/ui_interface.h>
 #include <shutdown.h>
 #include <tinyformat.h>
@@ -27,8 +28,9 @@ static void FatalError(const char* fmt, const Args&... args)
     StartShutdown();
 }
 
-BaseIndex::DB::DB(const fs::path& path, size_t n_cache_size, bool f_memory, bool f_wipe, bool f_obfuscate) :
-    CDBWrapper(path, n_cache_size, f_memory, f_wipe, f_obfuscate)
+BaseIndex::DB::DB(const fs::path& path, size_t n_cache_size, bool f_memory, bool f_wipe, bool f_obfuscate,
+                  const DBOptions& db_options) :
+    CDBWrapper(path, n_cache_size, f_memory, f_wipe, f_obfuscate, db_options)
 {}
 
 bool BaseIndex::DB::ReadBestBlock(CBlockLocator& locator) const
@@ -90,15 +92,23 @@ void BaseIndex::ThreadSync()
     if (!m_synced) {
         auto& consensus_params = Params().GetConsensus();
 
+        // Read the blocks ahead of the sync position in the background.
+        BlockPrefetcher prefetcher(consensus_params);
+        const CBlockIndex* pindex_ahead = nullptr;
+
         int64_t last_log_time = 0;
         int64_t last_locator_write_time = 0;
         while (true) {
             if (m_interrupt) {
-                m_best_block_index = pindex;
-                // No need to handle errors in Commit. If it fails, the error will be already be
-                // logged. The best way to recover is to continue, as index cannot be corrupted by
-                // a missed commit to disk for an advanced index state.
-                Commit();
+                // Nothing to commit before the first block is written: a null
+                // best block would be stored as the locator of the chain tip.
+                if (pindex) {
+                    m_best_block_index = pindex;
+                    // No need to handle errors in Commit. If it fails, the error will be already be
+                    // logged. The best way to recover is to continue, as index cannot be corrupted by
+                    // a missed commit to disk for an advanced index state.
+                    Commit();
+                }
                 return;
             }
 
@@ -118,6 +128,17 @@ void BaseIndex::ThreadSync()
                     return;
                 }
                 pindex = pindex_next;
+
+                if (!pindex_ahead || pindex_ahead->GetAncestor(pindex->nHeight) != pindex) {
+                    // First block, or the chain changed: restart the read-ahead from here.
+                    prefetcher.Clear();
+                    pindex_ahead = pindex->pprev;
+                }
+                while (true) {
+                    const CBlockIndex* pindex_fetch = pindex_ahead ? ::ChainActive().Next(pindex_ahead) : ::ChainActive().Genesis();
+                    if (!pindex_fetch || !prefetcher.Prefetch(pindex_fetch)) break;
+                    pindex_ahead = pindex_fetch;
+                }
             }
 
             int64_t current_time = GetTime();
@@ -127,20 +148,21 @@ void BaseIndex::ThreadSync()
                 last_log_time = current_time;
             }
 
-            if (last_locator_write_time + SYNC_LOCATOR_WRITE_INTERVAL < current_time) {
-                m_best_block_index = pindex;
+            if (pindex->pprev && last_locator_write_time + SYNC_LOCATOR_WRITE_INTERVAL < current_time) {
+                // pindex is not written yet; commit the state up to its parent.
+                m_best_block_index = pindex->pprev;
                 last_locator_write_time = current_time;
                 // No need to handle errors in Commit. See rationale above.
                 Commit();
             }
 
-            CBlock block;
-            if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+            std::shared_ptr<const CBlock> block = prefetcher.Get(pindex);
+            if (!block) {
                 FatalError("%s: Failed to read block %s from disk",
                            __func__, pindex->GetBlockHash().ToString());
                 return;
             }
-            if (!WriteBlock(block, pindex)) {
+            if (!WriteBlock(*block, pindex)) {
                 FatalError("%s: Failed to write block %s to index database",
                            __func__, pindex->GetBlockHash().ToString());
                 return;
@@ -38,7 +38,8 @@ protected:
     {
     public:
         DB(const fs::path& path, size_t n_cache_size,
-           bool f_memory = false, bool f_wipe = false, bool f_obfuscate = false);
+           bool f_memory = false, bool f_wipe = false, bool f_obfuscate = false,
+           const DBOptions& db_options = {});
 
         /// Read block locator of the chain that the txindex is in sync with.
         bool ReadBestBlock(CBlockLocator& locator) const;
@@ -97,6 +98,9 @@ protected:
 
     virtual DB& GetDB() const = 0;
 
+    /// The last block the index has been updated with.
+    const CBlockIndex* CurrentIndex() const { return m_best_block_index.load(); }
+
     /// Get the name of the index for display in logs.
     virtual const char* GetName() const = 0;
 
@@ -0,0 +1,317 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <coins.h>
+#include <index/coinstatsindex.h>
+#include <key_io.h>
+#include <script/standard.h>
+#include <undo.h>
+#include <util/system.h>
+#include <validation.h>
+
+/* The coinstats index database stores the UTXO set statistics after every
+ * block of the chain it has indexed, plus the MuHash state at its best block:
+ *
+ * 's' || height (BE) -> (block hash, statistics)
+ * 'M' -> MuHash3072 numerator and denominator
+ */
+constexpr char DB_BLOCK_HEIGHT = 's';
+constexpr char DB_MUHASH = 'M';
+
+std::unique_ptr<CoinStatsIndex> g_coin_stats_index;
+
+namespace {
+
+/** The UTXO set statistics after a block. All amounts are running totals. */
+struct DBVal {
+    uint256 muhash;
+    uint64_t transaction_output_count;
+    uint64_t bogo_size;
+    CAmount total_amount;
+    CAmount total_subsidy;
+    CAmount total_unspendable_amount;
+    CAmount total_burned_amount;
+    CAmount total_prevout_spent_amount;
+    CAmount total_new_outputs_ex_coinbase_amount;
+    CAmount total_coinbase_amount;
+
+    SERIALIZE_METHODS(DBVal, obj)
+    {
+        READWRITE(obj.muhash);
+        READWRITE(obj.transaction_output_count);
+        READWRITE(obj.bogo_size);
+        READWRITE(obj.total_amount);
+        READWRITE(obj.total_subsidy);
+        READWRITE(obj.total_unspendable_amount);
+        READWRITE(obj.total_burned_amount);
+        READWRITE(obj.total_prevout_spent_amount);
+        READWRITE(obj.total_new_outputs_ex_coinbase_amount);
+        READWRITE(obj.total_coinbase_amount);
+    }
+};
+
+struct DBHeightKey {
+    int height;
+
+    DBHeightKey() : height(0) {}
+    explicit DBHeightKey(int height_in) : height(height_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_BLOCK_HEIGHT);
+        ser_writedata32be(s, height);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        char prefix = ser_readdata8(s);
+        if (prefix != DB_BLOCK_HEIGHT) {
+            throw std::ios_base::failure("Invalid format for coinstatsindex DB height key");
+        }
+        height = ser_readdata32be(s);
+    }
+};
+
+} // namespace
+
+CoinStatsIndex::CoinStatsIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<BaseIndex::DB>(GetDataDir() / "indexes" / "coinstatsindex", n_cache_size, f_memory, f_wipe,
+                                     false, GetDBOptions("coinstatsindex")))
+{
+    const CTxDestination burn_dest = DecodeDestination(Params().GetConsensus().cBurnAddress);
+    if (const PKHash* burn_key_hash = boost::get<PKHash>(&burn_dest)) {
+        m_burn_key_hash.assign(burn_key_hash->begin(), burn_key_hash->end());
+    }
+}
+
+/** Outputs to the burn address, either plain or with data after the key hash. */
+bool CoinStatsIndex::IsBurn(const CScript& script) const
+{
+    if (m_burn_key_hash.empty()) return false;
+    std::vector<std::vector<unsigned char>> solutions;
+    const TxoutType type = Solver(script, solutions);
+    return (type == TxoutType::PUBKEYHASH || type == TxoutType::TX_BURN_DATA) && solutions[0] == m_burn_key_hash;
+}
+
+bool CoinStatsIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    CBlockUndo block_undo;
+
+    if (pindex->nHeight > 0) {
+        if (!UndoReadFromDisk(block_undo, pindex)) {
+            return false;
+        }
+        if (block_undo.vtxundo.size() + 1 != block.vtx.size()) {
+            return error("%s: Undo data for block %s does not match the block", __func__, pindex->GetBlockHash().ToString());
+        }
+
+        std::pair<uint256, DBVal> read_out;
+        if (!m_db->Read(DBHeightKey(pindex->nHeight - 1), read_out)) {
+            return false;
+        }
+
+        uint256 expected_block_hash = pindex->pprev->GetBlockHash();
+        if (read_out.first != expected_block_hash) {
+            return error("%s: previous block header belongs to unexpected block %s; expected %s",
+                         __func__, read_out.first.ToString(), expected_block_hash.ToString());
+        }
+    }
+
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        const CTransaction& tx = *block.vtx[i];
+
+        for (size_t j = 0; j < tx.vout.size(); ++j) {
+            const CTxOut& out = tx.vout[j];
+            if (tx.IsCoinBase()) {
+                m_total_coinbase_amount += out.nValue;
+            } else {
+                m_total_new_outputs_ex_coinbase_amount += out.nValue;
+            }
+            if (IsBurn(out.scriptPubKey)) {
+                m_total_burned_amount += out.nValue;
+            }
+
+            // The genesis block outputs and provably unspendable outputs never
+            // enter the UTXO set.
+            if (pindex->nHeight == 0 || out.scriptPubKey.IsUnspendable()) {
+                m_total_unspendable_amount += out.nValue;
+                continue;
+            }
+
+            const Coin coin(out, pindex->nHeight, tx.IsCoinBase(), tx.IsCoinStake());
+            ApplyCoinHash(m_muhash, COutPoint(tx.GetHash(), j), coin);
+            ++m_transaction_output_count;
+            m_total_amount += out.nValue;
+            m_bogo_size += GetBogoSize(out.scriptPubKey);
+        }
+
+        if (tx.IsCoinBase()) continue;
+
+        const CTxUndo& tx_undo = block_undo.vtxundo[i - 1];
+        for (size_t j = 0; j < tx.vin.size(); ++j) {
+            const Coin& coin = tx_undo.vprevout[j];
+            RemoveCoinHash(m_muhash, tx.vin[j].prevout, coin);
+            --m_transaction_output_count;
+            m_total_amount -= coin.out.nValue;
+            m_bogo_size -= GetBogoSize(coin.out.scriptPubKey);
+            m_total_prevout_spent_amount += coin.out.nValue;
+        }
+    }
+
+    // Coinbase and coinstake outputs are the only ones not fully funded by
+    // the inputs they spend.
+    m_total_subsidy = m_total_coinbase_amount + m_total_new_outputs_ex_coinbase_amount - m_total_prevout_spent_amount;
+
+    std::pair<uint256, DBVal> value;
+    value.first = pindex->GetBlockHash();
+    value.second.transaction_output_count = m_transaction_output_count;
+    value.second.bogo_size = m_bogo_size;
+    value.second.total_amount = m_total_amount;
+    value.second.total_subsidy = m_total_subsidy;
+    value.second.total_unspendable_amount = m_total_unspendable_amount;
+    value.second.total_burned_amount = m_total_burned_amount;
+    value.second.total_prevout_spent_amount = m_total_prevout_spent_amount;
+    value.second.total_new_outputs_ex_coinbase_amount = m_total_new_outputs_ex_coinbase_amount;
+    value.second.total_coinbase_amount = m_total_coinbase_amount;
+    m_muhash.Finalize(value.second.muhash);
+
+    return m_db->Write(DBHeightKey(pindex->nHeight), value);
+}
+
+bool CoinStatsIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    // Only the MuHash needs to be reversed block by block; the totals are
+    // stored for every block and are simply reloaded from the new tip. The
+    // entries of the disconnected heights are overwritten as the new chain
+    // gets connected.
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
+            return error("%s: Failed to read block %s from disk", __func__, pindex->GetBlockHash().ToString());
+        }
+        if (!ReverseBlock(block, pindex)) {
+            return false;
+        }
+    }
+
+    if (!LoadTotals(new_tip)) {
+        return false;
+    }
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+bool CoinStatsIndex::ReverseBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    CBlockUndo block_undo;
+    if (pindex->nHeight > 0) {
+        if (!UndoReadFromDisk(block_undo, pindex)) {
+            return error("%s: Failed to read undo data for block %s", __func__, pindex->GetBlockHash().ToString());
+        }
+        if (block_undo.vtxundo.size() + 1 != block.vtx.size()) {
+            return error("%s: Undo data for block %s does not match the block", __func__, pindex->GetBlockHash().ToString());
+        }
+    }
+
+    for (size_t i = block.vtx.size(); i-- > 0;) {
+        const CTransaction& tx = *block.vtx[i];
+
+        for (size_t j = 0; j < tx.vout.size(); ++j) {
+            const CTxOut& out = tx.vout[j];
+            if (pindex->nHeight == 0 || out.scriptPubKey.IsUnspendable()) continue;
+            RemoveCoinHash(m_muhash, COutPoint(tx.GetHash(), j), Coin(out, pindex->nHeight, tx.IsCoinBase(), tx.IsCoinStake()));
+        }
+
+        if (tx.IsCoinBase()) continue;
+
+        const CTxUndo& tx_undo = block_undo.vtxundo[i - 1];
+        for (size_t j = 0; j < tx.vin.size(); ++j) {
+            ApplyCoinHash(m_muhash, tx.vin[j].prevout, tx_undo.vprevout[j]);
+        }
+    }
+    return true;
+}
+
+bool CoinStatsIndex::LoadTotals(const CBlockIndex* pindex)
+{
+    std::pair<uint256, DBVal> entry;
+    if (!m_db->Read(DBHeightKey(pindex->nHeight), entry) || entry.first != pindex->GetBlockHash()) {
+        return error("%s: Cannot read current %s state; index may be corrupted", __func__, GetName());
+    }
+
+    uint256 muhash;
+    m_muhash.Finalize(muhash);
+    if (muhash != entry.second.muhash) {
+        return error("%s: MuHash of %s does not match the stored value for block %s; index may be corrupted",
+                     __func__, GetName(), pindex->GetBlockHash().ToString());
+    }
+
+    m_transaction_output_count = entry.second.transaction_output_count;
+    m_bogo_size = entry.second.bogo_size;
+    m_total_amount = entry.second.total_amount;
+    m_total_subsidy = entry.second.total_subsidy;
+    m_total_unspendable_amount = entry.second.total_unspendable_amount;
+    m_total_burned_amount = entry.second.total_burned_amount;
+    m_total_prevout_spent_amount = entry.second.total_prevout_spent_amount;
+    m_total_new_outputs_ex_coinbase_amount = entry.second.total_new_outputs_ex_coinbase_amount;
+    m_total_coinbase_amount = entry.second.total_coinbase_amount;
+    return true;
+}
+
+bool CoinStatsIndex::Init()
+{
+    if (!m_db->Read(DB_MUHASH, m_muhash)) {
+        // Check that the cause of the read failure is that the key does not
+        // exist. Any other errors indicate database corruption or a disk
+        // failure, and starting the index would cause further corruption.
+        if (m_db->Exists(DB_MUHASH)) {
+            return error("%s: Cannot read current %s state; index may be corrupted",
+                         __func__, GetName());
+        }
+    }
+
+    if (!BaseIndex::Init()) return false;
+
+    // The MuHash is committed together with the best block locator, so it
+    // matches the totals stored for that block.
+    const CBlockIndex* pindex = CurrentIndex();
+    if (pindex && !LoadTotals(pindex)) return false;
+    return true;
+}
+
+bool CoinStatsIndex::CommitInternal(CDBBatch& batch)
+{
+    // DB_MUHASH should always be committed in a batch together with
+    // DB_BEST_BLOCK to prevent an inconsistent state of the DB.
+    batch.Write(DB_MUHASH, m_muhash);
+    return BaseIndex::CommitInternal(batch);
+}
+
+bool CoinStatsIndex::LookUpStats(const CBlockIndex* block_index, CCoinsStats& coins_stats) const
+{
+    std::pair<uint256, DBVal> entry;
+    if (!m_db->Read(DBHeightKey(block_index->nHeight), entry) || entry.first != block_index->GetBlockHash()) {
+        return false;
+    }
+
+    coins_stats.nHeight = block_index->nHeight;
+    coins_stats.hashBlock = block_index->GetBlockHash();
+    coins_stats.hashSerialized = entry.second.muhash;
+    coins_stats.nTransactionOutputs = entry.second.transaction_output_count;
+    coins_stats.coins_count = entry.second.transaction_output_count;
+    coins_stats.nBogoSize = entry.second.bogo_size;
+    coins_stats.nTotalAmount = entry.second.total_amount;
+    coins_stats.total_subsidy = entry.second.total_subsidy;
+    coins_stats.total_unspendable_amount = entry.second.total_unspendable_amount;
+    coins_stats.total_burned_amount = entry.second.total_burned_amount;
+    coins_stats.total_prevout_spent_amount = entry.second.total_prevout_spent_amount;
+    coins_stats.total_new_outputs_ex_coinbase_amount = entry.second.total_new_outputs_ex_coinbase_amount;
+    coins_stats.total_coinbase_amount = entry.second.total_coinbase_amount;
+    return true;
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_COINSTATSINDEX_H
+#define BITCOIN_INDEX_COINSTATSINDEX_H
+
+#include <amount.h>
+#include <crypto/muhash.h>
+#include <index/base.h>
+#include <node/coinstats.h>
+
+#include <vector>
+
+static constexpr bool DEFAULT_COINSTATSINDEX{false};
+
+/**
+ * CoinStatsIndex maintains statistics on the UTXO set block by block: a
+ * rolling MuHash3072 commitment, the number and size of the outputs, and
+ * running totals of the amounts created, spent, made unspendable and sent to
+ * the burn address. The state after every block is stored under its height,
+ * so gettxoutsetinfo and supply audits are a single lookup at any height
+ * instead of a walk over the whole chainstate.
+ */
+class CoinStatsIndex final : public BaseIndex
+{
+private:
+    std::unique_ptr<BaseIndex::DB> m_db;
+
+    MuHash3072 m_muhash;
+    uint64_t m_transaction_output_count{0};
+    uint64_t m_bogo_size{0};
+    CAmount m_total_amount{0};
+    CAmount m_total_subsidy{0};
+    CAmount m_total_unspendable_amount{0};
+    CAmount m_total_burned_amount{0};
+    CAmount m_total_prevout_spent_amount{0};
+    CAmount m_total_new_outputs_ex_coinbase_amount{0};
+    CAmount m_total_coinbase_amount{0};
+
+    /// Key hash of the consensus burn address, empty if it does not decode on this chain.
+    std::vector<unsigned char> m_burn_key_hash;
+
+    bool IsBurn(const CScript& script) const;
+
+    /// Undo the MuHash updates of a block, using its undo data.
+    bool ReverseBlock(const CBlock& block, const CBlockIndex* pindex);
+
+    /// Load the running totals stored for a block and check them against m_muhash.
+    bool LoadTotals(const CBlockIndex* pindex);
+
+protected:
+    bool Init() override;
+
+    bool CommitInternal(CDBBatch& batch) override;
+
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override { return *m_db; }
+
+    const char* GetName() const override { return "coinstatsindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit CoinStatsIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Look up the UTXO set statistics after a block of the active chain.
+    bool LookUpStats(const CBlockIndex* block_index, CCoinsStats& coins_stats) const;
+};
+
+/// The global UTXO set statistics index. May be null.
+extern std::unique_ptr<CoinStatsIndex> g_coin_stats_index;
+
+#endif // BITCOIN_INDEX_COINSTATSINDEX_H
@@ -0,0 +1,84 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <index/disktxpos.h>
+#include <index/spentindex.h>
+#include <undo.h>
+#include <util/system.h>
+#include <validation.h>
+
+constexpr char DB_SPENT_OUTPUTS = 's';
+
+std::unique_ptr<SpentIndex> g_spentindex;
+
+SpentIndex::SpentIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<BaseIndex::DB>(GetDataDir() / "indexes" / "spentindex", n_cache_size, f_memory, f_wipe,
+                                     false, GetDBOptions("spentindex")))
+{}
+
+bool SpentIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // The genesis block has no undo data and its coinbase spends nothing.
+    if (pindex->nHeight == 0) return true;
+
+    CBlockUndo block_undo;
+    if (!UndoReadFromDisk(block_undo, pindex)) {
+        return error("%s: Failed to read undo data for block %s", __func__, pindex->GetBlockHash().ToString());
+    }
+    if (block_undo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: Undo data for block %s does not match the block", __func__, pindex->GetBlockHash().ToString());
+    }
+
+    CDBBatch batch(*m_db);
+    CDiskTxPos pos(pindex->GetUndoPos(), GetSizeOfCompactSize(block_undo.vtxundo.size()));
+    for (size_t i = 1; i < block.vtx.size(); ++i) {
+        batch.Write(std::make_pair(DB_SPENT_OUTPUTS, block.vtx[i]->GetHash()), pos);
+        pos.nTxOffset += ::GetSerializeSize(block_undo.vtxundo[i - 1], CLIENT_VERSION);
+    }
+    return m_db->WriteBatch(batch);
+}
+
+bool SpentIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    // Transactions of the disconnected blocks that are mined again are
+    // written back when their new block is connected.
+    CDBBatch batch(*m_db);
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
+            return error("%s: Failed to read block %s from disk", __func__, pindex->GetBlockHash().ToString());
+        }
+        for (size_t i = 1; i < block.vtx.size(); ++i) {
+            batch.Erase(std::make_pair(DB_SPENT_OUTPUTS, block.vtx[i]->GetHash()));
+        }
+    }
+    if (!m_db->WriteBatch(batch)) return false;
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+bool SpentIndex::FindSpentOutputs(const uint256& txid, CTxUndo& txundo) const
+{
+    CDiskTxPos pos;
+    if (!m_db->Read(std::make_pair(DB_SPENT_OUTPUTS, txid), pos)) {
+        return false;
+    }
+
+    CAutoFile file(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        return error("%s: OpenUndoFile failed", __func__);
+    }
+    try {
+        if (fseek(file.Get(), pos.nTxOffset, SEEK_CUR)) {
+            return error("%s: fseek(...) failed", __func__);
+        }
+        file >> txundo;
+    } catch (const std::exception& e) {
+        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+    }
+    return true;
+}
@@ -0,0 +1,51 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_SPENTINDEX_H
+#define BITCOIN_INDEX_SPENTINDEX_H
+
+#include <index/base.h>
+#include <uint256.h>
+
+class CTxUndo;
+
+static constexpr bool DEFAULT_SPENTINDEX{false};
+
+/**
+ * SpentIndex records, for every confirmed transaction, where the outputs spent
+ * by its inputs are stored: the position of its block's undo data in the undo
+ * files plus the offset of the transaction's undo data within it, keyed by
+ * txid. The value, script and origin of each prevout are then read straight
+ * from the undo file, with one database read and one seek per transaction.
+ */
+class SpentIndex final : public BaseIndex
+{
+private:
+    std::unique_ptr<BaseIndex::DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override { return *m_db; }
+
+    const char* GetName() const override { return "spentindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit SpentIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Look up the outputs spent by a confirmed transaction.
+    ///
+    /// @param[in]   txid    The hash of the transaction.
+    /// @param[out]  txundo  The spent outputs, in input order.
+    /// @return  true if the transaction is found, false otherwise (including for coinbases)
+    bool FindSpentOutputs(const uint256& txid, CTxUndo& txundo) const;
+};
+
+/// The global spent-output index, used by the RPCs to report prevouts and fees. May be null.
+extern std::unique_ptr<SpentIndex> g_spentindex;
+
+#endif // BITCOIN_INDEX_SPENTINDEX_H
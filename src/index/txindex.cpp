@@ -10,6 +10,9 @@
 #include <util/translation.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <tuple>
+
 constexpr char DB_BEST_BLOCK = 'B';
 constexpr char DB_TXINDEX = 't';
 constexpr char DB_TXINDEX_BLOCK = 'T';
@@ -37,7 +40,7 @@ public:
 };
 
 TxIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
-    BaseIndex::DB(GetDataDir() / "indexes" / "txindex", n_cache_size, f_memory, f_wipe)
+    BaseIndex::DB(GetDataDir() / "indexes" / "txindex", n_cache_size, f_memory, f_wipe, false, GetDBOptions("txindex"))
 {}
 
 bool TxIndex::DB::ReadTxPos(const uint256 &txid, CDiskTxPos& pos) const
@@ -255,3 +258,86 @@ bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRe
     block_hash = header.GetHash();
     return true;
 }
+
+bool TxIndex::FindTxs(const std::vector<uint256>& tx_hashes, std::vector<uint256>& block_hashes, std::vector<CTransactionRef>& txs) const
+{
+    block_hashes.assign(tx_hashes.size(), uint256());
+    txs.assign(tx_hashes.size(), nullptr);
+
+    std::vector<std::pair<CDiskTxPos, size_t>> positions;
+    positions.reserve(tx_hashes.size());
+    for (size_t i = 0; i < tx_hashes.size(); ++i) {
+        CDiskTxPos postx;
+        if (m_db->ReadTxPos(tx_hashes[i], postx)) {
+            positions.emplace_back(postx, i);
+        }
+    }
+    std::sort(positions.begin(), positions.end(), [](const std::pair<CDiskTxPos, size_t>& a, const std::pair<CDiskTxPos, size_t>& b) {
+        return std::tie(a.first.nFile, a.first.nPos, a.first.nTxOffset) < std::tie(b.first.nFile, b.first.nPos, b.first.nTxOffset);
+    });
+
+    size_t next = 0;
+    while (next < positions.size()) {
+        // Read all requested transactions of one block file through one handle.
+        const int file_num = positions[next].first.nFile;
+        CAutoFile file(OpenBlockFile(positions[next].first, true), SER_DISK, CLIENT_VERSION);
+        if (file.IsNull()) {
+            return error("%s: OpenBlockFile failed", __func__);
+        }
+
+        unsigned int block_pos = positions[next].first.nPos;
+        bool have_header = false;
+        uint256 block_hash;
+        // Position of the file relative to the end of the current block's header.
+        unsigned int tx_offset = 0;
+
+        for (; next < positions.size() && positions[next].first.nFile == file_num; ++next) {
+            const CDiskTxPos& postx = positions[next].first;
+            const size_t i = positions[next].second;
+
+            // The same transaction requested more than once.
+            if (next > 0) {
+                const auto& prev = positions[next - 1];
+                if (prev.first.nFile == postx.nFile && prev.first.nPos == postx.nPos && prev.first.nTxOffset == postx.nTxOffset) {
+                    block_hashes[i] = block_hashes[prev.second];
+                    txs[i] = txs[prev.second];
+                    continue;
+                }
+            }
+
+            try {
+                if (!have_header || postx.nPos != block_pos) {
+                    if (have_header && fseek(file.Get(), postx.nPos, SEEK_SET)) {
+                        return error("%s: fseek(...) failed", __func__);
+                    }
+                    CBlockHeader header;
+                    file >> header;
+                    block_hash = header.GetHash();
+                    block_pos = postx.nPos;
+                    have_header = true;
+                    tx_offset = 0;
+                }
+
+                // Transactions of one block are sorted by offset, so only the
+                // ones that were not requested are skipped over.
+                if (postx.nTxOffset != tx_offset) {
+                    if (fseek(file.Get(), (long)postx.nTxOffset - (long)tx_offset, SEEK_CUR)) {
+                        return error("%s: fseek(...) failed", __func__);
+                    }
+                }
+                CTransactionRef tx;
+                file >> tx;
+                tx_offset = postx.nTxOffset + ::GetSerializeSize(*tx, CLIENT_VERSION);
+
+                if (tx->GetHash() != tx_hashes[i]) {
+                    return error("%s: txid mismatch", __func__);
+                }
+                block_hashes[i] = block_hash;
+                txs[i] = std::move(tx);
+            } catch (const std::exception& e) {
+                return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+            }
+        }
+    }
+    return true;
+}
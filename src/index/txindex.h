@@ -46,6 +46,17 @@ public:
     /// @param[out]  tx  The transaction itself.
     /// @return  true if transaction is found, false otherwise
     bool FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const;
+
+    /// Look up many transactions by hash at once. The transactions are read
+    /// from disk in file and offset order, so that each block file is opened
+    /// once, each block header is read once and neighbouring transactions are
+    /// read without seeking.
+    ///
+    /// @param[in]   tx_hashes  The hashes of the transactions to be returned.
+    /// @param[out]  block_hashes  For each hash, the hash of the block the transaction is found in.
+    /// @param[out]  txs  For each hash, the transaction itself, or null if it is not indexed.
+    /// @return  false on a read error, true otherwise (even if some transactions are not found)
+    bool FindTxs(const std::vector<uint256>& tx_hashes, std::vector<uint256>& block_hashes, std::vector<CTransactionRef>& txs) const;
 };
 
 /// The global transaction index, used in GetTransaction. May be null.
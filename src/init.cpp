@@ -18,11 +18,15 @@
 #include <chainparams.h>
 #include <compat/sanity.h>
 #include <consensus/validation.h>
+#include <crypto/x11_aes.h>
 #include <fs.h>
 #include <hash.h>
 #include <httprpc.h>
 #include <httpserver.h>
+#include <index/addressindex.h>
 #include <index/blockfilterindex.h>
+#include <index/coinstatsindex.h>
+#include <index/spentindex.h>
 #include <index/txindex.h>
 #include <interfaces/chain.h>
 #include <interfaces/node.h>
@@ -32,7 +36,9 @@
 #include <net_permissions.h>
 #include <net_processing.h>
 #include <netbase.h>
+#include <node/blockcache.h>
 #include <node/context.h>
+#include <node/eventjournal.h>
 #include <node/ui_interface.h>
 #include <policy/feerate.h>
 #include <policy/fees.h>
@@ -193,12 +199,46 @@ void Interrupt(NodeContext& node)
     if (g_txindex) {
         g_txindex->Interrupt();
     }
+    if (g_addressindex) {
+        g_addressindex->Interrupt();
+    }
+    if (g_spentindex) {
+        g_spentindex->Interrupt();
+    }
+    if (g_coin_stats_index) {
+        g_coin_stats_index->Interrupt();
+    }
     if (stakectx) {
         stakectx->InterruptStaker();
     }
     ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Interrupt(); });
 }
 
+//>SIN
+/**
+ * Write the infinity-node caches to disk. Periodic snapshots skip the format
+ * check of the existing files, which already happened when they were loaded.
+ */
+static void DumpInfinitynodeCaches(bool fSnapshot)
+{
+    CFlatDB<CInfinitynodeMan> flatdb1("infinitynode.dat", "magicInfinityNodeCache");
+    CFlatDB<CInfinitynodersv> flatdb2("infinitynodersv.dat", "magicInfinityRSV");
+    CFlatDB<CInfinitynodeMeta> flatdb3("infinitynodemeta.dat", "magicInfinityMeta");
+    CFlatDB<CInfinitynodeLockInfo> flatdb4("infinitynodelockinfo.dat", "magicInfinityLockInfo");
+    if (fSnapshot) {
+        flatdb1.Snapshot(infnodeman);
+        flatdb2.Snapshot(infnodersv);
+        flatdb3.Snapshot(infnodemeta);
+        flatdb4.Snapshot(infnodelrinfo);
+    } else {
+        flatdb1.Dump(infnodeman);
+        flatdb2.Dump(infnodersv);
+        flatdb3.Dump(infnodemeta);
+        flatdb4.Dump(infnodelrinfo);
+    }
+}
+//<SIN
+
 void Shutdown(NodeContext& node)
 {
     static Mutex g_shutdown_mutex;
@@ -309,6 +349,18 @@ void Shutdown(NodeContext& node)
         g_txindex->Stop();
         g_txindex.reset();
     }
+    if (g_addressindex) {
+        g_addressindex->Stop();
+        g_addressindex.reset();
+    }
+    if (g_spentindex) {
+        g_spentindex->Stop();
+        g_spentindex.reset();
+    }
+    if (g_coin_stats_index) {
+        g_coin_stats_index->Stop();
+        g_coin_stats_index.reset();
+    }
     ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Stop(); });
     DestroyAllBlockFilterIndexes();
 
@@ -333,16 +385,14 @@ void Shutdown(NodeContext& node)
     }
 
 //>SIN
-    CFlatDB<CInfinitynodeMan> flatdb1("infinitynode.dat", "magicInfinityNodeCache");
-    flatdb1.Dump(infnodeman);
-    CFlatDB<CInfinitynodersv> flatdb2("infinitynodersv.dat", "magicInfinityRSV");
-    flatdb2.Dump(infnodersv);
-    CFlatDB<CInfinitynodeMeta> flatdb3("infinitynodemeta.dat", "magicInfinityMeta");
-    flatdb3.Dump(infnodemeta);
-    CFlatDB<CInfinitynodeLockInfo> flatdb4("infinitynodelockinfo.dat", "magicInfinityLockInfo");
-    flatdb4.Dump(infnodelrinfo);
+    DumpInfinitynodeCaches(false);
 //<SIN
 
+    if (g_event_journal) {
+        UnregisterValidationInterface(g_event_journal.get());
+        g_event_journal.reset();
+    }
+
 #if ENABLE_ZMQ
     if (g_zmq_notification_interface) {
         UnregisterValidationInterface(g_zmq_notification_interface);
@@ -452,18 +502,24 @@ void SetupServerArgs(NodeContext& node)
 #if HAVE_SYSTEM
     argsman.AddArg("-alertnotify=<cmd>", "Execute command when a relevant alert is received or we see a really long fork (%s in cmd is replaced by message)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
+    argsman.AddArg("-addressindex", strprintf("Maintain an index of outputs and spends by script, used by the getaddressbalance, getaddressutxos and getaddresshistory rpc calls (default: %u)", DEFAULT_ADDRESSINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-assumevalid=<hex>", strprintf("If this block is in the chain assume that it and its ancestors are valid and potentially skip their script verification (0 to verify all, default: %s, testnet: %s, signet: %s)", defaultChainParams->GetConsensus().defaultAssumeValid.GetHex(), testnetChainParams->GetConsensus().defaultAssumeValid.GetHex(), signetChainParams->GetConsensus().defaultAssumeValid.GetHex()), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-backgroundflush", strprintf("Write the coins cache to disk from a background thread, so that block validation continues during a flush (default: %u)", DEFAULT_BACKGROUND_FLUSH), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-blockcachemb=<n>", strprintf("Memory budget in MiB for recently connected and read blocks kept deserialized (0 to disable, default: %d)", DEFAULT_BLOCK_CACHE_MB), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blocksdir=<dir>", "Specify directory to hold blocks subdirectory for *.dat files (default: <datadir>)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #if HAVE_SYSTEM
     argsman.AddArg("-blocknotify=<cmd>", "Execute command when the best block changes (%s in cmd is replaced by block hash)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
     argsman.AddArg("-blockreconstructionextratxn=<n>", strprintf("Extra transactions to keep in memory for compact block reconstructions (default: %u)", DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blocksonly", strprintf("Whether to reject transactions from network peers. Automatic broadcast and rebroadcast of any transactions from inbound peers is disabled, unless the peer has the 'forcerelay' permission. RPC transactions are not affected. (default: %u)", DEFAULT_BLOCKSONLY), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-coinstatsindex", strprintf("Maintain coinstats index used by the gettxoutsetinfo RPC (default: %u)", DEFAULT_COINSTATSINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-conf=<file>", strprintf("Specify path to read-only configuration file. Relative paths will be prefixed by datadir location. (default: %s)", BITCOIN_CONF_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-datadir=<dir>", "Specify data directory", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-dbbatchsize", strprintf("Maximum database write batch size in bytes (default: %u)", nDefaultDbBatchSize), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-dbcache=<n>", strprintf("Maximum database cache size <n> MiB (%d to %d, default: %d). In addition, unused mempool memory is shared for this cache (see -maxmempool).", nMinDbCache, nMaxDbCache, nDefaultDbCache), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-dboption=<db>:<key>=<value>", "Tune LevelDB for one database. <db> is chainstate, blocktree, txindex, blockfilter, addressindex, spentindex or coinstatsindex; <key> is blocksize, bloombits, writebuffer, compression or maxfilesize, sizes in bytes. Can be specified multiple times", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-debuglogfile=<file>", strprintf("Specify location of debug log file. Relative paths will be prefixed by a net-specific datadir location. (-nodebuglogfile to disable; default: %s)", DEFAULT_DEBUGLOGFILE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-eventjournal=<n>", strprintf("Keep a journal of up to <n> MiB of block connect/disconnect and mempool events, which consumers of ZMQ notifications can resume from over REST. The journal is stored in segments of about 3 MiB, and the oldest whole segments are deleted to stay within the limit (0 = disable, >=%d = size in MiB, default: %d)", MIN_EVENT_JOURNAL_MB, DEFAULT_EVENT_JOURNAL_MB), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-feefilter", strprintf("Tell other nodes to filter invs to us by our mempool min fee (default: %u)", DEFAULT_FEEFILTER), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-includeconf=<file>", "Specify additional configuration file, relative to the -datadir path (only useable from configuration file, not command line)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-loadblock=<file>", "Imports blocks from external file on startup", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -476,12 +532,13 @@ void SetupServerArgs(NodeContext& node)
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-persistmempool", strprintf("Whether to save the mempool on shutdown and load on restart (default: %u)", DEFAULT_PERSIST_MEMPOOL), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-pid=<file>", strprintf("Specify pid file. Relative paths will be prefixed by a net-specific datadir location. (default: %s)", BITCOIN_PID_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
-    argsman.AddArg("-prune=<n>", strprintf("Reduce storage requirements by enabling pruning (deleting) of old blocks. This allows the pruneblockchain RPC to be called to delete specific blocks, and enables automatic pruning of old blocks if a target size in MiB is provided. This mode is incompatible with -txindex and -rescan. "
+    argsman.AddArg("-prune=<n>", strprintf("Reduce storage requirements by enabling pruning (deleting) of old blocks. This allows the pruneblockchain RPC to be called to delete specific blocks, and enables automatic pruning of old blocks if a target size in MiB is provided. This mode is incompatible with -txindex, -addressindex, -spentindex, -coinstatsindex and -rescan. "
             "Warning: Reverting this setting requires re-downloading the entire blockchain. "
             "(default: 0 = disable pruning blocks, 1 = allow manual pruning via RPC, >=%u = automatically prune block files to stay under the specified target size in MiB)", MIN_DISK_SPACE_FOR_BLOCK_FILES / 1024 / 1024), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-reindex", "Rebuild chain state and block index from the blk*.dat files on disk", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-reindex-chainstate", "Rebuild chain state from the currently indexed blocks. When in pruning mode or if blocks on disk might be corrupted, use full -reindex instead.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-settings=<file>", strprintf("Specify path to dynamic settings data file. Can be disabled with -nosettings. File is written at runtime and not meant to be edited by users (use %s instead for custom settings). Relative paths will be prefixed by datadir location. (default: %s)", BITCOIN_CONF_FILENAME, BITCOIN_SETTINGS_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-spentindex", strprintf("Maintain an index of the outputs spent by each transaction, used to report prevouts and fees in the getrawtransaction rpc call (default: %u)", DEFAULT_SPENTINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #if HAVE_SYSTEM
     argsman.AddArg("-startupnotify=<cmd>", "Execute command on startup.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
@@ -549,22 +606,26 @@ void SetupServerArgs(NodeContext& node)
 #if ENABLE_ZMQ
     argsman.AddArg("-zmqpubhashblock=<address>", "Enable publish hash block in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashtx=<address>", "Enable publish hash transaction in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubjournal=<address>", "Enable publish event journal entries in <address> (requires -eventjournal)", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawblock=<address>", "Enable publish raw block in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawtx=<address>", "Enable publish raw transaction in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubsequence=<address>", "Enable publish hash block and tx sequence in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashblockhwm=<n>", strprintf("Set publish hash block outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashtxhwm=<n>", strprintf("Set publish hash transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubjournalhwm=<n>", strprintf("Set publish event journal outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawblockhwm=<n>", strprintf("Set publish raw block outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawtxhwm=<n>", strprintf("Set publish raw transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubsequencehwm=<n>", strprintf("Set publish hash sequence message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
 #else
     hidden_args.emplace_back("-zmqpubhashblock=<address>");
     hidden_args.emplace_back("-zmqpubhashtx=<address>");
+    hidden_args.emplace_back("-zmqpubjournal=<address>");
     hidden_args.emplace_back("-zmqpubrawblock=<address>");
     hidden_args.emplace_back("-zmqpubrawtx=<address>");
     hidden_args.emplace_back("-zmqpubsequence=<n>");
     hidden_args.emplace_back("-zmqpubhashblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubhashtxhwm=<n>");
+    hidden_args.emplace_back("-zmqpubjournalhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawtxhwm=<n>");
     hidden_args.emplace_back("-zmqpubsequencehwm=<n>");
@@ -621,12 +682,15 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-blockmaxweight=<n>", strprintf("Set maximum BIP141 block weight (default: %d)", DEFAULT_BLOCK_MAX_WEIGHT), ArgsManager::ALLOW_ANY, OptionsCategory::BLOCK_CREATION);
     argsman.AddArg("-blockmintxfee=<amt>", strprintf("Set lowest fee rate (in %s/kB) for transactions to be included in block creation. (default: %s)", CURRENCY_UNIT, FormatMoney(DEFAULT_BLOCK_MIN_TX_FEE)), ArgsManager::ALLOW_ANY, OptionsCategory::BLOCK_CREATION);
     argsman.AddArg("-blockversion=<n>", "Override block version to test forking scenarios", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::BLOCK_CREATION);
+    argsman.AddArg("-genthreads=<n>", strprintf("Set the number of threads used to search for proof-of-work by the block generation RPCs (<= 0 = number of cores, default: %d)", DEFAULT_GENERATE_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::BLOCK_CREATION);
 
     argsman.AddArg("-rest", strprintf("Accept public REST requests (default: %u)", DEFAULT_REST_ENABLE), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcallowip=<ip>", "Allow JSON-RPC connections from specified source. Valid for <ip> are a single IP (e.g. 1.2.3.4), a network/netmask (e.g. 1.2.3.4/255.255.255.0) or a network/CIDR (e.g. 1.2.3.4/24). This option can be specified multiple times", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcauth=<userpw>", "Username and HMAC-SHA-256 hashed password for JSON-RPC connections. The field <userpw> comes in the format: <USERNAME>:<SALT>$<HASH>. A canonical python script is included in share/rpcauth. The client then connects normally using the rpcuser=<USERNAME>/rpcpassword=<PASSWORD> pair of arguments. This option can be specified multiple times", ArgsManager::ALLOW_ANY | ArgsManager::SENSITIVE, OptionsCategory::RPC);
+    argsman.AddArg("-rpcbatchthreads=<n>", strprintf("Number of additional RPC threads a single JSON-RPC batch may use to run consecutive read-only calls in parallel (default: %d)", DEFAULT_RPC_BATCH_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcbind=<addr>[:port]", "Bind to given address to listen for JSON-RPC connections. Do not expose the RPC server to untrusted networks such as the public internet! This option is ignored unless -rpcallowip is also passed. Port is optional and overrides -rpcport. Use [host]:port notation for IPv6. This option can be specified multiple times (default: 127.0.0.1 and ::1 i.e., localhost)", ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY | ArgsManager::SENSITIVE, OptionsCategory::RPC);
     argsman.AddArg("-rpccookiefile=<loc>", "Location of the auth cookie. Relative paths will be prefixed by a net-specific datadir location. (default: data dir)", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
+    argsman.AddArg("-rpcmethodpriority=<priority>:<method>,...", "Queue calls to the given JSON-RPC methods with a priority of high, normal or low. Can be specified multiple times (default: high for cheap status calls such as getblockcount, low for calls that walk the UTXO set or the chain such as scantxoutset, normal otherwise)", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcpassword=<pw>", "Password for JSON-RPC connections", ArgsManager::ALLOW_ANY | ArgsManager::SENSITIVE, OptionsCategory::RPC);
     argsman.AddArg("-rpcport=<port>", strprintf("Listen for JSON-RPC connections on <port> (default: %u, testnet: %u, signet: %u, regtest: %u)", defaultBaseParams->RPCPort(), testnetBaseParams->RPCPort(), signetBaseParams->RPCPort(), regtestBaseParams->RPCPort()), ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY, OptionsCategory::RPC);
     argsman.AddArg("-rpcserialversion", strprintf("Sets the serialization of raw transaction or block hex returned in non-verbose mode, non-segwit(0) or segwit(1) (default: %d)", DEFAULT_RPC_SERIALIZE_VERSION), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
@@ -635,7 +699,8 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-rpcuser=<user>", "Username for JSON-RPC connections", ArgsManager::ALLOW_ANY | ArgsManager::SENSITIVE, OptionsCategory::RPC);
     argsman.AddArg("-rpcwhitelist=<whitelist>", "Set a whitelist to filter incoming RPC calls for a specific user. The field <whitelist> comes in the format: <USERNAME>:<rpc 1>,<rpc 2>,...,<rpc n>. If multiple whitelists are set for a given user, they are set-intersected. See -rpcwhitelistdefault documentation for information on default whitelist behavior.", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcwhitelistdefault", "Sets default behavior for rpc whitelisting. Unless rpcwhitelistdefault is set to 0, if any -rpcwhitelist is set, the rpc server acts as if all rpc users are subject to empty-unless-otherwise-specified whitelists. If rpcwhitelistdefault is set to 1 and no -rpcwhitelist is set, rpc server acts as if all rpc users are subject to empty whitelists.", ArgsManager::ALLOW_BOOL, OptionsCategory::RPC);
-    argsman.AddArg("-rpcworkqueue=<n>", strprintf("Set the depth of the work queue to service RPC calls (default: %d)", DEFAULT_HTTP_WORKQUEUE), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::RPC);
+    argsman.AddArg("-rpcworkqueue=<n>", strprintf("Set the depth of each priority's work queue to service RPC calls (default: %d)", DEFAULT_HTTP_WORKQUEUE), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::RPC);
+    argsman.AddArg("-rpcworkthreads=<priority>:<n>", "Limit how many RPC threads may serve requests of a priority (high, normal or low) at once. Can be specified multiple times (default: all threads for high, all but one for normal, half for low). Normal and low together never use more than all but one thread", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-server", "Accept command line and JSON-RPC commands", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
 //>SIN
     argsman.AddArg("-infinitynode", "Start the node as an InfinityNode", ArgsManager::ALLOW_ANY, OptionsCategory::INFINITYNODE);
@@ -1083,11 +1148,30 @@ bool AppInitParameterInteraction(const ArgsManager& args)
     if (args.GetArg("-prune", 0)) {
         if (args.GetBoolArg("-txindex", DEFAULT_TXINDEX))
             return InitError(_("Prune mode is incompatible with -txindex."));
+        if (args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX))
+            return InitError(_("Prune mode is incompatible with -addressindex."));
+        if (args.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX))
+            return InitError(_("Prune mode is incompatible with -spentindex."));
+        if (args.GetBoolArg("-coinstatsindex", DEFAULT_COINSTATSINDEX))
+            return InitError(_("Prune mode is incompatible with -coinstatsindex."));
         if (!g_enabled_filter_types.empty()) {
             return InitError(_("Prune mode is incompatible with -blockfilterindex."));
         }
     }
 
+    // validate -dboption before any database is opened
+    for (const std::string& option : args.GetArgs("-dboption")) {
+        const std::string db = option.substr(0, option.find(':'));
+        if (db != "chainstate" && db != "blocktree" && db != "txindex" && db != "blockfilter" && db != "addressindex" && db != "spentindex" && db != "coinstatsindex") {
+            return InitError(strprintf(_("Unknown database in -dboption=%s."), option));
+        }
+        DBOptions db_options;
+        std::string error;
+        if (!ApplyDBOptionArgs(args, db, db_options, error)) {
+            return InitError(Untranslated(error));
+        }
+    }
+
     // -bind and -whitebind can't be set when not listening
     size_t nUserBind = args.GetArgs("-bind").size() + args.GetArgs("-whitebind").size();
     if (nUserBind != 0 && !args.GetBoolArg("-listen", DEFAULT_LISTEN)) {
@@ -1192,6 +1276,11 @@ bool AppInitParameterInteraction(const ArgsManager& args)
         fPruneMode = true;
     }
 
+    const int64_t event_journal_mb = args.GetArg("-eventjournal", DEFAULT_EVENT_JOURNAL_MB);
+    if (event_journal_mb != 0 && event_journal_mb < MIN_EVENT_JOURNAL_MB) {
+        return InitError(strprintf(_("Event journal configured below the minimum of %d MiB.  Please use a higher number."), MIN_EVENT_JOURNAL_MB));
+    }
+
     nConnectTimeout = args.GetArg("-timeout", DEFAULT_CONNECT_TIMEOUT);
     if (nConnectTimeout <= 0) {
         nConnectTimeout = DEFAULT_CONNECT_TIMEOUT;
@@ -1285,6 +1374,8 @@ bool AppInitSanityChecks()
     // Initialize elliptic curve code
     std::string sha256_algo = SHA256AutoDetect();
     LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    std::string x11_aes_algo = X11AESAutoDetect();
+    LogPrintf("Using the '%s' Groestl/ECHO/SHAvite implementation\n", x11_aes_algo);
     RandomInit();
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -1431,6 +1522,16 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
         }
     }
 
+    // Header hashing gets its own pool of the same size, so that hashing a
+    // headers message never waits behind block script checks.
+    if (script_threads >= 1) {
+        LogPrintf("Header hashing uses %d additional threads\n", script_threads);
+        g_parallel_header_hashing = true;
+        for (int i = 0; i < script_threads; ++i) {
+            threadGroup.create_thread([i]() { return ThreadHeaderHash(i); });
+        }
+    }
+
     assert(!node.scheduler);
     node.scheduler = MakeUnique<CScheduler>();
 
@@ -1613,6 +1714,15 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
         LogPrintf("Using /16 prefix for IP bucketing\n");
     }
 
+    // The journal comes first, so that ZMQ notifiers can publish its events.
+    const int64_t event_journal_mb = args.GetArg("-eventjournal", DEFAULT_EVENT_JOURNAL_MB);
+    if (event_journal_mb > 0) {
+        g_event_journal = MakeUnique<EventJournal>(GetDataDir() / "journal", event_journal_mb << 20);
+        if (!g_event_journal->Init()) {
+            return InitError(_("Unable to open the event journal"));
+        }
+    }
+
 #if ENABLE_ZMQ
     g_zmq_notification_interface = CZMQNotificationInterface::Create();
 
@@ -1679,6 +1789,12 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
     nTotalCache -= nBlockTreeDBCache;
     int64_t nTxIndexCache = std::min(nTotalCache / 8, args.GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxTxIndexCache << 20 : 0);
     nTotalCache -= nTxIndexCache;
+    int64_t address_index_cache = std::min(nTotalCache / 8, args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) ? nMaxTxIndexCache << 20 : 0);
+    nTotalCache -= address_index_cache;
+    int64_t spent_index_cache = std::min(nTotalCache / 8, args.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) ? nMaxTxIndexCache << 20 : 0);
+    nTotalCache -= spent_index_cache;
+    int64_t coin_stats_index_cache = std::min(nTotalCache / 8, args.GetBoolArg("-coinstatsindex", DEFAULT_COINSTATSINDEX) ? nMaxTxIndexCache << 20 : 0);
+    nTotalCache -= coin_stats_index_cache;
     int64_t filter_index_cache = 0;
     if (!g_enabled_filter_types.empty()) {
         size_t n_indexes = g_enabled_filter_types.size();
@@ -1696,12 +1812,24 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
     if (args.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
         LogPrintf("* Using %.1f MiB for transaction index database\n", nTxIndexCache * (1.0 / 1024 / 1024));
     }
+    if (args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
+        LogPrintf("* Using %.1f MiB for address index database\n", address_index_cache * (1.0 / 1024 / 1024));
+    }
+    if (args.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX)) {
+        LogPrintf("* Using %.1f MiB for spent output index database\n", spent_index_cache * (1.0 / 1024 / 1024));
+    }
+    if (args.GetBoolArg("-coinstatsindex", DEFAULT_COINSTATSINDEX)) {
+        LogPrintf("* Using %.1f MiB for coin statistics index database\n", coin_stats_index_cache * (1.0 / 1024 / 1024));
+    }
     for (BlockFilterType filter_type : g_enabled_filter_types) {
         LogPrintf("* Using %.1f MiB for %s block filter index database\n",
                   filter_index_cache * (1.0 / 1024 / 1024), BlockFilterTypeName(filter_type));
     }
     LogPrintf("* Using %.1f MiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1f MiB for in-memory UTXO set (plus up to %.1f MiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
+    const int64_t nBlockCacheMB = std::max<int64_t>(0, args.GetArg("-blockcachemb", DEFAULT_BLOCK_CACHE_MB));
+    g_block_cache.SetMaxUsage(nBlockCacheMB << 20);
+    LogPrintf("* Using %d MiB for recent blocks\n", nBlockCacheMB);
 
     bool fLoaded = false;
     while (!fLoaded && !ShutdownRequested()) {
@@ -1933,12 +2061,35 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
         ::feeEstimator.Read(est_filein);
     fFeeEstimatesInitialized = true;
 
+    // Journal the blocks connected since the journal was last written to,
+    // such as ones lost to a crash before their events were journaled.
+    if (g_event_journal) {
+        LOCK(cs_main);
+        g_event_journal->CatchUp(chainman.ActiveChain());
+        RegisterValidationInterface(g_event_journal.get());
+    }
+
     // ********************************************************* Step 8: start indexers
     if (args.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
         g_txindex = MakeUnique<TxIndex>(nTxIndexCache, false, fReindex);
         g_txindex->Start();
     }
 
+    if (args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
+        g_addressindex = MakeUnique<AddressIndex>(address_index_cache, false, fReindex);
+        g_addressindex->Start();
+    }
+
+    if (args.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX)) {
+        g_spentindex = MakeUnique<SpentIndex>(spent_index_cache, false, fReindex);
+        g_spentindex->Start();
+    }
+
+    if (args.GetBoolArg("-coinstatsindex", DEFAULT_COINSTATSINDEX)) {
+        g_coin_stats_index = MakeUnique<CoinStatsIndex>(coin_stats_index_cache, false, fReindex);
+        g_coin_stats_index->Start();
+    }
+
     for (const auto& filter_type : g_enabled_filter_types) {
         InitBlockFilterIndex(filter_type, filter_index_cache, false, fReindex);
         GetBlockFilterIndex(filter_type)->Start();
@@ -2180,6 +2331,12 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
         banman->DumpBanlist();
     }, DUMP_BANS_INTERVAL);
 
+//>SIN
+    node.scheduler->scheduleEvery([]{
+        DumpInfinitynodeCaches(true);
+    }, DUMP_INFINITYNODE_INTERVAL);
+//<SIN
+
 #if HAVE_SYSTEM
     StartupNotify(args);
 #endif
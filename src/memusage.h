@@ -7,6 +7,7 @@
 
 #include <indirectmap.h>
 #include <prevector.h>
+#include <support/allocators/pool.h>
 
 #include <stdlib.h>
 
@@ -167,6 +168,16 @@ static inline size_t DynamicUsage(const std::unordered_map<X, Y, Z>& m)
     return MallocUsage(sizeof(unordered_node<std::pair<const X, Y> >)) * m.size() + MallocUsage(sizeof(void*) * m.bucket_count());
 }
 
+/** A pool-backed map uses whole chunks of its resource, however many nodes are live. */
+template<typename X, typename Y, typename Z, typename E, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+static inline size_t DynamicUsage(const std::unordered_map<X, Y, Z, E, PoolAllocator<std::pair<const X, Y>, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>>& m)
+{
+    const auto* resource = m.get_allocator().resource();
+    // each chunk is tracked in a std::list node (two links and the pointer)
+    const size_t chunk_usage = MallocUsage(resource->ChunkSizeBytes()) + MallocUsage(sizeof(void*) * 3);
+    return chunk_usage * resource->NumAllocatedChunks() + MallocUsage(sizeof(void*) * m.bucket_count());
+}
+
 }
 
 #endif // BITCOIN_MEMUSAGE_H
@@ -19,6 +19,7 @@
 #include <policy/policy.h>
 #include <pow.h>
 #include <primitives/transaction.h>
+#include <shutdown.h>
 #include <timedata.h>
 #include <util/moneystr.h>
 #include <util/system.h>
@@ -33,6 +34,8 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
+#include <thread>
 #include <utility>
 
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev, bool fProofOfStake)
@@ -611,3 +614,104 @@ void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned
     pblock->vtx[0] = MakeTransactionRef(std::move(txCoinbase));
     pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
 }
+
+namespace {
+//! Number of nonces a search worker tries between cancellation checks
+constexpr uint64_t POW_SEARCH_CHECK_INTERVAL = 4096;
+
+std::atomic<double> g_last_pow_hashrate{0.0};
+
+bool TipMovedFrom(const uint256& hashPrevBlock)
+{
+    LOCK(g_best_block_mutex);
+    return !g_best_block.IsNull() && g_best_block != hashPrevBlock;
+}
+} // namespace
+
+PowSearchResult SearchProofOfWork(CBlockHeader& header, const Consensus::Params& params, int nThreads, uint64_t& max_tries)
+{
+    PowSearchResult result;
+    const int64_t nTimeStart = GetTimeMicros();
+    const uint32_t nonce_begin = header.nNonce;
+    const uint256 hashPrevBlock = header.hashPrevBlock;
+
+    // Like the serial loop, never test the last nonce and never exceed the
+    // caller's budget of tries.
+    const uint64_t span = std::min<uint64_t>(max_tries, std::numeric_limits<uint32_t>::max() - nonce_begin);
+    const uint64_t workers = std::max<uint64_t>(1, std::min<uint64_t>(std::max(nThreads, 1), span));
+
+    // Offset of the lowest valid nonce found so far (span if none)
+    std::atomic<uint64_t> best{span};
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> stale{false};
+    std::atomic<uint64_t> hashes{0};
+
+    auto worker = [&](uint64_t id) {
+        CBlockHeader work(header);
+        uint64_t nHashes = 0;
+        uint64_t next_check = 0;
+        for (uint64_t offset = id; offset < best.load(std::memory_order_relaxed); offset += workers) {
+            if (nHashes >= next_check) {
+                next_check = nHashes + POW_SEARCH_CHECK_INTERVAL;
+                if (cancelled.load(std::memory_order_relaxed)) break;
+                if (ShutdownRequested()) {
+                    cancelled = true;
+                    break;
+                }
+                if (TipMovedFrom(hashPrevBlock)) {
+                    stale = true;
+                    cancelled = true;
+                    break;
+                }
+            }
+            work.nNonce = nonce_begin + offset;
+            ++nHashes;
+            if (CheckProofOfWork(work.GetValidationHash(), work.nBits, params)) {
+                uint64_t current = best.load();
+                while (offset < current && !best.compare_exchange_weak(current, offset)) {}
+                break;
+            }
+        }
+        hashes += nHashes;
+    };
+
+    if (span > 0) {
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        for (uint64_t id = 1; id < workers; ++id) {
+            threads.emplace_back(worker, id);
+        }
+        worker(0);
+        for (std::thread& t : threads) {
+            t.join();
+        }
+    }
+
+    result.hashes = hashes;
+    result.elapsed = GetTimeMicros() - nTimeStart;
+    if (cancelled) {
+        // A worker may have stopped before reaching a lower nonce than the one
+        // recorded, so a partial search never reports a result.
+        result.stale = stale;
+        max_tries -= std::min(max_tries, result.hashes);
+    } else if (best < span) {
+        result.found = true;
+        header.nNonce = nonce_begin + best;
+        max_tries -= best;
+    } else {
+        header.nNonce = nonce_begin + span;
+        max_tries -= span;
+    }
+
+    const double hashrate = result.elapsed > 0 ? result.hashes * 1000000.0 / result.elapsed : 0.0;
+    g_last_pow_hashrate = hashrate;
+    LogPrint(BCLog::BENCH, "%s: %u hashes in %.2fms on %u threads (%.0f H/s)%s\n", __func__,
+        result.hashes, 0.001 * result.elapsed, workers, hashrate, result.found ? "" : " - no solution");
+
+    return result;
+}
+
+double GetLastPowSearchHashRate()
+{
+    return g_last_pow_hashrate;
+}
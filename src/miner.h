@@ -28,6 +28,8 @@ class CScript;
 namespace Consensus { struct Params; };
 
 static const bool DEFAULT_PRINTPRIORITY = false;
+/** Default number of threads used by the RPC block generator's nonce search */
+static const int DEFAULT_GENERATE_THREADS = 1;
 
 struct CBlockTemplate
 {
@@ -211,4 +213,32 @@ int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParam
 /** Update an old GenerateCoinbaseCommitment from CreateNewBlock after the block txs have changed */
 void RegenerateCommitments(CBlock& block);
 
+/** Outcome of a proof-of-work nonce search */
+struct PowSearchResult {
+    //! A valid nonce was found and written to the header
+    bool found{false};
+    //! The search was abandoned because the active tip moved away from hashPrevBlock
+    bool stale{false};
+    //! Number of header hashes computed across all threads
+    uint64_t hashes{0};
+    //! Wall-clock duration of the search in microseconds
+    int64_t elapsed{0};
+};
+
+/**
+ * Search for a nonce satisfying header.nBits, starting at header.nNonce.
+ *
+ * The nonce range is interleaved across nThreads workers and the lowest
+ * valid nonce wins, so the result is identical to a single-threaded linear
+ * scan regardless of the thread count. On return header.nNonce holds the
+ * winning nonce, or the first nonce that was not searched, and max_tries has
+ * been reduced by the number of nonces consumed, as the serial loop would.
+ * The search is cancelled on shutdown and when the active tip no longer
+ * matches header.hashPrevBlock.
+ */
+PowSearchResult SearchProofOfWork(CBlockHeader& header, const Consensus::Params& params, int nThreads, uint64_t& max_tries);
+
+/** Hash rate (hashes per second) achieved by the most recent SearchProofOfWork call */
+double GetLastPowSearchHashRate();
+
 #endif // BITCOIN_MINER_H
@@ -1592,11 +1592,9 @@ void static ProcessGetBlockData(CNode& pfrom, const CChainParams& chainparams, c
             connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::BLOCK, MakeSpan(block_data)));
             // Don't set pblock as we've sent the block
         } else {
-            // Send block from disk
-            std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
-            if (!ReadBlockFromDisk(*pblockRead, pindex, consensusParams))
+            // Send block from the recent-block cache or disk
+            if (!ReadBlockFromDisk(pblock, pindex, consensusParams))
                 assert(!"cannot load block from disk");
-            pblock = pblockRead;
         }
         if (pblock) {
             if (inv.IsMsgBlk()) {
@@ -1877,6 +1875,10 @@ void PeerManager::ProcessHeadersMessage(CNode& pfrom, const std::vector<CBlockHe
         return;
     }
 
+    // Hash the headers before taking cs_main, on the header-hashing threads
+    // if there are any; the result is reused by ProcessNewBlockHeaders.
+    const std::vector<uint256> hashes = ComputeHeaderHashes(headers);
+
     bool received_new_header = false;
     const CBlockIndex *pindexLast = nullptr;
     {
@@ -1895,14 +1897,14 @@ void PeerManager::ProcessHeadersMessage(CNode& pfrom, const std::vector<CBlockHe
             nodestate->nUnconnectingHeaders++;
             m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::GETHEADERS, ::ChainActive().GetLocator(pindexBestHeader), uint256()));
             LogPrint(BCLog::NET, "received header %s: missing prev block %s, sending getheaders (%d) to end (peer=%d, nUnconnectingHeaders=%d)\n",
-                    headers[0].GetHash().ToString(),
+                    hashes[0].ToString(),
                     headers[0].hashPrevBlock.ToString(),
                     pindexBestHeader->nHeight,
                     pfrom.GetId(), nodestate->nUnconnectingHeaders);
             // Set hashLastUnknownBlock for this peer, so that if we
             // eventually get the headers - even from a different peer -
             // we can use this peer to download.
-            UpdateBlockAvailability(pfrom.GetId(), headers.back().GetHash());
+            UpdateBlockAvailability(pfrom.GetId(), hashes.back());
 
             if (nodestate->nUnconnectingHeaders % MAX_UNCONNECTING_HEADERS == 0) {
                 Misbehaving(pfrom.GetId(), 20, strprintf("%d non-connecting headers", nodestate->nUnconnectingHeaders));
@@ -1911,12 +1913,12 @@ void PeerManager::ProcessHeadersMessage(CNode& pfrom, const std::vector<CBlockHe
         }
 
         uint256 hashLastBlock;
-        for (const CBlockHeader& header : headers) {
-            if (!hashLastBlock.IsNull() && header.hashPrevBlock != hashLastBlock) {
+        for (size_t i = 0; i < nCount; ++i) {
+            if (!hashLastBlock.IsNull() && headers[i].hashPrevBlock != hashLastBlock) {
                 Misbehaving(pfrom.GetId(), 20, "non-continuous headers sequence");
                 return;
             }
-            hashLastBlock = header.GetHash();
+            hashLastBlock = hashes[i];
         }
 
         // If we don't have the last header, then they'll have given us
@@ -1927,7 +1929,7 @@ void PeerManager::ProcessHeadersMessage(CNode& pfrom, const std::vector<CBlockHe
     }
 
     BlockValidationState state;
-    if (!m_chainman.ProcessNewBlockHeaders(headers, state, m_chainparams, &pindexLast)) {
+    if (!m_chainman.ProcessNewBlockHeaders(headers, state, m_chainparams, &pindexLast, &hashes)) {
         if (state.IsInvalid()) {
             MaybePunishNodeForBlock(pfrom.GetId(), state, via_compact_block, "invalid header received");
             return;
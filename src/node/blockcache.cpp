@@ -0,0 +1,79 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockcache.h>
+
+#include <core_memusage.h>
+#include <memusage.h>
+
+CBlockCache g_block_cache(DEFAULT_BLOCK_CACHE_MB << 20);
+
+std::shared_ptr<const CBlock> CBlockCache::Get(const uint256& hash)
+{
+    LOCK(m_mutex);
+    auto it = m_index.find(hash);
+    if (it == m_index.end()) {
+        ++m_misses;
+        return nullptr;
+    }
+    ++m_hits;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->block;
+}
+
+void CBlockCache::Insert(const uint256& hash, const std::shared_ptr<const CBlock>& block)
+{
+    // Account for the block itself plus the list node and index entry
+    const size_t usage = sizeof(CBlock) + RecursiveDynamicUsage(*block) + 2 * memusage::MallocUsage(sizeof(Entry) + 2 * sizeof(void*));
+
+    LOCK(m_mutex);
+    if (usage > m_max_usage) return;
+    auto it = m_index.find(hash);
+    if (it != m_index.end()) {
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return;
+    }
+    m_entries.push_front(Entry{hash, block, usage});
+    m_index.emplace(hash, m_entries.begin());
+    m_usage += usage;
+    TrimToSize();
+}
+
+void CBlockCache::SetMaxUsage(size_t max_usage)
+{
+    LOCK(m_mutex);
+    m_max_usage = max_usage;
+    TrimToSize();
+}
+
+void CBlockCache::Clear()
+{
+    LOCK(m_mutex);
+    m_index.clear();
+    m_entries.clear();
+    m_usage = 0;
+}
+
+CBlockCache::Stats CBlockCache::GetStats() const
+{
+    LOCK(m_mutex);
+    Stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.entries = m_entries.size();
+    stats.usage = m_usage;
+    stats.max_usage = m_max_usage;
+    return stats;
+}
+
+void CBlockCache::TrimToSize()
+{
+    AssertLockHeld(m_mutex);
+    while (m_usage > m_max_usage && !m_entries.empty()) {
+        const Entry& oldest = m_entries.back();
+        m_usage -= oldest.usage;
+        m_index.erase(oldest.hash);
+        m_entries.pop_back();
+    }
+}
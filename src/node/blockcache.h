@@ -0,0 +1,83 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKCACHE_H
+#define BITCOIN_NODE_BLOCKCACHE_H
+
+#include <crypto/common.h>
+#include <primitives/block.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+//! Default for -blockcachemb, the memory budget of the recent-block cache
+static const int64_t DEFAULT_BLOCK_CACHE_MB = 32;
+
+/**
+ * Memory-bounded LRU cache of deserialized blocks keyed by block hash.
+ *
+ * Blocks are shared, immutable and reference counted, so a block handed out
+ * stays valid after it has been evicted. The cache is filled when blocks are
+ * connected and when they are read from disk, so repeated reads of blocks
+ * near the tip neither touch disk nor deserialize again.
+ */
+class CBlockCache
+{
+public:
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        size_t entries{0};
+        size_t usage{0};
+        size_t max_usage{0};
+    };
+
+    explicit CBlockCache(size_t max_usage) : m_max_usage(max_usage) {}
+
+    /** Return the cached block with this hash, or nullptr (counted as a miss) */
+    std::shared_ptr<const CBlock> Get(const uint256& hash);
+
+    /**
+     * Insert a block under its hash (passed in, as computing it is costly),
+     * evicting the least recently used blocks to stay within budget.
+     */
+    void Insert(const uint256& hash, const std::shared_ptr<const CBlock>& block);
+
+    /** Change the memory budget (0 disables the cache) */
+    void SetMaxUsage(size_t max_usage);
+
+    void Clear();
+    Stats GetStats() const;
+
+private:
+    struct Entry {
+        uint256 hash;
+        std::shared_ptr<const CBlock> block;
+        size_t usage;
+    };
+    struct EntryHasher {
+        size_t operator()(const uint256& hash) const { return ReadLE64(hash.begin()); }
+    };
+    typedef std::list<Entry> EntryList;
+
+    void TrimToSize() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+    mutable Mutex m_mutex;
+    //! Most recently used entries first
+    EntryList m_entries GUARDED_BY(m_mutex);
+    std::unordered_map<uint256, EntryList::iterator, EntryHasher> m_index GUARDED_BY(m_mutex);
+    size_t m_usage GUARDED_BY(m_mutex){0};
+    size_t m_max_usage GUARDED_BY(m_mutex);
+    uint64_t m_hits GUARDED_BY(m_mutex){0};
+    uint64_t m_misses GUARDED_BY(m_mutex){0};
+};
+
+/** Cache shared by all readers of recent blocks, sized by -blockcachemb */
+extern CBlockCache g_block_cache;
+
+#endif // BITCOIN_NODE_BLOCKCACHE_H
@@ -0,0 +1,119 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockprefetch.h>
+
+#include <chain.h>
+#include <node/blockcache.h>
+#include <optional.h>
+#include <tinyformat.h>
+#include <util/threadnames.h>
+#include <validation.h>
+
+BlockPrefetcher::BlockPrefetcher(const Consensus::Params& params, size_t max_ahead, int threads, bool check_pow)
+    : m_params(params), m_max_ahead(std::max<size_t>(max_ahead, 1)), m_check_pow(check_pow)
+{
+    for (int i = 0; i < std::max(threads, 1); ++i) {
+        m_threads.emplace_back([this, i] {
+            util::ThreadRename(strprintf("blkprefetch.%i", i));
+            ThreadRead();
+        });
+    }
+}
+
+BlockPrefetcher::~BlockPrefetcher()
+{
+    {
+        LOCK(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+bool BlockPrefetcher::Prefetch(const CBlockIndex* pindex)
+{
+    {
+        LOCK(m_mutex);
+        if (m_entries.count(pindex)) return true;
+        if (m_entries.size() >= m_max_ahead) return false;
+    }
+    const Request request = MakeRequest(pindex);
+    {
+        LOCK(m_mutex);
+        if (!m_entries.emplace(pindex, Entry{}).second) return true;
+        m_queue.push_back(request);
+    }
+    m_cv.notify_all();
+    return true;
+}
+
+std::shared_ptr<const CBlock> BlockPrefetcher::Get(const CBlockIndex* pindex)
+{
+    {
+        WAIT_LOCK(m_mutex, lock);
+        auto it = m_entries.find(pindex);
+        if (it != m_entries.end()) {
+            m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return it->second.done; });
+            std::shared_ptr<const CBlock> block = std::move(it->second.block);
+            m_entries.erase(it);
+            return block;
+        }
+    }
+    return Read(MakeRequest(pindex));
+}
+
+void BlockPrefetcher::Clear()
+{
+    LOCK(m_mutex);
+    m_queue.clear();
+    m_entries.clear();
+    ++m_generation;
+}
+
+BlockPrefetcher::Request BlockPrefetcher::MakeRequest(const CBlockIndex* pindex) const
+{
+    LOCK(cs_main);
+    return Request{pindex, pindex->GetBlockPos(), IsBlockReadTrusted(pindex, m_check_pow)};
+}
+
+std::shared_ptr<const CBlock> BlockPrefetcher::Read(const Request& request) const
+{
+    if (!m_check_pow) {
+        if (std::shared_ptr<const CBlock> cached = g_block_cache.Get(request.pindex->GetBlockHash())) return cached;
+    }
+    std::shared_ptr<CBlock> block = std::make_shared<CBlock>();
+    if (!ReadIndexedBlockFromDisk(*block, request.pindex, request.pos, request.trusted, m_params)) return nullptr;
+    return block;
+}
+
+void BlockPrefetcher::ThreadRead()
+{
+    while (true) {
+        Optional<Request> request;
+        uint64_t generation;
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stop || !m_queue.empty(); });
+            if (m_stop) return;
+            request = m_queue.front();
+            m_queue.pop_front();
+            generation = m_generation;
+        }
+
+        std::shared_ptr<const CBlock> block = Read(*request);
+
+        {
+            LOCK(m_mutex);
+            if (generation != m_generation) continue;
+            auto it = m_entries.find(request->pindex);
+            if (it == m_entries.end()) continue;
+            it->second.done = true;
+            it->second.block = std::move(block);
+        }
+        m_cv.notify_all();
+    }
+}
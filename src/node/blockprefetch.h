@@ -0,0 +1,92 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKPREFETCH_H
+#define BITCOIN_NODE_BLOCKPREFETCH_H
+
+#include <flatfile.h>
+#include <primitives/block.h>
+#include <sync.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class CBlockIndex;
+namespace Consensus { struct Params; }
+
+//! Default number of blocks a BlockPrefetcher keeps read ahead
+static const size_t DEFAULT_PREFETCH_BLOCKS = 16;
+//! Default number of BlockPrefetcher reader threads
+static const int DEFAULT_PREFETCH_THREADS = 2;
+
+/**
+ * Reads blocks ahead of a sequential chain walk on background threads.
+ *
+ * The consumer announces the blocks it is about to visit with Prefetch(), in
+ * visiting order, and collects each one with Get(). Reader threads load and
+ * deserialize the announced blocks in parallel (checking them according to
+ * check_pow, as ReadBlockFromDisk does), so the walk only waits for the disk
+ * when it outruns the read-ahead window. Blocks already held by g_block_cache
+ * are taken from there; scanned blocks are not added to it.
+ */
+class BlockPrefetcher
+{
+public:
+    BlockPrefetcher(const Consensus::Params& params, size_t max_ahead = DEFAULT_PREFETCH_BLOCKS, int threads = DEFAULT_PREFETCH_THREADS, bool check_pow = false);
+    ~BlockPrefetcher();
+
+    BlockPrefetcher(const BlockPrefetcher&) = delete;
+    BlockPrefetcher& operator=(const BlockPrefetcher&) = delete;
+
+    /**
+     * Queue a read of a block that will be requested soon. Returns false,
+     * without queueing, when the read-ahead window is full. Takes cs_main
+     * briefly; the reader threads never do, so the consumer may hold it.
+     */
+    bool Prefetch(const CBlockIndex* pindex);
+
+    /**
+     * Return the block of pindex, waiting for its queued read or reading it
+     * directly if it was never queued. Returns nullptr if the read failed.
+     */
+    std::shared_ptr<const CBlock> Get(const CBlockIndex* pindex);
+
+    /** Drop all queued and completed reads, e.g. after the walk changed course */
+    void Clear();
+
+private:
+    //! Where to read a block from, captured under cs_main when it is requested
+    struct Request {
+        const CBlockIndex* pindex;
+        FlatFilePos pos;
+        bool trusted;
+    };
+    struct Entry {
+        bool done{false};
+        std::shared_ptr<const CBlock> block;
+    };
+
+    Request MakeRequest(const CBlockIndex* pindex) const;
+    std::shared_ptr<const CBlock> Read(const Request& request) const;
+    void ThreadRead();
+
+    const Consensus::Params& m_params;
+    const size_t m_max_ahead;
+    const bool m_check_pow;
+
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Request> m_queue GUARDED_BY(m_mutex);
+    std::unordered_map<const CBlockIndex*, Entry> m_entries GUARDED_BY(m_mutex);
+    //! Bumped by Clear() so that reads in flight at that point are discarded
+    uint64_t m_generation GUARDED_BY(m_mutex){0};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::vector<std::thread> m_threads;
+};
+
+#endif // BITCOIN_NODE_BLOCKPREFETCH_H
@@ -8,7 +8,9 @@
 #include <node/coinstats.h>
 
 #include <coins.h>
+#include <crypto/muhash.h>
 #include <hash.h>
+#include <index/coinstatsindex.h>
 #include <serialize.h>
 #include <uint256.h>
 #include <util/system.h>
@@ -16,7 +18,7 @@
 
 #include <map>
 
-static uint64_t GetBogoSize(const CScript& scriptPubKey)
+uint64_t GetBogoSize(const CScript& scriptPubKey)
 {
     return 32 /* txid */ +
            4 /* vout index */ +
@@ -26,6 +28,26 @@ static uint64_t GetBogoSize(const CScript& scriptPubKey)
            scriptPubKey.size() /* scriptPubKey */;
 }
 
+//! The MuHash set element of a coin: its outpoint, height and flags as in the coins database, and the output.
+static CDataStream TxOutSer(const COutPoint& outpoint, const Coin& coin)
+{
+    CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+    ss << outpoint;
+    ss << static_cast<uint32_t>(coin.nHeight * 4 + (coin.fCoinBase ? 1 : 0) + (coin.fCoinStake ? 2 : 0));
+    ss << coin.out;
+    return ss;
+}
+
+void ApplyCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& coin)
+{
+    muhash.Insert(MakeUCharSpan(TxOutSer(outpoint, coin)));
+}
+
+void RemoveCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& coin)
+{
+    muhash.Remove(MakeUCharSpan(TxOutSer(outpoint, coin)));
+}
+
 static void ApplyStats(CCoinsStats& stats, CHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
 {
     assert(!outputs.empty());
@@ -43,6 +65,18 @@ static void ApplyStats(CCoinsStats& stats, CHashWriter& ss, const uint256& hash,
     ss << VARINT(0u);
 }
 
+static void ApplyStats(CCoinsStats& stats, MuHash3072& muhash, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
+{
+    assert(!outputs.empty());
+    stats.nTransactions++;
+    for (const auto& output : outputs) {
+        ApplyCoinHash(muhash, COutPoint(hash, output.first), output.second);
+        stats.nTransactionOutputs++;
+        stats.nTotalAmount += output.second.out.nValue;
+        stats.nBogoSize += GetBogoSize(output.second.out.scriptPubKey);
+    }
+}
+
 static void ApplyStats(CCoinsStats& stats, std::nullptr_t, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
 {
     assert(!outputs.empty());
@@ -99,13 +133,28 @@ static bool GetUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, const
     return true;
 }
 
-bool GetUTXOStats(CCoinsView* view, CCoinsStats& stats, CoinStatsHashType hash_type, const std::function<void()>& interruption_point)
+bool GetUTXOStats(CCoinsView* view, CCoinsStats& stats, CoinStatsHashType hash_type, const std::function<void()>& interruption_point, const CBlockIndex* pindex, bool index_requested)
 {
+    // Use the coinstats index if it is available; it has no legacy hashes.
+    if (g_coin_stats_index && index_requested && hash_type != CoinStatsHashType::HASH_SERIALIZED) {
+        if (!pindex) {
+            LOCK(cs_main);
+            pindex = LookupBlockIndex(view->GetBestBlock());
+        }
+        stats = CCoinsStats();
+        stats.index_used = true;
+        return pindex && g_coin_stats_index->LookUpStats(pindex, stats);
+    }
+
     switch (hash_type) {
     case(CoinStatsHashType::HASH_SERIALIZED): {
         CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
         return GetUTXOStats(view, stats, ss, interruption_point);
     }
+    case(CoinStatsHashType::MUHASH): {
+        MuHash3072 muhash;
+        return GetUTXOStats(view, stats, muhash, interruption_point);
+    }
     case(CoinStatsHashType::NONE): {
         return GetUTXOStats(view, stats, nullptr, interruption_point);
     }
@@ -118,10 +167,17 @@ static void PrepareHash(CHashWriter& ss, CCoinsStats& stats)
 {
     ss << stats.hashBlock;
 }
+static void PrepareHash(MuHash3072& muhash, CCoinsStats& stats) {}
 static void PrepareHash(std::nullptr_t, CCoinsStats& stats) {}
 
 static void FinalizeHash(CHashWriter& ss, CCoinsStats& stats)
 {
     stats.hashSerialized = ss.GetHash();
 }
+static void FinalizeHash(MuHash3072& muhash, CCoinsStats& stats)
+{
+    uint256 out;
+    muhash.Finalize(out);
+    stats.hashSerialized = out;
+}
 static void FinalizeHash(std::nullptr_t, CCoinsStats& stats) {}
@@ -12,10 +12,16 @@
 #include <cstdint>
 #include <functional>
 
+class CBlockIndex;
 class CCoinsView;
+class COutPoint;
+class CScript;
+class Coin;
+class MuHash3072;
 
 enum class CoinStatsHashType {
     HASH_SERIALIZED,
+    MUHASH,
     NONE,
 };
 
@@ -32,9 +38,37 @@ struct CCoinsStats
 
     //! The number of coins contained.
     uint64_t coins_count{0};
+
+    //! Whether the stats were looked up in the coinstats index.
+    bool index_used{false};
+
+    // Following values are only available from the coinstats index. They are
+    // running totals from the genesis block up to and including this block.
+
+    //! Amount created by all blocks: coinbase and coinstake outputs minus the inputs they spent.
+    CAmount total_subsidy{0};
+    //! Amount sent to provably unspendable outputs, which never enter the UTXO set.
+    CAmount total_unspendable_amount{0};
+    //! Amount sent to the consensus burn address. These outputs stay in the UTXO set.
+    CAmount total_burned_amount{0};
+    CAmount total_prevout_spent_amount{0};
+    CAmount total_new_outputs_ex_coinbase_amount{0};
+    CAmount total_coinbase_amount{0};
 };
 
-//! Calculate statistics about the unspent transaction output set
-bool GetUTXOStats(CCoinsView* view, CCoinsStats& stats, const CoinStatsHashType hash_type, const std::function<void()>& interruption_point = {});
+/**
+ * Calculate statistics about the unspent transaction output set.
+ *
+ * With -coinstatsindex, MUHASH and NONE stats are looked up in the index for
+ * pindex (default: the view's best block) unless index_requested is false.
+ * Otherwise the whole view is walked, which only works for its best block.
+ */
+bool GetUTXOStats(CCoinsView* view, CCoinsStats& stats, const CoinStatsHashType hash_type, const std::function<void()>& interruption_point = {}, const CBlockIndex* pindex = nullptr, bool index_requested = true);
+
+uint64_t GetBogoSize(const CScript& script_pub_key);
+
+//! Add a coin to, or remove it from, a MuHash commitment of the UTXO set.
+void ApplyCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& coin);
+void RemoveCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& coin);
 
 #endif // BITCOIN_NODE_COINSTATS_H
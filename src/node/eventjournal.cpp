@@ -0,0 +1,343 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/eventjournal.h>
+
+#include <chain.h>
+#include <clientversion.h>
+#include <logging.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <streams.h>
+#include <tinyformat.h>
+#include <util/strencodings.h>
+#include <util/system.h>
+#include <util/threadnames.h>
+#include <validation.h>
+
+#include <algorithm>
+
+std::unique_ptr<EventJournal> g_event_journal;
+
+static constexpr uint64_t SEGMENT_SIZE = EventJournal::RECORDS_PER_SEGMENT * JournalEvent::SERIALIZED_SIZE;
+static_assert(uint64_t{MIN_EVENT_JOURNAL_MB} << 20 >= 2 * SEGMENT_SIZE, "-eventjournal minimum must hold two segments");
+
+EventJournal::EventJournal(fs::path dir, size_t max_size)
+    : m_dir(std::move(dir)), m_max_segments(std::max<uint64_t>(max_size / SEGMENT_SIZE, 2))
+{
+}
+
+EventJournal::~EventJournal()
+{
+    {
+        LOCK(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    if (m_sync_thread.joinable()) m_sync_thread.join();
+    {
+        LOCK(m_publish_guard->mutex);
+        m_publish_guard->stopped = true;
+    }
+
+    LOCK(m_mutex);
+    for (FILE* file : m_filled_files) fclose(file);
+    if (m_file) fclose(m_file);
+}
+
+fs::path EventJournal::SegmentPath(uint64_t segment) const
+{
+    return m_dir / strprintf("%08u.dat", segment);
+}
+
+bool EventJournal::Init()
+{
+    LOCK(m_mutex);
+    TryCreateDirectories(m_dir);
+
+    // Find the newest segment, and walk back to the oldest one of the
+    // unbroken run that ends in it.
+    bool found = false;
+    uint64_t last = 0;
+    for (fs::directory_iterator it(m_dir); it != fs::directory_iterator(); ++it) {
+        const std::string name = it->path().filename().string();
+        int64_t segment;
+        if (name.size() != 12 || name.substr(8) != ".dat" || !ParseInt64(name.substr(0, 8), &segment) || segment < 0) continue;
+        if (!found || (uint64_t)segment > last) last = segment;
+        found = true;
+    }
+    uint64_t first = last;
+    while (first > 0 && fs::exists(SegmentPath(first - 1))) --first;
+
+    uint64_t records = 0;
+    if (found) {
+        // Drop a partial event left by an unclean shutdown.
+        const fs::path path = SegmentPath(last);
+        const uint64_t size = fs::file_size(path);
+        records = std::min(size / JournalEvent::SERIALIZED_SIZE, RECORDS_PER_SEGMENT);
+        if (records * JournalEvent::SERIALIZED_SIZE != size) {
+            LogPrintf("%s: Truncating %s to %u events\n", __func__, path.string(), records);
+            fs::resize_file(path, records * JournalEvent::SERIALIZED_SIZE);
+        }
+    }
+    m_oldest = first * RECORDS_PER_SEGMENT;
+    m_next = last * RECORDS_PER_SEGMENT + records;
+    m_synced = m_next;
+
+    if (!OpenSegment(m_next / RECORDS_PER_SEGMENT)) return false;
+    PruneSegments();
+    LogPrintf("Event journal holds events %u to %u\n", m_oldest, m_next);
+
+    m_sync_thread = std::thread([this] {
+        util::ThreadRename("journalsync");
+        ThreadSync();
+    });
+    return true;
+}
+
+bool EventJournal::OpenSegment(uint64_t segment)
+{
+    m_file = fsbridge::fopen(SegmentPath(segment), "ab");
+    if (!m_file) {
+        LogPrintf("%s: Unable to open %s\n", __func__, SegmentPath(segment).string());
+        return false;
+    }
+    return true;
+}
+
+void EventJournal::PruneSegments()
+{
+    const uint64_t current = m_next / RECORDS_PER_SEGMENT;
+    while (current - m_oldest / RECORDS_PER_SEGMENT >= m_max_segments) {
+        fs::remove(SegmentPath(m_oldest / RECORDS_PER_SEGMENT));
+        m_oldest += RECORDS_PER_SEGMENT;
+    }
+}
+
+void EventJournal::Append(JournalEvent::Type type, const uint256& hash, uint64_t value)
+{
+    LOCK(m_mutex);
+    if (!m_file) return;
+
+    JournalEvent event;
+    event.sequence = m_next;
+    event.type = type;
+    event.hash = hash;
+    event.value = value;
+    std::vector<unsigned char> data;
+    CVectorWriter(SER_DISK, CLIENT_VERSION, data, 0) << event;
+    assert(data.size() == JournalEvent::SERIALIZED_SIZE);
+
+    if (fwrite(data.data(), 1, data.size(), m_file) != data.size() || fflush(m_file) != 0) {
+        // A partial event would misplace every later one, so stop here;
+        // the next startup truncates it away.
+        LogPrintf("%s: Failed to write event %u, no longer journaling\n", __func__, m_next);
+        m_filled_files.push_back(m_file);
+        m_file = nullptr;
+        m_cond.notify_all();
+        return;
+    }
+
+    ++m_next;
+    m_unsynced.push_back(event);
+    if (m_next % RECORDS_PER_SEGMENT == 0) {
+        m_filled_files.push_back(m_file);
+        m_file = nullptr;
+        OpenSegment(m_next / RECORDS_PER_SEGMENT);
+        PruneSegments();
+    }
+    m_cond.notify_all();
+}
+
+void EventJournal::ThreadSync()
+{
+    WAIT_LOCK(m_mutex, lock);
+    while (true) {
+        m_cond.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+            return m_stop || !m_unsynced.empty() || !m_filled_files.empty();
+        });
+        // Events appended before stopping are still synced.
+        if (m_unsynced.empty() && m_filled_files.empty()) return;
+
+        std::vector<JournalEvent> events;
+        events.swap(m_unsynced);
+        std::vector<FILE*> filled_files;
+        filled_files.swap(m_filled_files);
+        FILE* const file = m_file;
+        bool ok = true;
+        {
+            // Segments are only closed by this thread, so they stay open
+            // while appending continues into the current one.
+            REVERSE_LOCK(lock);
+            for (FILE* filled_file : filled_files) {
+                ok = FileCommit(filled_file) && ok;
+                fclose(filled_file);
+            }
+            if (file && !events.empty()) ok = FileCommit(file) && ok;
+        }
+
+        if (!ok) {
+            LogPrintf("%s: Failed to sync the journal, no longer journaling\n", __func__);
+            if (m_file) m_filled_files.push_back(m_file);
+            m_file = nullptr;
+            m_unsynced.clear();
+        } else if (!events.empty()) {
+            m_synced = events.back().sequence + 1;
+            // Publish from the validation interface queue, like other
+            // notifications, and in order since only this thread adds them.
+            if (!m_stop) {
+                CallFunctionInValidationInterfaceQueue([this, guard = m_publish_guard, events = std::move(events)] {
+                    LOCK(guard->mutex);
+                    if (guard->stopped) return;
+                    for (const JournalEvent& event : events) EventAppended(event);
+                });
+            }
+        }
+        m_cond.notify_all();
+    }
+}
+
+void EventJournal::WaitForSync()
+{
+    SyncWithValidationInterfaceQueue();
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_cond.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return !m_file || m_synced == m_next; });
+    }
+    SyncWithValidationInterfaceQueue();
+}
+
+bool EventJournal::Read(uint64_t from, size_t max_count, std::vector<JournalEvent>& events) const
+{
+    events.clear();
+    uint64_t synced;
+    {
+        LOCK(m_mutex);
+        if (from < m_oldest) return false;
+        synced = m_synced;
+    }
+
+    // Synced events never change, so they are read without holding the lock.
+    // A segment pruned in the meantime fails to open: its events are no
+    // longer kept.
+    const uint64_t end = from + std::min<uint64_t>(max_count, synced > from ? synced - from : 0);
+    for (uint64_t sequence = from; sequence < end;) {
+        const uint64_t segment = sequence / RECORDS_PER_SEGMENT;
+        const uint64_t segment_end = std::min(end, (segment + 1) * RECORDS_PER_SEGMENT);
+        CAutoFile file(fsbridge::fopen(SegmentPath(segment), "rb"), SER_DISK, CLIENT_VERSION);
+        if (file.IsNull() || fseek(file.Get(), (sequence % RECORDS_PER_SEGMENT) * JournalEvent::SERIALIZED_SIZE, SEEK_SET) != 0) {
+            if (segment >= OldestSequence() / RECORDS_PER_SEGMENT) {
+                LogPrintf("%s: Unable to open %s\n", __func__, SegmentPath(segment).string());
+            }
+            return false;
+        }
+        try {
+            for (; sequence < segment_end; ++sequence) {
+                events.emplace_back();
+                file >> events.back();
+            }
+        } catch (const std::exception& e) {
+            LogPrintf("%s: Unable to read %s: %s\n", __func__, SegmentPath(segment).string(), e.what());
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t EventJournal::OldestSequence() const
+{
+    LOCK(m_mutex);
+    return m_oldest;
+}
+
+uint64_t EventJournal::NextSequence() const
+{
+    LOCK(m_mutex);
+    return m_synced;
+}
+
+void EventJournal::AppendBlock(const CBlockIndex* pindex, bool connected)
+{
+    {
+        LOCK(m_mutex);
+        // Skip blocks that CatchUp already journaled, whose notifications were
+        // still queued when the journal was registered.
+        const bool journaled = m_tip && m_tip->GetAncestor(pindex->nHeight) == pindex;
+        if (connected == journaled) return;
+        m_tip = connected ? pindex : pindex->pprev;
+    }
+    Append(connected ? JournalEvent::BLOCK_CONNECT : JournalEvent::BLOCK_DISCONNECT, pindex->GetBlockHash(), pindex->nHeight);
+}
+
+void EventJournal::CatchUp(const CChain& chain)
+{
+    AssertLockHeld(cs_main);
+
+    // Find the block the journal last saw the chain at, from its newest block event.
+    const CBlockIndex* journal_tip = nullptr;
+    bool found = false;
+    std::vector<JournalEvent> events;
+    const uint64_t oldest = OldestSequence();
+    for (uint64_t end = NextSequence(); !found && end > oldest;) {
+        const uint64_t from = end - std::min<uint64_t>(end - oldest, RECORDS_PER_SEGMENT);
+        if (!Read(from, end - from, events)) break;
+        for (auto it = events.rbegin(); it != events.rend(); ++it) {
+            if (it->type != JournalEvent::BLOCK_CONNECT && it->type != JournalEvent::BLOCK_DISCONNECT) continue;
+            found = true;
+            const CBlockIndex* pindex = LookupBlockIndex(it->hash);
+            if (!pindex) {
+                LogPrintf("%s: Last journaled block %s is unknown, not catching up\n", __func__, it->hash.ToString());
+            } else {
+                journal_tip = it->type == JournalEvent::BLOCK_CONNECT ? pindex : pindex->pprev;
+            }
+            break;
+        }
+        end = from;
+    }
+    if (!journal_tip) {
+        // A new journal starts at the current tip.
+        LOCK(m_mutex);
+        m_tip = chain.Tip();
+        return;
+    }
+
+    {
+        LOCK(m_mutex);
+        m_tip = journal_tip;
+    }
+    const CBlockIndex* fork = chain.FindFork(journal_tip);
+    int disconnected = 0, connected = 0;
+    for (const CBlockIndex* pindex = journal_tip; pindex != fork; pindex = pindex->pprev) {
+        AppendBlock(pindex, false);
+        ++disconnected;
+    }
+    for (const CBlockIndex* pindex = fork ? chain.Next(fork) : chain.Genesis(); pindex; pindex = chain.Next(pindex)) {
+        AppendBlock(pindex, true);
+        ++connected;
+    }
+    if (disconnected > 0 || connected > 0) {
+        LogPrintf("Event journal caught up with %d disconnected and %d connected blocks\n", disconnected, connected);
+    }
+}
+
+void EventJournal::TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence)
+{
+    Append(JournalEvent::MEMPOOL_ACCEPT, tx->GetHash(), mempool_sequence);
+}
+
+void EventJournal::TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence)
+{
+    // Called for all non-block inclusion reasons
+    Append(JournalEvent::MEMPOOL_REMOVE, tx->GetHash(), mempool_sequence);
+}
+
+void EventJournal::BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    AppendBlock(pindex, true);
+}
+
+void EventJournal::BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    AppendBlock(pindex, false);
+}
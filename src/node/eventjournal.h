@@ -0,0 +1,154 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_EVENTJOURNAL_H
+#define BITCOIN_NODE_EVENTJOURNAL_H
+
+#include <fs.h>
+#include <serialize.h>
+#include <sync.h>
+#include <uint256.h>
+#include <validationinterface.h>
+
+#include <boost/signals2/signal.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class CBlockIndex;
+class CChain;
+
+extern RecursiveMutex cs_main;
+
+//! Default for -eventjournal, the size limit in MiB of the event journal (0 disables it)
+static const int64_t DEFAULT_EVENT_JOURNAL_MB = 0;
+//! Minimum for -eventjournal: two segments, the one being written and the one before it
+static const int64_t MIN_EVENT_JOURNAL_MB = 7;
+
+/** A journaled block connect/disconnect or mempool event. */
+struct JournalEvent {
+    //! The same labels as the ZMQ sequence topic
+    enum Type : char {
+        BLOCK_CONNECT = 'C',
+        BLOCK_DISCONNECT = 'D',
+        MEMPOOL_ACCEPT = 'A',
+        MEMPOOL_REMOVE = 'R',
+    };
+
+    static constexpr size_t SERIALIZED_SIZE = 8 + 1 + 32 + 8;
+
+    //! Position in the journal, counting up from 0 across restarts
+    uint64_t sequence{0};
+    char type{0};
+    //! Block hash or txid
+    uint256 hash;
+    //! Block height for block events, mempool sequence for mempool events
+    uint64_t value{0};
+
+    SERIALIZE_METHODS(JournalEvent, obj) { READWRITE(obj.sequence, obj.type, obj.hash, obj.value); }
+};
+
+/**
+ * Append-only journal of block connect/disconnect and mempool events, so that
+ * consumers of the live ZMQ notifications can resume from the last sequence
+ * number they saw instead of rescanning after a restart.
+ *
+ * Events have a fixed size and are kept in segment files of
+ * RECORDS_PER_SEGMENT events each, named by segment number, so the position
+ * of any event follows from its sequence number. The oldest segments are
+ * deleted to stay within the size limit.
+ *
+ * Events are written by the validation callbacks and synced to disk by a
+ * separate thread, which syncs everything appended since its previous sync in
+ * one go. Only synced events are readable and published through
+ * EventAppended, so a crash cannot take back an event a consumer has seen.
+ *
+ * Block events that were lost to a crash between connecting a block and
+ * journaling it are recovered by CatchUp() at startup.
+ */
+class EventJournal final : public CValidationInterface
+{
+public:
+    static constexpr uint64_t RECORDS_PER_SEGMENT = 1 << 16;
+
+    /** Keep at most max_size bytes of whole segments, but never fewer than two. */
+    EventJournal(fs::path dir, size_t max_size);
+    ~EventJournal();
+
+    /** Find the end of the journal on disk, open it for appending and start the sync thread. */
+    bool Init();
+
+    /**
+     * Journal the block disconnects and connects that take the last block
+     * event in the journal to the tip of the chain. Call before registering
+     * the journal for validation events, in the same cs_main section.
+     */
+    void CatchUp(const CChain& chain) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /**
+     * Read up to max_count events starting at sequence number from. Returns
+     * false if those events are no longer kept.
+     */
+    bool Read(uint64_t from, size_t max_count, std::vector<JournalEvent>& events) const;
+
+    /** Sequence number of the oldest event kept */
+    uint64_t OldestSequence() const;
+    /** Sequence number following the newest synced event */
+    uint64_t NextSequence() const;
+
+    /** Wait until the queued validation events are journaled, synced and published. Used by tests. */
+    void WaitForSync();
+
+    /** Fired for each event once it is synced, from the validation interface queue. */
+    boost::signals2::signal<void(const JournalEvent&)> EventAppended;
+
+protected:
+    void TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence) override;
+    void TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence) override;
+    void BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override;
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override;
+
+private:
+    //! Lets EventAppended calls still queued after destruction be dropped
+    struct PublishGuard {
+        Mutex mutex;
+        bool stopped GUARDED_BY(mutex){false};
+    };
+
+    void Append(JournalEvent::Type type, const uint256& hash, uint64_t value);
+    void AppendBlock(const CBlockIndex* pindex, bool connected);
+    void ThreadSync();
+    fs::path SegmentPath(uint64_t segment) const;
+    bool OpenSegment(uint64_t segment) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void PruneSegments() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+    const fs::path m_dir;
+    const uint64_t m_max_segments;
+
+    mutable Mutex m_mutex;
+    uint64_t m_oldest GUARDED_BY(m_mutex){0};
+    uint64_t m_next GUARDED_BY(m_mutex){0};
+    //! Events before this one are synced
+    uint64_t m_synced GUARDED_BY(m_mutex){0};
+    //! Segment being appended to, or nullptr once writing failed
+    FILE* m_file GUARDED_BY(m_mutex){nullptr};
+    //! Segments no longer appended to, for the sync thread to sync and close
+    std::vector<FILE*> m_filled_files GUARDED_BY(m_mutex);
+    //! Events appended since the last sync
+    std::vector<JournalEvent> m_unsynced GUARDED_BY(m_mutex);
+    std::condition_variable m_cond;
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::thread m_sync_thread;
+    const std::shared_ptr<PublishGuard> m_publish_guard{std::make_shared<PublishGuard>()};
+    //! Last block connected according to the journal's block events
+    const CBlockIndex* m_tip GUARDED_BY(m_mutex){nullptr};
+};
+
+/** The journal, if -eventjournal is set */
+extern std::unique_ptr<EventJournal> g_event_journal;
+
+#endif // BITCOIN_NODE_EVENTJOURNAL_H
@@ -19,7 +19,6 @@ class uint256;
 const CBlockIndex* GetLastBlockIndex(const CBlockIndex* pindex, bool fProofOfStake = false);
 int CountPoS(const CBlockIndex* pindex, int nHeightScan);
 unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params&, bool fProofOfStake);
-unsigned int CalculateNextWorkRequired(const CBlockIndex* pindexLast, int64_t nFirstBlockTime, const Consensus::Params&);
 
 /** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
 bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&);
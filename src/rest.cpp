@@ -9,6 +9,7 @@
 #include <httpserver.h>
 #include <index/txindex.h>
 #include <node/context.h>
+#include <node/eventjournal.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <rpc/blockchain.h>
@@ -28,6 +29,7 @@
 #include <univalue.h>
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
+static const int32_t MAX_REST_BLOCK_SUMMARIES = 50000; //allow a max of 50000 block summaries per request
 
 enum class RetFormat {
     UNDEF,
@@ -228,6 +230,144 @@ static bool rest_headers(const util::Ref& context,
     }
 }
 
+/**
+ * Fixed-width summary of an active chain block, built from its CBlockIndex
+ * alone so that ranges can be served without reading block files.
+ */
+struct RESTBlockSummary {
+    static constexpr size_t SERIALIZED_SIZE = 80 + 32 + 4 + 4 + 4 + 32;
+
+    CBlockHeader header;
+    uint256 hash;
+    int32_t height{0};
+    //! CBlockIndex::nFlags, bit 0 marks proof-of-stake blocks
+    uint32_t flags{0};
+    uint32_t tx_count{0};
+    //! Zero for proof-of-work blocks
+    uint256 stake_modifier;
+
+    explicit RESTBlockSummary(const CBlockIndex* pindex)
+        : header(pindex->GetBlockHeader()), hash(pindex->GetBlockHash()), height(pindex->nHeight),
+          flags(pindex->nFlags), tx_count(pindex->nTx), stake_modifier(pindex->GetStakeModifier()) {}
+
+    SERIALIZE_METHODS(RESTBlockSummary, obj) { READWRITE(obj.header, obj.hash, obj.height, obj.flags, obj.tx_count, obj.stake_modifier); }
+};
+
+static bool rest_block_summaries(const util::Ref& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    if (path.size() != 2)
+        return RESTERR(req, HTTP_BAD_REQUEST, "No summary count specified. Use /rest/blocksummaries/<count>/<height>.<ext>.");
+
+    int32_t count;
+    if (!ParseInt32(path[0], &count) || count < 1 || count > MAX_REST_BLOCK_SUMMARIES)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Summary count out of range: " + SanitizeString(path[0]));
+
+    int32_t start;
+    if (!ParseInt32(path[1], &start) || start < 0)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid height: " + SanitizeString(path[1]));
+
+    if (rf == RetFormat::UNDEF)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+
+    std::vector<const CBlockIndex*> blocks;
+    int tip_height;
+    {
+        LOCK(cs_main);
+        const CChain& active_chain = ::ChainActive();
+        tip_height = active_chain.Height();
+        if (start > tip_height)
+            return RESTERR(req, HTTP_NOT_FOUND, "Block height out of range");
+        const int end = std::min<int64_t>(tip_height, (int64_t)start + count - 1);
+        blocks.reserve(end - start + 1);
+        for (int height = start; height <= end; ++height) {
+            blocks.push_back(active_chain[height]);
+        }
+    }
+
+    // The hash of the last block pins down the whole range, so the tag can be
+    // checked before anything is serialized. Ranges below the reorg limit
+    // never change and may be cached; the rest has to be revalidated.
+    const std::string etag = strprintf("\"%s-%d-%d-%d\"", blocks.back()->GetBlockHash().GetHex(), start, blocks.size(), (int)rf);
+    req->WriteHeader("ETag", etag);
+    if (tip_height - blocks.back()->nHeight >= Params().MaxReorganizationDepth()) {
+        req->WriteHeader("Cache-Control", "public, max-age=86400");
+    } else {
+        req->WriteHeader("Cache-Control", "no-cache");
+    }
+    const std::pair<bool, std::string> if_none_match = req->GetHeader("If-None-Match");
+    if (if_none_match.first && (if_none_match.second == "*" || if_none_match.second.find(etag) != std::string::npos)) {
+        req->WriteReply(HTTP_NOT_MODIFIED);
+        return true;
+    }
+
+    switch (rf) {
+    case RetFormat::BINARY:
+    case RetFormat::HEX: {
+        CDataStream ss_summaries(SER_NETWORK, PROTOCOL_VERSION);
+        ss_summaries.reserve(blocks.size() * RESTBlockSummary::SERIALIZED_SIZE);
+        for (const CBlockIndex* pindex : blocks) {
+            ss_summaries << RESTBlockSummary(pindex);
+        }
+        if (rf == RetFormat::BINARY) {
+            req->WriteHeader("Content-Type", "application/octet-stream");
+            req->WriteReply(HTTP_OK, ss_summaries.str());
+        } else {
+            req->WriteHeader("Content-Type", "text/plain");
+            req->WriteReply(HTTP_OK, HexStr(ss_summaries) + "\n");
+        }
+        return true;
+    }
+    case RetFormat::JSON: {
+        UniValue summaries(UniValue::VARR);
+        for (const CBlockIndex* pindex : blocks) {
+            UniValue entry(UniValue::VOBJ);
+            entry.pushKV("hash", pindex->GetBlockHash().GetHex());
+            entry.pushKV("height", pindex->nHeight);
+            entry.pushKV("version", pindex->nVersion);
+            entry.pushKV("previousblockhash", pindex->pprev ? pindex->pprev->GetBlockHash().GetHex() : uint256().GetHex());
+            entry.pushKV("merkleroot", pindex->hashMerkleRoot.GetHex());
+            entry.pushKV("time", (int64_t)pindex->nTime);
+            entry.pushKV("bits", strprintf("%08x", pindex->nBits));
+            entry.pushKV("nonce", (uint64_t)pindex->nNonce);
+            entry.pushKV("proofofstake", pindex->IsProofOfStake());
+            entry.pushKV("stakemodifier", pindex->GetStakeModifier().GetHex());
+            entry.pushKV("nTx", (uint64_t)pindex->nTx);
+            summaries.push_back(entry);
+        }
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, summaries.write() + "\n");
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
+/**
+ * Read the network serialization of a block. The bytes on disk already are
+ * that serialization unless witness data has to be stripped, so they are
+ * served as they are instead of being deserialized and serialized again.
+ */
+static bool ReadSerializedBlock(const CBlockIndex* pblockindex, std::vector<uint8_t>& block_data)
+{
+    if (RPCSerializationFlags() == 0) {
+        return ReadRawBlockFromDisk(block_data, pblockindex, Params().MessageStart());
+    }
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
+        return false;
+    CVectorWriter(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags(), block_data, 0) << block;
+    return true;
+}
+
 static bool rest_block(HTTPRequest* req,
                        const std::string& strURIPart,
                        bool showTxDetails)
@@ -241,7 +381,6 @@ static bool rest_block(HTTPRequest* req,
     if (!ParseHashStr(hashStr, hash))
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
-    CBlock block;
     CBlockIndex* pblockindex = nullptr;
     CBlockIndex* tip = nullptr;
     {
@@ -254,31 +393,32 @@ static bool rest_block(HTTPRequest* req,
 
         if (IsBlockPruned(pblockindex))
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
-
-        if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
-            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
     }
 
     switch (rf) {
     case RetFormat::BINARY: {
-        CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-        ssBlock << block;
-        std::string binaryBlock = ssBlock.str();
+        std::vector<uint8_t> block_data;
+        if (!ReadSerializedBlock(pblockindex, block_data))
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
         req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryBlock);
+        req->WriteReply(HTTP_OK, block_data);
         return true;
     }
 
     case RetFormat::HEX: {
-        CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-        ssBlock << block;
-        std::string strHex = HexStr(ssBlock) + "\n";
+        std::vector<uint8_t> block_data;
+        if (!ReadSerializedBlock(pblockindex, block_data))
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        std::string strHex = HexStr(block_data) + "\n";
         req->WriteHeader("Content-Type", "text/plain");
         req->WriteReply(HTTP_OK, strHex);
         return true;
     }
 
     case RetFormat::JSON: {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
         UniValue objBlock = blockToJSON(block, tip, pblockindex, showTxDetails);
         std::string strJSON = objBlock.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
@@ -666,26 +806,110 @@ static bool rest_blockhash_by_height(const util::Ref& context, HTTPRequest* req,
     }
 }
 
+static UniValue JournalEventToJSON(const JournalEvent& event)
+{
+    UniValue entry(UniValue::VOBJ);
+    entry.pushKV("sequence", event.sequence);
+    switch (event.type) {
+    case JournalEvent::BLOCK_CONNECT:
+    case JournalEvent::BLOCK_DISCONNECT:
+        entry.pushKV("type", event.type == JournalEvent::BLOCK_CONNECT ? "blockconnect" : "blockdisconnect");
+        entry.pushKV("hash", event.hash.GetHex());
+        entry.pushKV("height", event.value);
+        break;
+    default:
+        entry.pushKV("type", event.type == JournalEvent::MEMPOOL_ACCEPT ? "mempoolaccept" : "mempoolremove");
+        entry.pushKV("txid", event.hash.GetHex());
+        entry.pushKV("mempool_sequence", event.value);
+        break;
+    }
+    return entry;
+}
+
+static bool rest_events(const util::Ref& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    if (!g_event_journal) {
+        return RESTERR(req, HTTP_NOT_FOUND, "Event journal is disabled (see -eventjournal)");
+    }
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    if (path.size() != 2)
+        return RESTERR(req, HTTP_BAD_REQUEST, "No event count specified. Use /rest/events/<count>/<sequence>.<ext>.");
+
+    int32_t count;
+    if (!ParseInt32(path[0], &count) || count < 1 || count > 10000)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Event count out of range: " + SanitizeString(path[0]));
+
+    int64_t from;
+    if (!ParseInt64(path[1], &from) || from < 0)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid sequence number: " + SanitizeString(path[1]));
+
+    std::vector<JournalEvent> events;
+    if (!g_event_journal->Read(from, count, events)) {
+        return RESTERR(req, HTTP_NOT_FOUND, strprintf("Event %d is no longer in the journal, the oldest is %d", from, g_event_journal->OldestSequence()));
+    }
+
+    switch (rf) {
+    case RetFormat::BINARY: {
+        CDataStream ss_events(SER_DISK, CLIENT_VERSION);
+        for (const JournalEvent& event : events) ss_events << event;
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, ss_events.str());
+        return true;
+    }
+    case RetFormat::HEX: {
+        CDataStream ss_events(SER_DISK, CLIENT_VERSION);
+        for (const JournalEvent& event : events) ss_events << event;
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, HexStr(ss_events) + "\n");
+        return true;
+    }
+    case RetFormat::JSON: {
+        UniValue result(UniValue::VOBJ);
+        result.pushKV("oldest", g_event_journal->OldestSequence());
+        result.pushKV("next", g_event_journal->NextSequence());
+        UniValue json_events(UniValue::VARR);
+        for (const JournalEvent& event : events) json_events.push_back(JournalEventToJSON(event));
+        result.pushKV("events", json_events);
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, result.write() + "\n");
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(const util::Ref& context, HTTPRequest* req, const std::string& strReq);
+    HTTPWorkPriority priority;
 } uri_prefixes[] = {
-      {"/rest/tx/", rest_tx},
-      {"/rest/block/notxdetails/", rest_block_notxdetails},
-      {"/rest/block/", rest_block_extended},
-      {"/rest/chaininfo", rest_chaininfo},
-      {"/rest/mempool/info", rest_mempool_info},
-      {"/rest/mempool/contents", rest_mempool_contents},
-      {"/rest/headers/", rest_headers},
-      {"/rest/getutxos", rest_getutxos},
-      {"/rest/blockhashbyheight/", rest_blockhash_by_height},
+      {"/rest/tx/", rest_tx, HTTPWorkPriority::NORMAL},
+      {"/rest/block/notxdetails/", rest_block_notxdetails, HTTPWorkPriority::LOW},
+      {"/rest/block/", rest_block_extended, HTTPWorkPriority::LOW},
+      {"/rest/chaininfo", rest_chaininfo, HTTPWorkPriority::HIGH},
+      {"/rest/mempool/info", rest_mempool_info, HTTPWorkPriority::HIGH},
+      {"/rest/mempool/contents", rest_mempool_contents, HTTPWorkPriority::LOW},
+      {"/rest/headers/", rest_headers, HTTPWorkPriority::NORMAL},
+      {"/rest/blocksummaries/", rest_block_summaries, HTTPWorkPriority::NORMAL},
+      {"/rest/getutxos", rest_getutxos, HTTPWorkPriority::NORMAL},
+      {"/rest/blockhashbyheight/", rest_blockhash_by_height, HTTPWorkPriority::NORMAL},
+      {"/rest/events/", rest_events, HTTPWorkPriority::NORMAL},
 };
 
 void StartREST(const util::Ref& context)
 {
     for (const auto& up : uri_prefixes) {
         auto handler = [&context, up](HTTPRequest* req, const std::string& prefix) { return up.handler(context, req, prefix); };
-        RegisterHTTPHandler(up.prefix, false, handler);
+        const HTTPWorkPriority priority = up.priority;
+        RegisterHTTPHandler(up.prefix, false, handler, [priority](HTTPRequest*) { return priority; });
     }
 }
 
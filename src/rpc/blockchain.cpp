@@ -15,7 +15,10 @@
 #include <consensus/validation.h>
 #include <core_io.h>
 #include <hash.h>
+#include <key_io.h>
+#include <index/addressindex.h>
 #include <index/blockfilterindex.h>
+#include <index/coinstatsindex.h>
 #include <node/coinstats.h>
 #include <node/context.h>
 #include <node/utxo_snapshot.h>
@@ -25,6 +28,7 @@
 #include <primitives/transaction.h>
 #include <pos/pos.h>
 #include <pow.h>
+#include <rpc/jsonstream.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 #include <script/descriptor.h>
@@ -149,6 +153,24 @@ UniValue blockheaderToJSON(const CBlockIndex* tip, const CBlockIndex* blockindex
     return result;
 }
 
+/** Call fn with the verbose JSON of each transaction of a block, in block order. */
+static void ForEachTxToJSON(const CBlock& block, const CBlockIndex* blockindex, const std::function<void(const UniValue&)>& fn)
+{
+    // One read of the block's undo data gives the spent outputs of all
+    // its inputs, instead of a transaction lookup per input.
+    CBlockUndo blockUndo;
+    const bool have_undo = blockindex->pprev && (blockindex->nStatus & BLOCK_HAVE_UNDO) &&
+                           UndoReadFromDisk(blockUndo, blockindex) && blockUndo.vtxundo.size() + 1 == block.vtx.size();
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        const CTransactionRef& tx = block.vtx[i];
+        // coinbase transaction (i == 0) doesn't have undo data
+        const CTxUndo* txundo = (have_undo && i) ? &blockUndo.vtxundo.at(i - 1) : nullptr;
+        UniValue objTx(UniValue::VOBJ);
+        TxToUniv(*tx, uint256(), objTx, true, RPCSerializationFlags(), txundo);
+        fn(objTx);
+    }
+}
+
 UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails)
 {
     // Serialize passed information without accessing chain state of the active chain!
@@ -167,16 +189,12 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIn
     result.pushKV("versionHex", strprintf("%08x", block.nVersion));
     result.pushKV("merkleroot", block.hashMerkleRoot.GetHex());
     UniValue txs(UniValue::VARR);
-    for(const auto& tx : block.vtx)
-    {
-        if(txDetails)
-        {
-            UniValue objTx(UniValue::VOBJ);
-            TxToUniv(*tx, uint256(), objTx, true, RPCSerializationFlags());
-            txs.push_back(objTx);
-        }
-        else
+    if (txDetails) {
+        ForEachTxToJSON(block, blockindex, [&txs](const UniValue& objTx) { txs.push_back(objTx); });
+    } else {
+        for (const auto& tx : block.vtx) {
             txs.push_back(tx->GetHash().GetHex());
+        }
     }
     result.pushKV("tx", txs);
     result.pushKV("time", block.GetBlockTime());
@@ -209,6 +227,29 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIn
     return result;
 }
 
+/**
+ * Write the same object as blockToJSON with txDetails to a stream. Only the
+ * JSON of one transaction is held in memory at a time.
+ */
+static void BlockToJSONStream(JSONStreamWriter& out, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex) LOCKS_EXCLUDED(cs_main)
+{
+    // The summary has the transaction ids where the details go.
+    const UniValue summary = blockToJSON(block, tip, blockindex, /* txDetails */ false);
+    out.BeginObject();
+    for (size_t i = 0; i < summary.size(); ++i) {
+        const std::string& key = summary.getKeys()[i];
+        if (key != "tx") {
+            out.KeyValue(key, summary.getValues()[i]);
+            continue;
+        }
+        out.Key(key);
+        out.BeginArray();
+        ForEachTxToJSON(block, blockindex, [&out](const UniValue& objTx) { out.Value(objTx); });
+        out.EndArray();
+    }
+    out.EndObject();
+}
+
 static RPCHelpMan getblockcount()
 {
     return RPCHelpMan{"getblockcount",
@@ -545,6 +586,19 @@ static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPool
     info.pushKV("unbroadcast", pool.IsUnbroadcastTx(tx.GetHash()));
 }
 
+/** Write the same object as verbose MempoolToJSON to a stream, one entry at a time. */
+static void MempoolToJSONStream(JSONStreamWriter& out, const CTxMemPool& pool)
+{
+    LOCK(pool.cs);
+    out.BeginObject();
+    for (const CTxMemPoolEntry& e : pool.mapTx) {
+        UniValue info(UniValue::VOBJ);
+        entryToJSON(pool, info, e);
+        out.KeyValue(e.GetTx().GetHash().ToString(), info);
+    }
+    out.EndObject();
+}
+
 UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempool_sequence)
 {
     if (verbose) {
@@ -631,6 +685,10 @@ static RPCHelpMan getrawmempool()
         include_mempool_sequence = request.params[1].get_bool();
     }
 
+    if (fVerbose && !include_mempool_sequence && request.result_stream) {
+        MempoolToJSONStream(*request.result_stream, EnsureMemPool(request.context));
+        return NullUniValue;
+    }
     return MempoolToJSON(EnsureMemPool(request.context), fVerbose, include_mempool_sequence);
 },
     };
@@ -930,7 +988,8 @@ static RPCHelpMan getblock()
     return RPCHelpMan{"getblock",
                 "\nIf verbosity is 0, returns a string that is serialized, hex-encoded data for block 'hash'.\n"
                 "If verbosity is 1, returns an Object with information about block <hash>.\n"
-                "If verbosity is 2, returns an Object with information about block <hash> and information about each transaction. \n",
+                "If verbosity is 2, returns an Object with information about block <hash> and information about each transaction,\n"
+                "including the outputs spent by its inputs when the block's undo data is available.\n",
                 {
                     {"blockhash", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The block hash"},
                     {"verbosity|verbose", RPCArg::Type::NUM, /* default */ "1", "0 for hex-encoded data, 1 for a json object, and 2 for json object with transaction data"},
@@ -971,6 +1030,7 @@ static RPCHelpMan getblock()
                         {RPCResult::Type::OBJ, "", "",
                         {
                             {RPCResult::Type::ELISION, "", "The transactions in the format of the getrawtransaction RPC. Different from verbosity = 1 \"tx\" result"},
+                            {RPCResult::Type::NUM, "fee", /* optional */ true, "The transaction fee in " + CURRENCY_UNIT + ", omitted if block undo data is not available"},
                         }},
                     }},
                 }},
@@ -1014,6 +1074,10 @@ static RPCHelpMan getblock()
         return strHex;
     }
 
+    if (verbosity >= 2 && request.result_stream) {
+        BlockToJSONStream(*request.result_stream, block, tip, pblockindex);
+        return NullUniValue;
+    }
     return blockToJSON(block, tip, pblockindex, verbosity >= 2);
 },
     };
@@ -1076,53 +1140,158 @@ static RPCHelpMan pruneblockchain()
     };
 }
 
+/** Resolve a block hash or height parameter to a block of the active chain. */
+static CBlockIndex* ParseHashOrHeight(const UniValue& param) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    CBlockIndex* pindex;
+    if (param.isNum()) {
+        const int height = param.get_int();
+        const int current_tip = ::ChainActive().Height();
+        if (height < 0) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d is negative", height));
+        }
+        if (height > current_tip) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d after current tip %d", height, current_tip));
+        }
+
+        pindex = ::ChainActive()[height];
+    } else {
+        const uint256 hash(ParseHashV(param, "hash_or_height"));
+        pindex = LookupBlockIndex(hash);
+        if (!pindex) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+        }
+        if (!::ChainActive().Contains(pindex)) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Block is not in chain %s", Params().NetworkIDString()));
+        }
+    }
+
+    CHECK_NONFATAL(pindex != nullptr);
+    return pindex;
+}
+
 static RPCHelpMan gettxoutsetinfo()
 {
     return RPCHelpMan{"gettxoutsetinfo",
                 "\nReturns statistics about the unspent transaction output set.\n"
-                "Note this call may take some time.\n",
+                "Note this call may take some time if you are not using coinstatsindex.\n",
                 {
-                    {"hash_type", RPCArg::Type::STR, /* default */ "hash_serialized_2", "Which UTXO set hash should be calculated. Options: 'hash_serialized_2' (the legacy algorithm), 'none'."},
+                    {"hash_type", RPCArg::Type::STR, /* default */ "hash_serialized_2", "Which UTXO set hash should be calculated. Options: 'hash_serialized_2' (the legacy algorithm), 'muhash', 'none'."},
+                    {"hash_or_height", RPCArg::Type::NUM, /* default */ "the current best block", "The block hash or height of the target block, only available with coinstatsindex.", "", {"", "string or numeric"}},
+                    {"use_index", RPCArg::Type::BOOL, /* default */ "true", "Use coinstatsindex, if available."},
                 },
                 RPCResult{
                     RPCResult::Type::OBJ, "", "",
                     {
-                        {RPCResult::Type::NUM, "height", "The current block height (index)"},
-                        {RPCResult::Type::STR_HEX, "bestblock", "The hash of the block at the tip of the chain"},
-                        {RPCResult::Type::NUM, "transactions", "The number of transactions with unspent outputs"},
+                        {RPCResult::Type::NUM, "height", "The block height (index) of the returned statistics"},
+                        {RPCResult::Type::STR_HEX, "bestblock", "The hash of the block at which these statistics are calculated"},
+                        {RPCResult::Type::NUM, "transactions", /* optional */ true, "The number of transactions with unspent outputs (not available when coinstatsindex is used)"},
                         {RPCResult::Type::NUM, "txouts", "The number of unspent transaction outputs"},
                         {RPCResult::Type::NUM, "bogosize", "A meaningless metric for UTXO set size"},
-                        {RPCResult::Type::STR_HEX, "hash_serialized_2", "The serialized hash (only present if 'hash_serialized_2' hash_type is chosen)"},
-                        {RPCResult::Type::NUM, "disk_size", "The estimated size of the chainstate on disk"},
-                        {RPCResult::Type::STR_AMOUNT, "total_amount", "The total amount"},
+                        {RPCResult::Type::STR_HEX, "hash_serialized_2", /* optional */ true, "The serialized hash (only present if 'hash_serialized_2' hash_type is chosen)"},
+                        {RPCResult::Type::STR_HEX, "muhash", /* optional */ true, "The serialized hash (only present if 'muhash' hash_type is chosen)"},
+                        {RPCResult::Type::NUM, "disk_size", /* optional */ true, "The estimated size of the chainstate on disk (not available when coinstatsindex is used)"},
+                        {RPCResult::Type::STR_AMOUNT, "total_amount", "The total amount of coins in the UTXO set"},
+                        {RPCResult::Type::STR_AMOUNT, "total_subsidy", /* optional */ true, "The total amount of coins created by coinbase and coinstake transactions up to this block (only available if coinstatsindex is used)"},
+                        {RPCResult::Type::STR_AMOUNT, "total_unspendable_amount", /* optional */ true, "The total amount of coins permanently excluded from the UTXO set (only available if coinstatsindex is used)"},
+                        {RPCResult::Type::STR_AMOUNT, "total_burned_amount", /* optional */ true, "The total amount of coins sent to the burn address (only available if coinstatsindex is used)"},
+                        {RPCResult::Type::OBJ, "block_info", /* optional */ true, "Info on amounts in the block at this block height (only available if coinstatsindex is used)",
+                        {
+                            {RPCResult::Type::STR_AMOUNT, "prevout_spent", "Total amount of all prevouts spent in this block"},
+                            {RPCResult::Type::STR_AMOUNT, "coinbase", "Coinbase subsidy amount of this block"},
+                            {RPCResult::Type::STR_AMOUNT, "new_outputs_ex_coinbase", "Total amount of new outputs created by this block, excluding the coinbase"},
+                            {RPCResult::Type::STR_AMOUNT, "subsidy", "Amount created by this block, the outputs of coinbase and coinstake minus what they spent"},
+                            {RPCResult::Type::STR_AMOUNT, "unspendable", "Total amount of outputs of this block that are excluded from the UTXO set"},
+                            {RPCResult::Type::STR_AMOUNT, "burned", "Total amount sent to the burn address in this block"},
+                        }},
                     }},
                 RPCExamples{
-                    HelpExampleCli("gettxoutsetinfo", "")
-            + HelpExampleRpc("gettxoutsetinfo", "")
+                    HelpExampleCli("gettxoutsetinfo", "") +
+                    HelpExampleCli("gettxoutsetinfo", R"("none")") +
+                    HelpExampleCli("gettxoutsetinfo", R"("none" 1000)") +
+                    HelpExampleCli("gettxoutsetinfo", R"("muhash" '"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09"')") +
+                    HelpExampleRpc("gettxoutsetinfo", "") +
+                    HelpExampleRpc("gettxoutsetinfo", R"("none")") +
+                    HelpExampleRpc("gettxoutsetinfo", R"("none", 1000)") +
+                    HelpExampleRpc("gettxoutsetinfo", R"("muhash", "00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09")")
                 },
         [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
 {
     UniValue ret(UniValue::VOBJ);
 
+    CBlockIndex* pindex{nullptr};
+    const CoinStatsHashType hash_type = ParseHashType(request.params[0], CoinStatsHashType::HASH_SERIALIZED);
+    const bool index_requested = request.params[2].isNull() || request.params[2].get_bool();
+
     CCoinsStats stats;
-    ::ChainstateActive().ForceFlushStateToDisk();
+    CCoinsView* coins_view;
+    {
+        LOCK(cs_main);
+        coins_view = &ChainstateActive().CoinsDB();
+        if (!request.params[1].isNull()) {
+            if (!g_coin_stats_index || !index_requested) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Querying specific block heights requires coinstatsindex");
+            }
+            if (hash_type == CoinStatsHashType::HASH_SERIALIZED) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "hash_serialized_2 hash type cannot be queried for a specific block");
+            }
+            pindex = ParseHashOrHeight(request.params[1]);
+        } else if (g_coin_stats_index && index_requested && hash_type != CoinStatsHashType::HASH_SERIALIZED) {
+            // The chainstate on disk may lag behind the tip; the index does not.
+            pindex = ::ChainActive().Tip();
+        }
+    }
 
-    const CoinStatsHashType hash_type = ParseHashType(request.params[0], CoinStatsHashType::HASH_SERIALIZED);
+    if (g_coin_stats_index && index_requested && hash_type != CoinStatsHashType::HASH_SERIALIZED) {
+        // Answer from the index once it has caught up with the chain.
+        g_coin_stats_index->BlockUntilSyncedToCurrentChain();
+    } else {
+        ::ChainstateActive().ForceFlushStateToDisk();
+    }
 
-    CCoinsView* coins_view = WITH_LOCK(cs_main, return &ChainstateActive().CoinsDB());
     NodeContext& node = EnsureNodeContext(request.context);
-    if (GetUTXOStats(coins_view, stats, hash_type, node.rpc_interruption_point)) {
+    if (GetUTXOStats(coins_view, stats, hash_type, node.rpc_interruption_point, pindex, index_requested)) {
         ret.pushKV("height", (int64_t)stats.nHeight);
         ret.pushKV("bestblock", stats.hashBlock.GetHex());
-        ret.pushKV("transactions", (int64_t)stats.nTransactions);
         ret.pushKV("txouts", (int64_t)stats.nTransactionOutputs);
         ret.pushKV("bogosize", (int64_t)stats.nBogoSize);
         if (hash_type == CoinStatsHashType::HASH_SERIALIZED) {
             ret.pushKV("hash_serialized_2", stats.hashSerialized.GetHex());
         }
-        ret.pushKV("disk_size", stats.nDiskSize);
+        if (hash_type == CoinStatsHashType::MUHASH) {
+            ret.pushKV("muhash", stats.hashSerialized.GetHex());
+        }
         ret.pushKV("total_amount", ValueFromAmount(stats.nTotalAmount));
+        if (!stats.index_used) {
+            ret.pushKV("transactions", (int64_t)stats.nTransactions);
+            ret.pushKV("disk_size", stats.nDiskSize);
+        } else {
+            ret.pushKV("total_subsidy", ValueFromAmount(stats.total_subsidy));
+            ret.pushKV("total_unspendable_amount", ValueFromAmount(stats.total_unspendable_amount));
+            ret.pushKV("total_burned_amount", ValueFromAmount(stats.total_burned_amount));
+
+            CCoinsStats prev_stats{};
+            if (stats.nHeight > 0) {
+                const CBlockIndex* block_index = WITH_LOCK(cs_main, return LookupBlockIndex(stats.hashBlock));
+                CHECK_NONFATAL(block_index);
+                if (!GetUTXOStats(coins_view, prev_stats, hash_type, node.rpc_interruption_point, block_index->pprev, index_requested)) {
+                    throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
+                }
+            }
+
+            UniValue block_info(UniValue::VOBJ);
+            block_info.pushKV("prevout_spent", ValueFromAmount(stats.total_prevout_spent_amount - prev_stats.total_prevout_spent_amount));
+            block_info.pushKV("coinbase", ValueFromAmount(stats.total_coinbase_amount - prev_stats.total_coinbase_amount));
+            block_info.pushKV("new_outputs_ex_coinbase", ValueFromAmount(stats.total_new_outputs_ex_coinbase_amount - prev_stats.total_new_outputs_ex_coinbase_amount));
+            block_info.pushKV("subsidy", ValueFromAmount(stats.total_subsidy - prev_stats.total_subsidy));
+            block_info.pushKV("unspendable", ValueFromAmount(stats.total_unspendable_amount - prev_stats.total_unspendable_amount));
+            block_info.pushKV("burned", ValueFromAmount(stats.total_burned_amount - prev_stats.total_burned_amount));
+            ret.pushKV("block_info", block_info);
+        }
     } else {
+        if (g_coin_stats_index && index_requested && hash_type != CoinStatsHashType::HASH_SERIALIZED) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set statistics from coinstatsindex; it may still be syncing");
+        }
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
     }
     return ret;
@@ -1889,30 +2058,7 @@ static RPCHelpMan getblockstats()
 {
     LOCK(cs_main);
 
-    CBlockIndex* pindex;
-    if (request.params[0].isNum()) {
-        const int height = request.params[0].get_int();
-        const int current_tip = ::ChainActive().Height();
-        if (height < 0) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d is negative", height));
-        }
-        if (height > current_tip) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d after current tip %d", height, current_tip));
-        }
-
-        pindex = ::ChainActive()[height];
-    } else {
-        const uint256 hash(ParseHashV(request.params[0], "hash_or_height"));
-        pindex = LookupBlockIndex(hash);
-        if (!pindex) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
-        }
-        if (!::ChainActive().Contains(pindex)) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Block is not in chain %s", Params().NetworkIDString()));
-        }
-    }
-
-    CHECK_NONFATAL(pindex != nullptr);
+    CBlockIndex* pindex = ParseHashOrHeight(request.params[0]);
 
     std::set<std::string> stats;
     if (!request.params[1].isNull()) {
@@ -2404,6 +2550,198 @@ static RPCHelpMan getblockfilter()
     };
 }
 
+/** Maximum number of outputs a single getaddressutxos call returns */
+static const int MAX_GETADDRESSUTXOS_COUNT = 10000;
+
+/** Decode the address argument of the address index RPCs, once the index has caught up. */
+static CScript AddressIndexScript(const UniValue& address)
+{
+    if (!g_addressindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Address index is not enabled. Use -addressindex to enable it.");
+    }
+    const CTxDestination dest = DecodeDestination(address.get_str());
+    if (!IsValidDestination(dest)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
+    }
+    g_addressindex->BlockUntilSyncedToCurrentChain();
+    return GetScriptForDestination(dest);
+}
+
+static RPCHelpMan getaddressbalance()
+{
+    return RPCHelpMan{"getaddressbalance",
+                "\nReturns the confirmed balance of an address, as recorded by the address index.\n"
+                "Requires -addressindex. Mempool transactions are not taken into account.\n",
+                {
+                    {"address", RPCArg::Type::STR, RPCArg::Optional::NO, "The address"},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::STR_AMOUNT, "balance", "The sum of the unspent outputs paying to the address"},
+                        {RPCResult::Type::STR_AMOUNT, "received", "The sum of all outputs ever paid to the address"},
+                        {RPCResult::Type::NUM, "utxos", "The number of unspent outputs paying to the address"},
+                        {RPCResult::Type::NUM, "height", "The height the address index is synced to"},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getaddressbalance", "\"" + EXAMPLE_ADDRESS[0] + "\"")
+            + HelpExampleRpc("getaddressbalance", "\"" + EXAMPLE_ADDRESS[0] + "\"")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const CScript script = AddressIndexScript(request.params[0]);
+
+    AddressBalance balance;
+    if (!g_addressindex->FindBalance(script, balance)) {
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read the address index");
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("balance", ValueFromAmount(balance.balance));
+    ret.pushKV("received", ValueFromAmount(balance.received));
+    ret.pushKV("utxos", balance.utxos);
+    ret.pushKV("height", g_addressindex->GetSummary().best_block_height);
+    return ret;
+},
+    };
+}
+
+static RPCHelpMan getaddressutxos()
+{
+    return RPCHelpMan{"getaddressutxos",
+                "\nReturns the confirmed unspent outputs paying to an address, as recorded by the address index.\n"
+                "Requires -addressindex. Mempool transactions are not taken into account.\n"
+                "\nOutputs are returned in outpoint order, at most count at a time. To page through them, pass the\n"
+                "last output returned as start of the next call, until fewer than count outputs are returned.\n",
+                {
+                    {"address", RPCArg::Type::STR, RPCArg::Optional::NO, "The address"},
+                    {"count", RPCArg::Type::NUM, /* default */ "1000", "The maximum number of outputs to return, at most " + std::to_string(MAX_GETADDRESSUTXOS_COUNT)},
+                    {"start", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED_NAMED_ARG, "Return the outputs following this one",
+                        {
+                            {"txid", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The transaction id"},
+                            {"vout", RPCArg::Type::NUM, RPCArg::Optional::NO, "The output number"},
+                        },
+                    },
+                },
+                RPCResult{
+                    RPCResult::Type::ARR, "", "",
+                    {
+                        {RPCResult::Type::OBJ, "", "",
+                        {
+                            {RPCResult::Type::STR_HEX, "txid", "The transaction id"},
+                            {RPCResult::Type::NUM, "vout", "The output index"},
+                            {RPCResult::Type::STR_AMOUNT, "amount", "The output value in " + CURRENCY_UNIT},
+                            {RPCResult::Type::NUM, "height", "The height of the block containing the transaction"},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getaddressutxos", "\"" + EXAMPLE_ADDRESS[0] + "\"")
+            + HelpExampleCli("getaddressutxos", "\"" + EXAMPLE_ADDRESS[0] + "\" 100 '{\"txid\":\"mytxid\",\"vout\":0}'")
+            + HelpExampleRpc("getaddressutxos", "\"" + EXAMPLE_ADDRESS[0] + "\", 100, {\"txid\":\"mytxid\",\"vout\":0}")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const CScript script = AddressIndexScript(request.params[0]);
+
+    const int count = request.params[1].isNull() ? 1000 : request.params[1].get_int();
+    if (count < 1 || count > MAX_GETADDRESSUTXOS_COUNT) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Count must be between 1 and %d", MAX_GETADDRESSUTXOS_COUNT));
+    }
+
+    COutPoint start;
+    if (!request.params[2].isNull()) {
+        const UniValue& o = request.params[2].get_obj();
+        RPCTypeCheckObj(o,
+            {
+                {"txid", UniValueType(UniValue::VSTR)},
+                {"vout", UniValueType(UniValue::VNUM)},
+            });
+        const int vout = find_value(o, "vout").get_int();
+        if (vout < 0) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid parameter, vout cannot be negative");
+        }
+        start = COutPoint(ParseHashO(o, "txid"), vout);
+    }
+
+    std::vector<AddressUnspentEntry> unspent;
+    if (!g_addressindex->FindUnspent(script, start, count, unspent)) {
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read the address index");
+    }
+
+    UniValue ret(UniValue::VARR);
+    for (const AddressUnspentEntry& entry : unspent) {
+        UniValue utxo(UniValue::VOBJ);
+        utxo.pushKV("txid", entry.outpoint.hash.GetHex());
+        utxo.pushKV("vout", (int)entry.outpoint.n);
+        utxo.pushKV("amount", ValueFromAmount(entry.value));
+        utxo.pushKV("height", entry.height);
+        ret.push_back(utxo);
+    }
+    return ret;
+},
+    };
+}
+
+static RPCHelpMan getaddresshistory()
+{
+    return RPCHelpMan{"getaddresshistory",
+                "\nReturns the confirmed credits and debits of an address, oldest first, as recorded by the address index.\n"
+                "Requires -addressindex. Mempool transactions are not taken into account.\n",
+                {
+                    {"address", RPCArg::Type::STR, RPCArg::Optional::NO, "The address"},
+                    {"skip", RPCArg::Type::NUM, /* default */ "0", "The number of entries to skip"},
+                    {"count", RPCArg::Type::NUM, /* default */ "100", "The maximum number of entries to return"},
+                },
+                RPCResult{
+                    RPCResult::Type::ARR, "", "",
+                    {
+                        {RPCResult::Type::OBJ, "", "",
+                        {
+                            {RPCResult::Type::NUM, "height", "The height of the block containing the transaction"},
+                            {RPCResult::Type::STR_HEX, "txid", "The transaction id"},
+                            {RPCResult::Type::NUM, "vout", /* optional */ true, "The output index, for a credit"},
+                            {RPCResult::Type::NUM, "vin", /* optional */ true, "The input index, for a debit"},
+                            {RPCResult::Type::STR_AMOUNT, "amount", "The value in " + CURRENCY_UNIT + ", negative for a debit"},
+                            {RPCResult::Type::BOOL, "spent", /* optional */ true, "For a credit, whether the output has been spent since"},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getaddresshistory", "\"" + EXAMPLE_ADDRESS[0] + "\" 100 50")
+            + HelpExampleRpc("getaddresshistory", "\"" + EXAMPLE_ADDRESS[0] + "\", 100, 50")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const CScript script = AddressIndexScript(request.params[0]);
+
+    const int skip = request.params[1].isNull() ? 0 : request.params[1].get_int();
+    const int count = request.params[2].isNull() ? 100 : request.params[2].get_int();
+    if (skip < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative skip");
+    }
+    if (count < 1) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Count must be at least 1");
+    }
+
+    std::vector<AddressHistoryEntry> history;
+    if (!g_addressindex->FindHistory(script, skip, count, history)) {
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read the address index");
+    }
+
+    UniValue ret(UniValue::VARR);
+    for (const AddressHistoryEntry& entry : history) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("height", entry.height);
+        obj.pushKV("txid", entry.txid.GetHex());
+        obj.pushKV(entry.spending ? "vin" : "vout", (int)entry.index);
+        obj.pushKV("amount", ValueFromAmount(entry.value));
+        if (!entry.spending) obj.pushKV("spent", entry.spent);
+        ret.push_back(obj);
+    }
+    return ret;
+},
+    };
+}
+
 /**
  * Serialize the UTXO set to a file for loading elsewhere.
  *
@@ -2471,7 +2809,7 @@ static RPCHelpMan dumptxoutset()
 
         ::ChainstateActive().ForceFlushStateToDisk();
 
-        if (!GetUTXOStats(&::ChainstateActive().CoinsDB(), stats, CoinStatsHashType::NONE, node.rpc_interruption_point)) {
+        if (!GetUTXOStats(&::ChainstateActive().CoinsDB(), stats, CoinStatsHashType::NONE, node.rpc_interruption_point, nullptr, /* index_requested */ false)) {
             throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
         }
 
@@ -2516,33 +2854,36 @@ void RegisterBlockchainRPCCommands(CRPCTable &t)
 {
 // clang-format off
 static const CRPCCommand commands[] =
-{ //  category              name                      actor (function)         argNames
+{ //  category              name                      actor (function)         argNames (, parallel_safe)
   //  --------------------- ------------------------  -----------------------  ----------
-    { "blockchain",         "getblockchaininfo",      &getblockchaininfo,      {} },
-    { "blockchain",         "getchaintxstats",        &getchaintxstats,        {"nblocks", "blockhash"} },
-    { "blockchain",         "getblockstats",          &getblockstats,          {"hash_or_height", "stats"} },
-    { "blockchain",         "getbestblockhash",       &getbestblockhash,       {} },
-    { "blockchain",         "getblockcount",          &getblockcount,          {} },
-    { "blockchain",         "getblock",               &getblock,               {"blockhash","verbosity|verbose"} },
-    { "blockchain",         "getblockhash",           &getblockhash,           {"height"} },
-    { "blockchain",         "getblockheader",         &getblockheader,         {"blockhash","verbose"} },
-    { "blockchain",         "getchaintips",           &getchaintips,           {} },
-    { "blockchain",         "getdifficulty",          &getdifficulty,          {} },
-    { "blockchain",         "getdifficultypos",       &getdifficultypos,       {} },
-    { "blockchain",         "getmempoolancestors",    &getmempoolancestors,    {"txid","verbose"} },
-    { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  {"txid","verbose"} },
-    { "blockchain",         "getmempoolentry",        &getmempoolentry,        {"txid"} },
-    { "blockchain",         "getmempoolinfo",         &getmempoolinfo,         {} },
-    { "blockchain",         "getrawmempool",          &getrawmempool,          {"verbose", "mempool_sequence"} },
-    { "blockchain",         "gettxout",               &gettxout,               {"txid","n","include_mempool"} },
-    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {"hash_type"} },
+    { "blockchain",         "getblockchaininfo",      &getblockchaininfo,      {}, true },
+    { "blockchain",         "getchaintxstats",        &getchaintxstats,        {"nblocks", "blockhash"}, true },
+    { "blockchain",         "getblockstats",          &getblockstats,          {"hash_or_height", "stats"}, true },
+    { "blockchain",         "getbestblockhash",       &getbestblockhash,       {}, true },
+    { "blockchain",         "getblockcount",          &getblockcount,          {}, true },
+    { "blockchain",         "getblock",               &getblock,               {"blockhash","verbosity|verbose"}, true },
+    { "blockchain",         "getblockhash",           &getblockhash,           {"height"}, true },
+    { "blockchain",         "getblockheader",         &getblockheader,         {"blockhash","verbose"}, true },
+    { "blockchain",         "getchaintips",           &getchaintips,           {}, true },
+    { "blockchain",         "getdifficulty",          &getdifficulty,          {}, true },
+    { "blockchain",         "getdifficultypos",       &getdifficultypos,       {}, true },
+    { "blockchain",         "getmempoolancestors",    &getmempoolancestors,    {"txid","verbose"}, true },
+    { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  {"txid","verbose"}, true },
+    { "blockchain",         "getmempoolentry",        &getmempoolentry,        {"txid"}, true },
+    { "blockchain",         "getmempoolinfo",         &getmempoolinfo,         {}, true },
+    { "blockchain",         "getrawmempool",          &getrawmempool,          {"verbose", "mempool_sequence"}, true },
+    { "blockchain",         "gettxout",               &gettxout,               {"txid","n","include_mempool"}, true },
+    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {"hash_type", "hash_or_height", "use_index"} },
     { "blockchain",         "pruneblockchain",        &pruneblockchain,        {"height"} },
     { "blockchain",         "savemempool",            &savemempool,            {} },
     { "blockchain",         "verifychain",            &verifychain,            {"checklevel","nblocks"} },
 
     { "blockchain",         "preciousblock",          &preciousblock,          {"blockhash"} },
     { "blockchain",         "scantxoutset",           &scantxoutset,           {"action", "scanobjects"} },
-    { "blockchain",         "getblockfilter",         &getblockfilter,         {"blockhash", "filtertype"} },
+    { "blockchain",         "getblockfilter",         &getblockfilter,         {"blockhash", "filtertype"}, true },
+    { "blockchain",         "getaddressbalance",      &getaddressbalance,      {"address"}, true },
+    { "blockchain",         "getaddressutxos",        &getaddressutxos,        {"address", "count", "start"}, true },
+    { "blockchain",         "getaddresshistory",      &getaddresshistory,      {"address", "skip", "count"}, true },
 
     /* Not shown in help */
     { "hidden",             "invalidateblock",        &invalidateblock,        {"blockhash"} },
@@ -0,0 +1,84 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/jsonstream.h>
+
+#include <cassert>
+
+JSONStreamWriter::JSONStreamWriter(Sink sink, size_t flush_size)
+    : m_sink(std::move(sink)), m_flush_size(flush_size)
+{
+}
+
+void JSONStreamWriter::BeginElement()
+{
+    if (m_expects_value) {
+        // Value of a key, or the top-level value.
+        m_expects_value = false;
+        return;
+    }
+    assert(!m_has_elements.empty());
+    if (m_has_elements.back()) m_buffer += ',';
+    m_has_elements.back() = true;
+}
+
+void JSONStreamWriter::BeginObject()
+{
+    BeginElement();
+    m_buffer += '{';
+    m_has_elements.push_back(false);
+}
+
+void JSONStreamWriter::EndObject()
+{
+    assert(!m_has_elements.empty() && !m_expects_value);
+    m_has_elements.pop_back();
+    m_buffer += '}';
+    MaybeFlush();
+}
+
+void JSONStreamWriter::BeginArray()
+{
+    BeginElement();
+    m_buffer += '[';
+    m_has_elements.push_back(false);
+}
+
+void JSONStreamWriter::EndArray()
+{
+    assert(!m_has_elements.empty());
+    m_has_elements.pop_back();
+    m_buffer += ']';
+    MaybeFlush();
+}
+
+void JSONStreamWriter::Key(const std::string& key)
+{
+    assert(!m_expects_value);
+    BeginElement();
+    // UniValue escapes the key the same way it does in write().
+    m_buffer += UniValue(key).write();
+    m_buffer += ':';
+    m_expects_value = true;
+}
+
+void JSONStreamWriter::Value(const UniValue& value)
+{
+    BeginElement();
+    m_buffer += value.write();
+    MaybeFlush();
+}
+
+void JSONStreamWriter::MaybeFlush()
+{
+    if (m_buffer.size() >= m_flush_size) Flush();
+}
+
+void JSONStreamWriter::Flush()
+{
+    if (m_buffer.empty()) return;
+    m_sink(MakeUCharSpan(m_buffer));
+    m_buffer.clear();
+    m_flushed = true;
+}
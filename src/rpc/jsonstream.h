@@ -0,0 +1,78 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_JSONSTREAM_H
+#define BITCOIN_RPC_JSONSTREAM_H
+
+#include <span.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <univalue.h>
+
+/**
+ * Writes one JSON document incrementally. Output is collected in a buffer and
+ * handed to the sink whenever it grows past the flush size, so a large result
+ * can be emitted piece by piece instead of being built as one UniValue tree and
+ * one string first. The output is byte-for-byte what UniValue::write() would
+ * produce for the same document.
+ *
+ * Nothing reaches the sink until the buffer first fills up or Flush() is
+ * called, so a small document can still be sent as a single reply.
+ */
+class JSONStreamWriter
+{
+public:
+    using Sink = std::function<void(Span<const unsigned char>)>;
+
+    static constexpr size_t DEFAULT_FLUSH_SIZE = 64 * 1024;
+
+    explicit JSONStreamWriter(Sink sink, size_t flush_size = DEFAULT_FLUSH_SIZE);
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+
+    /** Write an object key. Must be followed by a value. */
+    void Key(const std::string& key);
+
+    /** Write a complete value. */
+    void Value(const UniValue& value);
+
+    void KeyValue(const std::string& key, const UniValue& value)
+    {
+        Key(key);
+        Value(value);
+    }
+
+    /** Whether the next thing written has to be a value: right after a key, or before anything was written. */
+    bool ExpectsValue() const { return m_expects_value; }
+
+    /** Whether any output has been handed to the sink yet. */
+    bool Flushed() const { return m_flushed; }
+
+    /** Hand all buffered output to the sink. */
+    void Flush();
+
+    /** Output written since the last flush. */
+    const std::string& Buffer() const { return m_buffer; }
+
+private:
+    Sink m_sink;
+    const size_t m_flush_size;
+    std::string m_buffer;
+    /// For each open container, whether it already has an element.
+    std::vector<bool> m_has_elements;
+    bool m_expects_value{true};
+    bool m_flushed{false};
+
+    /** Write the separator needed before a new element of the innermost container. */
+    void BeginElement();
+    void MaybeFlush();
+};
+
+#endif // BITCOIN_RPC_JSONSTREAM_H
@@ -4,10 +4,14 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <httpserver.h>
+#include <index/addressindex.h>
 #include <index/blockfilterindex.h>
+#include <index/coinstatsindex.h>
+#include <index/spentindex.h>
 #include <index/txindex.h>
 #include <interfaces/chain.h>
 #include <key_io.h>
+#include <node/blockcache.h>
 #include <node/context.h>
 #include <outputtype.h>
 #include <rpc/blockchain.h>
@@ -440,6 +444,18 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCBlockCacheInfo()
+{
+    const CBlockCache::Stats stats = g_block_cache.GetStats();
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("entries", uint64_t(stats.entries));
+    obj.pushKV("usage", uint64_t(stats.usage));
+    obj.pushKV("max_usage", uint64_t(stats.max_usage));
+    obj.pushKV("hits", stats.hits);
+    obj.pushKV("misses", stats.misses);
+    return obj;
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -484,6 +500,14 @@ static RPCHelpMan getmemoryinfo()
                                 {RPCResult::Type::NUM, "chunks_used", "Number allocated chunks"},
                                 {RPCResult::Type::NUM, "chunks_free", "Number unused chunks"},
                             }},
+                            {RPCResult::Type::OBJ, "blockcache", "Information about the recent-block cache",
+                            {
+                                {RPCResult::Type::NUM, "entries", "Number of blocks held"},
+                                {RPCResult::Type::NUM, "usage", "Estimated memory usage in bytes"},
+                                {RPCResult::Type::NUM, "max_usage", "Memory budget in bytes (see -blockcachemb)"},
+                                {RPCResult::Type::NUM, "hits", "Number of block reads served from the cache"},
+                                {RPCResult::Type::NUM, "misses", "Number of block reads that went to disk"},
+                            }},
                         }
                     },
                     RPCResult{"mode \"mallocinfo\"",
@@ -500,6 +524,7 @@ static RPCHelpMan getmemoryinfo()
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("locked", RPCLockedMemoryInfo());
+        obj.pushKV("blockcache", RPCBlockCacheInfo());
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -681,6 +706,18 @@ static RPCHelpMan getindexinfo()
         result.pushKVs(SummaryToJSON(g_txindex->GetSummary(), index_name));
     }
 
+    if (g_addressindex) {
+        result.pushKVs(SummaryToJSON(g_addressindex->GetSummary(), index_name));
+    }
+
+    if (g_spentindex) {
+        result.pushKVs(SummaryToJSON(g_spentindex->GetSummary(), index_name));
+    }
+
+    if (g_coin_stats_index) {
+        result.pushKVs(SummaryToJSON(g_coin_stats_index->GetSummary(), index_name));
+    }
+
     ForEachBlockFilterIndex([&result, &index_name](const BlockFilterIndex& index) {
         result.pushKVs(SummaryToJSON(index.GetSummary(), index_name));
     });
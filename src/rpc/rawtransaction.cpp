@@ -7,6 +7,7 @@
 #include <coins.h>
 #include <consensus/validation.h>
 #include <core_io.h>
+#include <index/spentindex.h>
 #include <index/txindex.h>
 #include <key_io.h>
 #include <merkleblock.h>
@@ -28,6 +29,7 @@
 #include <script/signingprovider.h>
 #include <script/standard.h>
 #include <uint256.h>
+#include <undo.h>
 #include <util/bip32.h>
 #include <util/moneystr.h>
 #include <util/strencodings.h>
@@ -41,14 +43,17 @@
 
 #include <univalue.h>
 
-static void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry)
+/** Maximum number of txids a single getrawtransactions call may look up */
+static const size_t MAX_GETRAWTRANSACTIONS_TXIDS = 1000;
+
+static void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry, const CTxUndo* txundo = nullptr)
 {
     // Call into TxToUniv() in bitcoin-common to decode the transaction hex.
     //
     // Blockchain contextual information (confirmations and blocktime) is not
     // available to code in bitcoin-common, so we query them here and push the
     // data into the returned UniValue.
-    TxToUniv(tx, uint256(), entry, true, RPCSerializationFlags());
+    TxToUniv(tx, uint256(), entry, true, RPCSerializationFlags(), txundo);
 
     if (!hashBlock.IsNull()) {
         LOCK(cs_main);
@@ -120,6 +125,16 @@ static RPCHelpMan getrawtransaction()
                                      {
                                          {RPCResult::Type::STR_HEX, "hex", "hex-encoded witness data (if any)"},
                                      }},
+                                     {RPCResult::Type::OBJ, "prevout", /* optional */ true, "The spent output (only with -spentindex, for confirmed transactions)",
+                                     {
+                                         {RPCResult::Type::BOOL, "generated", "Whether the output was created by a coinbase or coinstake"},
+                                         {RPCResult::Type::NUM, "height", "The height of the block that created the output"},
+                                         {RPCResult::Type::NUM, "value", "The value in " + CURRENCY_UNIT},
+                                         {RPCResult::Type::OBJ, "scriptPubKey", "",
+                                         {
+                                             {RPCResult::Type::ELISION, "", "Same as in \"vout\""},
+                                         }},
+                                     }},
                                  }},
                              }},
                              {RPCResult::Type::ARR, "vout", "",
@@ -141,6 +156,7 @@ static RPCHelpMan getrawtransaction()
                                      }},
                                  }},
                              }},
+                             {RPCResult::Type::NUM, "fee", /* optional */ true, "The transaction fee in " + CURRENCY_UNIT + " (only with -spentindex, for confirmed transactions)"},
                              {RPCResult::Type::STR_HEX, "blockhash", "the block hash"},
                              {RPCResult::Type::NUM, "confirmations", "The confirmations"},
                              {RPCResult::Type::NUM_TIME, "blocktime", "The block time expressed in " + UNIX_EPOCH_TIME},
@@ -213,9 +229,120 @@ static RPCHelpMan getrawtransaction()
         return EncodeHexTx(*tx, RPCSerializationFlags());
     }
 
+    // Report the spent outputs and the fee of confirmed transactions if the
+    // spent-output index has them.
+    CTxUndo txundo;
+    bool have_undo = false;
+    if (g_spentindex && !hash_block.IsNull() && !tx->IsCoinBase()) {
+        g_spentindex->BlockUntilSyncedToCurrentChain();
+        have_undo = g_spentindex->FindSpentOutputs(tx->GetHash(), txundo);
+    }
+
     UniValue result(UniValue::VOBJ);
     if (blockindex) result.pushKV("in_active_chain", in_active_chain);
-    TxToJSON(*tx, hash_block, result);
+    TxToJSON(*tx, hash_block, result, have_undo ? &txundo : nullptr);
+    return result;
+},
+    };
+}
+
+static RPCHelpMan getrawtransactions()
+{
+    return RPCHelpMan{
+                "getrawtransactions",
+                "\nReturn the raw transaction data of many transactions at once.\n"
+
+                "\nEach transaction is looked up in the mempool and then, if -txindex is enabled, in the blockchain.\n"
+                "Transactions in blocks are read from disk in one ordered pass, which is much faster than calling\n"
+                "getrawtransaction for each of them. At most " + std::to_string(MAX_GETRAWTRANSACTIONS_TXIDS) + " transactions can be requested at once.\n"
+
+                "\nIf verbose is 'true', returns an Object for each transaction, as getrawtransaction does.\n"
+                "If verbose is 'false' or omitted, returns a string that is serialized, hex-encoded data for each transaction.\n",
+                {
+                    {"txids", RPCArg::Type::ARR, RPCArg::Optional::NO, "The transaction ids",
+                        {
+                            {"txid", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, "A transaction id"},
+                        },
+                    },
+                    {"verbose", RPCArg::Type::BOOL, /* default */ "false", "If false, return strings, otherwise return json objects"},
+                },
+                RPCResult{
+                    RPCResult::Type::ARR, "", "One entry per requested txid, in request order, null if the transaction was not found",
+                    {
+                        {RPCResult::Type::STR, "data", "The serialized, hex-encoded data for 'txid', or an object as returned by getrawtransaction if verbose is set"},
+                    }
+                },
+                RPCExamples{
+                    HelpExampleCli("getrawtransactions", "'[\"mytxid\",\"myothertxid\"]'")
+            + HelpExampleCli("getrawtransactions", "'[\"mytxid\",\"myothertxid\"]' true")
+            + HelpExampleRpc("getrawtransactions", "[\"mytxid\",\"myothertxid\"], true")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const NodeContext& node = EnsureNodeContext(request.context);
+
+    const UniValue& txids = request.params[0].get_array();
+    if (txids.size() > MAX_GETRAWTRANSACTIONS_TXIDS) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Too many txids (max: %u, tried: %u)", MAX_GETRAWTRANSACTIONS_TXIDS, txids.size()));
+    }
+    std::vector<uint256> hashes;
+    hashes.reserve(txids.size());
+    for (size_t i = 0; i < txids.size(); ++i) {
+        hashes.push_back(ParseHashV(txids[i], "txid"));
+    }
+
+    bool fVerbose = false;
+    if (!request.params[1].isNull()) {
+        fVerbose = request.params[1].isNum() ? (request.params[1].get_int() != 0) : request.params[1].get_bool();
+    }
+
+    // Mempool first, then everything that is left from the txindex in one batch.
+    std::vector<CTransactionRef> txs(hashes.size());
+    std::vector<uint256> block_hashes(hashes.size());
+    std::vector<uint256> lookups;
+    std::vector<size_t> lookup_indexes;
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        if (node.mempool) txs[i] = node.mempool->get(hashes[i]);
+        if (!txs[i]) {
+            lookups.push_back(hashes[i]);
+            lookup_indexes.push_back(i);
+        }
+    }
+
+    if (g_txindex && !lookups.empty()) {
+        g_txindex->BlockUntilSyncedToCurrentChain();
+
+        std::vector<uint256> found_block_hashes;
+        std::vector<CTransactionRef> found_txs;
+        if (!g_txindex->FindTxs(lookups, found_block_hashes, found_txs)) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read transactions from disk");
+        }
+        for (size_t j = 0; j < lookups.size(); ++j) {
+            txs[lookup_indexes[j]] = std::move(found_txs[j]);
+            block_hashes[lookup_indexes[j]] = found_block_hashes[j];
+        }
+    }
+
+    if (fVerbose && g_spentindex) {
+        g_spentindex->BlockUntilSyncedToCurrentChain();
+    }
+
+    UniValue result(UniValue::VARR);
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        const CTransactionRef& tx = txs[i];
+        if (!tx) {
+            result.push_back(NullUniValue);
+        } else if (!fVerbose) {
+            result.push_back(EncodeHexTx(*tx, RPCSerializationFlags()));
+        } else {
+            CTxUndo txundo;
+            const bool have_undo = g_spentindex && !block_hashes[i].IsNull() && !tx->IsCoinBase() &&
+                                   g_spentindex->FindSpentOutputs(tx->GetHash(), txundo);
+            UniValue entry(UniValue::VOBJ);
+            TxToJSON(*tx, block_hashes[i], entry, have_undo ? &txundo : nullptr);
+            result.push_back(entry);
+        }
+    }
     return result;
 },
     };
@@ -1989,17 +2116,18 @@ void RegisterRawTransactionRPCCommands(CRPCTable &t)
 {
 // clang-format off
 static const CRPCCommand commands[] =
-{ //  category              name                            actor (function)            argNames
+{ //  category              name                            actor (function)            argNames (, parallel_safe)
   //  --------------------- ------------------------        -----------------------     ----------
-    { "rawtransactions",    "getrawtransaction",            &getrawtransaction,         {"txid","verbose","blockhash"} },
+    { "rawtransactions",    "getrawtransaction",            &getrawtransaction,         {"txid","verbose","blockhash"}, true },
+    { "rawtransactions",    "getrawtransactions",           &getrawtransactions,        {"txids","verbose"}, true },
     { "rawtransactions",    "createrawtransaction",         &createrawtransaction,      {"inputs","outputs","locktime","replaceable"} },
-    { "rawtransactions",    "decoderawtransaction",         &decoderawtransaction,      {"hexstring","iswitness"} },
-    { "rawtransactions",    "decodescript",                 &decodescript,              {"hexstring"} },
+    { "rawtransactions",    "decoderawtransaction",         &decoderawtransaction,      {"hexstring","iswitness"}, true },
+    { "rawtransactions",    "decodescript",                 &decodescript,              {"hexstring"}, true },
     { "rawtransactions",    "sendrawtransaction",           &sendrawtransaction,        {"hexstring","maxfeerate"} },
     { "rawtransactions",    "combinerawtransaction",        &combinerawtransaction,     {"txs"} },
     { "rawtransactions",    "signrawtransactionwithkey",    &signrawtransactionwithkey, {"hexstring","privkeys","prevtxs","sighashtype"} },
     { "rawtransactions",    "testmempoolaccept",            &testmempoolaccept,         {"rawtxs","maxfeerate"} },
-    { "rawtransactions",    "decodepsbt",                   &decodepsbt,                {"psbt"} },
+    { "rawtransactions",    "decodepsbt",                   &decodepsbt,                {"psbt"}, true },
     { "rawtransactions",    "combinepsbt",                  &combinepsbt,               {"txs"} },
     { "rawtransactions",    "finalizepsbt",                 &finalizepsbt,              {"psbt", "extract"} },
     { "rawtransactions",    "createpsbt",                   &createpsbt,                {"inputs","outputs","locktime","replaceable"} },
@@ -2008,11 +2136,11 @@ static const CRPCCommand commands[] =
     { "rawtransactions",    "joinpsbts",                    &joinpsbts,                 {"txs"} },
     { "rawtransactions",    "analyzepsbt",                  &analyzepsbt,               {"psbt"} },
 //>SIN
-    { "rawtransactions",    "decodetimelockscript",         &decodetimelockscript,      {"hexstring"} },
-    { "rawtransactions",    "decodeburnanddatascript",      &decodeburnanddatascript,   {"hexstring"} },
+    { "rawtransactions",    "decodetimelockscript",         &decodetimelockscript,      {"hexstring"}, true },
+    { "rawtransactions",    "decodeburnanddatascript",      &decodeburnanddatascript,   {"hexstring"}, true },
 //<SIN
-    { "blockchain",         "gettxoutproof",                &gettxoutproof,             {"txids", "blockhash"} },
-    { "blockchain",         "verifytxoutproof",             &verifytxoutproof,          {"proof"} },
+    { "blockchain",         "gettxoutproof",                &gettxoutproof,             {"txids", "blockhash"}, true },
+    { "blockchain",         "verifytxoutproof",             &verifytxoutproof,          {"proof"}, true },
 };
 // clang-format on
     for (const auto& c : commands) {
@@ -10,6 +10,8 @@
 
 #include <univalue.h>
 
+class JSONStreamWriter;
+
 namespace util {
 class Ref;
 } // namespace util
@@ -39,6 +41,10 @@ public:
     std::string authUser;
     std::string peerAddr;
     const util::Ref& context;
+    //! If set, the method may write its result here, positioned where the
+    //! result value goes, instead of returning it. Set for single HTTP
+    //! requests only.
+    JSONStreamWriter* result_stream{nullptr};
 
     JSONRPCRequest(const util::Ref& context) : id(NullUniValue), params(NullUniValue), fHelp(false), context(context) {}
 
@@ -47,7 +53,7 @@ public:
     //! added or removed above.
     JSONRPCRequest(const JSONRPCRequest& other, const util::Ref& context)
         : id(other.id), strMethod(other.strMethod), params(other.params), fHelp(other.fHelp), URI(other.URI),
-          authUser(other.authUser), peerAddr(other.peerAddr), context(context)
+          authUser(other.authUser), peerAddr(other.peerAddr), context(context), result_stream(other.result_stream)
     {
     }
 
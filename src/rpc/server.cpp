@@ -5,6 +5,7 @@
 
 #include <rpc/server.h>
 
+#include <httpserver.h>
 #include <rpc/util.h>
 #include <shutdown.h>
 #include <sync.h>
@@ -15,7 +16,10 @@
 #include <boost/algorithm/string/split.hpp>
 #include <boost/signals2/signal.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <memory> // for unique_ptr
 #include <mutex>
 #include <unordered_map>
@@ -214,6 +218,27 @@ static RPCHelpMan getrpcinfo()
                             }},
                         }},
                         {RPCResult::Type::STR, "logpath", "The complete file path to the debug log"},
+                        {RPCResult::Type::ARR, "work_queues", "The HTTP work queue of each priority, most urgent first",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::STR, "priority", "The priority (high, normal or low)"},
+                                {RPCResult::Type::NUM, "max_threads", "How many threads may serve this priority at once"},
+                                {RPCResult::Type::NUM, "max_depth", "How many requests may be queued"},
+                                {RPCResult::Type::NUM, "running", "Requests being served"},
+                                {RPCResult::Type::NUM, "queued", "Requests waiting for a thread"},
+                                {RPCResult::Type::NUM, "rejected", "Requests rejected because the queue was full"},
+                                {RPCResult::Type::NUM, "total_wait", "Total time started requests spent queued, in microseconds"},
+                                {RPCResult::Type::ARR, "wait_histogram", "Started requests by time spent queued",
+                                {
+                                    {RPCResult::Type::OBJ, "", "",
+                                    {
+                                        {RPCResult::Type::NUM, "max_wait", /* optional */ true, "Upper bound of the bucket in microseconds, omitted for the last one"},
+                                        {RPCResult::Type::NUM, "count", "Requests in the bucket"},
+                                    }},
+                                }},
+                            }},
+                        }},
                     }
                 },
                 RPCExamples{
@@ -237,6 +262,28 @@ static RPCHelpMan getrpcinfo()
     UniValue log_path(UniValue::VSTR, path);
     result.pushKV("logpath", log_path);
 
+    UniValue work_queues(UniValue::VARR);
+    for (const HTTPWorkQueueStats& stats : GetHTTPWorkQueueStats()) {
+        UniValue histogram(UniValue::VARR);
+        for (size_t i = 0; i < stats.wait_histogram.size(); ++i) {
+            UniValue bucket(UniValue::VOBJ);
+            if (i < HTTP_WORK_WAIT_BUCKETS_US.size()) bucket.pushKV("max_wait", HTTP_WORK_WAIT_BUCKETS_US[i]);
+            bucket.pushKV("count", stats.wait_histogram[i]);
+            histogram.push_back(bucket);
+        }
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("priority", HTTPWorkPriorityName(stats.priority));
+        entry.pushKV("max_threads", (uint64_t)stats.max_threads);
+        entry.pushKV("max_depth", (uint64_t)stats.max_depth);
+        entry.pushKV("running", (uint64_t)stats.running);
+        entry.pushKV("queued", (uint64_t)stats.queued);
+        entry.pushKV("rejected", stats.rejected);
+        entry.pushKV("total_wait", stats.total_wait_us);
+        entry.pushKV("wait_histogram", histogram);
+        work_queues.push_back(entry);
+    }
+    result.pushKV("work_queues", work_queues);
+
     return result;
 }
     };
@@ -373,12 +420,77 @@ static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
     return rpc_result;
 }
 
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq)
+/** A run of batch requests [next, end) that any number of threads work through together. */
+struct RPCBatchRun
 {
-    UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+    const JSONRPCRequest* jreq;
+    const UniValue* requests;
+    std::vector<UniValue>* results;
+    std::atomic<size_t> next;
+    size_t end;
 
+    Mutex mutex;
+    std::condition_variable cond;
+    size_t remaining GUARDED_BY(mutex);
+
+    /** Execute requests until none are left to claim. */
+    void Work()
+    {
+        for (size_t idx = next++; idx < end; idx = next++) {
+            // The pointers are only dereferenced for a claimed request: the
+            // thread that started the run waits for all of those to finish.
+            (*results)[idx] = JSONRPCExecOne(*jreq, (*requests)[idx]);
+            LOCK(mutex);
+            if (--remaining == 0) cond.notify_all();
+        }
+    }
+};
+
+static void JSONRPCExecParallel(const JSONRPCRequest& jreq, const UniValue& vReq, size_t begin, size_t end, std::vector<UniValue>& results, const RPCTaskDispatcher& dispatcher, size_t max_helpers)
+{
+    // Helpers may be dequeued long after the run is over, so they share
+    // ownership of it.
+    auto run = std::make_shared<RPCBatchRun>();
+    run->jreq = &jreq;
+    run->requests = &vReq;
+    run->results = &results;
+    run->next = begin;
+    run->end = end;
+    WITH_LOCK(run->mutex, run->remaining = end - begin);
+
+    const size_t helpers = std::min(max_helpers, end - begin - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        if (!dispatcher([run] { run->Work(); })) break;
+    }
+    run->Work();
+
+    WAIT_LOCK(run->mutex, lock);
+    while (run->remaining > 0) run->cond.wait(lock);
+}
+
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, const RPCTaskDispatcher& dispatcher, size_t max_helpers)
+{
+    const auto parallel_safe = [&](size_t idx) {
+        const UniValue& method = find_value(vReq[idx], "method");
+        return method.isStr() && tableRPC.isParallelSafe(method.get_str());
+    };
+
+    std::vector<UniValue> results(vReq.size());
+    for (size_t reqIdx = 0; reqIdx < vReq.size();) {
+        size_t end = reqIdx + 1;
+        if (dispatcher && max_helpers > 0 && parallel_safe(reqIdx)) {
+            while (end < vReq.size() && parallel_safe(end)) ++end;
+        }
+        if (end - reqIdx > 1) {
+            JSONRPCExecParallel(jreq, vReq, reqIdx, end, results, dispatcher, max_helpers);
+        } else {
+            results[reqIdx] = JSONRPCExecOne(jreq, vReq[reqIdx]);
+        }
+        reqIdx = end;
+    }
+
+    UniValue ret(UniValue::VARR);
+    ret.push_backV(results);
     return ret.write() + "\n";
 }
 
@@ -472,6 +584,16 @@ static bool ExecuteCommand(const CRPCCommand& command, const JSONRPCRequest& req
     }
 }
 
+bool CRPCTable::isParallelSafe(const std::string& method) const
+{
+    auto it = mapCommands.find(method);
+    if (it == mapCommands.end()) return false;
+    for (const CRPCCommand* command : it->second) {
+        if (!command->parallel_safe) return false;
+    }
+    return true;
+}
+
 std::vector<std::string> CRPCTable::listCommands() const
 {
     std::vector<std::string> commandList;
@@ -103,7 +103,7 @@ public:
     }
 
     //! Simplified constructor taking plain RpcMethodFnType function pointer.
-    CRPCCommand(std::string category, std::string name_in, RpcMethodFnType fn, std::vector<std::string> args_in)
+    CRPCCommand(std::string category, std::string name_in, RpcMethodFnType fn, std::vector<std::string> args_in, bool parallel_safe = false)
         : CRPCCommand(
               category,
               fn().m_name,
@@ -113,6 +113,7 @@ public:
     {
         CHECK_NONFATAL(fn().m_name == name_in);
         CHECK_NONFATAL(fn().GetArgNames() == args_in);
+        this->parallel_safe = parallel_safe;
     }
 
     std::string category;
@@ -120,6 +121,9 @@ public:
     Actor actor;
     std::vector<std::string> argNames;
     intptr_t unique_id;
+    //! Whether the command only reads state, so that calls to it within a
+    //! batch may run concurrently and in any order.
+    bool parallel_safe{false};
 };
 
 /**
@@ -147,6 +151,8 @@ public:
     */
     std::vector<std::string> listCommands() const;
 
+    /** Whether every handler registered for a method is marked parallel_safe. */
+    bool isParallelSafe(const std::string& method) const;
 
     /**
      * Appends a CRPCCommand to the dispatch table.
@@ -171,7 +177,19 @@ extern CRPCTable tableRPC;
 void StartRPC();
 void InterruptRPC();
 void StopRPC();
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq);
+
+/** Queues a task on a worker pool. Returns false if the task was not accepted. */
+using RPCTaskDispatcher = std::function<bool(std::function<void()>)>;
+
+/**
+ * Execute a batch of requests, returning the serialized array of replies.
+ *
+ * If a dispatcher is given, each run of consecutive calls to parallel_safe
+ * commands is spread over up to max_helpers additional tasks queued with it.
+ * The calling thread works through the same run, so the batch completes even
+ * if no task is ever picked up. Replies are always in request order.
+ */
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, const RPCTaskDispatcher& dispatcher = nullptr, size_t max_helpers = 0);
 
 // Retrieves any serialization flags requested in command line argument
 int RPCSerializationFlags();
@@ -10,13 +10,133 @@
 #include <chainparams.h>
 #include <clientversion.h>
 #include <hash.h>
+#include <key_io.h>
+#include <fs.h>
+#include <logging.h>
+#include <random.h>
+#include <serialize.h>
 #include <streams.h>
+#include <util/strencodings.h>
+#include <util/system.h>
+#include <util/time.h>
+
+#include <stdio.h>
 
 #include <boost/filesystem.hpp>
 
+/**
+*   Compact on-disk encoding
+*   ------------------------
+*
+*   Objects stored through CFlatDB check this stream version flag and, when it
+*   is set, store heights and counters as (delta-encoded) VARINTs and addresses
+*   and keys in binary form instead of their string representation.
+*/
+static constexpr int FLATDB_COMPACT_FORMAT = 0x10000000;
+
+/** Serialization wrapper for signed integers as a VARINT of their zigzag
+ *  encoding, so that small negative values (e.g. -1 for "unset") stay short. */
+struct ZigZagVarIntFormatter
+{
+    template<typename Stream, typename I> void Ser(Stream& s, I v)
+    {
+        typedef typename std::make_unsigned<typename std::remove_cv<I>::type>::type U;
+        const U z = (static_cast<U>(v) << 1) ^ (v < 0 ? ~U{0} : U{0});
+        WriteVarInt<Stream, VarIntMode::DEFAULT, U>(s, z);
+    }
+
+    template<typename Stream, typename I> void Unser(Stream& s, I& v)
+    {
+        typedef typename std::make_unsigned<I>::type U;
+        const U z = ReadVarInt<Stream, VarIntMode::DEFAULT, U>(s);
+        v = static_cast<I>((z >> 1) ^ (U{0} - (z & 1)));
+    }
+};
+#define ZIGZAG(obj) Using<ZigZagVarIntFormatter>(obj)
+
+/** Serialization wrapper for address strings: standard destinations are
+ *  stored as their 20-byte hash, anything else verbatim. */
+struct AddressStringFormatter
+{
+    enum : uint8_t { RAW = 0, PKHASH = 1, SCRIPTHASH = 2, WITNESS_V0_KEYHASH = 3 };
+
+    template<typename Stream> void Ser(Stream& s, const std::string& str)
+    {
+        const CTxDestination dest = DecodeDestination(str);
+        if (IsValidDestination(dest) && EncodeDestination(dest) == str) {
+            if (const PKHash* id = boost::get<PKHash>(&dest)) {
+                ser_writedata8(s, PKHASH);
+                s.write((const char*)id->begin(), id->end() - id->begin());
+                return;
+            }
+            if (const ScriptHash* id = boost::get<ScriptHash>(&dest)) {
+                ser_writedata8(s, SCRIPTHASH);
+                s.write((const char*)id->begin(), id->end() - id->begin());
+                return;
+            }
+            if (const WitnessV0KeyHash* id = boost::get<WitnessV0KeyHash>(&dest)) {
+                ser_writedata8(s, WITNESS_V0_KEYHASH);
+                s.write((const char*)id->begin(), id->end() - id->begin());
+                return;
+            }
+        }
+        ser_writedata8(s, RAW);
+        s << str;
+    }
+
+    template<typename Stream> void Unser(Stream& s, std::string& str)
+    {
+        switch (ser_readdata8(s)) {
+        case RAW: s >> str; return;
+        case PKHASH: { uint160 hash; s >> hash; str = EncodeDestination(PKHash(hash)); return; }
+        case SCRIPTHASH: { uint160 hash; s >> hash; str = EncodeDestination(ScriptHash(hash)); return; }
+        case WITNESS_V0_KEYHASH: { uint160 hash; s >> hash; str = EncodeDestination(WitnessV0KeyHash(hash)); return; }
+        }
+        throw std::ios_base::failure("Unknown address encoding");
+    }
+};
+
+/** Serialization wrapper for base64 strings (e.g. metadata public keys):
+ *  canonical base64 is stored decoded, anything else verbatim. */
+struct Base64StringFormatter
+{
+    template<typename Stream> void Ser(Stream& s, const std::string& str)
+    {
+        bool invalid = false;
+        const std::vector<unsigned char> raw = DecodeBase64(str.c_str(), &invalid);
+        if (!invalid && !str.empty() && EncodeBase64(raw) == str) {
+            ser_writedata8(s, 1);
+            s << raw;
+        } else {
+            ser_writedata8(s, 0);
+            s << str;
+        }
+    }
+
+    template<typename Stream> void Unser(Stream& s, std::string& str)
+    {
+        if (ser_readdata8(s)) {
+            std::vector<unsigned char> raw;
+            s >> raw;
+            str = EncodeBase64(raw);
+        } else {
+            s >> str;
+        }
+    }
+};
+
 /**
 *   Generic Dumping and Loading
 *   ---------------------------
+*
+*   File layout (format version 1):
+*     magic message | network magic | 0x00 | VARINT(format version) |
+*     CompactSize(payload size) | payload | checksum
+*   The payload is the object serialized with FLATDB_COMPACT_FORMAT. Files
+*   written before the versioned format have the object directly after the
+*   network magic; its version string never starts with a zero byte, which
+*   is how the two layouts are told apart. The checksum is the double-SHA256
+*   of everything before it.
 */
 
 template<typename T>
@@ -34,45 +154,96 @@ private:
         IncorrectFormat
     };
 
+    //! Current on-disk format version, written after the format marker
+    static constexpr uint64_t FORMAT_VERSION = 1;
+
     boost::filesystem::path pathDB;
     std::string strFilename;
     std::string strMagicMessage;
 
+    /**
+     * Serialize a snapshot of the object while holding its lock, then hash
+     * and write it without the lock into a temporary file that is renamed
+     * over the old one, so a crash never leaves a truncated file behind.
+     */
     bool Write(const T& objToSave)
     {
-        // LOCK(objToSave.cs);
-
         int64_t nStart = GetTimeMillis();
 
-        // serialize, checksum data up to that point, then append checksum
-        CDataStream ssObj(SER_DISK, CLIENT_VERSION);
-        ssObj << strMagicMessage; // specific magic message for this type of object
-        ssObj << Params().MessageStart(); // network specific magic number
-        ssObj << objToSave;
-        uint256 hash = HashS(ssObj.begin(), ssObj.end());
-        ssObj << hash;
+        // serialize the payload on its own so it can be length-prefixed
+        CDataStream ssPayload(SER_DISK, CLIENT_VERSION | FLATDB_COMPACT_FORMAT);
+        {
+            LOCK(objToSave.cs);
+            ssPayload << objToSave;
+        }
 
-        // open output file, and associate with CAutoFile
-        FILE *file = fopen(pathDB.string().c_str(), "wb");
+        CDataStream ssHeader(SER_DISK, CLIENT_VERSION);
+        ssHeader << strMagicMessage; // specific magic message for this type of object
+        ssHeader << Params().MessageStart(); // network specific magic number
+        ssHeader << uint8_t{0} << VARINT(FORMAT_VERSION);
+        WriteCompactSize(ssHeader, ssPayload.size());
+        // checksum covers header and payload
+        uint256 hash = HashS(ssHeader.begin(), ssHeader.end(), ssPayload.begin(), ssPayload.end());
+
+        // open temp output file, and associate with CAutoFile
+        uint16_t randv = 0;
+        GetRandBytes((unsigned char*)&randv, sizeof(randv));
+        boost::filesystem::path pathTmp = GetDataDir() / strprintf("%s.%04x", strFilename, randv);
+        FILE *file = fsbridge::fopen(pathTmp, "wb");
         CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
         if (fileout.IsNull())
-            return error("%s: Failed to open file %s", __func__, pathDB.string());
+            return error("%s: Failed to open file %s", __func__, pathTmp.string());
 
         // Write and commit header, data
         try {
-            fileout << ssObj;
+            fileout << ssHeader << ssPayload << hash;
         }
         catch (std::exception &e) {
+            fileout.fclose();
+            remove(pathTmp);
             return error("%s: Serialize or I/O error - %s", __func__, e.what());
         }
+        if (!FileCommit(fileout.Get())) {
+            fileout.fclose();
+            remove(pathTmp);
+            return error("%s: Failed to flush file %s", __func__, pathTmp.string());
+        }
         fileout.fclose();
 
-        LogPrintf("Written info to %s  %dms\n", strFilename, GetTimeMillis() - nStart);
+        // replace existing file, if any, with new file
+        if (!RenameOver(pathTmp, pathDB)) {
+            remove(pathTmp);
+            return error("%s: Rename-into-place failed", __func__);
+        }
+
+        LogPrintf("Written info to %s (%u bytes)  %dms\n", strFilename, ssHeader.size() + ssPayload.size() + sizeof(hash), GetTimeMillis() - nStart);
         //LogPrintf("     %s\n", objToSave.ToString());
 
         return true;
     }
 
+    /** Hash the first nDataSize bytes of the file and compare them with the checksum that follows */
+    static bool VerifyChecksum(CAutoFile& filein, uint64_t nDataSize)
+    {
+        if (fseek(filein.Get(), 0, SEEK_SET) != 0) return false;
+        CHashVerifier<CAutoFile> verifier(&filein);
+        uint256 hashIn;
+        try {
+            verifier.ignore(nDataSize);
+            filein >> hashIn;
+        }
+        catch (std::exception &e) {
+            return false;
+        }
+        return verifier.GetHash() == hashIn;
+    }
+
+    /**
+     * Deserialize the object straight from the file while hashing it, so the
+     * file contents are never held in memory next to the loaded object. A
+     * corrupted file is still reported as IncorrectHash rather than as a
+     * format error, as it was when the checksum was verified up front.
+     */
     ReadResult Read(T& objToLoad, bool fDryRun = false)
     {
         //LOCK(objToLoad.cs);
@@ -87,72 +258,108 @@ private:
             return FileError;
         }
 
-        // use file size to size memory buffer
-        int fileSize = boost::filesystem::file_size(pathDB);
-        int dataSize = fileSize - sizeof(uint256);
-        // Don't try to resize to a negative number if file is small
-        if (dataSize < 0)
-            dataSize = 0;
-        std::vector<unsigned char> vchData;
-        vchData.resize(dataSize);
-        uint256 hashIn;
-
-        // read data and checksum from file
-        try {
-            filein.read((char *)&vchData[0], dataSize);
-            filein >> hashIn;
-        }
-        catch (std::exception &e) {
-            error("%s: Deserialize or I/O error - %s", __func__, e.what());
-            return HashReadError;
-        }
-        filein.fclose();
-
-        CDataStream ssObj(vchData, SER_DISK, CLIENT_VERSION);
-
-        // verify stored checksum matches input data
-        uint256 hashTmp = HashS(ssObj.begin(), ssObj.end());
-        if (hashIn != hashTmp)
+        const uint64_t fileSize = boost::filesystem::file_size(pathDB);
+        if (fileSize < sizeof(uint256))
         {
-            error("%s: Checksum mismatch, data corrupted", __func__);
-            return IncorrectHash;
+            error("%s: Deserialize or I/O error - file too small", __func__);
+            return HashReadError;
         }
+        const uint64_t dataSize = fileSize - sizeof(uint256);
 
-
-        unsigned char pchMsgTmp[4];
-        std::string strMagicMessageTmp;
+        ReadResult result = Ok;
+        bool fLegacy = false;
         try {
+            CHashVerifier<CAutoFile> verifier(&filein);
+            unsigned char pchMsgTmp[4];
+            std::string strMagicMessageTmp;
+
             // de-serialize file header (file specific magic message) and ..
-            ssObj >> strMagicMessageTmp;
+            verifier >> strMagicMessageTmp;
 
             // ... verify the message matches predefined one
             if (strMagicMessage != strMagicMessageTmp)
             {
-                error("%s: Invalid magic message", __func__);
-                return IncorrectMagicMessage;
+                result = IncorrectMagicMessage;
             }
-
-
-            // de-serialize file header (network specific magic number) and ..
-            ssObj >> pchMsgTmp;
-
-            // ... verify the network matches ours
-            if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp)))
+            else
             {
-                error("%s: Invalid network magic number", __func__);
-                return IncorrectMagicNumber;
+                // de-serialize file header (network specific magic number) and ..
+                verifier >> pchMsgTmp;
+
+                // ... verify the network matches ours
+                if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp)))
+                {
+                    result = IncorrectMagicNumber;
+                }
+                else if (ser_readdata8(verifier) != 0)
+                {
+                    fLegacy = true;
+                }
+                else
+                {
+                    uint64_t nFormatVersion;
+                    verifier >> VARINT(nFormatVersion);
+                    if (nFormatVersion != FORMAT_VERSION)
+                        throw std::ios_base::failure(strprintf("unknown format version %u", nFormatVersion));
+                    const uint64_t nPayloadSize = ReadCompactSize(verifier, false);
+                    const long nPayloadStart = ftell(filein.Get());
+                    if (nPayloadStart < 0 || nPayloadStart + nPayloadSize != dataSize)
+                        throw std::ios_base::failure("payload size mismatch");
+
+                    // de-serialize data into T object
+                    OverrideStream<CHashVerifier<CAutoFile>> payload(&verifier, SER_DISK, CLIENT_VERSION | FLATDB_COMPACT_FORMAT);
+                    payload >> objToLoad;
+                    if ((uint64_t)ftell(filein.Get()) != dataSize)
+                        throw std::ios_base::failure("payload size mismatch");
+
+                    uint256 hashIn;
+                    filein >> hashIn;
+                    if (verifier.GetHash() != hashIn)
+                        result = IncorrectHash;
+                }
             }
 
-            // de-serialize data into T object
-            ssObj >> objToLoad;
+            if (fLegacy)
+            {
+                // Pre-versioned file: the object follows the network magic
+                if (fseek(filein.Get(), 0, SEEK_SET) != 0)
+                    throw std::ios_base::failure("seek failed");
+                CHashVerifier<CAutoFile> legacy(&filein);
+                legacy >> strMagicMessageTmp >> pchMsgTmp >> objToLoad;
+                if ((uint64_t)ftell(filein.Get()) != dataSize)
+                    throw std::ios_base::failure("trailing data");
+
+                uint256 hashIn;
+                filein >> hashIn;
+                if (legacy.GetHash() != hashIn)
+                    result = IncorrectHash;
+            }
         }
         catch (std::exception &e) {
+            result = VerifyChecksum(filein, dataSize) ? IncorrectFormat : IncorrectHash;
+            if (result == IncorrectFormat)
+                error("%s: Deserialize or I/O error - %s", __func__, e.what());
+        }
+        if (result == IncorrectMagicMessage || result == IncorrectMagicNumber)
+        {
+            if (!VerifyChecksum(filein, dataSize))
+                result = IncorrectHash;
+        }
+        filein.fclose();
+
+        if (result != Ok)
+        {
             objToLoad.Clear();
-            error("%s: Deserialize or I/O error - %s", __func__, e.what());
-            return IncorrectFormat;
+            switch (result) {
+            case IncorrectHash: error("%s: Checksum mismatch, data corrupted", __func__); break;
+            case IncorrectMagicMessage: error("%s: Invalid magic message", __func__); break;
+            case IncorrectMagicNumber: error("%s: Invalid network magic number", __func__); break;
+            default: break;
+            }
+            return result;
         }
 
-        LogPrintf("Loaded info from %s  %dms\n", strFilename, GetTimeMillis() - nStart);
+        LogPrintf("Loaded info from %s%s  %dms\n", strFilename, fLegacy ? " (legacy format)" : "", GetTimeMillis() - nStart);
         //LogPrintf("     %s\n", objToLoad.ToString());
         if(!fDryRun) {
             LogPrintf("%s: Cleaning....\n", __func__);
@@ -225,6 +432,16 @@ public:
         return true;
     }
 
+    /**
+     * Write a snapshot of the object without first verifying the file on disk.
+     * Meant for periodic saves while running, after Load() has already
+     * established that the existing file is ours.
+     */
+    bool Snapshot(const T& objToSave)
+    {
+        return Write(objToSave);
+    }
+
 };
 
 
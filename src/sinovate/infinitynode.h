@@ -12,6 +12,7 @@
 #include <net.h>
 #include <netbase.h>
 #include <chainparams.h>
+#include <sinovate/flat-database.h>
 
 using namespace std;
 
@@ -63,6 +64,24 @@ public:
 
     SERIALIZE_METHODS(CInfinitynode, obj)
     {
+        if (s.GetVersion() & FLATDB_COMPACT_FORMAT) {
+            // reward and expiry heights are stored relative to the burn height
+            int nExpireDelta = 0, nLastRewardDelta = 0, nNextRewardDelta = 0;
+            SER_WRITE(obj, nExpireDelta = obj.nExpireHeight - obj.nHeight);
+            SER_WRITE(obj, nLastRewardDelta = obj.nLastRewardHeight - obj.nHeight);
+            SER_WRITE(obj, nNextRewardDelta = obj.nNextRewardHeight - obj.nHeight);
+            READWRITE(obj.vinBurnFund, ZIGZAG(obj.sigTime), ZIGZAG(obj.nProtocolVersion));
+            READWRITE(ZIGZAG(obj.nHeight), ZIGZAG(nExpireDelta), ZIGZAG(nLastRewardDelta), ZIGZAG(nNextRewardDelta));
+            SER_READ(obj, obj.nExpireHeight = obj.nHeight + nExpireDelta);
+            SER_READ(obj, obj.nLastRewardHeight = obj.nHeight + nLastRewardDelta);
+            SER_READ(obj, obj.nNextRewardHeight = obj.nHeight + nNextRewardDelta);
+            READWRITE(ZIGZAG(obj.nBurnValue), ZIGZAG(obj.nSINType));
+            READWRITE(Using<AddressStringFormatter>(obj.collateralAddress));
+            READWRITE(obj.scriptPubKey);
+            READWRITE(Using<AddressStringFormatter>(obj.backupAddress));
+            READWRITE(obj.metadataID);
+            return;
+        }
         READWRITE(obj.vinBurnFund);
         READWRITE(obj.sigTime);
         READWRITE(obj.nProtocolVersion);
@@ -33,9 +33,17 @@ public:
 
     SERIALIZE_METHODS(CLockRewardExtractInfo, obj)
     {
-        READWRITE(obj.nBlockHeight);
-        READWRITE(obj.nSINtype);
-        READWRITE(obj.nRewardHeight);
+        if (s.GetVersion() & FLATDB_COMPACT_FORMAT) {
+            // the reward height is stored relative to the height it was read at
+            int nRewardDelta = 0;
+            SER_WRITE(obj, nRewardDelta = obj.nRewardHeight - obj.nBlockHeight);
+            READWRITE(ZIGZAG(obj.nBlockHeight), ZIGZAG(obj.nSINtype), ZIGZAG(nRewardDelta));
+            SER_READ(obj, obj.nRewardHeight = obj.nBlockHeight + nRewardDelta);
+        } else {
+            READWRITE(obj.nBlockHeight);
+            READWRITE(obj.nSINtype);
+            READWRITE(obj.nRewardHeight);
+        }
         READWRITE(obj.scriptPubKey);
         READWRITE(obj.sLRInfo);
     }
@@ -45,11 +53,11 @@ class CInfinitynodeLockInfo
 {
 private:
     static const std::string SERIALIZATION_VERSION_STRING;
-    // critical section to protect the inner data structures
-    mutable RecursiveMutex cs;
     // Keep track of current block height
     int nCachedBlockHeight;
 public:
+    // critical section to protect the inner data structures
+    mutable RecursiveMutex cs;
     std::vector<CLockRewardExtractInfo> vecLRInfo;
 
     CInfinitynodeLockInfo():
@@ -10,6 +10,7 @@
 #include <sinovate/flat-database.h>
 #include <chainparams.h>
 #include <key_io.h>
+#include <node/blockprefetch.h>
 #include <script/standard.h>
 #include <netbase.h>
 
@@ -305,14 +306,21 @@ bool CInfinitynodeMan::buildInfinitynodeList(int nBeginHeight, int nEndHeight)
     LOCK2(cs_main, cs);
 
     int nLowHeight = nBeginHeight;
+    // Read the blocks ahead of the scan in the background.
+    BlockPrefetcher prefetcher(Params().GetConsensus());
+    int nAheadHeight = nLowHeight;
 
     while(nLowHeight <= nEndHeight)
     {
         CBlockIndex* pindex  = ::ChainActive()[nLowHeight];
 
-        CBlock blockReadFromDisk;
-        if (ReadBlockFromDisk(blockReadFromDisk, pindex, Params().GetConsensus()))
+        while (nAheadHeight <= nEndHeight && ::ChainActive()[nAheadHeight] && prefetcher.Prefetch(::ChainActive()[nAheadHeight])) {
+            nAheadHeight++;
+        }
+        std::shared_ptr<const CBlock> pblockRead = prefetcher.Get(pindex);
+        if (pblockRead)
         {
+            const CBlock& blockReadFromDisk = *pblockRead;
             for (const CTransactionRef& tx : blockReadFromDisk.vtx) {
                 //Not coinbase
                 if (!tx->IsCoinBase()) {
@@ -554,12 +562,20 @@ bool CInfinitynodeMan::updateLastPaidList(int nBlockHeight, int nLowHeight)
         nLastPaidScanDeepth = nBlockHeight - 1;
     }
 
+    // Read the blocks below the scan position in the background.
+    BlockPrefetcher prefetcher(Params().GetConsensus());
+    const CBlockIndex* pindexAhead = prevBlockIndex;
+
     //change nLowHeight to 1 ==> do full scan
     while (prevBlockIndex->nHeight >= nLowHeight)
     {
-        CBlock blockReadFromDisk;
-        if (ReadBlockFromDisk(blockReadFromDisk, prevBlockIndex, Params().GetConsensus()))
+        while (pindexAhead && pindexAhead->nHeight >= nLowHeight && prefetcher.Prefetch(pindexAhead)) {
+            pindexAhead = pindexAhead->pprev;
+        }
+        std::shared_ptr<const CBlock> pblockRead = prefetcher.Get(prevBlockIndex);
+        if (pblockRead)
         {
+            const CBlock& blockReadFromDisk = *pblockRead;
             for (const CTransactionRef& tx : blockReadFromDisk.vtx) {
                 //Not coinbase
                 if (!tx->IsCoinBase()) {
@@ -11,6 +11,8 @@
 
 #include <logging.h>
 
+#include <chrono>
+
 using namespace std;
 
 class CInfinitynodeMan;
@@ -18,6 +20,9 @@ class CConnman;
 
 extern CInfinitynodeMan infnodeman;
 
+/** How often the infinity-node caches are snapshotted to disk while running */
+static constexpr std::chrono::minutes DUMP_INFINITYNODE_INTERVAL{15};
+
 class CInfinitynodeMan
 {
 public:
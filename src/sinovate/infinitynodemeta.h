@@ -9,6 +9,7 @@
 #include <validation.h>
 #include <script/standard.h>
 #include <key_io.h>
+#include <sinovate/flat-database.h>
 
 using namespace std;
 
@@ -34,6 +35,10 @@ public:
 
     SERIALIZE_METHODS(CMetahisto, obj)
     {
+        if (s.GetVersion() & FLATDB_COMPACT_FORMAT) {
+            READWRITE(ZIGZAG(obj.nHeightHisto), Using<Base64StringFormatter>(obj.pubkeyHisto), obj.serviceHisto);
+            return;
+        }
         READWRITE(obj.nHeightHisto);
         READWRITE(obj.pubkeyHisto);
         READWRITE(obj.serviceHisto);
@@ -74,6 +79,11 @@ public:
 
     SERIALIZE_METHODS(CMetadata, obj)
     {
+        if (s.GetVersion() & FLATDB_COMPACT_FORMAT) {
+            READWRITE(obj.metaID, Using<Base64StringFormatter>(obj.metadataPublicKey), obj.metadataService);
+            READWRITE(ZIGZAG(obj.nMetadataHeight), ZIGZAG(obj.activeBackupAddress), obj.vHisto);
+            return;
+        }
         READWRITE(obj.metaID);
         READWRITE(obj.metadataPublicKey);
         READWRITE(obj.metadataService);
@@ -103,11 +113,11 @@ class CInfinitynodeMeta
 {
 private:
     static const std::string SERIALIZATION_VERSION_STRING;
-    // critical section to protect the inner data structures
-    mutable RecursiveMutex cs;
     // Keep track of current block height
     int nCachedBlockHeight;
 public:
+    // critical section to protect the inner data structures
+    mutable RecursiveMutex cs;
     std::map<std::string, CMetadata> mapNodeMetadata;
 
     CInfinitynodeMeta();
@@ -9,6 +9,7 @@
 #include <validation.h>
 #include <script/standard.h>
 #include <key_io.h>
+#include <sinovate/flat-database.h>
 
 using namespace std;
 
@@ -42,7 +43,11 @@ public:
     {
         READWRITE(obj.proposalId);
         READWRITE(*(CScriptBase*)(&obj.voter));
-        READWRITE(obj.nHeight);
+        if (s.GetVersion() & FLATDB_COMPACT_FORMAT) {
+            READWRITE(ZIGZAG(obj.nHeight));
+        } else {
+            READWRITE(obj.nHeight);
+        }
         READWRITE(obj.opinion);
     }
 
@@ -56,11 +61,11 @@ class CInfinitynodersv
 {
 private:
     static const std::string SERIALIZATION_VERSION_STRING;
-    // critical section to protect the inner data structures
-    mutable RecursiveMutex cs;
     // Keep track of current block height
     int nCachedBlockHeight;
 public:
+    // critical section to protect the inner data structures
+    mutable RecursiveMutex cs;
     std::map<std::string, std::vector<CVote>> mapProposalVotes;
 
     CInfinitynodersv();
@@ -0,0 +1,191 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SUPPORT_ALLOCATORS_POOL_H
+#define BITCOIN_SUPPORT_ALLOCATORS_POOL_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <new>
+#include <utility>
+
+/**
+ * A memory resource for many small allocations of similar size, such as the
+ * nodes of a node-based container.
+ *
+ * Memory is taken from the system in large chunks and handed out in multiples
+ * of ALIGN_BYTES. Freed blocks of up to MAX_BLOCK_SIZE_BYTES go to a free list
+ * per size and are reused; they are only returned to the system, all at once,
+ * when the resource is destroyed. Larger or over-aligned requests fall back to
+ * ::operator new.
+ *
+ * Compared to one heap allocation per node this saves the allocator's
+ * per-allocation overhead, keeps nodes densely packed, and makes releasing a
+ * whole container a handful of free() calls.
+ *
+ * Not thread-safe.
+ */
+template <std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+class PoolResource final
+{
+    static_assert(ALIGN_BYTES > 0, "ALIGN_BYTES must be nonzero");
+    static_assert((ALIGN_BYTES & (ALIGN_BYTES - 1)) == 0, "ALIGN_BYTES must be a power of two");
+
+    //! Free blocks are linked through their own storage
+    struct ListNode {
+        ListNode* m_next;
+        explicit ListNode(ListNode* next) : m_next(next) {}
+    };
+
+    //! Blocks are handed out in multiples of this
+    static constexpr std::size_t ELEM_ALIGN_BYTES = std::max(alignof(ListNode), ALIGN_BYTES);
+    static_assert(sizeof(ListNode) <= ELEM_ALIGN_BYTES, "a free block must be able to hold a ListNode");
+    static_assert(MAX_BLOCK_SIZE_BYTES >= ELEM_ALIGN_BYTES, "MAX_BLOCK_SIZE_BYTES too small");
+
+    const std::size_t m_chunk_size_bytes;
+
+    //! Chunks taken from the system, released in the destructor
+    std::list<std::byte*> m_allocated_chunks{};
+
+    //! Free lists, indexed by block size in multiples of ELEM_ALIGN_BYTES
+    std::array<ListNode*, MAX_BLOCK_SIZE_BYTES / ELEM_ALIGN_BYTES + 1> m_free_lists{};
+
+    //! Untouched remainder of the current chunk
+    std::byte* m_available_memory_it{nullptr};
+    std::byte* m_available_memory_end{nullptr};
+
+    static constexpr std::size_t NumElemAlignBytes(std::size_t bytes)
+    {
+        return (bytes + ELEM_ALIGN_BYTES - 1) / ELEM_ALIGN_BYTES + (bytes == 0);
+    }
+
+    static constexpr bool IsFreeListUsable(std::size_t bytes, std::size_t alignment)
+    {
+        return alignment <= ELEM_ALIGN_BYTES && bytes <= MAX_BLOCK_SIZE_BYTES;
+    }
+
+    static void PlacementAddToList(void* p, ListNode*& node)
+    {
+        node = new (p) ListNode{node};
+    }
+
+    void AllocateChunk()
+    {
+        // Keep what is left of the current chunk on the free list of its size
+        const std::size_t remaining_available_bytes = m_available_memory_end - m_available_memory_it;
+        if (remaining_available_bytes != 0) {
+            PlacementAddToList(m_available_memory_it, m_free_lists[remaining_available_bytes / ELEM_ALIGN_BYTES]);
+        }
+
+        void* storage = ::operator new (m_chunk_size_bytes, std::align_val_t{ELEM_ALIGN_BYTES});
+        m_available_memory_it = new (storage) std::byte[m_chunk_size_bytes];
+        m_available_memory_end = m_available_memory_it + m_chunk_size_bytes;
+        m_allocated_chunks.emplace_back(m_available_memory_it);
+    }
+
+public:
+    static constexpr std::size_t DEFAULT_CHUNK_SIZE_BYTES = 256 << 10;
+
+    /** The first chunk is only allocated on first use, so an empty resource is cheap. */
+    explicit PoolResource(std::size_t chunk_size_bytes = DEFAULT_CHUNK_SIZE_BYTES)
+        : m_chunk_size_bytes(NumElemAlignBytes(chunk_size_bytes) * ELEM_ALIGN_BYTES)
+    {
+        assert(m_chunk_size_bytes >= MAX_BLOCK_SIZE_BYTES);
+    }
+
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+
+    ~PoolResource()
+    {
+        for (std::byte* chunk : m_allocated_chunks) {
+            ::operator delete ((void*)chunk, std::align_val_t{ELEM_ALIGN_BYTES});
+        }
+    }
+
+    void* Allocate(std::size_t bytes, std::size_t alignment)
+    {
+        if (!IsFreeListUsable(bytes, alignment)) {
+            return ::operator new (bytes, std::align_val_t{alignment});
+        }
+        const std::size_t num_alignments = NumElemAlignBytes(bytes);
+        if (m_free_lists[num_alignments] != nullptr) {
+            return std::exchange(m_free_lists[num_alignments], m_free_lists[num_alignments]->m_next);
+        }
+        const std::size_t round_bytes = num_alignments * ELEM_ALIGN_BYTES;
+        if (round_bytes > static_cast<std::size_t>(m_available_memory_end - m_available_memory_it)) {
+            AllocateChunk();
+        }
+        return std::exchange(m_available_memory_it, m_available_memory_it + round_bytes);
+    }
+
+    void Deallocate(void* p, std::size_t bytes, std::size_t alignment) noexcept
+    {
+        if (!IsFreeListUsable(bytes, alignment)) {
+            ::operator delete (p, std::align_val_t{alignment});
+            return;
+        }
+        PlacementAddToList(p, m_free_lists[NumElemAlignBytes(bytes)]);
+    }
+
+    std::size_t NumAllocatedChunks() const { return m_allocated_chunks.size(); }
+    std::size_t ChunkSizeBytes() const { return m_chunk_size_bytes; }
+};
+
+/**
+ * Stateful allocator drawing from a PoolResource, for standard containers.
+ * All copies (and rebinds) share the resource, which must outlive them.
+ */
+template <class T, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES = alignof(T)>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+    using ResourceType = PoolResource<MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>;
+
+    template <typename U>
+    struct rebind {
+        using other = PoolAllocator<U, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>;
+    };
+
+    PoolAllocator(ResourceType* resource) noexcept : m_resource(resource) {}
+
+    template <class U>
+    PoolAllocator(const PoolAllocator<U, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& other) noexcept : m_resource(other.resource()) {}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(m_resource->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        m_resource->Deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    ResourceType* resource() const noexcept { return m_resource; }
+
+private:
+    ResourceType* m_resource;
+};
+
+template <class T1, class T2, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+bool operator==(const PoolAllocator<T1, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& a,
+                const PoolAllocator<T2, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& b) noexcept
+{
+    return a.resource() == b.resource();
+}
+
+template <class T1, class T2, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+bool operator!=(const PoolAllocator<T1, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& a,
+                const PoolAllocator<T2, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& b) noexcept
+{
+    return !(a == b);
+}
+
+#endif // BITCOIN_SUPPORT_ALLOCATORS_POOL_H
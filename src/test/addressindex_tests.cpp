@@ -0,0 +1,187 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <index/addressindex.h>
+#include <key.h>
+#include <script/interpreter.h>
+#include <script/standard.h>
+#include <test/util/index.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(addressindex_tests)
+
+static bool HasUnspent(const AddressIndex& index, const CScript& script, const COutPoint& outpoint)
+{
+    std::vector<AddressUnspentEntry> unspent;
+    BOOST_REQUIRE(index.FindUnspent(script, COutPoint(), 0, unspent));
+    for (const AddressUnspentEntry& entry : unspent) {
+        if (entry.outpoint == outpoint) return true;
+    }
+    return false;
+}
+
+/** Check the running totals of a script against its unspent outputs and history. */
+static AddressBalance CheckBalance(const AddressIndex& index, const CScript& script)
+{
+    std::vector<AddressUnspentEntry> unspent;
+    std::vector<AddressHistoryEntry> history;
+    BOOST_REQUIRE(index.FindUnspent(script, COutPoint(), 0, unspent));
+    BOOST_REQUIRE(index.FindHistory(script, 0, 0, history));
+    AddressBalance expected;
+    for (const AddressUnspentEntry& entry : unspent) {
+        expected.balance += entry.value;
+    }
+    for (const AddressHistoryEntry& entry : history) {
+        if (!entry.spending) expected.received += entry.value;
+    }
+    expected.utxos = unspent.size();
+
+    AddressBalance balance;
+    BOOST_REQUIRE(index.FindBalance(script, balance));
+    BOOST_CHECK_EQUAL(balance.balance, expected.balance);
+    BOOST_CHECK_EQUAL(balance.received, expected.received);
+    BOOST_CHECK_EQUAL(balance.utxos, expected.utxos);
+    return balance;
+}
+
+BOOST_FIXTURE_TEST_CASE(addressindex_sync_spend_reorg, TestChain100Setup)
+{
+    AddressIndex address_index(1 << 20, true);
+
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+
+    std::vector<AddressUnspentEntry> unspent;
+    BOOST_REQUIRE(address_index.FindUnspent(coinbase_script, COutPoint(), 0, unspent));
+    BOOST_CHECK(unspent.empty());
+
+    address_index.Start();
+
+    // Allow address index to catch up with the block index.
+    BOOST_REQUIRE(IndexWaitSynced(address_index));
+
+    // Every coinbase output paying to the test key is unspent and credited once.
+    size_t n_credits = 0;
+    for (const auto& txn : m_coinbase_txns) {
+        for (size_t i = 0; i < txn->vout.size(); ++i) {
+            if (txn->vout[i].scriptPubKey != coinbase_script) continue;
+            BOOST_CHECK(HasUnspent(address_index, coinbase_script, COutPoint(txn->GetHash(), i)));
+            ++n_credits;
+        }
+    }
+    std::vector<AddressHistoryEntry> history;
+    BOOST_REQUIRE(address_index.FindHistory(coinbase_script, 0, 0, history));
+    BOOST_CHECK_EQUAL(history.size(), n_credits);
+    for (size_t i = 1; i < history.size(); ++i) {
+        BOOST_CHECK(history[i - 1].height <= history[i].height);
+    }
+    const AddressBalance synced_balance = CheckBalance(address_index, coinbase_script);
+    BOOST_CHECK_EQUAL(synced_balance.utxos, n_credits);
+
+    // Paging returns consecutive slices of the full history.
+    std::vector<AddressHistoryEntry> page;
+    BOOST_REQUIRE(address_index.FindHistory(coinbase_script, 10, 5, page));
+    BOOST_REQUIRE_EQUAL(page.size(), 5U);
+    BOOST_CHECK(page[0].txid == history[10].txid);
+    BOOST_CHECK(page[4].txid == history[14].txid);
+
+    // Paging from an outpoint returns the outputs following it.
+    std::vector<AddressUnspentEntry> all_unspent, paged_unspent;
+    BOOST_REQUIRE(address_index.FindUnspent(coinbase_script, COutPoint(), 0, all_unspent));
+    BOOST_REQUIRE_EQUAL(all_unspent.size(), n_credits);
+    COutPoint cursor;
+    while (true) {
+        std::vector<AddressUnspentEntry> unspent_page;
+        BOOST_REQUIRE(address_index.FindUnspent(coinbase_script, cursor, 7, unspent_page));
+        BOOST_REQUIRE(unspent_page.size() <= 7);
+        if (unspent_page.empty()) break;
+        paged_unspent.insert(paged_unspent.end(), unspent_page.begin(), unspent_page.end());
+        cursor = unspent_page.back().outpoint;
+    }
+    BOOST_REQUIRE_EQUAL(paged_unspent.size(), all_unspent.size());
+    for (size_t i = 0; i < all_unspent.size(); ++i) {
+        BOOST_CHECK(paged_unspent[i].outpoint == all_unspent[i].outpoint);
+    }
+
+    // Spend the first coinbase to a fresh key.
+    CKey dest_key;
+    dest_key.MakeNewKey(true);
+    const CScript dest_script = GetScriptForDestination(PKHash(dest_key.GetPubKey()));
+    const COutPoint spent_outpoint(m_coinbase_txns[0]->GetHash(), 0);
+
+    CMutableTransaction spend;
+    spend.nVersion = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = spent_outpoint;
+    spend.vout.resize(1);
+    spend.vout[0].nValue = 11 * CENT;
+    spend.vout[0].scriptPubKey = dest_script;
+    std::vector<unsigned char> vchSig;
+    const uint256 hash = SignatureHash(coinbase_script, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_REQUIRE(coinbaseKey.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << vchSig;
+
+    const CBlock block = CreateAndProcessBlock({spend}, coinbase_script);
+    BOOST_REQUIRE(block.vtx.size() == 2);
+    BOOST_CHECK(address_index.BlockUntilSyncedToCurrentChain());
+
+    BOOST_CHECK(!HasUnspent(address_index, coinbase_script, spent_outpoint));
+    BOOST_CHECK(HasUnspent(address_index, dest_script, COutPoint(spend.GetHash(), 0)));
+
+    history.clear();
+    BOOST_REQUIRE(address_index.FindHistory(coinbase_script, 0, 0, history));
+    bool found_debit = false;
+    for (const AddressHistoryEntry& entry : history) {
+        if (entry.spending) {
+            BOOST_CHECK(entry.txid == spend.GetHash());
+            BOOST_CHECK_EQUAL(entry.value, -m_coinbase_txns[0]->vout[0].nValue);
+            found_debit = true;
+        } else if (entry.txid == spent_outpoint.hash && entry.index == spent_outpoint.n) {
+            BOOST_CHECK(entry.spent);
+        }
+    }
+    BOOST_CHECK(found_debit);
+
+    // The spent coinbase leaves the balance but not the amount received.
+    const AddressBalance spent_balance = CheckBalance(address_index, coinbase_script);
+    BOOST_CHECK(spent_balance.balance < spent_balance.received);
+    const AddressBalance dest_balance = CheckBalance(address_index, dest_script);
+    BOOST_CHECK_EQUAL(dest_balance.balance, 11 * CENT);
+    BOOST_CHECK_EQUAL(dest_balance.utxos, 1U);
+
+    // Replace the block with one that does not contain the spend: the index
+    // must rewind it.
+    {
+        BlockValidationState state;
+        ChainstateActive().InvalidateBlock(state, Params(), ChainActive().Tip());
+    }
+    CreateAndProcessBlock({}, coinbase_script);
+    BOOST_CHECK(address_index.BlockUntilSyncedToCurrentChain());
+
+    BOOST_CHECK(HasUnspent(address_index, coinbase_script, spent_outpoint));
+    unspent.clear();
+    BOOST_REQUIRE(address_index.FindUnspent(dest_script, COutPoint(), 0, unspent));
+    BOOST_CHECK(unspent.empty());
+    history.clear();
+    BOOST_REQUIRE(address_index.FindHistory(dest_script, 0, 0, history));
+    BOOST_CHECK(history.empty());
+
+    // Rewinding restores the totals, and drops those of the fresh key.
+    const AddressBalance rewound_balance = CheckBalance(address_index, coinbase_script);
+    BOOST_CHECK_EQUAL(rewound_balance.balance, rewound_balance.received);
+    AddressBalance rewound_dest;
+    BOOST_REQUIRE(address_index.FindBalance(dest_script, rewound_dest));
+    BOOST_CHECK_EQUAL(rewound_dest.balance, 0);
+    BOOST_CHECK_EQUAL(rewound_dest.received, 0);
+    BOOST_CHECK_EQUAL(rewound_dest.utxos, 0U);
+
+    IndexStop(address_index);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
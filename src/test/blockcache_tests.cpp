@@ -0,0 +1,113 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <chainparams.h>
+#include <node/blockcache.h>
+#include <node/blockprefetch.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockcache_tests, BasicTestingSetup)
+
+static std::shared_ptr<const CBlock> MakeBlock(uint32_t nonce, size_t num_txs)
+{
+    auto block = std::make_shared<CBlock>();
+    block->nNonce = nonce;
+    for (size_t i = 0; i < num_txs; ++i) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vout.resize(1);
+        tx.vout[0].nValue = i;
+        block->vtx.push_back(MakeTransactionRef(tx));
+    }
+    return block;
+}
+
+BOOST_AUTO_TEST_CASE(blockcache_lru)
+{
+    std::vector<std::shared_ptr<const CBlock>> blocks;
+    std::vector<uint256> hashes;
+    for (uint32_t i = 0; i < 4; ++i) {
+        blocks.push_back(MakeBlock(i, 10));
+        hashes.push_back(InsecureRand256());
+    }
+
+    // Measure one entry, then allow exactly three of them
+    CBlockCache cache(std::numeric_limits<size_t>::max());
+    cache.Insert(hashes[0], blocks[0]);
+    const size_t entry_usage = cache.GetStats().usage;
+    BOOST_REQUIRE(entry_usage > 0);
+    cache.SetMaxUsage(3 * entry_usage);
+
+    cache.Insert(hashes[1], blocks[1]);
+    cache.Insert(hashes[2], blocks[2]);
+    // Touch the oldest entry so that the second one is evicted instead
+    BOOST_CHECK(cache.Get(hashes[0]) == blocks[0]);
+    cache.Insert(hashes[3], blocks[3]);
+
+    BOOST_CHECK(cache.Get(hashes[0]) == blocks[0]);
+    BOOST_CHECK(cache.Get(hashes[1]) == nullptr);
+    BOOST_CHECK(cache.Get(hashes[2]) == blocks[2]);
+    BOOST_CHECK(cache.Get(hashes[3]) == blocks[3]);
+
+    CBlockCache::Stats stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.entries, 3U);
+    BOOST_CHECK_EQUAL(stats.usage, 3 * entry_usage);
+    BOOST_CHECK_EQUAL(stats.hits, 4U);
+    BOOST_CHECK_EQUAL(stats.misses, 1U);
+
+    // Evicted blocks stay alive for their holders; disabling empties the cache
+    cache.SetMaxUsage(0);
+    BOOST_CHECK_EQUAL(cache.GetStats().entries, 0U);
+    BOOST_CHECK_EQUAL(blocks[2]->nNonce, 2U);
+    cache.Insert(hashes[1], blocks[1]);
+    BOOST_CHECK(cache.Get(hashes[1]) == nullptr);
+}
+
+BOOST_FIXTURE_TEST_CASE(blockprefetch_order, TestChain100Setup)
+{
+    std::vector<const CBlockIndex*> chain;
+    {
+        LOCK(cs_main);
+        for (const CBlockIndex* pindex = ::ChainActive().Genesis(); pindex; pindex = ::ChainActive().Next(pindex)) {
+            chain.push_back(pindex);
+        }
+    }
+    BOOST_REQUIRE(chain.size() > 10);
+
+    for (bool check_pow : {false, true}) {
+        g_block_cache.Clear();
+        BlockPrefetcher prefetcher(Params().GetConsensus(), 4, 3, check_pow);
+        size_t ahead = 0;
+        for (size_t i = 0; i < chain.size(); ++i) {
+            while (ahead < chain.size() && prefetcher.Prefetch(chain[ahead])) ++ahead;
+            // the read-ahead window is bounded
+            BOOST_CHECK(ahead <= i + 4);
+            std::shared_ptr<const CBlock> block = prefetcher.Get(chain[i]);
+            BOOST_REQUIRE(block);
+            BOOST_CHECK_EQUAL(block->GetHash(), chain[i]->GetBlockHash());
+
+            if (i == chain.size() / 2) {
+                // dropping the window falls back to direct reads
+                prefetcher.Clear();
+                BOOST_CHECK(prefetcher.Get(chain[i + 1]));
+                ahead = i + 1;
+            }
+        }
+        // prefetched reads are not added to the recent-block cache
+        BOOST_CHECK_EQUAL(g_block_cache.GetStats().entries, 0U);
+    }
+
+    // a failed read is reported rather than returning another block
+    CBlockIndex mismatched = *chain.back();
+    mismatched.nNonce ^= 1;
+    BlockPrefetcher prefetcher(Params().GetConsensus());
+    BOOST_CHECK(prefetcher.Prefetch(&mismatched));
+    BOOST_CHECK(prefetcher.Get(&mismatched) == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
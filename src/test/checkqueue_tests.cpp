@@ -140,14 +140,20 @@ typedef CCheckQueue<FailingCheck> Failing_Queue;
 typedef CCheckQueue<UniqueCheck> Unique_Queue;
 typedef CCheckQueue<MemoryCheck> Memory_Queue;
 typedef CCheckQueue<FrozenCleanupCheck> FrozenCleanup_Queue;
+typedef CWorkStealingCheckQueue<FakeCheckCheckCompletion> Correct_WSQueue;
+typedef CWorkStealingCheckQueue<FailingCheck> Failing_WSQueue;
+typedef CWorkStealingCheckQueue<UniqueCheck> Unique_WSQueue;
+typedef CWorkStealingCheckQueue<MemoryCheck> Memory_WSQueue;
+typedef CWorkStealingCheckQueue<FrozenCleanupCheck> FrozenCleanup_WSQueue;
 
 
 /** This test case checks that the CCheckQueue works properly
  * with each specified size_t Checks pushed.
  */
+template <typename Queue = Correct_Queue>
 static void Correct_Queue_range(std::vector<size_t> range)
 {
-    auto small_queue = MakeUnique<Correct_Queue>(QUEUE_BATCH_SIZE);
+    auto small_queue = MakeUnique<Queue>(QUEUE_BATCH_SIZE);
     boost::thread_group tg;
     for (auto x = 0; x < SCRIPT_CHECK_THREADS; ++x) {
        tg.create_thread([&]{small_queue->Thread();});
@@ -157,7 +163,7 @@ static void Correct_Queue_range(std::vector<size_t> range)
     for (const size_t i : range) {
         size_t total = i;
         FakeCheckCheckCompletion::n_calls = 0;
-        CCheckQueueControl<FakeCheckCheckCompletion> control(small_queue.get());
+        CCheckQueueControl<FakeCheckCheckCompletion, Queue> control(small_queue.get());
         while (total) {
             vChecks.resize(std::min(total, (size_t) InsecureRandRange(10)));
             total -= vChecks.size();
@@ -444,5 +450,135 @@ BOOST_AUTO_TEST_CASE(test_CheckQueueControl_Locks)
         tg.join_all();
     }
 }
+/** The work-stealing queue runs every check exactly once for any number of checks */
+BOOST_AUTO_TEST_CASE(test_WorkStealingQueue_Correct)
+{
+    std::vector<size_t> range{0, 1, 2, 100000};
+    for (size_t i = 3; i < 20000; i += std::max((size_t)1, (size_t)InsecureRandRange(1000)))
+        range.push_back(i);
+    Correct_Queue_range<Correct_WSQueue>(range);
+
+    auto queue = MakeUnique<Unique_WSQueue>(QUEUE_BATCH_SIZE);
+    boost::thread_group tg;
+    for (auto x = 0; x < SCRIPT_CHECK_THREADS; ++x) {
+       tg.create_thread([&]{queue->Thread();});
+    }
+    {
+        LOCK(UniqueCheck::m);
+        UniqueCheck::results.clear();
+    }
+    size_t COUNT = 100000;
+    size_t total = COUNT;
+    {
+        CCheckQueueControl<UniqueCheck, Unique_WSQueue> control(queue.get());
+        while (total) {
+            size_t r = InsecureRandRange(10);
+            std::vector<UniqueCheck> vChecks;
+            for (size_t k = 0; k < r && total; k++)
+                vChecks.emplace_back(--total);
+            control.Add(vChecks);
+        }
+    }
+    {
+        LOCK(UniqueCheck::m);
+        BOOST_REQUIRE_EQUAL(UniqueCheck::results.size(), COUNT);
+        bool r = true;
+        for (size_t i = 0; i < COUNT; ++i) {
+            r = r && UniqueCheck::results.count(i) == 1;
+        }
+        BOOST_REQUIRE(r);
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+/** Failures are reported and do not leak into the next round */
+BOOST_AUTO_TEST_CASE(test_WorkStealingQueue_Failure)
+{
+    auto fail_queue = MakeUnique<Failing_WSQueue>(QUEUE_BATCH_SIZE);
+    boost::thread_group tg;
+    for (auto x = 0; x < SCRIPT_CHECK_THREADS; ++x) {
+       tg.create_thread([&]{fail_queue->Thread();});
+    }
+    for (size_t i = 0; i < 1001; ++i) {
+        const bool fails = i % 2 == 1;
+        CCheckQueueControl<FailingCheck, Failing_WSQueue> control(fail_queue.get());
+        size_t remaining = i;
+        while (remaining) {
+            size_t r = InsecureRandRange(10);
+            std::vector<FailingCheck> vChecks;
+            vChecks.reserve(r);
+            for (size_t k = 0; k < r && remaining; k++, remaining--)
+                vChecks.emplace_back(fails && remaining == 1);
+            control.Add(vChecks);
+        }
+        BOOST_REQUIRE_EQUAL(control.Wait(), !fails);
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+/** Checks are destroyed before the round ends, also when stolen */
+BOOST_AUTO_TEST_CASE(test_WorkStealingQueue_Memory)
+{
+    auto queue = MakeUnique<Memory_WSQueue>(QUEUE_BATCH_SIZE);
+    boost::thread_group tg;
+    for (auto x = 0; x < SCRIPT_CHECK_THREADS; ++x) {
+       tg.create_thread([&]{queue->Thread();});
+    }
+    for (size_t i = 0; i < 1000; ++i) {
+        size_t total = i;
+        {
+            CCheckQueueControl<MemoryCheck, Memory_WSQueue> control(queue.get());
+            while (total) {
+                size_t r = InsecureRandRange(10);
+                std::vector<MemoryCheck> vChecks;
+                for (size_t k = 0; k < r && total; k++) {
+                    total--;
+                    vChecks.emplace_back(total == 0 || total == i || total == i/2);
+                }
+                control.Add(vChecks);
+            }
+        }
+        BOOST_REQUIRE_EQUAL(MemoryCheck::fake_allocated_memory, 0U);
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+/** A new round cannot start until all checks of the last one have been destructed */
+BOOST_AUTO_TEST_CASE(test_WorkStealingQueue_FrozenCleanup)
+{
+    auto queue = MakeUnique<FrozenCleanup_WSQueue>(QUEUE_BATCH_SIZE);
+    boost::thread_group tg;
+    bool fails = false;
+    for (auto x = 0; x < SCRIPT_CHECK_THREADS; ++x) {
+        tg.create_thread([&]{queue->Thread();});
+    }
+    std::thread t0([&]() {
+        CCheckQueueControl<FrozenCleanupCheck, FrozenCleanup_WSQueue> control(queue.get());
+        std::vector<FrozenCleanupCheck> vChecks(1);
+        vChecks[0].should_freeze = true;
+        control.Add(vChecks);
+        bool waitResult = control.Wait(); // Hangs here
+        assert(waitResult);
+    });
+    {
+        std::unique_lock<std::mutex> l(FrozenCleanupCheck::m);
+        FrozenCleanupCheck::cv.wait(l, [](){return FrozenCleanupCheck::nFrozen == 1;});
+    }
+    for (auto x = 0; x < 100 && !fails; ++x) {
+        fails = queue->ControlMutex.try_lock();
+    }
+    {
+        std::unique_lock<std::mutex> l(FrozenCleanupCheck::m);
+        FrozenCleanupCheck::nFrozen = 0;
+    }
+    FrozenCleanupCheck::cv.notify_one();
+    t0.join();
+    tg.interrupt_all();
+    tg.join_all();
+    BOOST_REQUIRE(!fails);
+}
 BOOST_AUTO_TEST_SUITE_END()
 
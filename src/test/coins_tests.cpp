@@ -393,7 +393,7 @@ BOOST_AUTO_TEST_CASE(updatecoins_simulation_test)
             // Update the expected result to know about the new output coins
             assert(tx.vout.size() == 1);
             const COutPoint outpoint(tx.GetHash(), 0);
-            result[outpoint] = Coin(tx.vout[0], height, CTransaction(tx).IsCoinBase());
+            result[outpoint] = Coin(tx.vout[0], height, CTransaction(tx).IsCoinBase(), false);
 
             // Call UpdateCoins on the top cache
             CTxUndo undo;
@@ -609,7 +609,8 @@ void GetCoinsMapEntry(const CCoinsMap& map, CAmount& value, char& flags)
 
 void WriteCoinsViewEntry(CCoinsView& view, CAmount value, char flags)
 {
-    CCoinsMap map;
+    CCoinsMapMemoryResource resource;
+    CCoinsMap map{0, CCoinsMap::hasher{}, CCoinsMap::key_equal{}, &resource};
     InsertCoinsMapEntry(map, value, flags);
     BOOST_CHECK(view.BatchWrite(map, {}));
 }
@@ -739,7 +740,7 @@ static void CheckAddCoinBase(CAmount base_value, CAmount cache_value, CAmount mo
     try {
         CTxOut output;
         output.nValue = modify_value;
-        test.cache.AddCoin(OUTPOINT, Coin(std::move(output), 1, coinbase), coinbase);
+        test.cache.AddCoin(OUTPOINT, Coin(std::move(output), 1, coinbase, false), coinbase);
         test.cache.SelfTest();
         GetCoinsMapEntry(test.cache.map(), result_value, result_flags);
     } catch (std::logic_error&) {
@@ -878,4 +879,80 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_warm)
+{
+    CCoinsViewTest base;
+    CCoinsViewCacheTest cache(&base);
+    const COutPoint outpoint(InsecureRand256(), 0);
+    CTxOut out;
+    out.nValue = 5000;
+    out.scriptPubKey = CScript() << OP_TRUE;
+
+    // A warmed coin is served from memory and is not written back
+    cache.WarmCoin(outpoint, Coin(out, 10, false, false));
+    BOOST_CHECK(cache.HaveCoinInCache(outpoint));
+    BOOST_CHECK_EQUAL(cache.AccessCoin(outpoint).out.nValue, 5000);
+    BOOST_CHECK_EQUAL(cache.map().at(outpoint).flags, 0);
+    cache.SelfTest();
+
+    // An entry already in the cache wins
+    CTxOut other = out;
+    other.nValue = 1;
+    cache.WarmCoin(outpoint, Coin(other, 11, false, false));
+    BOOST_CHECK_EQUAL(cache.AccessCoin(outpoint).out.nValue, 5000);
+    cache.SelfTest();
+
+    BOOST_CHECK(cache.Flush());
+    Coin coin;
+    BOOST_CHECK(!base.GetCoin(outpoint, coin));
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_sync_evict)
+{
+    CCoinsViewTest base;
+    CCoinsViewCacheTest cache(&base);
+    const COutPoint cold(InsecureRand256(), 0), hot(InsecureRand256(), 0), spent(InsecureRand256(), 0);
+    CTxOut out;
+    out.nValue = 5000;
+    out.scriptPubKey = CScript() << OP_TRUE;
+    for (const COutPoint& outpoint : {cold, hot, spent}) {
+        cache.AddCoin(outpoint, Coin(out, 10, false, false), false);
+    }
+
+    // Sync writes the coins but keeps them cached, clean
+    cache.SetBestBlock(InsecureRand256());
+    BOOST_CHECK(cache.Sync());
+    Coin coin;
+    BOOST_CHECK(base.GetCoin(cold, coin) && !coin.IsSpent());
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 3U);
+    for (const auto& entry : cache.map()) {
+        BOOST_CHECK_EQUAL(entry.second.flags, 0);
+    }
+    cache.SelfTest();
+
+    // A synced spend is dropped from the cache
+    BOOST_CHECK_EQUAL(cache.AccessCoin(hot).out.nValue, 5000);
+    BOOST_CHECK(cache.SpendCoin(spent));
+    cache.SetBestBlock(InsecureRand256());
+    BOOST_CHECK(cache.Sync());
+    BOOST_CHECK(!base.GetCoin(spent, coin) || coin.IsSpent());
+    BOOST_CHECK(!cache.map().count(spent));
+    cache.SelfTest();
+
+    // Eviction takes the least recently used clean coins first, and never dirty ones
+    const COutPoint dirty(InsecureRand256(), 0);
+    cache.AddCoin(dirty, Coin(out, 11, false, false), false);
+    BOOST_CHECK_EQUAL(cache.Evict(cache.ResidentMemoryUsage()), 0U);
+    BOOST_CHECK_EQUAL(cache.Evict(cache.ResidentMemoryUsage() - 1), 1U);
+    BOOST_CHECK(!cache.HaveCoinInCache(cold));
+    BOOST_CHECK(cache.HaveCoinInCache(hot));
+    BOOST_CHECK_EQUAL(cache.Evict(0), 1U);
+    BOOST_CHECK(!cache.HaveCoinInCache(hot));
+    BOOST_CHECK(cache.HaveCoinInCache(dirty));
+    cache.SelfTest();
+
+    // Evicted coins are read back from the base
+    BOOST_CHECK_EQUAL(cache.AccessCoin(cold).out.nValue, 5000);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
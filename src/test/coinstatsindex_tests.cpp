@@ -0,0 +1,159 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <index/coinstatsindex.h>
+#include <node/coinstats.h>
+#include <test/util/index.h>
+#include <test/util/setup_common.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(coinstatsindex_tests)
+
+/** Walk the chainstate on disk, bypassing the index. */
+static CCoinsStats WalkUTXOSet()
+{
+    CCoinsStats stats;
+    CCoinsView* coins_view = WITH_LOCK(cs_main, ::ChainstateActive().ForceFlushStateToDisk(); return &::ChainstateActive().CoinsDB());
+    BOOST_REQUIRE(GetUTXOStats(coins_view, stats, CoinStatsHashType::MUHASH, [] {}, nullptr, /* index_requested */ false));
+    BOOST_CHECK(!stats.index_used);
+    return stats;
+}
+
+/** An index that reads back its stored best block each time it is asked to
+ *  write a block, which is what it would resume from if killed right then. */
+class CommittedBlockIndex final : public BaseIndex
+{
+    const std::unique_ptr<BaseIndex::DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override
+    {
+        CBlockLocator locator;
+        m_db->ReadBestBlock(locator);
+        m_committed.emplace_back(pindex->nHeight, locator);
+        return true;
+    }
+
+    BaseIndex::DB& GetDB() const override { return *m_db; }
+
+    const char* GetName() const override { return "committedblockindex"; }
+
+public:
+    explicit CommittedBlockIndex() : m_db(MakeUnique<BaseIndex::DB>(GetDataDir() / "indexes" / "committedblockindex", 1 << 20, true)) {}
+
+    CBlockLocator ReadBestBlock() const
+    {
+        CBlockLocator locator;
+        m_db->ReadBestBlock(locator);
+        return locator;
+    }
+
+    /** The height of each block written, with the best block stored at the time. */
+    std::vector<std::pair<int, CBlockLocator>> m_committed;
+};
+
+BOOST_FIXTURE_TEST_CASE(index_interrupted_first_sync, TestChain100Setup)
+{
+    // Interrupted before writing any block: nothing is stored, in particular
+    // not the locator of the chain tip.
+    {
+        CommittedBlockIndex index;
+        index.Interrupt();
+        index.Start();
+        IndexStop(index);
+        BOOST_CHECK(index.m_committed.empty());
+        BOOST_CHECK(index.ReadBestBlock().IsNull());
+    }
+
+    // Killed at any point of the first sync, the stored best block must be
+    // behind the block being written.
+    CommittedBlockIndex index;
+    index.Start();
+    BOOST_REQUIRE(IndexWaitSynced(index));
+    IndexStop(index);
+
+    const int tip_height = WITH_LOCK(cs_main, return ::ChainActive().Height());
+    BOOST_REQUIRE_EQUAL(index.m_committed.size(), size_t(tip_height + 1));
+    for (const auto& [height, locator] : index.m_committed) {
+        if (locator.IsNull()) continue;
+        const CBlockIndex* best = WITH_LOCK(cs_main, return LookupBlockIndex(locator.vHave.front()));
+        BOOST_REQUIRE(best);
+        BOOST_CHECK_LT(best->nHeight, height);
+    }
+    BOOST_CHECK(index.m_committed.front().second.IsNull());
+}
+
+BOOST_FIXTURE_TEST_CASE(coinstatsindex_initial_sync, TestChain100Setup)
+{
+    CoinStatsIndex coin_stats_index(1 << 20, true);
+
+    CCoinsStats index_stats;
+    const CBlockIndex* tip = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+
+    // CoinStatsIndex should not be found before it is started.
+    BOOST_CHECK(!coin_stats_index.LookUpStats(tip, index_stats));
+
+    // BlockUntilSyncedToCurrentChain should return false before CoinStatsIndex
+    // is started.
+    BOOST_CHECK(!coin_stats_index.BlockUntilSyncedToCurrentChain());
+
+    coin_stats_index.Start();
+
+    // Allow the CoinStatsIndex to catch up with the block index that is syncing
+    // in a background thread.
+    BOOST_REQUIRE(IndexWaitSynced(coin_stats_index));
+
+    // The index agrees with a full walk of the UTXO set.
+    BOOST_REQUIRE(coin_stats_index.LookUpStats(tip, index_stats));
+    CCoinsStats walk_stats = WalkUTXOSet();
+    BOOST_CHECK(index_stats.hashBlock == walk_stats.hashBlock);
+    BOOST_CHECK(index_stats.hashSerialized == walk_stats.hashSerialized);
+    BOOST_CHECK_EQUAL(index_stats.nTransactionOutputs, walk_stats.nTransactionOutputs);
+    BOOST_CHECK_EQUAL(index_stats.nBogoSize, walk_stats.nBogoSize);
+    BOOST_CHECK_EQUAL(index_stats.nTotalAmount, walk_stats.nTotalAmount);
+
+    // Every amount created is either still unspent or was made unspendable.
+    BOOST_CHECK_EQUAL(index_stats.total_subsidy, index_stats.nTotalAmount + index_stats.total_unspendable_amount);
+
+    // Every block has an entry.
+    const CBlockIndex* genesis_block_index = WITH_LOCK(cs_main, return ::ChainActive().Genesis());
+    BOOST_CHECK(coin_stats_index.LookUpStats(genesis_block_index, index_stats));
+    BOOST_CHECK_EQUAL(index_stats.nTransactionOutputs, 0U);
+
+    // Mine a new block and check that the index picks it up.
+    const CScript script_pub_key{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    CreateAndProcessBlock({}, script_pub_key);
+    BOOST_CHECK(coin_stats_index.BlockUntilSyncedToCurrentChain());
+
+    const CBlockIndex* new_tip = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+    CCoinsStats new_stats;
+    BOOST_REQUIRE(coin_stats_index.LookUpStats(new_tip, new_stats));
+    BOOST_CHECK(new_stats.hashSerialized != index_stats.hashSerialized);
+    BOOST_CHECK(new_stats.hashSerialized == WalkUTXOSet().hashSerialized);
+
+    // Replace the block: the index must rewind it and agree with the chainstate again.
+    // The replacement pays elsewhere, or it would be the invalidated block again.
+    {
+        BlockValidationState state;
+        ChainstateActive().InvalidateBlock(state, Params(), ChainActive().Tip());
+    }
+    CreateAndProcessBlock({}, CScript() << OP_TRUE);
+    BOOST_CHECK(coin_stats_index.BlockUntilSyncedToCurrentChain());
+
+    const CBlockIndex* reorg_tip = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+    BOOST_CHECK(reorg_tip != new_tip);
+    BOOST_CHECK_EQUAL(reorg_tip->nHeight, new_tip->nHeight);
+    BOOST_CHECK(!coin_stats_index.LookUpStats(new_tip, new_stats));
+    BOOST_REQUIRE(coin_stats_index.LookUpStats(reorg_tip, new_stats));
+    BOOST_CHECK(new_stats.hashSerialized == WalkUTXOSet().hashSerialized);
+
+    IndexStop(coin_stats_index);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -413,4 +413,45 @@ BOOST_AUTO_TEST_CASE(unicodepath)
 }
 
 
+BOOST_AUTO_TEST_CASE(dbwrapper_options)
+{
+    ArgsManager args;
+    args.AddArg("-dboption", "", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    const char* argv[] = {"ignored", "-dboption=chainstate:bloombits=0", "-dboption=txindex:blocksize=16384",
+                          "-dboption=chainstate:blocksize=1024", "-dboption=chainstate:maxfilesize=33554432"};
+    std::string error;
+    BOOST_REQUIRE(args.ParseParameters(5, (char**)argv, error));
+
+    DBOptions chainstate;
+    BOOST_CHECK(ApplyDBOptionArgs(args, "chainstate", chainstate, error));
+    BOOST_CHECK_EQUAL(chainstate.bloom_bits, 0);
+    BOOST_CHECK_EQUAL(chainstate.block_size, 1024U);
+    BOOST_CHECK_EQUAL(chainstate.max_file_size, 32U << 20);
+    BOOST_CHECK_EQUAL(chainstate.write_buffer_size, 0U);
+
+    DBOptions blocktree;
+    BOOST_CHECK(ApplyDBOptionArgs(args, "blocktree", blocktree, error));
+    BOOST_CHECK_EQUAL(blocktree.bloom_bits, DBOptions{}.bloom_bits);
+    BOOST_CHECK_EQUAL(blocktree.block_size, DBOptions{}.block_size);
+
+    for (const char* bad : {"-dboption=chainstate", "-dboption=chainstate:bloombits", "-dboption=chainstate:bloombits=x",
+                            "-dboption=chainstate:bloombits=65", "-dboption=chainstate:cachesize=1"}) {
+        ArgsManager bad_args;
+        bad_args.AddArg("-dboption", "", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+        const char* bad_argv[] = {"ignored", bad};
+        BOOST_REQUIRE(bad_args.ParseParameters(2, (char**)bad_argv, error));
+        DBOptions options;
+        BOOST_CHECK(!ApplyDBOptionArgs(bad_args, "chainstate", options, error));
+    }
+
+    // A database opened with non-default options works as usual
+    CDBWrapper dbw(GetDataDir() / "dbwrapper_options", 1 << 20, true, false, false, chainstate);
+    const uint256 in = InsecureRand256();
+    uint256 res;
+    BOOST_CHECK(dbw.Write('k', in));
+    BOOST_CHECK(dbw.Read('k', res));
+    BOOST_CHECK_EQUAL(res.ToString(), in.ToString());
+    BOOST_CHECK(!dbw.Exists('j'));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
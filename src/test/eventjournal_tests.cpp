@@ -0,0 +1,231 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <node/eventjournal.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <tinyformat.h>
+#include <util/system.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(eventjournal_tests, TestingSetup)
+
+static CTransactionRef MakeTx(uint32_t n)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout.n = n;
+    tx.vout.resize(1);
+    return MakeTransactionRef(tx);
+}
+
+/** Write count mempool events at the start of a segment, as the journal would have. */
+static void WriteSegment(const fs::path& dir, uint64_t segment, uint64_t count)
+{
+    CAutoFile file(fsbridge::fopen(dir / strprintf("%08u.dat", segment), "wb"), SER_DISK, CLIENT_VERSION);
+    BOOST_REQUIRE(!file.IsNull());
+    for (uint64_t i = 0; i < count; ++i) {
+        JournalEvent event;
+        event.sequence = segment * EventJournal::RECORDS_PER_SEGMENT + i;
+        event.type = JournalEvent::MEMPOOL_ACCEPT;
+        event.value = event.sequence;
+        file << event;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(eventjournal_append_and_resume)
+{
+    const fs::path dir = GetDataDir() / "journal";
+    std::vector<JournalEvent> events;
+
+    CBlockIndex index;
+    const uint256 block_hash = InsecureRand256();
+    index.phashBlock = &block_hash;
+    index.nHeight = 7;
+    const CTransactionRef tx = MakeTx(1);
+    {
+        EventJournal journal(dir, 0);
+        BOOST_REQUIRE(journal.Init());
+        BOOST_CHECK_EQUAL(journal.NextSequence(), 0U);
+
+        std::vector<uint64_t> appended;
+        journal.EventAppended.connect([&](const JournalEvent& event) { appended.push_back(event.sequence); });
+
+        RegisterValidationInterface(&journal);
+        GetMainSignals().TransactionAddedToMempool(tx, 11);
+        GetMainSignals().BlockConnected(std::make_shared<CBlock>(), &index);
+        GetMainSignals().BlockDisconnected(std::make_shared<CBlock>(), &index);
+        GetMainSignals().TransactionRemovedFromMempool(tx, MemPoolRemovalReason::EXPIRY, 12);
+        journal.WaitForSync();
+        UnregisterValidationInterface(&journal);
+
+        BOOST_CHECK(appended == std::vector<uint64_t>({0, 1, 2, 3}));
+        BOOST_CHECK_EQUAL(journal.NextSequence(), 4U);
+
+        BOOST_REQUIRE(journal.Read(1, 2, events));
+        BOOST_REQUIRE_EQUAL(events.size(), 2U);
+        BOOST_CHECK_EQUAL(events[0].sequence, 1U);
+        BOOST_CHECK_EQUAL(events[0].type, JournalEvent::BLOCK_CONNECT);
+        BOOST_CHECK(events[0].hash == block_hash);
+        BOOST_CHECK_EQUAL(events[0].value, 7U);
+        BOOST_CHECK_EQUAL(events[1].type, JournalEvent::BLOCK_DISCONNECT);
+
+        // Reading past the end returns what there is.
+        BOOST_REQUIRE(journal.Read(3, 100, events));
+        BOOST_REQUIRE_EQUAL(events.size(), 1U);
+        BOOST_CHECK_EQUAL(events[0].type, JournalEvent::MEMPOOL_REMOVE);
+        BOOST_CHECK(events[0].hash == tx->GetHash());
+        BOOST_CHECK_EQUAL(events[0].value, 12U);
+        BOOST_REQUIRE(journal.Read(4, 100, events));
+        BOOST_CHECK(events.empty());
+    }
+
+    // Leave a partial event behind, as a crash during a write would.
+    {
+        FILE* file = fsbridge::fopen(dir / "00000000.dat", "ab");
+        BOOST_REQUIRE(file);
+        fwrite("xyz", 1, 3, file);
+        fclose(file);
+    }
+
+    // The journal resumes where it left off.
+    EventJournal journal(dir, 0);
+    BOOST_REQUIRE(journal.Init());
+    BOOST_CHECK_EQUAL(journal.OldestSequence(), 0U);
+    BOOST_CHECK_EQUAL(journal.NextSequence(), 4U);
+    RegisterValidationInterface(&journal);
+    GetMainSignals().TransactionAddedToMempool(MakeTx(2), 1);
+    journal.WaitForSync();
+    UnregisterValidationInterface(&journal);
+
+    BOOST_REQUIRE(journal.Read(0, 100, events));
+    BOOST_REQUIRE_EQUAL(events.size(), 5U);
+    for (size_t i = 0; i < events.size(); ++i) {
+        BOOST_CHECK_EQUAL(events[i].sequence, i);
+    }
+    BOOST_CHECK_EQUAL(events[0].type, JournalEvent::MEMPOOL_ACCEPT);
+    BOOST_CHECK_EQUAL(events[0].value, 11U);
+    BOOST_CHECK_EQUAL(events[4].type, JournalEvent::MEMPOOL_ACCEPT);
+}
+
+BOOST_AUTO_TEST_CASE(eventjournal_segments)
+{
+    constexpr uint64_t RECORDS = EventJournal::RECORDS_PER_SEGMENT;
+    const fs::path dir = GetDataDir() / "journal";
+    std::vector<JournalEvent> events;
+
+    // Three segments, the last one an event short of full.
+    TryCreateDirectories(dir);
+    WriteSegment(dir, 0, RECORDS);
+    WriteSegment(dir, 1, RECORDS);
+    WriteSegment(dir, 2, RECORDS - 1);
+
+    {
+        // The journal keeps two segments, so the oldest is pruned at startup.
+        EventJournal journal(dir, 0);
+        BOOST_REQUIRE(journal.Init());
+        BOOST_CHECK_EQUAL(journal.OldestSequence(), RECORDS);
+        BOOST_CHECK_EQUAL(journal.NextSequence(), 3 * RECORDS - 1);
+        BOOST_CHECK(!fs::exists(dir / "00000000.dat"));
+        BOOST_CHECK(!journal.Read(RECORDS - 1, 1, events));
+
+        // Reads continue across segments.
+        BOOST_REQUIRE(journal.Read(2 * RECORDS - 1, 2, events));
+        BOOST_REQUIRE_EQUAL(events.size(), 2U);
+        BOOST_CHECK_EQUAL(events[0].sequence, 2 * RECORDS - 1);
+        BOOST_CHECK_EQUAL(events[1].sequence, 2 * RECORDS);
+        BOOST_CHECK_EQUAL(events[1].value, 2 * RECORDS);
+
+        // Filling the last segment starts a new one and prunes the oldest.
+        RegisterValidationInterface(&journal);
+        GetMainSignals().TransactionAddedToMempool(MakeTx(1), 1);
+        GetMainSignals().TransactionAddedToMempool(MakeTx(2), 2);
+        journal.WaitForSync();
+        UnregisterValidationInterface(&journal);
+
+        BOOST_CHECK_EQUAL(journal.OldestSequence(), 2 * RECORDS);
+        BOOST_CHECK_EQUAL(journal.NextSequence(), 3 * RECORDS + 1);
+        BOOST_CHECK(!fs::exists(dir / "00000001.dat"));
+        BOOST_CHECK_EQUAL(fs::file_size(dir / "00000002.dat"), RECORDS * JournalEvent::SERIALIZED_SIZE);
+        BOOST_CHECK_EQUAL(fs::file_size(dir / "00000003.dat"), JournalEvent::SERIALIZED_SIZE);
+        BOOST_CHECK(!journal.Read(2 * RECORDS - 1, 1, events));
+
+        BOOST_REQUIRE(journal.Read(3 * RECORDS - 2, 10, events));
+        BOOST_REQUIRE_EQUAL(events.size(), 3U);
+        BOOST_CHECK_EQUAL(events[0].value, 3 * RECORDS - 2);
+        BOOST_CHECK_EQUAL(events[1].sequence, 3 * RECORDS - 1);
+        BOOST_CHECK_EQUAL(events[1].value, 1U);
+        BOOST_CHECK_EQUAL(events[2].sequence, 3 * RECORDS);
+        BOOST_CHECK_EQUAL(events[2].value, 2U);
+    }
+
+    // The journal resumes in the new segment.
+    EventJournal journal(dir, 0);
+    BOOST_REQUIRE(journal.Init());
+    BOOST_CHECK_EQUAL(journal.OldestSequence(), 2 * RECORDS);
+    BOOST_CHECK_EQUAL(journal.NextSequence(), 3 * RECORDS + 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(eventjournal_catch_up, TestChain100Setup)
+{
+    const CScript script = CScript() << OP_TRUE;
+    std::vector<JournalEvent> events;
+
+    EventJournal journal(GetDataDir() / "journal", 0);
+    BOOST_REQUIRE(journal.Init());
+
+    // A new journal starts at the tip.
+    {
+        LOCK(cs_main);
+        journal.CatchUp(ChainActive());
+        RegisterValidationInterface(&journal);
+    }
+    BOOST_CHECK_EQUAL(journal.NextSequence(), 0U);
+    const uint256 journaled_block = CreateAndProcessBlock({}, script).GetHash();
+    journal.WaitForSync();
+    BOOST_CHECK_EQUAL(journal.NextSequence(), 1U);
+
+    // Miss a reorg of the journaled block, as a crash before its
+    // notifications were handled would.
+    UnregisterValidationInterface(&journal);
+    {
+        BlockValidationState state;
+        ChainstateActive().InvalidateBlock(state, Params(), ChainActive().Tip());
+    }
+    const uint256 first_block = CreateAndProcessBlock({}, CScript() << OP_TRUE << OP_TRUE).GetHash();
+    const uint256 second_block = CreateAndProcessBlock({}, script).GetHash();
+    SyncWithValidationInterfaceQueue();
+
+    const CBlockIndex* tip;
+    {
+        LOCK(cs_main);
+        tip = ChainActive().Tip();
+        journal.CatchUp(ChainActive());
+        RegisterValidationInterface(&journal);
+    }
+    journal.WaitForSync();
+    BOOST_REQUIRE(journal.Read(1, 100, events));
+    BOOST_REQUIRE_EQUAL(events.size(), 3U);
+    BOOST_CHECK_EQUAL(events[0].type, JournalEvent::BLOCK_DISCONNECT);
+    BOOST_CHECK(events[0].hash == journaled_block);
+    BOOST_CHECK_EQUAL(events[1].type, JournalEvent::BLOCK_CONNECT);
+    BOOST_CHECK(events[1].hash == first_block);
+    BOOST_CHECK_EQUAL(events[2].type, JournalEvent::BLOCK_CONNECT);
+    BOOST_CHECK(events[2].hash == second_block);
+    BOOST_CHECK_EQUAL(events[2].value, (uint64_t)tip->nHeight);
+
+    // A notification for a block that was caught up with is not journaled again.
+    GetMainSignals().BlockConnected(std::make_shared<CBlock>(), tip);
+    journal.WaitForSync();
+    BOOST_CHECK_EQUAL(journal.NextSequence(), 4U);
+    UnregisterValidationInterface(&journal);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,113 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <clientversion.h>
+#include <hash.h>
+#include <key_io.h>
+#include <sinovate/flat-database.h>
+#include <sinovate/infinitynode.h>
+#include <sinovate/infinitynodelockinfo.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <util/system.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(flatdb_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(flatdb_zigzag_varint)
+{
+    for (const int64_t value : {int64_t{0}, int64_t{-1}, int64_t{1}, int64_t{-1440}, int64_t{750000}, std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max()}) {
+        CDataStream ss(SER_DISK, CLIENT_VERSION);
+        ss << ZIGZAG(value);
+        int64_t decoded;
+        ss >> ZIGZAG(decoded);
+        BOOST_CHECK_EQUAL(decoded, value);
+        BOOST_CHECK(ss.empty());
+    }
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << ZIGZAG(int{-1});
+    BOOST_CHECK_EQUAL(ss.size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(flatdb_compact_infinitynode)
+{
+    CInfinitynode node(PROTOCOL_VERSION, COutPoint(InsecureRand256(), 1));
+    node.setHeight(465000);
+    node.setLastRewardHeight(470000);
+    node.setBurnValue(1000000 * COIN);
+    node.setSINType(CInfinitynode::SINNODE_10);
+    const PKHash collateral(uint160(std::vector<unsigned char>(20, 0x5a)));
+    node.setScriptPublicKey(GetScriptForDestination(collateral));
+    node.setCollateralAddress(EncodeDestination(collateral));
+
+    CDataStream legacy(SER_DISK, CLIENT_VERSION);
+    legacy << node;
+    CDataStream compact(SER_DISK, CLIENT_VERSION | FLATDB_COMPACT_FORMAT);
+    compact << node;
+    BOOST_CHECK_LT(compact.size(), legacy.size());
+
+    CInfinitynode decoded;
+    compact >> decoded;
+    BOOST_CHECK(compact.empty());
+    BOOST_CHECK(decoded.vinBurnFund == node.vinBurnFund);
+    BOOST_CHECK_EQUAL(decoded.nHeight, node.nHeight);
+    BOOST_CHECK_EQUAL(decoded.nExpireHeight, node.nExpireHeight);
+    BOOST_CHECK_EQUAL(decoded.nLastRewardHeight, node.nLastRewardHeight);
+    BOOST_CHECK_EQUAL(decoded.nNextRewardHeight, -1);
+    BOOST_CHECK_EQUAL(decoded.nBurnValue, node.nBurnValue);
+    BOOST_CHECK_EQUAL(decoded.nSINType, node.nSINType);
+    BOOST_CHECK_EQUAL(decoded.collateralAddress, node.collateralAddress);
+    BOOST_CHECK(decoded.scriptPubKey == node.scriptPubKey);
+    // not an address, kept verbatim
+    BOOST_CHECK_EQUAL(decoded.backupAddress, "BackupAddress");
+    BOOST_CHECK_EQUAL(decoded.metadataID, node.metadataID);
+}
+
+BOOST_AUTO_TEST_CASE(flatdb_legacy_upgrade)
+{
+    const std::string strMagic = "magicInfinityLockInfoTest";
+    CInfinitynodeLockInfo info;
+    CLockRewardExtractInfo lr(500000, 10, 500010, CScript() << OP_TRUE, "lrinfo");
+    info.Add(lr);
+
+    // Write a file in the layout used before the versioned format
+    CDataStream ssLegacy(SER_DISK, CLIENT_VERSION);
+    ssLegacy << strMagic << Params().MessageStart() << info;
+    ssLegacy << HashS(ssLegacy.begin(), ssLegacy.end());
+    const fs::path path = GetDataDir() / "flatdb_test.dat";
+    {
+        CAutoFile file(fsbridge::fopen(path, "wb"), SER_DISK, CLIENT_VERSION);
+        file << ssLegacy;
+    }
+
+    CFlatDB<CInfinitynodeLockInfo> flatdb("flatdb_test.dat", strMagic);
+    CInfinitynodeLockInfo loaded;
+    BOOST_CHECK(flatdb.Load(loaded));
+    BOOST_REQUIRE_EQUAL(loaded.vecLRInfo.size(), 1U);
+    BOOST_CHECK_EQUAL(loaded.vecLRInfo[0].nRewardHeight, 500010);
+
+    // Dumping rewrites it in the compact format, which loads back the same
+    BOOST_CHECK(flatdb.Dump(loaded));
+    BOOST_CHECK_LT(fs::file_size(path), ssLegacy.size());
+    CInfinitynodeLockInfo reloaded;
+    BOOST_CHECK(flatdb.Load(reloaded));
+    BOOST_REQUIRE_EQUAL(reloaded.vecLRInfo.size(), 1U);
+    BOOST_CHECK_EQUAL(reloaded.vecLRInfo[0].nBlockHeight, 500000);
+    BOOST_CHECK_EQUAL(reloaded.vecLRInfo[0].nRewardHeight, 500010);
+    BOOST_CHECK_EQUAL(reloaded.vecLRInfo[0].sLRInfo, "lrinfo");
+
+    // A corrupted file is rejected and leaves nothing behind
+    {
+        FILE* file = fsbridge::fopen(path, "r+b");
+        fseek(file, -40, SEEK_END);
+        fputc(0xff, file);
+        fclose(file);
+    }
+    CInfinitynodeLockInfo corrupted;
+    BOOST_CHECK(!flatdb.Load(corrupted));
+    BOOST_CHECK(corrupted.vecLRInfo.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
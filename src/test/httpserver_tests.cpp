@@ -0,0 +1,193 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <httprpc.h>
+#include <httpserver.h>
+#include <httpworkqueue.h>
+#include <test/util/setup_common.h>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(httpserver_tests, BasicTestingSetup)
+
+namespace {
+struct TestWorkItem {
+    std::function<void()> func;
+    void operator()() { func(); }
+};
+
+/** Lets queued items block until the test releases them */
+class Gate
+{
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_open GUARDED_BY(m_mutex){false};
+
+public:
+    void Wait()
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_open; });
+    }
+    void Open()
+    {
+        LOCK(m_mutex);
+        m_open = true;
+        m_cond.notify_all();
+    }
+};
+
+HTTPWorkThreadLimits Limits(size_t high, size_t normal, size_t low, size_t below_high)
+{
+    return {{high, normal, low}, below_high};
+}
+
+const HTTPWorkQueueStats& Stats(const std::vector<HTTPWorkQueueStats>& stats, HTTPWorkPriority priority)
+{
+    return stats[static_cast<size_t>(priority)];
+}
+
+/** Wait until pred holds for the queue's statistics */
+bool WaitForStats(WorkQueue<TestWorkItem>& queue, std::function<bool(const std::vector<HTTPWorkQueueStats>&)> pred)
+{
+    for (int i = 0; i < 1000; ++i) {
+        if (pred(queue.Stats())) return true;
+        UninterruptibleSleep(std::chrono::milliseconds{5});
+    }
+    return false;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(http_work_queue_order)
+{
+    WorkQueue<TestWorkItem> queue(16, Limits(1, 1, 1, 1));
+    std::vector<std::string> order;
+    std::atomic<int> done{0};
+    const auto add = [&](HTTPWorkPriority priority, std::string name) {
+        BOOST_CHECK(queue.Enqueue(new TestWorkItem{[&order, &done, name] { order.push_back(name); ++done; }}, priority));
+    };
+    add(HTTPWorkPriority::LOW, "low1");
+    add(HTTPWorkPriority::NORMAL, "normal1");
+    add(HTTPWorkPriority::HIGH, "high1");
+    add(HTTPWorkPriority::LOW, "low2");
+    add(HTTPWorkPriority::NORMAL, "normal2");
+    add(HTTPWorkPriority::HIGH, "high2");
+
+    // A single worker takes the most urgent class first, oldest item first.
+    std::thread worker([&] { queue.Run(); });
+    BOOST_CHECK(WaitForStats(queue, [&](const std::vector<HTTPWorkQueueStats>&) { return done == 6; }));
+    queue.Interrupt();
+    worker.join();
+    BOOST_CHECK(order == std::vector<std::string>({"high1", "high2", "normal1", "normal2", "low1", "low2"}));
+
+    const auto stats = queue.Stats();
+    BOOST_REQUIRE_EQUAL(stats.size(), NUM_HTTP_WORK_PRIORITIES);
+    for (const HTTPWorkQueueStats& s : stats) {
+        BOOST_CHECK_EQUAL(s.queued, 0U);
+        BOOST_CHECK_EQUAL(s.running, 0U);
+        uint64_t started = 0;
+        for (uint64_t count : s.wait_histogram) started += count;
+        BOOST_CHECK_EQUAL(started, 2U);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(http_work_queue_limits)
+{
+    // Three threads. LOW may use one, NORMAL two, but the two together only
+    // two, so one thread is always left for HIGH.
+    WorkQueue<TestWorkItem> queue(2, Limits(3, 2, 1, 2));
+    Gate gate;
+    std::atomic<int> high_done{0};
+    const auto blocked = [&] { return new TestWorkItem{[&gate] { gate.Wait(); }}; };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 3; ++i) workers.emplace_back([&] { queue.Run(); });
+
+    BOOST_CHECK(queue.Enqueue(blocked(), HTTPWorkPriority::LOW));
+    BOOST_CHECK(queue.Enqueue(blocked(), HTTPWorkPriority::LOW));
+    BOOST_CHECK(WaitForStats(queue, [](const std::vector<HTTPWorkQueueStats>& s) {
+        return Stats(s, HTTPWorkPriority::LOW).running == 1 && Stats(s, HTTPWorkPriority::LOW).queued == 1;
+    }));
+
+    // The class limit holds back the second LOW item, not NORMAL work.
+    BOOST_CHECK(queue.Enqueue(blocked(), HTTPWorkPriority::NORMAL));
+    BOOST_CHECK(queue.Enqueue(blocked(), HTTPWorkPriority::NORMAL));
+    BOOST_CHECK(WaitForStats(queue, [](const std::vector<HTTPWorkQueueStats>& s) {
+        return Stats(s, HTTPWorkPriority::NORMAL).running == 1 && Stats(s, HTTPWorkPriority::NORMAL).queued == 1;
+    }));
+
+    // The combined limit keeps the third thread idle for HIGH work, which
+    // gets it even though NORMAL and LOW work is waiting.
+    BOOST_CHECK(queue.Enqueue(new TestWorkItem{[&high_done] { ++high_done; }}, HTTPWorkPriority::HIGH));
+    BOOST_CHECK(WaitForStats(queue, [&](const std::vector<HTTPWorkQueueStats>&) { return high_done == 1; }));
+    auto stats = queue.Stats();
+    BOOST_CHECK_EQUAL(Stats(stats, HTTPWorkPriority::LOW).running + Stats(stats, HTTPWorkPriority::NORMAL).running, 2U);
+
+    // Each class has its own queue of depth 2.
+    BOOST_CHECK(queue.Enqueue(blocked(), HTTPWorkPriority::NORMAL));
+    BOOST_CHECK(!queue.Enqueue(blocked(), HTTPWorkPriority::NORMAL));
+    BOOST_CHECK_EQUAL(Stats(queue.Stats(), HTTPWorkPriority::NORMAL).rejected, 1U);
+    BOOST_CHECK(queue.Enqueue(blocked(), HTTPWorkPriority::HIGH));
+
+    gate.Open();
+    BOOST_CHECK(WaitForStats(queue, [](const std::vector<HTTPWorkQueueStats>& s) {
+        for (const HTTPWorkQueueStats& c : s) {
+            if (c.running != 0 || c.queued != 0) return false;
+        }
+        return true;
+    }));
+    queue.Interrupt();
+    for (std::thread& worker : workers) worker.join();
+}
+
+BOOST_AUTO_TEST_CASE(http_work_threads_parsing)
+{
+    HTTPWorkThreadLimits limits;
+    std::string invalid;
+    BOOST_CHECK(ParseHTTPWorkThreads(4, {}, limits, invalid));
+    BOOST_CHECK(limits.per_class == (std::array<size_t, NUM_HTTP_WORK_PRIORITIES>{4, 3, 2}));
+    BOOST_CHECK_EQUAL(limits.below_high, 3U);
+
+    // A single thread cannot be reserved.
+    BOOST_CHECK(ParseHTTPWorkThreads(1, {}, limits, invalid));
+    BOOST_CHECK(limits.per_class == (std::array<size_t, NUM_HTTP_WORK_PRIORITIES>{1, 1, 1}));
+    BOOST_CHECK_EQUAL(limits.below_high, 1U);
+
+    // Limits are capped at the number of threads; the later one wins.
+    BOOST_CHECK(ParseHTTPWorkThreads(4, {"low:3", "normal:9", "low:1"}, limits, invalid));
+    BOOST_CHECK(limits.per_class == (std::array<size_t, NUM_HTTP_WORK_PRIORITIES>{4, 4, 1}));
+    BOOST_CHECK_EQUAL(limits.below_high, 3U);
+
+    for (const std::string spec : {"low", "low:0", "low:-1", "low:x", "urgent:2", ":2"}) {
+        BOOST_CHECK(!ParseHTTPWorkThreads(4, {"high:1", spec}, limits, invalid));
+        BOOST_CHECK_EQUAL(invalid, spec);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(rpc_method_priority_parsing)
+{
+    std::map<std::string, HTTPWorkPriority> priorities;
+    std::string invalid;
+    BOOST_CHECK(ParseRPCMethodPriorities({}, priorities, invalid));
+    BOOST_CHECK(priorities.at("getblockcount") == HTTPWorkPriority::HIGH);
+    BOOST_CHECK(priorities.at("scantxoutset") == HTTPWorkPriority::LOW);
+    BOOST_CHECK(!priorities.count("getblock"));
+
+    BOOST_CHECK(ParseRPCMethodPriorities({"low:getblock,getblockheader", "normal:getblockcount", "high: getblock"}, priorities, invalid));
+    BOOST_CHECK(priorities.at("getblock") == HTTPWorkPriority::HIGH);
+    BOOST_CHECK(priorities.at("getblockheader") == HTTPWorkPriority::LOW);
+    BOOST_CHECK(priorities.at("getblockcount") == HTTPWorkPriority::NORMAL);
+    BOOST_CHECK(!priorities.count(""));
+
+    BOOST_CHECK(!ParseRPCMethodPriorities({"getblock"}, priorities, invalid));
+    BOOST_CHECK_EQUAL(invalid, "getblock");
+    BOOST_CHECK(!ParseRPCMethodPriorities({"urgent:getblock"}, priorities, invalid));
+    BOOST_CHECK_EQUAL(invalid, "urgent:getblock");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,93 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <coins.h>
+#include <memusage.h>
+#include <support/allocators/pool.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(pool_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(pool_reuses_freed_blocks)
+{
+    PoolResource<64, 8> resource(1024);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 0U);
+
+    void* a = resource.Allocate(24, 8);
+    void* b = resource.Allocate(24, 8);
+    BOOST_CHECK(a != b);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+
+    // a freed block is handed out again for the same size class only
+    resource.Deallocate(a, 24, 8);
+    void* c = resource.Allocate(40, 8);
+    BOOST_CHECK(c != a);
+    void* d = resource.Allocate(17, 8);
+    BOOST_CHECK_EQUAL(d, a);
+
+    // too large or over-aligned requests bypass the pool
+    void* big = resource.Allocate(128, 8);
+    void* aligned = resource.Allocate(16, 64);
+    BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(aligned) % 64, 0U);
+    resource.Deallocate(big, 128, 8);
+    resource.Deallocate(aligned, 16, 64);
+
+    // filling the chunk takes a new one
+    for (int i = 0; i < 64; ++i) {
+        resource.Allocate(64, 8);
+    }
+    BOOST_CHECK(resource.NumAllocatedChunks() > 1);
+
+    resource.Deallocate(b, 24, 8);
+    resource.Deallocate(c, 40, 8);
+    resource.Deallocate(d, 24, 8);
+}
+
+BOOST_AUTO_TEST_CASE(pool_coins_map_usage)
+{
+    CCoinsMapMemoryResource resource;
+    {
+        CCoinsMap map{0, CCoinsMap::hasher{}, CCoinsMap::key_equal{}, &resource};
+        BOOST_CHECK_EQUAL(memusage::DynamicUsage(map), memusage::MallocUsage(sizeof(void*) * map.bucket_count()));
+        for (uint32_t i = 0; i < 20000; ++i) {
+            map[COutPoint(uint256::ONE, i)].coin.out.nValue = i;
+        }
+        BOOST_CHECK(resource.NumAllocatedChunks() > 0);
+        // usage covers the nodes: whole chunks plus the bucket array
+        BOOST_CHECK(memusage::DynamicUsage(map) >= resource.NumAllocatedChunks() * resource.ChunkSizeBytes());
+        BOOST_CHECK(memusage::DynamicUsage(map) >= map.size() * sizeof(CCoinsMap::value_type));
+
+        // erased nodes are reused rather than growing the pool
+        const size_t chunks = resource.NumAllocatedChunks();
+        for (int round = 0; round < 3; ++round) {
+            for (uint32_t i = 0; i < 10000; ++i) {
+                map.erase(COutPoint(uint256::ONE, i));
+            }
+            for (uint32_t i = 0; i < 10000; ++i) {
+                map[COutPoint(uint256::ONE, i)].coin.out.nValue = i;
+            }
+        }
+        BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), chunks);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(pool_coins_cache_flush_releases)
+{
+    CCoinsView base;
+    CCoinsViewCache cache(&base);
+    for (uint32_t i = 0; i < 20000; ++i) {
+        CTxOut out(i + 1, CScript() << OP_TRUE);
+        cache.AddCoin(COutPoint(uint256::ONE, i), Coin(out, 1, false, false), false);
+    }
+    const size_t usage = cache.DynamicMemoryUsage();
+    BOOST_CHECK(usage > 20000 * sizeof(CCoinsMap::value_type));
+    // CCoinsView::BatchWrite fails, but the cache is emptied and its pool released regardless
+    cache.Flush();
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+    BOOST_CHECK(cache.DynamicMemoryUsage() < usage / 10);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,61 +4,16 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <miner.h>
 #include <pow.h>
+#include <shutdown.h>
 #include <test/util/setup_common.h>
+#include <validation.h>
 
 #include <boost/test/unit_test.hpp>
 
 BOOST_FIXTURE_TEST_SUITE(pow_tests, BasicTestingSetup)
 
-/* Test calculation of next difficulty target with no constraints applying */
-BOOST_AUTO_TEST_CASE(get_next_work)
-{
-    const auto chainParams = CreateChainParams(*m_node.args, CBaseChainParams::MAIN);
-    int64_t nLastRetargetTime = 1261130161; // Block #30240
-    CBlockIndex pindexLast;
-    pindexLast.nHeight = 32255;
-    pindexLast.nTime = 1262152739;  // Block #32255
-    pindexLast.nBits = 0x1d00ffff;
-    BOOST_CHECK_EQUAL(CalculateNextWorkRequired(&pindexLast, nLastRetargetTime, chainParams->GetConsensus()), 0x1d00d86aU);
-}
-
-/* Test the constraint on the upper bound for next work */
-BOOST_AUTO_TEST_CASE(get_next_work_pow_limit)
-{
-    const auto chainParams = CreateChainParams(*m_node.args, CBaseChainParams::MAIN);
-    int64_t nLastRetargetTime = 1231006505; // Block #0
-    CBlockIndex pindexLast;
-    pindexLast.nHeight = 2015;
-    pindexLast.nTime = 1233061996;  // Block #2015
-    pindexLast.nBits = 0x1d00ffff;
-    BOOST_CHECK_EQUAL(CalculateNextWorkRequired(&pindexLast, nLastRetargetTime, chainParams->GetConsensus()), 0x1d00ffffU);
-}
-
-/* Test the constraint on the lower bound for actual time taken */
-BOOST_AUTO_TEST_CASE(get_next_work_lower_limit_actual)
-{
-    const auto chainParams = CreateChainParams(*m_node.args, CBaseChainParams::MAIN);
-    int64_t nLastRetargetTime = 1279008237; // Block #66528
-    CBlockIndex pindexLast;
-    pindexLast.nHeight = 68543;
-    pindexLast.nTime = 1279297671;  // Block #68543
-    pindexLast.nBits = 0x1c05a3f4;
-    BOOST_CHECK_EQUAL(CalculateNextWorkRequired(&pindexLast, nLastRetargetTime, chainParams->GetConsensus()), 0x1c0168fdU);
-}
-
-/* Test the constraint on the upper bound for actual time taken */
-BOOST_AUTO_TEST_CASE(get_next_work_upper_limit_actual)
-{
-    const auto chainParams = CreateChainParams(*m_node.args, CBaseChainParams::MAIN);
-    int64_t nLastRetargetTime = 1263163443; // NOTE: Not an actual block time
-    CBlockIndex pindexLast;
-    pindexLast.nHeight = 46367;
-    pindexLast.nTime = 1269211443;  // Block #46367
-    pindexLast.nBits = 0x1c387f6f;
-    BOOST_CHECK_EQUAL(CalculateNextWorkRequired(&pindexLast, nLastRetargetTime, chainParams->GetConsensus()), 0x1d00e1fdU);
-}
-
 BOOST_AUTO_TEST_CASE(CheckProofOfWork_test_negative_target)
 {
     const auto consensus = CreateChainParams(*m_node.args, CBaseChainParams::MAIN)->GetConsensus();
@@ -153,13 +108,6 @@ void sanity_check_chainparams(const ArgsManager& args, std::string chainName)
     BOOST_CHECK(!neg && pow_compact != 0);
     BOOST_CHECK(!over);
     BOOST_CHECK(UintToArith256(consensus.powLimit) >= pow_compact);
-
-    // check max target * 4*nPowTargetTimespan doesn't overflow -- see pow.cpp:CalculateNextWorkRequired()
-    if (!consensus.fPowNoRetargeting) {
-        arith_uint256 targ_max("0xFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF");
-        targ_max /= consensus.nPowTargetTimespan*4;
-        BOOST_CHECK(UintToArith256(consensus.powLimit) < targ_max);
-    }
 }
 
 BOOST_AUTO_TEST_CASE(ChainParams_MAIN_sanity)
@@ -182,4 +130,104 @@ BOOST_AUTO_TEST_CASE(ChainParams_SIGNET_sanity)
     sanity_check_chainparams(*m_node.args, CBaseChainParams::SIGNET);
 }
 
+BOOST_AUTO_TEST_CASE(search_proof_of_work_threads)
+{
+    const auto chainParams = CreateChainParams(*m_node.args, CBaseChainParams::REGTEST);
+    const Consensus::Params& params = chainParams->GetConsensus();
+
+    CBlockHeader header;
+    header.nVersion = 4;
+    header.hashPrevBlock = WITH_LOCK(g_best_block_mutex, return g_best_block);
+    header.hashMerkleRoot = uint256S("0x1234");
+    header.nTime = 1600000000;
+    header.nBits = 0x1f00ffff; // roughly one in 256 hashes is valid
+    header.nNonce = 7;
+
+    // The serial search defines the expected nonce and remaining budget
+    CBlockHeader serial(header);
+    uint64_t serial_tries = 100000;
+    BOOST_CHECK(SearchProofOfWork(serial, params, 1, serial_tries).found);
+    BOOST_CHECK(CheckProofOfWork(serial.GetValidationHash(), serial.nBits, params));
+    for (uint32_t nonce = header.nNonce; nonce < serial.nNonce; ++nonce) {
+        CBlockHeader check(header);
+        check.nNonce = nonce;
+        BOOST_CHECK(!CheckProofOfWork(check.GetValidationHash(), check.nBits, params));
+    }
+    BOOST_CHECK_EQUAL(serial_tries, 100000U - (serial.nNonce - header.nNonce));
+
+    for (int threads : {2, 3, 8}) {
+        CBlockHeader parallel(header);
+        uint64_t tries = 100000;
+        const PowSearchResult result = SearchProofOfWork(parallel, params, threads, tries);
+        BOOST_CHECK(result.found);
+        BOOST_CHECK(!result.stale);
+        BOOST_CHECK_GE(result.hashes, uint64_t{serial.nNonce - header.nNonce + 1});
+        BOOST_CHECK_EQUAL(parallel.nNonce, serial.nNonce);
+        BOOST_CHECK_EQUAL(tries, serial_tries);
+    }
+
+    // A budget that stops just short of the solution finds nothing
+    CBlockHeader limited(header);
+    uint64_t tries = serial.nNonce - header.nNonce;
+    BOOST_CHECK(!SearchProofOfWork(limited, params, 4, tries).found);
+    BOOST_CHECK_EQUAL(tries, 0U);
+    BOOST_CHECK_EQUAL(limited.nNonce, serial.nNonce);
+}
+
+BOOST_AUTO_TEST_CASE(search_proof_of_work_cancel)
+{
+    const auto chainParams = CreateChainParams(*m_node.args, CBaseChainParams::REGTEST);
+    const Consensus::Params& params = chainParams->GetConsensus();
+    const uint256 best_block = WITH_LOCK(g_best_block_mutex, return g_best_block);
+
+    CBlockHeader header;
+    header.nVersion = 4;
+    header.hashPrevBlock = uint256S("0xabcd");
+    header.hashMerkleRoot = uint256S("0x1234");
+    header.nTime = 1600000000;
+    header.nBits = 0x03000001; // a target of 1 is never met
+    header.nNonce = 7;
+
+    // The active tip moved away from the template's parent: the search is
+    // abandoned as stale before any nonce is tried, on every thread.
+    WITH_LOCK(g_best_block_mutex, g_best_block = uint256S("0xef01"));
+    for (int threads : {1, 4}) {
+        CBlockHeader stale(header);
+        uint64_t tries = 1000000;
+        const PowSearchResult result = SearchProofOfWork(stale, params, threads, tries);
+        BOOST_CHECK(!result.found);
+        BOOST_CHECK(result.stale);
+        BOOST_CHECK_EQUAL(result.hashes, 0U);
+        BOOST_CHECK_EQUAL(tries, 1000000U);
+        BOOST_CHECK_EQUAL(stale.nNonce, header.nNonce);
+    }
+
+    // A tip that matches the template does not stop the search.
+    WITH_LOCK(g_best_block_mutex, g_best_block = header.hashPrevBlock);
+    {
+        CBlockHeader current(header);
+        uint64_t tries = 2000;
+        const PowSearchResult result = SearchProofOfWork(current, params, 2, tries);
+        BOOST_CHECK(!result.found);
+        BOOST_CHECK(!result.stale);
+        BOOST_CHECK_EQUAL(result.hashes, 2000U);
+        BOOST_CHECK_EQUAL(tries, 0U);
+    }
+
+    // A shutdown request cancels the search without marking it stale.
+    StartShutdown();
+    {
+        CBlockHeader cancelled(header);
+        uint64_t tries = 1000000;
+        const PowSearchResult result = SearchProofOfWork(cancelled, params, 4, tries);
+        BOOST_CHECK(!result.found);
+        BOOST_CHECK(!result.stale);
+        BOOST_CHECK_EQUAL(result.hashes, 0U);
+        BOOST_CHECK_EQUAL(tries, 1000000U);
+    }
+    AbortShutdown();
+
+    WITH_LOCK(g_best_block_mutex, g_best_block = best_block);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <rpc/client.h>
+#include <rpc/jsonstream.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 
@@ -13,6 +14,8 @@
 #include <util/ref.h>
 #include <util/time.h>
 
+#include <thread>
+
 #include <boost/algorithm/string.hpp>
 #include <boost/test/unit_test.hpp>
 
@@ -421,4 +424,110 @@ BOOST_AUTO_TEST_CASE(rpc_getblockstats_calculate_percentiles_by_weight)
     }
 }
 
+BOOST_AUTO_TEST_CASE(rpc_json_stream_writer)
+{
+    UniValue inner(UniValue::VOBJ);
+    inner.pushKV("a\"b", 1);
+    inner.pushKV("list", UniValue(UniValue::VARR));
+    inner.pushKV("none", NullUniValue);
+
+    UniValue expected(UniValue::VOBJ);
+    expected.pushKV("result", inner);
+    UniValue items(UniValue::VARR);
+    for (int i = 0; i < 50; ++i) {
+        items.push_back(inner);
+    }
+    expected.pushKV("items", items);
+    expected.pushKV("empty", UniValue(UniValue::VOBJ));
+    expected.pushKV("id", "x");
+
+    // Flush after every few bytes, so the document arrives in many chunks.
+    std::string out;
+    size_t chunks = 0;
+    JSONStreamWriter stream([&](Span<const unsigned char> chunk) {
+        out.append(chunk.begin(), chunk.end());
+        ++chunks;
+    }, 16);
+    BOOST_CHECK(stream.ExpectsValue());
+    stream.BeginObject();
+    BOOST_CHECK(!stream.ExpectsValue());
+    stream.Key("result");
+    BOOST_CHECK(stream.ExpectsValue());
+    stream.Value(inner);
+    BOOST_CHECK(!stream.ExpectsValue());
+    stream.Key("items");
+    stream.BeginArray();
+    for (int i = 0; i < 50; ++i) {
+        stream.Value(inner);
+    }
+    stream.EndArray();
+    stream.Key("empty");
+    stream.BeginObject();
+    stream.EndObject();
+    stream.KeyValue("id", "x");
+    stream.EndObject();
+    BOOST_CHECK(stream.Flushed());
+    stream.Flush();
+
+    BOOST_CHECK(chunks > 1);
+    BOOST_CHECK_EQUAL(out, expected.write());
+
+    // Nothing reaches the sink before the buffer fills up.
+    bool sunk = false;
+    JSONStreamWriter small([&](Span<const unsigned char>) { sunk = true; });
+    small.Value(inner);
+    BOOST_CHECK(!sunk);
+    BOOST_CHECK(!small.Flushed());
+    BOOST_CHECK_EQUAL(small.Buffer(), inner.write());
+}
+
+BOOST_AUTO_TEST_CASE(rpc_batch_parallel)
+{
+    if (RPCIsInWarmup(nullptr)) SetRPCWarmupFinished();
+    BOOST_CHECK(tableRPC.isParallelSafe("decodescript"));
+    BOOST_CHECK(!tableRPC.isParallelSafe("createrawtransaction"));
+    BOOST_CHECK(!tableRPC.isParallelSafe("nosuchmethod"));
+
+    // Runs of read-only calls, split by calls that must stay in order.
+    UniValue batch(UniValue::VARR);
+    for (int i = 0; i < 40; ++i) {
+        UniValue req(UniValue::VOBJ);
+        req.pushKV("id", i);
+        if (i % 13 == 12) {
+            req.pushKV("method", i == 25 ? "nosuchmethod" : "createrawtransaction");
+            req.pushKV("params", ParseNonRFCJSONValue("[[], {}]"));
+        } else {
+            req.pushKV("method", "decodescript");
+            req.pushKV("params", ParseNonRFCJSONValue(strprintf("[\"%02x\"]", 0x51 + i % 16)));
+        }
+        batch.push_back(req);
+    }
+
+    util::Ref context{m_node};
+    JSONRPCRequest jreq(context);
+    const std::string serial = JSONRPCExecBatch(jreq, batch);
+
+    std::vector<std::thread> threads;
+    Mutex threads_mutex;
+    size_t accepted = 0;
+    const RPCTaskDispatcher dispatcher = [&](std::function<void()> task) {
+        LOCK(threads_mutex);
+        // Refuse some tasks, as a full work queue would.
+        if (++accepted % 4 == 0) return false;
+        threads.emplace_back(std::move(task));
+        return true;
+    };
+    const std::string parallel = JSONRPCExecBatch(jreq, batch, dispatcher, 3);
+    for (auto& thread : threads) thread.join();
+
+    BOOST_CHECK(!threads.empty());
+    BOOST_CHECK_EQUAL(parallel, serial);
+    UniValue replies;
+    BOOST_REQUIRE(replies.read(parallel));
+    BOOST_REQUIRE_EQUAL(replies.size(), batch.size());
+    for (size_t i = 0; i < replies.size(); ++i) {
+        BOOST_CHECK_EQUAL(find_value(replies[i], "id").get_int(), (int)i);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
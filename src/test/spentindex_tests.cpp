@@ -0,0 +1,92 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <core_io.h>
+#include <index/spentindex.h>
+#include <key.h>
+#include <script/interpreter.h>
+#include <test/util/index.h>
+#include <test/util/setup_common.h>
+#include <undo.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <univalue.h>
+
+BOOST_AUTO_TEST_SUITE(spentindex_tests)
+
+BOOST_FIXTURE_TEST_CASE(spentindex_prevouts, TestChain100Setup)
+{
+    SpentIndex spent_index(1 << 20, true);
+    spent_index.Start();
+
+    // Allow spent index to catch up with the block index.
+    BOOST_REQUIRE(IndexWaitSynced(spent_index));
+
+    // Coinbases spend nothing and are not indexed.
+    CTxUndo txundo;
+    BOOST_CHECK(!spent_index.FindSpentOutputs(m_coinbase_txns[0]->GetHash(), txundo));
+
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    const auto make_spend = [&](const COutPoint& prevout, const CTxOut& prev_out) {
+        CMutableTransaction spend;
+        spend.nVersion = 1;
+        spend.vin.resize(1);
+        spend.vin[0].prevout = prevout;
+        spend.vout.resize(1);
+        spend.vout[0].nValue = prev_out.nValue - 1 * CENT;
+        spend.vout[0].scriptPubKey = coinbase_script;
+        std::vector<unsigned char> vchSig;
+        const uint256 hash = SignatureHash(coinbase_script, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+        BOOST_REQUIRE(coinbaseKey.Sign(hash, vchSig));
+        vchSig.push_back((unsigned char)SIGHASH_ALL);
+        spend.vin[0].scriptSig << vchSig;
+        return spend;
+    };
+    const CTxOut& prev_out = m_coinbase_txns[0]->vout[0];
+    const CMutableTransaction spend = make_spend(COutPoint(m_coinbase_txns[0]->GetHash(), 0), prev_out);
+    // A second transaction in the same block, spending the first one's output.
+    const CMutableTransaction spend2 = make_spend(COutPoint(spend.GetHash(), 0), spend.vout[0]);
+
+    const CBlock block = CreateAndProcessBlock({spend, spend2}, coinbase_script);
+    BOOST_REQUIRE(block.vtx.size() == 3);
+    BOOST_CHECK(spent_index.BlockUntilSyncedToCurrentChain());
+
+    BOOST_REQUIRE(spent_index.FindSpentOutputs(spend.GetHash(), txundo));
+    BOOST_REQUIRE_EQUAL(txundo.vprevout.size(), 1U);
+    BOOST_CHECK(txundo.vprevout[0].out == prev_out);
+    BOOST_CHECK(txundo.vprevout[0].IsCoinBase());
+    BOOST_CHECK_EQUAL(txundo.vprevout[0].nHeight, 1U);
+
+    // The undo data of a later transaction is found past that of earlier ones.
+    CTxUndo txundo2;
+    BOOST_REQUIRE(spent_index.FindSpentOutputs(spend2.GetHash(), txundo2));
+    BOOST_REQUIRE_EQUAL(txundo2.vprevout.size(), 1U);
+    BOOST_CHECK(txundo2.vprevout[0].out == spend.vout[0]);
+    BOOST_CHECK(!txundo2.vprevout[0].IsCoinBase());
+    BOOST_CHECK_EQUAL(txundo2.vprevout[0].nHeight, (uint32_t)ChainActive().Height());
+
+    // The spent outputs let TxToUniv report the prevout and the fee.
+    UniValue entry(UniValue::VOBJ);
+    TxToUniv(CTransaction(spend), uint256(), entry, false, 0, &txundo);
+    BOOST_CHECK_EQUAL(entry["fee"].getValStr(), "0.01000000");
+    BOOST_CHECK_EQUAL(entry["vin"][0]["prevout"]["height"].get_int(), 1);
+
+    // Disconnecting the block drops its transactions from the index.
+    {
+        BlockValidationState state;
+        ChainstateActive().InvalidateBlock(state, Params(), ChainActive().Tip());
+    }
+    CreateAndProcessBlock({}, coinbase_script);
+    BOOST_CHECK(spent_index.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(!spent_index.FindSpentOutputs(spend.GetHash(), txundo));
+    BOOST_CHECK(!spent_index.FindSpentOutputs(spend2.GetHash(), txundo));
+
+    IndexStop(spent_index);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,9 +4,11 @@
 
 #include <chainparams.h>
 #include <index/txindex.h>
+#include <key.h>
+#include <script/interpreter.h>
 #include <script/standard.h>
+#include <test/util/index.h>
 #include <test/util/setup_common.h>
-#include <util/time.h>
 
 #include <boost/test/unit_test.hpp>
 
@@ -30,12 +32,7 @@ BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
     txindex.Start();
 
     // Allow tx index to catch up with the block index.
-    constexpr int64_t timeout_ms = 10 * 1000;
-    int64_t time_start = GetTimeMillis();
-    while (!txindex.BlockUntilSyncedToCurrentChain()) {
-        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
-        UninterruptibleSleep(std::chrono::milliseconds{100});
-    }
+    BOOST_REQUIRE(IndexWaitSynced(txindex));
 
     // Check that txindex excludes genesis block transactions.
     const CBlock& genesis_block = Params().GenesisBlock();
@@ -52,6 +49,28 @@ BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
         }
     }
 
+    // Check that a batch lookup returns the same transactions in request
+    // order, in any order of the requests, with duplicates and misses.
+    std::vector<uint256> batch;
+    for (auto it = m_coinbase_txns.rbegin(); it != m_coinbase_txns.rend(); ++it) {
+        batch.push_back((*it)->GetHash());
+    }
+    batch.push_back(m_coinbase_txns[0]->GetHash());
+    batch.push_back(genesis_block.vtx[0]->GetHash());
+    std::vector<uint256> block_hashes;
+    std::vector<CTransactionRef> txs;
+    BOOST_REQUIRE(txindex.FindTxs(batch, block_hashes, txs));
+    BOOST_REQUIRE_EQUAL(txs.size(), batch.size());
+    BOOST_REQUIRE_EQUAL(block_hashes.size(), batch.size());
+    for (size_t i = 0; i + 1 < batch.size(); ++i) {
+        BOOST_REQUIRE(txs[i]);
+        BOOST_CHECK(txs[i]->GetHash() == batch[i]);
+        BOOST_CHECK(txindex.FindTx(batch[i], block_hash, tx_disk));
+        BOOST_CHECK(block_hashes[i] == block_hash);
+    }
+    BOOST_CHECK(!txs.back());
+    BOOST_CHECK(block_hashes.back().IsNull());
+
     // Check that new transactions in new blocks make it into the index.
     for (int i = 0; i < 10; i++) {
         CScript coinbase_script_pub_key = GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()));
@@ -67,11 +86,43 @@ BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
         }
     }
 
-    // shutdown sequence (c.f. Shutdown() in init.cpp)
-    txindex.Stop();
+    // Check that a batch lookup finds transactions within one block whatever
+    // order they are requested in.
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    std::vector<CMutableTransaction> chain_txns;
+    COutPoint prevout(m_coinbase_txns[0]->GetHash(), 0);
+    CAmount value = m_coinbase_txns[0]->vout[0].nValue;
+    for (int i = 0; i < 3; i++) {
+        CMutableTransaction spend;
+        spend.nVersion = 1;
+        spend.vin.resize(1);
+        spend.vin[0].prevout = prevout;
+        spend.vout.resize(1);
+        value -= 1 * CENT;
+        spend.vout[0].nValue = value;
+        spend.vout[0].scriptPubKey = coinbase_script;
+        std::vector<unsigned char> vchSig;
+        const uint256 hash = SignatureHash(coinbase_script, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+        BOOST_REQUIRE(coinbaseKey.Sign(hash, vchSig));
+        vchSig.push_back((unsigned char)SIGHASH_ALL);
+        spend.vin[0].scriptSig << vchSig;
+        prevout = COutPoint(spend.GetHash(), 0);
+        chain_txns.push_back(spend);
+    }
+    const CBlock block = CreateAndProcessBlock(chain_txns, coinbase_script);
+    BOOST_REQUIRE_EQUAL(block.vtx.size(), 4U);
+    BOOST_CHECK(txindex.BlockUntilSyncedToCurrentChain());
+
+    batch = {block.vtx[2]->GetHash(), block.vtx[0]->GetHash(), block.vtx[3]->GetHash(), block.vtx[1]->GetHash(), block.vtx[2]->GetHash()};
+    BOOST_REQUIRE(txindex.FindTxs(batch, block_hashes, txs));
+    BOOST_REQUIRE_EQUAL(txs.size(), batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        BOOST_REQUIRE(txs[i]);
+        BOOST_CHECK(txs[i]->GetHash() == batch[i]);
+        BOOST_CHECK(block_hashes[i] == block.GetHash());
+    }
 
-    // Let scheduler events finish running to avoid accessing any memory related to txindex after it is destructed
-    SyncWithValidationInterfaceQueue();
+    IndexStop(txindex);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
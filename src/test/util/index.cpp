@@ -0,0 +1,28 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/util/index.h>
+
+#include <index/base.h>
+#include <util/time.h>
+#include <validationinterface.h>
+
+bool IndexWaitSynced(BaseIndex& index)
+{
+    constexpr int64_t timeout_ms = 10 * 1000;
+    const int64_t time_start = GetTimeMillis();
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        if (time_start + timeout_ms <= GetTimeMillis()) return false;
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+    return true;
+}
+
+void IndexStop(BaseIndex& index)
+{
+    index.Stop();
+    // Let scheduler events finish running to avoid accessing any memory
+    // related to the index after it is destructed
+    SyncWithValidationInterfaceQueue();
+}
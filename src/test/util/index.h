@@ -0,0 +1,16 @@
+// Copyright (c) 2020 The SINOVATE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_TEST_UTIL_INDEX_H
+#define BITCOIN_TEST_UTIL_INDEX_H
+
+class BaseIndex;
+
+/** Wait for a started index to catch up with the active chain. Returns false if it has not within 10 seconds. */
+bool IndexWaitSynced(BaseIndex& index);
+
+/** Stop an index the way Shutdown() does, and let the scheduler drain so the index can be destroyed. */
+void IndexStop(BaseIndex& index);
+
+#endif // BITCOIN_TEST_UTIL_INDEX_H
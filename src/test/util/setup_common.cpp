@@ -10,6 +10,7 @@
 #include <consensus/params.h>
 #include <consensus/validation.h>
 #include <crypto/sha256.h>
+#include <crypto/x11_aes.h>
 #include <init.h>
 #include <interfaces/chain.h>
 #include <miner.h>
@@ -101,6 +102,7 @@ BasicTestingSetup::BasicTestingSetup(const std::string& chainName, const std::ve
     AppInitParameterInteraction(*m_node.args);
     LogInstance().StartLogging();
     SHA256AutoDetect();
+    X11AESAutoDetect();
     ECC_Start();
     SetupEnvironment();
     SetupNetworking();
@@ -167,6 +169,12 @@ TestingSetup::TestingSetup(const std::string& chainName, const std::vector<const
     }
     g_parallel_script_checks = true;
 
+    // Start header-hashing threads as well.
+    for (int i = 0; i < script_check_threads; ++i) {
+        threadGroup.create_thread([i]() { return ThreadHeaderHash(i); });
+    }
+    g_parallel_header_hashing = true;
+
     m_node.banman = MakeUnique<BanMan>(GetDataDir() / "banlist.dat", nullptr, DEFAULT_MISBEHAVING_BANTIME);
     m_node.connman = MakeUnique<CConnman>(0x1337, 0x1337); // Deterministic randomness for tests.
     m_node.peerman = MakeUnique<PeerManager>(chainparams, *m_node.connman, m_node.banman.get(), *m_node.scheduler, *m_node.chainman, *m_node.mempool);
@@ -217,9 +225,30 @@ CBlock TestChain100Setup::CreateAndProcessBlock(const std::vector<CMutableTransa
     for (const CMutableTransaction& tx : txns) {
         block.vtx.push_back(MakeTransactionRef(tx));
     }
+    // The template was made without these transactions. Like BlockAssembler
+    // does for mempool transactions, take the dev fee on their fees as well
+    // and burn the fees in the output ahead of the witness commitment.
+    CAmount fees = 0;
+    {
+        LOCK(cs_main);
+        const int height = ::ChainActive().Height() + 1;
+        CCoinsViewCache view(&::ChainstateActive().CoinsTip());
+        for (size_t i = 1; i < block.vtx.size(); ++i) {
+            fees += std::max<CAmount>(view.GetValueIn(*block.vtx[i]) - block.vtx[i]->GetValueOut(), 0);
+            // Tests may add the same transaction twice to build an invalid block.
+            AddCoins(view, *block.vtx[i], height, /* check */ true);
+        }
+        if (fees > 0) {
+            CMutableTransaction coinbase(*block.vtx[0]);
+            const int commitpos = GetWitnessCommitmentIndex(block);
+            coinbase.vout[1].nValue = GetDevCoin(height, coinbase.vout[0].nValue + fees);
+            coinbase.vout[(commitpos == NO_WITNESS_COMMITMENT ? coinbase.vout.size() : commitpos) - 1].nValue = fees;
+            block.vtx[0] = MakeTransactionRef(std::move(coinbase));
+        }
+    }
     RegenerateCommitments(block);
 
-    while (!CheckProofOfWork(block.GetHash(), block.nBits, chainparams.GetConsensus())) ++block.nNonce;
+    while (!CheckProofOfWork(block.GetValidationHash(), block.nBits, chainparams.GetConsensus())) ++block.nNonce;
 
     std::shared_ptr<const CBlock> shared_pblock = std::make_shared<const CBlock>(block);
     Assert(m_node.chainman)->ProcessNewBlock(chainparams, shared_pblock, true, nullptr);
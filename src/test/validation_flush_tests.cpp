@@ -4,6 +4,7 @@
 //
 #include <sync.h>
 #include <test/util/setup_common.h>
+#include <txdb.h>
 #include <txmempool.h>
 #include <validation.h>
 
@@ -50,7 +51,7 @@ BOOST_AUTO_TEST_CASE(getcoinscachesizestate)
     constexpr unsigned int COIN_SIZE = is_64_bit ? 80 : 64;
 
     auto print_view_mem_usage = [](CCoinsViewCache& view) {
-        BOOST_TEST_MESSAGE("CCoinsViewCache memory usage: " << view.DynamicMemoryUsage());
+        BOOST_TEST_MESSAGE("CCoinsViewCache memory usage: " << view.DynamicMemoryUsage() << ", resident: " << view.ResidentMemoryUsage());
     };
 
     constexpr size_t MAX_COINS_CACHE_BYTES = 1024;
@@ -116,7 +117,7 @@ BOOST_AUTO_TEST_CASE(getcoinscachesizestate)
         chainstate.GetCoinsCacheSizeState(&tx_pool, MAX_COINS_CACHE_BYTES, /*max_mempool_size_bytes*/ 1 << 10),
         CoinsCacheSizeState::OK);
 
-    for (int i{0}; i < 3; ++i) {
+    for (int i{0}; i < 4; ++i) {
         add_coin(view);
         print_view_mem_usage(view);
         BOOST_CHECK_EQUAL(
@@ -131,7 +132,9 @@ BOOST_AUTO_TEST_CASE(getcoinscachesizestate)
 
     // Only perform these checks on 64 bit hosts; I haven't done the math for 32.
     if (is_64_bit) {
-        float usage_percentage = (float)view.DynamicMemoryUsage() / (MAX_COINS_CACHE_BYTES + (1 << 10));
+        // GetCoinsCacheSizeState() measures the live entries, not the pool
+        // chunks that hold them, which DynamicMemoryUsage() reports.
+        float usage_percentage = (float)view.ResidentMemoryUsage() / (MAX_COINS_CACHE_BYTES + (1 << 10));
         BOOST_TEST_MESSAGE("CoinsTip usage percentage: " << usage_percentage);
         BOOST_CHECK(usage_percentage >= 0.9);
         BOOST_CHECK(usage_percentage < 1);
@@ -148,8 +151,8 @@ BOOST_AUTO_TEST_CASE(getcoinscachesizestate)
             CoinsCacheSizeState::OK);
     }
 
-    // Flushing the view doesn't take us back to OK because cacheCoins has
-    // preallocated memory that doesn't get reclaimed even after flush.
+    // Flushing the view takes us back to OK because ReallocateCache() hands
+    // the pool's chunks and the map's buckets back to the system.
 
     BOOST_CHECK_EQUAL(
         chainstate.GetCoinsCacheSizeState(&tx_pool, MAX_COINS_CACHE_BYTES, 0),
@@ -158,10 +161,61 @@ BOOST_AUTO_TEST_CASE(getcoinscachesizestate)
     view.SetBestBlock(InsecureRand256());
     BOOST_CHECK(view.Flush());
     print_view_mem_usage(view);
+    BOOST_CHECK_EQUAL(view.DynamicMemoryUsage(), is_64_bit ? 32U : 16U);
+
+    // The flushed coins count until the background write has landed.
+    BOOST_CHECK(chainstate.CoinsFlushView().WaitForWrite());
+    BOOST_CHECK_EQUAL(chainstate.CoinsFlushView().DynamicMemoryUsage(), 0U);
 
     BOOST_CHECK_EQUAL(
         chainstate.GetCoinsCacheSizeState(&tx_pool, MAX_COINS_CACHE_BYTES, 0),
-        CoinsCacheSizeState::CRITICAL);
+        CoinsCacheSizeState::OK);
+}
+
+BOOST_AUTO_TEST_CASE(background_flush)
+{
+    CCoinsViewDB db(GetDataDir() / "chainstate_flush", 1 << 20, /*fMemory*/ true, /*fWipe*/ false);
+    CCoinsViewBackgroundFlush flush_view(&db, /*background*/ true);
+    CCoinsViewCache cache(&flush_view);
+
+    std::vector<COutPoint> outpoints;
+    for (int i = 0; i < 100; ++i) {
+        outpoints.emplace_back(InsecureRand256(), 0);
+        Coin coin;
+        coin.nHeight = 1;
+        coin.out.nValue = i + 1;
+        coin.out.scriptPubKey.assign((uint32_t)25, 1);
+        cache.AddCoin(outpoints.back(), std::move(coin), false);
+    }
+    const uint256 block1 = InsecureRand256();
+    cache.SetBestBlock(block1);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+
+    // Whether or not the write has landed, reads through the view see the flushed state.
+    BOOST_CHECK(flush_view.GetBestBlock() == block1);
+    for (int i = 0; i < 100; ++i) {
+        BOOST_CHECK_EQUAL(cache.AccessCoin(outpoints[i]).out.nValue, i + 1);
+    }
+    BOOST_CHECK(flush_view.WaitForWrite());
+    BOOST_CHECK_EQUAL(flush_view.DynamicMemoryUsage(), 0U);
+    BOOST_CHECK(db.GetBestBlock() == block1);
+    BOOST_CHECK(db.GetHeadBlocks().empty());
+    BOOST_CHECK(db.HaveCoin(outpoints[0]));
+
+    // Spends are written as erasures.
+    for (int i = 0; i < 50; ++i) {
+        BOOST_CHECK(cache.SpendCoin(outpoints[i]));
+    }
+    const uint256 block2 = InsecureRand256();
+    cache.SetBestBlock(block2);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(!cache.HaveCoin(outpoints[0]));
+    BOOST_CHECK(cache.HaveCoin(outpoints[50]));
+    BOOST_CHECK(flush_view.WaitForWrite());
+    BOOST_CHECK(db.GetBestBlock() == block2);
+    BOOST_CHECK(!db.HaveCoin(outpoints[0]));
+    BOOST_CHECK(db.HaveCoin(outpoints[99]));
 }
 
 BOOST_AUTO_TEST_SUITE_END()
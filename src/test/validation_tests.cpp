@@ -3,8 +3,14 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chainparams.h>
+#include <fs.h>
+#include <miner.h>
 #include <net.h>
+#include <node/blockcache.h>
+#include <pow.h>
 #include <signet.h>
+#include <txmempool.h>
+#include <util/system.h>
 #include <validation.h>
 
 #include <test/util/setup_common.h>
@@ -58,6 +64,76 @@ BOOST_AUTO_TEST_CASE(subsidy_limit_test)
     BOOST_CHECK_EQUAL(nSum, CAmount{2099999997690000});
 }
 
+BOOST_AUTO_TEST_CASE(header_hash_batch_tests)
+{
+    // TestingSetup starts the header-hashing threads, so this runs in parallel.
+    BOOST_CHECK(g_parallel_header_hashing);
+    for (size_t count : {0, 1, 2, 17, 200}) {
+        std::vector<CBlockHeader> headers(count);
+        for (CBlockHeader& header : headers) {
+            header.nVersion = InsecureRand32();
+            header.hashPrevBlock = InsecureRand256();
+            header.hashMerkleRoot = InsecureRand256();
+            header.nTime = InsecureRand32();
+            header.nBits = InsecureRand32();
+            header.nNonce = InsecureRand32();
+        }
+        const std::vector<uint256> hashes = ComputeHeaderHashes(headers);
+        BOOST_REQUIRE_EQUAL(hashes.size(), count);
+        for (size_t i = 0; i < count; ++i) {
+            BOOST_CHECK(hashes[i] == headers[i].GetHash());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(read_block_trusted_header)
+{
+    const CBlockIndex* genesis = WITH_LOCK(cs_main, return ::ChainActive().Genesis());
+    BOOST_REQUIRE(genesis);
+    BOOST_CHECK(genesis->IsValid(BLOCK_VALID_TRANSACTIONS));
+
+    // The trusted read and the full re-check agree on an accepted block
+    CBlock trusted, checked;
+    BOOST_CHECK(ReadBlockFromDisk(trusted, genesis, Params().GetConsensus()));
+    BOOST_CHECK(ReadBlockFromDisk(checked, genesis, Params().GetConsensus(), /* fCheckPoW */ true));
+    BOOST_CHECK_EQUAL(trusted.GetHash(), genesis->GetBlockHash());
+    BOOST_CHECK_EQUAL(checked.GetHash(), genesis->GetBlockHash());
+
+    // A header that differs from the index entry is still rejected once the
+    // block has to come from disk again
+    g_block_cache.Clear();
+    CBlockIndex mismatched = *genesis;
+    mismatched.nNonce ^= 1;
+    CBlock block;
+    BOOST_CHECK(!ReadBlockFromDisk(block, &mismatched, Params().GetConsensus()));
+}
+
+BOOST_AUTO_TEST_CASE(load_external_block_file_resync)
+{
+    const CChainParams& chainparams = Params();
+    CTxMemPool empty_pool;
+    CBlock block = BlockAssembler(empty_pool, chainparams).CreateNewBlock(CScript() << OP_TRUE)->block;
+    while (!CheckProofOfWork(block.GetValidationHash(), block.nBits, chainparams.GetConsensus())) ++block.nNonce;
+    const uint256 hash = block.GetHash();
+    BOOST_CHECK(!WITH_LOCK(cs_main, return LookupBlockIndex(hash)));
+
+    // A record that does not decode, followed by the block: the import has to
+    // drop the bad record and resume scanning inside it to find the block.
+    const fs::path path = GetDataDir() / "import.dat";
+    {
+        CAutoFile file(fsbridge::fopen(path, "wb"), SER_DISK, CLIENT_VERSION);
+        file << chainparams.MessageStart() << uint32_t{200};
+        file << std::vector<unsigned char>(199, 0xff);
+        file << chainparams.MessageStart() << (uint32_t)::GetSerializeSize(block, CLIENT_VERSION) << block;
+    }
+    LoadExternalBlockFile(chainparams, fsbridge::fopen(path, "rb"));
+
+    LOCK(cs_main);
+    const CBlockIndex* pindex = LookupBlockIndex(hash);
+    BOOST_REQUIRE(pindex);
+    BOOST_CHECK(pindex->nStatus & BLOCK_HAVE_DATA);
+}
+
 BOOST_AUTO_TEST_CASE(signet_parse_tests)
 {
     ArgsManager signet_argsman;
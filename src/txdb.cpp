@@ -14,6 +14,8 @@
 #include <uint256.h>
 #include <util/memory.h>
 #include <util/system.h>
+#include <util/threadnames.h>
+#include <util/time.h>
 #include <util/translation.h>
 #include <util/vector.h>
 
@@ -43,7 +45,7 @@ struct CoinEntry {
 }
 
 CCoinsViewDB::CCoinsViewDB(fs::path ldb_path, size_t nCacheSize, bool fMemory, bool fWipe) :
-    m_db(MakeUnique<CDBWrapper>(ldb_path, nCacheSize, fMemory, fWipe, true)),
+    m_db(MakeUnique<CDBWrapper>(ldb_path, nCacheSize, fMemory, fWipe, true, GetDBOptions("chainstate"))),
     m_ldb_path(ldb_path),
     m_is_memory(fMemory) { }
 
@@ -53,7 +55,7 @@ void CCoinsViewDB::ResizeCache(size_t new_cache_size)
     // filesystem lock.
     m_db.reset();
     m_db = MakeUnique<CDBWrapper>(
-        m_ldb_path, new_cache_size, m_is_memory, /*fWipe*/ false, /*obfuscate*/ true);
+        m_ldb_path, new_cache_size, m_is_memory, /*fWipe*/ false, /*obfuscate*/ true, GetDBOptions("chainstate"));
 }
 
 bool CCoinsViewDB::GetCoin(const COutPoint &outpoint, Coin &coin) const {
@@ -79,12 +81,70 @@ std::vector<uint256> CCoinsViewDB::GetHeadBlocks() const {
     return vhashHeadBlocks;
 }
 
-bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
-    CDBBatch batch(*m_db);
-    size_t count = 0;
-    size_t changed = 0;
-    size_t batch_size = (size_t)gArgs.GetArg("-dbbatchsize", nDefaultDbBatchSize);
-    int crash_simulate = gArgs.GetArg("-dbcrashratio", 0);
+namespace {
+
+/**
+ * Writes the transition of the coin database to a new best block in batches
+ * of at most -dbbatchsize bytes.
+ */
+class CoinsTransitionWriter
+{
+    CDBWrapper& m_db;
+    CDBBatch m_batch;
+    const size_t m_batch_size;
+    const int m_crash_simulate;
+
+public:
+    CoinsTransitionWriter(CDBWrapper& db, const uint256& old_tip, const uint256& hashBlock) :
+        m_db(db),
+        m_batch(db),
+        m_batch_size((size_t)gArgs.GetArg("-dbbatchsize", nDefaultDbBatchSize)),
+        m_crash_simulate(gArgs.GetArg("-dbcrashratio", 0))
+    {
+        // In the first batch, mark the database as being in the middle of a
+        // transition from old_tip to hashBlock.
+        // A vector is used for future extensibility, as we may want to support
+        // interrupting after partial writes from multiple independent reorgs.
+        m_batch.Erase(DB_BEST_BLOCK);
+        m_batch.Write(DB_HEAD_BLOCKS, Vector(hashBlock, old_tip));
+    }
+
+    void Write(const COutPoint& outpoint, const Coin& coin)
+    {
+        CoinEntry entry(&outpoint);
+        if (coin.IsSpent())
+            m_batch.Erase(entry);
+        else
+            m_batch.Write(entry, coin);
+        if (m_batch.SizeEstimate() > m_batch_size) {
+            LogPrint(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", m_batch.SizeEstimate() * (1.0 / 1048576.0));
+            m_db.WriteBatch(m_batch);
+            m_batch.Clear();
+            if (m_crash_simulate) {
+                static FastRandomContext rng;
+                if (rng.randrange(m_crash_simulate) == 0) {
+                    LogPrintf("Simulating a crash. Goodbye.\n");
+                    _Exit(0);
+                }
+            }
+        }
+    }
+
+    bool Commit(const uint256& hashBlock)
+    {
+        // In the last batch, mark the database as consistent with hashBlock again.
+        m_batch.Erase(DB_HEAD_BLOCKS);
+        m_batch.Write(DB_BEST_BLOCK, hashBlock);
+
+        LogPrint(BCLog::COINDB, "Writing final batch of %.2f MiB\n", m_batch.SizeEstimate() * (1.0 / 1048576.0));
+        return m_db.WriteBatch(m_batch);
+    }
+};
+
+}
+
+uint256 CCoinsViewDB::TransitionStartTip(const uint256& hashBlock) const
+{
     assert(!hashBlock.IsNull());
 
     uint256 old_tip = GetBestBlock();
@@ -96,56 +156,178 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
             old_tip = old_heads[1];
         }
     }
+    return old_tip;
+}
 
-    // In the first batch, mark the database as being in the middle of a
-    // transition from old_tip to hashBlock.
-    // A vector is used for future extensibility, as we may want to support
-    // interrupting after partial writes from multiple independent reorgs.
-    batch.Erase(DB_BEST_BLOCK);
-    batch.Write(DB_HEAD_BLOCKS, Vector(hashBlock, old_tip));
+bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
+    CoinsTransitionWriter writer(*m_db, TransitionStartTip(hashBlock), hashBlock);
+    size_t count = 0;
+    size_t changed = 0;
 
     for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
         if (it->second.flags & CCoinsCacheEntry::DIRTY) {
-            CoinEntry entry(&it->first);
-            if (it->second.coin.IsSpent())
-                batch.Erase(entry);
-            else
-                batch.Write(entry, it->second.coin);
+            writer.Write(it->first, it->second.coin);
             changed++;
         }
         count++;
         CCoinsMap::iterator itOld = it++;
         mapCoins.erase(itOld);
-        if (batch.SizeEstimate() > batch_size) {
-            LogPrint(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
-            m_db->WriteBatch(batch);
-            batch.Clear();
-            if (crash_simulate) {
-                static FastRandomContext rng;
-                if (rng.randrange(crash_simulate) == 0) {
-                    LogPrintf("Simulating a crash. Goodbye.\n");
-                    _Exit(0);
-                }
-            }
-        }
     }
 
-    // In the last batch, mark the database as consistent with hashBlock again.
-    batch.Erase(DB_HEAD_BLOCKS);
-    batch.Write(DB_BEST_BLOCK, hashBlock);
-
-    LogPrint(BCLog::COINDB, "Writing final batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
-    bool ret = m_db->WriteBatch(batch);
+    bool ret = writer.Commit(hashBlock);
     LogPrint(BCLog::COINDB, "Committed %u changed transaction outputs (out of %u) to coin database...\n", (unsigned int)changed, (unsigned int)count);
     return ret;
 }
 
+bool CCoinsViewDB::WriteCoins(const CCoinsWriteSet& coins, const uint256& hashBlock)
+{
+    CoinsTransitionWriter writer(*m_db, TransitionStartTip(hashBlock), hashBlock);
+    for (const auto& entry : coins) {
+        writer.Write(entry.first, entry.second);
+    }
+    bool ret = writer.Commit(hashBlock);
+    LogPrint(BCLog::COINDB, "Committed %u changed transaction outputs to coin database...\n", (unsigned int)coins.size());
+    return ret;
+}
+
 size_t CCoinsViewDB::EstimateSize() const
 {
     return m_db->EstimateSize(DB_COIN, (char)(DB_COIN+1));
 }
 
-CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe) {
+CCoinsViewBackgroundFlush::CCoinsViewBackgroundFlush(CCoinsViewDB* db, bool background) :
+    CCoinsViewBacked(db), m_db(*db), m_background(background) {}
+
+CCoinsViewBackgroundFlush::~CCoinsViewBackgroundFlush()
+{
+    {
+        LOCK(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+bool CCoinsViewBackgroundFlush::GetCoin(const COutPoint& outpoint, Coin& coin) const
+{
+    {
+        LOCK(m_mutex);
+        auto it = m_pending.find(outpoint);
+        if (it != m_pending.end()) {
+            coin = it->second;
+            return !coin.IsSpent();
+        }
+    }
+    // Not part of the write in flight, so the database is current for it.
+    return base->GetCoin(outpoint, coin);
+}
+
+bool CCoinsViewBackgroundFlush::HaveCoin(const COutPoint& outpoint) const
+{
+    {
+        LOCK(m_mutex);
+        auto it = m_pending.find(outpoint);
+        if (it != m_pending.end()) return !it->second.IsSpent();
+    }
+    return base->HaveCoin(outpoint);
+}
+
+uint256 CCoinsViewBackgroundFlush::GetBestBlock() const
+{
+    {
+        LOCK(m_mutex);
+        if (m_writing || m_failed) return m_pending_block;
+    }
+    return base->GetBestBlock();
+}
+
+bool CCoinsViewBackgroundFlush::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock)
+{
+    {
+        WAIT_LOCK(m_mutex, lock);
+        // Coins of the previous flush must land first; this is the only point
+        // at which a flush can still stall the caller.
+        m_cond.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return !m_writing; });
+        if (m_failed) return false;
+
+        if (m_background) {
+            assert(m_pending.empty());
+            size_t coins_usage = 0;
+            for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
+                if (it->second.flags & CCoinsCacheEntry::DIRTY) {
+                    coins_usage += it->second.coin.DynamicMemoryUsage();
+                    m_pending.emplace(it->first, std::move(it->second.coin));
+                }
+                CCoinsMap::iterator itOld = it++;
+                mapCoins.erase(itOld);
+            }
+            m_pending_usage = memusage::DynamicUsage(m_pending) + coins_usage;
+            m_pending_block = hashBlock;
+            m_writing = true;
+            if (!m_thread.joinable()) {
+                m_thread = std::thread([this] {
+                    util::ThreadRename("coinsflush");
+                    ThreadWrite();
+                });
+            }
+            m_cond.notify_all();
+            return true;
+        }
+    }
+    return m_db.BatchWrite(mapCoins, hashBlock);
+}
+
+bool CCoinsViewBackgroundFlush::WaitForWrite()
+{
+    WAIT_LOCK(m_mutex, lock);
+    m_cond.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return !m_writing; });
+    return !m_failed;
+}
+
+size_t CCoinsViewBackgroundFlush::DynamicMemoryUsage() const
+{
+    LOCK(m_mutex);
+    return m_pending_usage;
+}
+
+void CCoinsViewBackgroundFlush::ThreadWrite()
+{
+    WAIT_LOCK(m_mutex, lock);
+    while (true) {
+        m_cond.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_writing || m_stop; });
+        // A queued write is finished even when stopping.
+        if (!m_writing) return;
+
+        const uint256 hashBlock = m_pending_block;
+        const int64_t nStart = GetTimeMillis();
+        bool fOk = false;
+        {
+            // m_pending is only changed while no write is in flight, so it can
+            // be read here without the lock, concurrently with GetCoin.
+            REVERSE_LOCK(lock);
+            try {
+                fOk = m_db.WriteCoins(m_pending, hashBlock);
+            } catch (const std::runtime_error& e) {
+                LogPrintf("%s: %s\n", __func__, e.what());
+            }
+        }
+        if (fOk) {
+            LogPrint(BCLog::COINDB, "Background flush of %u coins finished in %dms\n", m_pending.size(), GetTimeMillis() - nStart);
+            m_pending.clear();
+            // clear() keeps the buckets; give them back as well
+            m_pending.rehash(0);
+            m_pending_usage = 0;
+        } else {
+            // Keep serving the unwritten coins; the next flush reports the failure.
+            LogPrintf("ERROR: %s: failed to write coins to the database\n", __func__);
+            m_failed = true;
+        }
+        m_writing = false;
+        m_cond.notify_all();
+    }
+}
+
+CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe, false, GetDBOptions("blocktree")) {
 }
 
 bool CBlockTreeDB::ReadBlockFileInfo(int nFile, CBlockFileInfo &info) {
@@ -10,9 +10,13 @@
 #include <dbwrapper.h>
 #include <chain.h>
 #include <primitives/block.h>
+#include <sync.h>
 
+#include <condition_variable>
 #include <memory>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -24,6 +28,8 @@ class uint256;
 static const int64_t nDefaultDbCache = 450;
 //! -dbbatchsize default (bytes)
 static const int64_t nDefaultDbBatchSize = 16 << 20;
+//! -backgroundflush default
+static const bool DEFAULT_BACKGROUND_FLUSH = true;
 //! max. -dbcache (MiB)
 static const int64_t nMaxDbCache = sizeof(void*) > 4 ? 16384 : 1024;
 //! min. -dbcache (MiB)
@@ -42,6 +48,9 @@ static const int64_t nMaxCoinsDBCache = 8;
 // Actually declared in validation.cpp; can't include because of circular dependency.
 extern RecursiveMutex cs_main;
 
+/** Dirty coins taken out of a cache to be written; spent coins are erased. */
+typedef std::unordered_map<COutPoint, Coin, SaltedOutpointHasher> CCoinsWriteSet;
+
 /** CCoinsView backed by the coin database (chainstate/) */
 class CCoinsViewDB final : public CCoinsView
 {
@@ -62,12 +71,74 @@ public:
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
     CCoinsViewCursor *Cursor() const override;
 
+    //! Write coins and move the best block to hashBlock, like BatchWrite but
+    //! leaving the coins in place.
+    bool WriteCoins(const CCoinsWriteSet& coins, const uint256& hashBlock);
+
     //! Attempt to update from an older database format. Returns whether an error occurred.
     bool Upgrade();
     size_t EstimateSize() const override;
 
     //! Dynamically alter the underlying leveldb cache size.
     void ResizeCache(size_t new_cache_size) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+private:
+    //! The best block to record as the start of a transition to hashBlock.
+    uint256 TransitionStartTip(const uint256& hashBlock) const;
+};
+
+/**
+ * Sits between the coins cache and CCoinsViewDB to take the database write
+ * of a flush out of the caller's path (and thereby out of cs_main).
+ *
+ * BatchWrite moves the dirty coins into a pending set and returns; a
+ * background thread then writes them in -dbbatchsize batches. Until that
+ * write has committed, reads are answered from the pending set first, so
+ * the view above never sees a stale coin. The database carries the
+ * head-blocks marker for the whole write, which keeps a crash in the middle
+ * of it recoverable by ReplayBlocks exactly like an interrupted synchronous
+ * flush.
+ *
+ * Only one write is in flight at a time: a flush arriving while the previous
+ * one is still being written waits for it.
+ */
+class CCoinsViewBackgroundFlush final : public CCoinsViewBacked
+{
+public:
+    //! @param[in] background  Write from a background thread; otherwise
+    //!                        BatchWrite passes straight through.
+    CCoinsViewBackgroundFlush(CCoinsViewDB* db, bool background);
+    ~CCoinsViewBackgroundFlush();
+
+    bool GetCoin(const COutPoint& outpoint, Coin& coin) const override;
+    bool HaveCoin(const COutPoint& outpoint) const override;
+    uint256 GetBestBlock() const override;
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) override;
+
+    //! Block until no write is in flight, so that the database is current.
+    //! Returns false if a background write failed.
+    bool WaitForWrite();
+
+    //! Memory held by coins that are waiting to be written.
+    size_t DynamicMemoryUsage() const;
+
+private:
+    void ThreadWrite();
+
+    CCoinsViewDB& m_db;
+    const bool m_background;
+
+    mutable Mutex m_mutex;
+    std::condition_variable m_cond;
+    //! Coins being written. Changed under m_mutex, and only while no write is
+    //! in flight, so that the writer thread can read it without the lock.
+    CCoinsWriteSet m_pending;
+    uint256 m_pending_block GUARDED_BY(m_mutex);
+    size_t m_pending_usage GUARDED_BY(m_mutex){0};
+    bool m_writing GUARDED_BY(m_mutex){false};
+    bool m_failed GUARDED_BY(m_mutex){false};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::thread m_thread;
 };
 
 /** Specialization of CCoinsViewCursor to iterate over a CCoinsViewDB */
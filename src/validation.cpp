@@ -23,6 +23,8 @@
 #include <index/txindex.h>
 #include <logging.h>
 #include <logging/timer.h>
+#include <node/blockcache.h>
+#include <node/blockprefetch.h>
 #include <node/ui_interface.h>
 #include <optional.h>
 #include <policy/fees.h>
@@ -58,6 +60,7 @@
 #include <sinovate/infinitynodelockinfo.h>
 #include <sinovate/infinitynodemeta.h>
 //<SIN
+#include <functional>
 #include <string>
 
 #include <boost/algorithm/string/replace.hpp>
@@ -122,6 +125,8 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 static constexpr std::chrono::hours DATABASE_WRITE_INTERVAL{1};
 /** Time to wait between flushing chainstate to disk. */
 static constexpr std::chrono::hours DATABASE_FLUSH_INTERVAL{24};
+/** Share of the coins cache budget kept when an oversized cache is trimmed. */
+static constexpr size_t COINS_CACHE_KEEP_PERCENT = 70;
 /** Maximum age of our tip for us to be considered current for fee estimation */
 static constexpr std::chrono::hours MAX_FEE_ESTIMATION_TIP_AGE{3};
 const std::vector<std::string> CHECKLEVEL_DOC {
@@ -183,6 +188,7 @@ Mutex g_best_block_mutex;
 std::condition_variable g_best_block_cv;
 uint256 g_best_block;
 bool g_parallel_script_checks{false};
+bool g_parallel_header_hashing{false};
 std::atomic_bool fImporting(false);
 std::atomic_bool fReindex(false);
 bool fHavePruned = false;
@@ -249,7 +255,6 @@ CBlockIndex* FindForkInGlobalIndex(const CChain& chain, const CBlockLocator& loc
 std::unique_ptr<CBlockTreeDB> pblocktree;
 
 bool CheckInputScripts(const CTransaction& tx, TxValidationState &state, const CCoinsViewCache &inputs, unsigned int flags, bool cacheSigStore, bool cacheFullScriptStore, PrecomputedTransactionData& txdata, std::vector<CScriptCheck> *pvChecks = nullptr);
-static FILE* OpenUndoFile(const FlatFilePos &pos, bool fReadOnly = false);
 static FlatFileSeq BlockFileSeq();
 static FlatFileSeq UndoFileSeq();
 
@@ -1224,7 +1229,7 @@ static bool WriteBlockToDisk(const CBlock& block, FlatFilePos& pos, const CMessa
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams)
+bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams, bool fCheckPoW)
 {
     block.SetNull();
 
@@ -1241,7 +1246,7 @@ bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::P
         return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
     }
 
-    if (block.IsProofOfWork()) {
+    if (fCheckPoW && block.IsProofOfWork()) {
         // Check the header
         if (!CheckProofOfWork(block.GetValidationHash(), block.nBits, consensusParams)) {
             return error("ReadBlockFromDisk: Errors in block header at %s", pos.ToString());
@@ -1256,19 +1261,79 @@ bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::P
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
+/** Whether a header read from disk carries exactly the fields stored in its index entry */
+static bool HeaderMatchesIndex(const CBlockHeader& header, const CBlockIndex* pindex)
+{
+    return header.nVersion == pindex->nVersion &&
+           header.hashPrevBlock == (pindex->pprev ? pindex->pprev->GetBlockHash() : uint256()) &&
+           header.hashMerkleRoot == pindex->hashMerkleRoot &&
+           header.nTime == pindex->nTime &&
+           header.nBits == pindex->nBits &&
+           header.nNonce == pindex->nNonce;
+}
+
+bool ReadIndexedBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const FlatFilePos& blockPos, bool fTrusted, const Consensus::Params& consensusParams)
+{
+    if (!ReadBlockFromDisk(block, blockPos, consensusParams, !fTrusted))
+        return false;
+    if (fTrusted) {
+        if (!HeaderMatchesIndex(block, pindex))
+            return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): header doesn't match index for %s at %s",
+                    pindex->ToString(), blockPos.ToString());
+        return true;
+    }
+    if (block.GetHash() != pindex->GetBlockHash())
+        return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): GetHash() doesn't match index for %s at %s",
+                pindex->ToString(), blockPos.ToString());
+    return true;
+}
+
+bool IsBlockReadTrusted(const CBlockIndex* pindex, bool fCheckPoW)
+{
+    AssertLockHeld(cs_main);
+    // Blocks that were fully checked (including proof of work) when they
+    // were accepted only need to match their stored header: equal header
+    // fields imply an equal block hash.
+    return !fCheckPoW && pindex->IsValid(BLOCK_VALID_TRANSACTIONS);
+}
+
+/** Read a block straight from disk, bypassing g_block_cache */
+static bool ReadBlockFromDiskUncached(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams, bool fCheckPoW)
 {
     FlatFilePos blockPos;
+    bool fTrusted;
     {
         LOCK(cs_main);
         blockPos = pindex->GetBlockPos();
+        fTrusted = IsBlockReadTrusted(pindex, fCheckPoW);
     }
+    return ReadIndexedBlockFromDisk(block, pindex, blockPos, fTrusted, consensusParams);
+}
 
-    if (!ReadBlockFromDisk(block, blockPos, consensusParams))
+bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams, bool fCheckPoW)
+{
+    if (fCheckPoW) {
+        // explicit verification always goes to disk
+        return ReadBlockFromDiskUncached(block, pindex, consensusParams, true);
+    }
+    std::shared_ptr<const CBlock> pblock;
+    if (!ReadBlockFromDisk(pblock, pindex, consensusParams))
         return false;
-    if (block.GetHash() != pindex->GetBlockHash())
-        return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): GetHash() doesn't match index for %s at %s",
-                pindex->ToString(), pindex->GetBlockPos().ToString());
+    block = *pblock;
+    return true;
+}
+
+bool ReadBlockFromDisk(std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
+{
+    const uint256 hash = pindex->GetBlockHash();
+    pblock = g_block_cache.Get(hash);
+    if (pblock) return true;
+
+    std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
+    if (!ReadBlockFromDiskUncached(*pblockRead, pindex, consensusParams, false))
+        return false;
+    pblock = pblockRead;
+    g_block_cache.Insert(hash, pblock);
     return true;
 }
 
@@ -1419,7 +1484,8 @@ CoinsViews::CoinsViews(
     bool in_memory,
     bool should_wipe) : m_dbview(
                             GetDataDir() / ldb_name, cache_size_bytes, in_memory, should_wipe),
-                        m_catcherview(&m_dbview) {}
+                        m_flushview(&m_dbview, gArgs.GetBoolArg("-backgroundflush", DEFAULT_BACKGROUND_FLUSH)),
+                        m_catcherview(&m_flushview) {}
 
 void CoinsViews::InitCache()
 {
@@ -1932,13 +1998,76 @@ static bool WriteUndoDataForBlock(const CBlockUndo& blockundo, BlockValidationSt
     return true;
 }
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+// Script checks of a block are spread over per-thread lanes, so high -par
+// values do not contend on a single queue lock.
+static CWorkStealingCheckQueue<CScriptCheck> scriptcheckqueue(128);
 
 void ThreadScriptCheck(int worker_num) {
     util::ThreadRename(strprintf("scriptch.%i", worker_num));
     scriptcheckqueue.Thread();
 }
 
+/**
+ * Closure run on a header-hashing thread. X22I is expensive enough that
+ * hashing a full headers message under cs_main stalls every other peer, so
+ * batches are hashed up front; -reindex decodes and hashes blocks the same way.
+ */
+class CHashCheck
+{
+private:
+    std::function<void()> m_func;
+
+public:
+    CHashCheck() {}
+    explicit CHashCheck(std::function<void()> func) : m_func(std::move(func)) {}
+
+    bool operator()()
+    {
+        m_func();
+        return true;
+    }
+
+    void swap(CHashCheck& check)
+    {
+        std::swap(m_func, check.m_func);
+    }
+};
+
+static CCheckQueue<CHashCheck> headerhashqueue(16);
+
+void ThreadHeaderHash(int worker_num) {
+    util::ThreadRename(strprintf("hdrhash.%i", worker_num));
+    headerhashqueue.Thread();
+}
+
+/** Run the closures on the header-hashing threads (inline when there are none) and wait for them */
+static void RunHashChecks(std::vector<CHashCheck>& vChecks)
+{
+    if (!g_parallel_header_hashing || vChecks.size() < 2) {
+        for (CHashCheck& check : vChecks) {
+            check();
+        }
+        return;
+    }
+
+    CCheckQueueControl<CHashCheck> control(&headerhashqueue);
+    control.Add(vChecks);
+    control.Wait();
+}
+
+std::vector<uint256> ComputeHeaderHashes(const std::vector<CBlockHeader>& headers)
+{
+    AssertLockNotHeld(cs_main);
+    std::vector<uint256> hashes(headers.size());
+    std::vector<CHashCheck> vChecks;
+    vChecks.reserve(headers.size());
+    for (size_t i = 0; i < headers.size(); ++i) {
+        vChecks.emplace_back([&headers, &hashes, i] { hashes[i] = headers[i].GetHash(); });
+    }
+    RunHashChecks(vChecks);
+    return hashes;
+}
+
 VersionBitsCache versionbitscache GUARDED_BY(cs_main);
 
 int32_t ComputeBlockVersion(const CBlockIndex* pindexPrev, const Consensus::Params& params)
@@ -2258,7 +2387,7 @@ bool CChainState::ConnectBlock(const CBlock& block, BlockValidationState& state,
     // in multiple threads). Preallocate the vector size so a new allocation
     // doesn't invalidate pointers into the vector, and keep txsdata in scope
     // for as long as `control`.
-    CCheckQueueControl<CScriptCheck> control(fScriptChecks && g_parallel_script_checks ? &scriptcheckqueue : nullptr);
+    CCheckQueueControl<CScriptCheck, CWorkStealingCheckQueue<CScriptCheck>> control(fScriptChecks && g_parallel_script_checks ? &scriptcheckqueue : nullptr);
     std::vector<PrecomputedTransactionData> txsdata(block.vtx.size());
 
     std::vector<int> prevheights;
@@ -2455,7 +2584,8 @@ CoinsCacheSizeState CChainState::GetCoinsCacheSizeState(
     size_t max_mempool_size_bytes)
 {
     const int64_t nMempoolUsage = tx_pool ? tx_pool->DynamicMemoryUsage() : 0;
-    int64_t cacheSize = CoinsTip().DynamicMemoryUsage();
+    // Coins handed to a background write still occupy memory until it lands.
+    int64_t cacheSize = CoinsTip().ResidentMemoryUsage() + CoinsFlushView().DynamicMemoryUsage();
     int64_t nTotalSpace =
         max_coins_cache_size_bytes + std::max<int64_t>(max_mempool_size_bytes - nMempoolUsage, 0);
 
@@ -2587,7 +2717,29 @@ bool CChainState::FlushStateToDisk(
                 return AbortNode(state, "Disk space is too low!", _("Disk space is too low!"));
             }
             // Flush the chainstate (which may refer to block index entries).
-            if (!CoinsTip().Flush())
+            // Only an explicit full flush empties the cache; otherwise the
+            // dirty coins are written back and the rest stays warm, minus the
+            // coldest coins if the cache has grown too large.
+            if (mode == FlushStateMode::ALWAYS) {
+                if (!CoinsTip().Flush())
+                    return AbortNode(state, "Failed to write to coin database");
+            } else {
+                if (!CoinsTip().Sync())
+                    return AbortNode(state, "Failed to write to coin database");
+                if (fCacheLarge || fCacheCritical) {
+                    // The coins just synced are held twice until the background
+                    // write lands, clean in the cache and in the write set, so
+                    // the write set comes out of the cache's share.
+                    const size_t keep = m_coinstip_cache_size_bytes * COINS_CACHE_KEEP_PERCENT / 100;
+                    const size_t pending = CoinsFlushView().DynamicMemoryUsage();
+                    const size_t evicted = CoinsTip().Evict(keep > pending ? keep - pending : 0);
+                    LogPrint(BCLog::COINDB, "Evicted %u cold coins, %u left in cache\n", evicted, CoinsTip().GetCacheSize());
+                }
+            }
+            // The coins may still be on their way to disk. Callers asking for
+            // a full flush read the database next, and pruning must not
+            // delete blocks the database could still need to be replayed.
+            if ((mode == FlushStateMode::ALWAYS || fFlushForPrune) && !CoinsFlushView().WaitForWrite())
                 return AbortNode(state, "Failed to write to coin database");
             nLastFlush = nNow;
             full_flush_completed = true;
@@ -2749,6 +2901,72 @@ static int64_t nTimeConnectTotal = 0;
 static int64_t nTimeFlush = 0;
 static int64_t nTimeChainState = 0;
 static int64_t nTimePostConnect = 0;
+static int64_t nTimePrefetch = 0;
+static uint64_t nPrefetchInputs = 0;
+static uint64_t nPrefetchCached = 0;
+
+//! Outpoints looked up by one prefetch closure
+static const size_t PREFETCH_INPUTS_PER_CHECK = 16;
+
+/**
+ * Load the coins spent by a block that are missing from the coins cache,
+ * reading the database on the header-hashing threads, and add them to the
+ * cache. ConnectBlock then finds all of its inputs in memory instead of
+ * waiting on one leveldb read at a time.
+ */
+static void PrefetchBlockInputs(const CBlock& block, CCoinsViewCache& cache, CCoinsView& db)
+{
+    AssertLockHeld(cs_main);
+    if (!g_parallel_header_hashing) return;
+    int64_t nTimeStart = GetTimeMicros();
+
+    std::set<uint256> block_txids;
+    for (const auto& tx : block.vtx) {
+        block_txids.insert(tx->GetHash());
+    }
+    size_t inputs = 0;
+    std::vector<COutPoint> missing;
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase()) continue;
+        for (const CTxIn& txin : tx->vin) {
+            // outputs created in this block are not in the database
+            if (block_txids.count(txin.prevout.hash)) continue;
+            ++inputs;
+            if (!cache.HaveCoinInCache(txin.prevout)) missing.push_back(txin.prevout);
+        }
+    }
+
+    std::vector<Coin> coins(missing.size());
+    std::vector<CHashCheck> vChecks;
+    for (size_t first = 0; first < missing.size(); first += PREFETCH_INPUTS_PER_CHECK) {
+        const size_t last = std::min(missing.size(), first + PREFETCH_INPUTS_PER_CHECK);
+        vChecks.emplace_back([&db, &missing, &coins, first, last] {
+            for (size_t i = first; i < last; ++i) {
+                try {
+                    if (!db.GetCoin(missing[i], coins[i])) coins[i].Clear();
+                } catch (const std::exception&) {
+                    // leave read errors to ConnectBlock's own lookup
+                    coins[i].Clear();
+                }
+            }
+        });
+    }
+    RunHashChecks(vChecks);
+
+    size_t loaded = 0;
+    for (size_t i = 0; i < missing.size(); ++i) {
+        if (coins[i].IsSpent()) continue;
+        cache.WarmCoin(missing[i], std::move(coins[i]));
+        ++loaded;
+    }
+
+    nPrefetchInputs += inputs;
+    nPrefetchCached += inputs - missing.size();
+    int64_t nTimeEnd = GetTimeMicros(); nTimePrefetch += nTimeEnd - nTimeStart;
+    LogPrint(BCLog::BENCH, "  - Prefetch inputs: %u/%u cached, %u loaded: %.2fms [%.2fs, %.1f%% hit rate]\n",
+        inputs - missing.size(), inputs, loaded, (nTimeEnd - nTimeStart) * MILLI, nTimePrefetch * MICRO,
+        nPrefetchInputs ? 100.0 * nPrefetchCached / nPrefetchInputs : 100.0);
+}
 
 struct PerBlockConnectTrace {
     CBlockIndex* pindex = nullptr;
@@ -2806,10 +3024,8 @@ bool CChainState::ConnectTip(BlockValidationState& state, const CChainParams& ch
     int64_t nTime1 = GetTimeMicros();
     std::shared_ptr<const CBlock> pthisBlock;
     if (!pblock) {
-        std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
-        if (!ReadBlockFromDisk(*pblockNew, pindexNew, chainparams.GetConsensus()))
+        if (!ReadBlockFromDisk(pthisBlock, pindexNew, chainparams.GetConsensus()))
             return AbortNode(state, "Failed to read block");
-        pthisBlock = pblockNew;
     } else {
         pthisBlock = pblock;
     }
@@ -2818,6 +3034,8 @@ bool CChainState::ConnectTip(BlockValidationState& state, const CChainParams& ch
     int64_t nTime2 = GetTimeMicros(); nTimeReadFromDisk += nTime2 - nTime1;
     int64_t nTime3;
     LogPrint(BCLog::BENCH, "  - Load block from disk: %.2fms [%.2fs]\n", (nTime2 - nTime1) * MILLI, nTimeReadFromDisk * MICRO);
+    PrefetchBlockInputs(blockConnecting, CoinsTip(), CoinsErrorCatcher());
+    nTime2 = GetTimeMicros();
     {
         CCoinsViewCache view(&CoinsTip());
 //>SIN
@@ -2847,6 +3065,8 @@ bool CChainState::ConnectTip(BlockValidationState& state, const CChainParams& ch
         bool flushed = view.Flush();
         assert(flushed);
     }
+    // Blocks near the tip are read again by peers, RPC and the infinity-node scans
+    g_block_cache.Insert(pindexNew->GetBlockHash(), pthisBlock);
     int64_t nTime4 = GetTimeMicros(); nTimeFlush += nTime4 - nTime3;
     LogPrint(BCLog::BENCH, "  - Flush: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime4 - nTime3) * MILLI, nTimeFlush * MICRO, nTimeFlush * MILLI / nBlocksTotal);
     // Write the chain state to disk, if necessary.
@@ -2946,7 +3166,7 @@ void CChainState::PruneBlockIndexCandidates() {
  *
  * @returns true unless a system error occurred
  */
-bool CChainState::ActivateBestChainStep(BlockValidationState& state, const CChainParams& chainparams, CBlockIndex* pindexMostWork, const std::shared_ptr<const CBlock>& pblock, bool& fInvalidFound, ConnectTrace& connectTrace)
+bool CChainState::ActivateBestChainStep(BlockValidationState& state, const CChainParams& chainparams, CBlockIndex* pindexMostWork, const std::shared_ptr<const CBlock>& pblock, bool& fInvalidFound, ConnectTrace& connectTrace, BlockPrefetcher* prefetcher)
 {
     AssertLockHeld(cs_main);
     AssertLockHeld(m_mempool.cs);
@@ -2971,6 +3191,10 @@ bool CChainState::ActivateBestChainStep(BlockValidationState& state, const CChai
         }
         fBlocksDisconnected = true;
     }
+    if (fBlocksDisconnected && prefetcher) {
+        // Blocks read ahead may be on the branch that was just left.
+        prefetcher->Clear();
+    }
 
     // Build list of new blocks to connect (in descending height order).
     std::vector<CBlockIndex*> vpindexToConnect;
@@ -2989,9 +3213,22 @@ bool CChainState::ActivateBestChainStep(BlockValidationState& state, const CChai
         }
         nHeight = nTargetHeight;
 
+        if (prefetcher) {
+            // Read the next blocks while the first ones are being connected.
+            for (CBlockIndex* pindexAhead : reverse_iterate(vpindexToConnect)) {
+                if ((pindexAhead == pindexMostWork && pblock) || !prefetcher->Prefetch(pindexAhead)) break;
+            }
+        }
+
         // Connect new blocks.
         for (CBlockIndex* pindexConnect : reverse_iterate(vpindexToConnect)) {
-            if (!ConnectTip(state, chainparams, pindexConnect, pindexConnect == pindexMostWork ? pblock : std::shared_ptr<const CBlock>(), connectTrace, disconnectpool)) {
+            std::shared_ptr<const CBlock> pblockConnect = pindexConnect == pindexMostWork ? pblock : std::shared_ptr<const CBlock>();
+            if (!pblockConnect && prefetcher) {
+                // On a failed read ConnectTip reads the block again and reports the error.
+                pblockConnect = prefetcher->Get(pindexConnect);
+            }
+            if (!ConnectTip(state, chainparams, pindexConnect, pblockConnect, connectTrace, disconnectpool)) {
+                if (prefetcher) prefetcher->Clear();
                 if (state.IsInvalid()) {
                     // The block violates a consensus rule.
                     if (state.GetResult() != BlockValidationResult::BLOCK_MUTATED) {
@@ -3084,6 +3321,9 @@ bool CChainState::ActivateBestChain(BlockValidationState &state, const CChainPar
     CBlockIndex *pindexMostWork = nullptr;
     CBlockIndex *pindexNewTip = nullptr;
     int nStopAtHeight = gArgs.GetArg("-stopatheight", DEFAULT_STOPATHEIGHT);
+    // Reads blocks ahead when there is more than one to connect, such as
+    // during -reindex-chainstate or when catching up after a restart.
+    std::unique_ptr<BlockPrefetcher> prefetcher;
     do {
         // Block until the validation queue drains. This should largely
         // never happen in normal operation, however may happen during
@@ -3112,9 +3352,13 @@ bool CChainState::ActivateBestChain(BlockValidationState &state, const CChainPar
                     break;
                 }
 
+                if (!prefetcher && pindexMostWork->nHeight > m_chain.Height() + 1) {
+                    prefetcher = MakeUnique<BlockPrefetcher>(chainparams.GetConsensus());
+                }
+
                 bool fInvalidFound = false;
                 std::shared_ptr<const CBlock> nullBlockPtr;
-                if (!ActivateBestChainStep(state, chainparams, pindexMostWork, pblock && pblock->GetHash() == pindexMostWork->GetBlockHash() ? pblock : nullBlockPtr, fInvalidFound, connectTrace)) {
+                if (!ActivateBestChainStep(state, chainparams, pindexMostWork, pblock && pblock->GetHash() == pindexMostWork->GetBlockHash() ? pblock : nullBlockPtr, fInvalidFound, connectTrace, prefetcher.get())) {
                     // A system error occurred
                     return false;
                 }
@@ -3380,12 +3624,12 @@ void ResetBlockFailureFlags(CBlockIndex *pindex) {
     return ::ChainstateActive().ResetBlockFailureFlags(pindex);
 }
 
-CBlockIndex* BlockManager::AddToBlockIndex(const CBlockHeader& block)
+CBlockIndex* BlockManager::AddToBlockIndex(const CBlockHeader& block, const uint256* phash)
 {
     AssertLockHeld(cs_main);
 
     // Check for duplicate
-    uint256 hash = block.GetHash();
+    uint256 hash = phash ? *phash : block.GetHash();
     BlockMap::iterator it = m_block_index.find(hash);
     if (it != m_block_index.end())
         return it->second;
@@ -3873,11 +4117,11 @@ static bool ContextualCheckBlock(const CBlock& block, BlockValidationState& stat
     return true;
 }
 
-bool BlockManager::AcceptBlockHeader(const CBlockHeader& block, BlockValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+bool BlockManager::AcceptBlockHeader(const CBlockHeader& block, BlockValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, const uint256* phash)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
-    uint256 hash = block.GetHash();
+    uint256 hash = phash ? *phash : block.GetHash();
     BlockMap::iterator miSelf = m_block_index.find(hash);
     CBlockIndex *pindex = nullptr;
     if (hash != chainparams.GetConsensus().hashGenesisBlock) {
@@ -3955,7 +4199,7 @@ bool BlockManager::AcceptBlockHeader(const CBlockHeader& block, BlockValidationS
         }
     }
     if (pindex == nullptr)
-        pindex = AddToBlockIndex(block);
+        pindex = AddToBlockIndex(block, &hash);
 
     if (ppindex)
         *ppindex = pindex;
@@ -3964,15 +4208,23 @@ bool BlockManager::AcceptBlockHeader(const CBlockHeader& block, BlockValidationS
 }
 
 // Exposed wrapper for AcceptBlockHeader
-bool ChainstateManager::ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, BlockValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex)
+bool ChainstateManager::ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, BlockValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, const std::vector<uint256>* hashes)
 {
     AssertLockNotHeld(cs_main);
+    // Hash the whole batch before taking cs_main; only the contextual
+    // checks need the lock.
+    std::vector<uint256> computed_hashes;
+    if (hashes == nullptr) {
+        computed_hashes = ComputeHeaderHashes(headers);
+        hashes = &computed_hashes;
+    }
+    assert(hashes->size() == headers.size());
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        for (size_t i = 0; i < headers.size(); ++i) {
             CBlockIndex *pindex = nullptr; // Use a temp pindex instead of ppindex to avoid a const_cast
             bool accepted = m_blockman.AcceptBlockHeader(
-                header, state, chainparams, &pindex);
+                headers[i], state, chainparams, &pindex, &(*hashes)[i]);
             ::ChainstateActive().CheckBlockIndex(chainparams.GetConsensus());
 
             if (!accepted) {
@@ -4011,7 +4263,7 @@ static FlatFilePos SaveBlockToDisk(const CBlock& block, int nHeight, const CChai
 }
 
 /** Store block on disk. If dbp is non-nullptr, the file is known to already reside on disk */
-bool CChainState::AcceptBlock(const std::shared_ptr<const CBlock>& pblock, BlockValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const FlatFilePos* dbp, bool* fNewBlock)
+bool CChainState::AcceptBlock(const std::shared_ptr<const CBlock>& pblock, BlockValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const FlatFilePos* dbp, bool* fNewBlock, const uint256* phash)
 {
     const CBlock& block = *pblock;
 
@@ -4021,7 +4273,7 @@ bool CChainState::AcceptBlock(const std::shared_ptr<const CBlock>& pblock, Block
     CBlockIndex *pindexDummy = nullptr;
     CBlockIndex *&pindex = ppindex ? *ppindex : pindexDummy;
 
-    bool accepted_header = m_blockman.AcceptBlockHeader(block, state, chainparams, &pindex);
+    bool accepted_header = m_blockman.AcceptBlockHeader(block, state, chainparams, &pindex, phash);
     CheckBlockIndex(chainparams.GetConsensus());
 
     if (!accepted_header)
@@ -4329,7 +4581,7 @@ FILE* OpenBlockFile(const FlatFilePos &pos, bool fReadOnly) {
 }
 
 /** Open an undo file (rev?????.dat) */
-static FILE* OpenUndoFile(const FlatFilePos &pos, bool fReadOnly) {
+FILE* OpenUndoFile(const FlatFilePos &pos, bool fReadOnly) {
     return UndoFileSeq().Open(pos, fReadOnly);
 }
 
@@ -4542,6 +4794,9 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
     int nGoodTransactions = 0;
     BlockValidationState state;
     int reportDone = 0;
+    // Blocks below the one being checked are read and re-hashed in the background.
+    BlockPrefetcher prefetcher(chainparams.GetConsensus(), DEFAULT_PREFETCH_BLOCKS, DEFAULT_PREFETCH_THREADS, /* check_pow */ true);
+    const CBlockIndex* pindex_ahead = ::ChainActive().Tip();
     LogPrintf("[0%%]..."); /* Continued */
     for (pindex = ::ChainActive().Tip(); pindex && pindex->pprev; pindex = pindex->pprev) {
         const int percentageDone = std::max(1, std::min(99, (int)(((double)(::ChainActive().Height() - pindex->nHeight)) / (double)nCheckDepth * (nCheckLevel >= 4 ? 50 : 100))));
@@ -4558,10 +4813,15 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
             LogPrintf("VerifyDB(): block verification stopping at height %d (pruning, no data)\n", pindex->nHeight);
             break;
         }
-        CBlock block;
-        // check level 0: read from disk
-        if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
+        while (pindex_ahead && pindex_ahead->pprev && pindex_ahead->nHeight > ::ChainActive().Height() - nCheckDepth &&
+               !(fPruneMode && !(pindex_ahead->nStatus & BLOCK_HAVE_DATA)) && prefetcher.Prefetch(pindex_ahead)) {
+            pindex_ahead = pindex_ahead->pprev;
+        }
+        // check level 0: read from disk, re-checking proof of work and hash
+        std::shared_ptr<const CBlock> pblock = prefetcher.Get(pindex);
+        if (!pblock)
             return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
+        const CBlock& block = *pblock;
         // check level 1: verify block validity
         if (nCheckLevel >= 1 && !CheckBlock(block, state, chainparams.GetConsensus()))
             return error("%s: *** found bad block at %d, hash=%s (%s)\n", __func__,
@@ -4933,6 +5193,58 @@ bool LoadGenesisBlock(const CChainParams& chainparams)
     return ::ChainstateActive().LoadGenesisBlock(chainparams);
 }
 
+/** A block located in a block file during -reindex, decoded on a header-hashing thread */
+struct ReindexBlock {
+    //! Position of the serialized block in the file
+    uint64_t nBlockPos;
+    //! Where to resume scanning if the block turns out not to decode
+    uint64_t nRewind;
+    //! Serialized block as recorded in the file; released once decoded
+    std::vector<unsigned char> raw;
+    unsigned int nSize;
+    //! Decoded block and its hash; null if deserialization failed
+    std::shared_ptr<CBlock> pblock;
+    uint256 hash;
+    //! Bytes of the record the block actually used
+    size_t nUsed{0};
+    std::string strError;
+};
+
+//! Upper bound on the number of blocks -reindex locates ahead of acceptance
+static const size_t REINDEX_BATCH_BLOCKS = 64;
+//! How far back the block file reader can always seek during -reindex
+static const uint64_t REINDEX_REWIND_LIMIT = MAX_BLOCK_SERIALIZED_SIZE + 8;
+
+/**
+ * Deserialize, hash and run the context-free checks (including proof of
+ * work) of a batch of blocks in parallel. Passing blocks are marked fChecked,
+ * so AcceptBlock does not repeat the work under cs_main.
+ */
+static void DecodeReindexBlocks(std::vector<ReindexBlock>& batch, const Consensus::Params& consensusParams)
+{
+    std::vector<CHashCheck> vChecks;
+    vChecks.reserve(batch.size());
+    for (ReindexBlock& item : batch) {
+        vChecks.emplace_back([&item, &consensusParams] {
+            try {
+                VectorReader reader(SER_DISK, CLIENT_VERSION, item.raw, 0);
+                auto pblock = std::make_shared<CBlock>();
+                reader >> *pblock;
+                item.nUsed = item.raw.size() - reader.size();
+                item.hash = pblock->GetHash();
+                BlockValidationState state;
+                CheckBlock(*pblock, state, consensusParams);
+                item.pblock = std::move(pblock);
+            } catch (const std::exception& e) {
+                item.strError = e.what();
+            }
+            item.raw.clear();
+            item.raw.shrink_to_fit();
+        });
+    }
+    RunHashChecks(vChecks);
+}
+
 void LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, FlatFilePos* dbp)
 {
     // Map of disk positions for blocks with unknown parent (only used for reindex)
@@ -4942,109 +5254,161 @@ void LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, FlatFi
     int nLoaded = 0;
     try {
         // This takes over fileIn and calls fclose() on it in the CBufferedFile destructor
-        CBufferedFile blkdat(fileIn, 2*MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE+8, SER_DISK, CLIENT_VERSION);
+        CBufferedFile blkdat(fileIn, 2*MAX_BLOCK_SERIALIZED_SIZE, REINDEX_REWIND_LIMIT, SER_DISK, CLIENT_VERSION);
         uint64_t nRewind = blkdat.GetPos();
-        while (!blkdat.eof()) {
+        bool fScanDone = false;
+        while (!fScanDone && !blkdat.eof()) {
             if (ShutdownRequested()) return;
 
-            blkdat.SetPos(nRewind);
-            nRewind++; // start one byte further next time, in case of failure
-            blkdat.SetLimit(); // remove former limit
-            unsigned int nSize = 0;
-            try {
-                // locate a header
-                unsigned char buf[CMessageHeader::MESSAGE_START_SIZE];
-                blkdat.FindByte(chainparams.MessageStart()[0]);
-                nRewind = blkdat.GetPos()+1;
-                blkdat >> buf;
-                if (memcmp(buf, chainparams.MessageStart(), CMessageHeader::MESSAGE_START_SIZE))
-                    continue;
-                // read size
-                blkdat >> nSize;
-                if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
-                    continue;
-            } catch (const std::exception&) {
-                // no valid block header found; don't complain
-                break;
-            }
-            try {
-                // read block
-                uint64_t nBlockPos = blkdat.GetPos();
-                if (dbp)
-                    dbp->nPos = nBlockPos;
-                blkdat.SetLimit(nBlockPos + nSize);
-                std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
-                CBlock& block = *pblock;
-                blkdat >> block;
-                nRewind = blkdat.GetPos();
-
-                uint256 hash = block.GetHash();
-                {
-                    LOCK(cs_main);
-                    // detect out of order blocks, and store them for later
-                    if (hash != chainparams.GetConsensus().hashGenesisBlock && !LookupBlockIndex(block.hashPrevBlock)) {
-                        LogPrint(BCLog::REINDEX, "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
-                                block.hashPrevBlock.ToString());
-                        if (dbp)
-                            mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
+            // Locate a batch of blocks on this thread. Batches stay within the
+            // rewind limit of blkdat, so scanning can resume inside the batch.
+            std::vector<ReindexBlock> batch;
+            while (batch.size() < REINDEX_BATCH_BLOCKS && !blkdat.eof()) {
+                if (!blkdat.SetPos(nRewind)) {
+                    // Batches are capped so this cannot happen; if it does, the
+                    // bytes in between are gone from the buffer and are skipped.
+                    LogPrintf("%s: Unable to seek to position %u, resuming at %u\n", __func__, nRewind, blkdat.GetPos());
+                    nRewind = blkdat.GetPos();
+                }
+                nRewind++; // start one byte further next time, in case of failure
+                blkdat.SetLimit(); // remove former limit
+                unsigned int nSize = 0;
+                try {
+                    // locate a header
+                    unsigned char buf[CMessageHeader::MESSAGE_START_SIZE];
+                    blkdat.FindByte(chainparams.MessageStart()[0]);
+                    nRewind = blkdat.GetPos()+1;
+                    blkdat >> buf;
+                    if (memcmp(buf, chainparams.MessageStart(), CMessageHeader::MESSAGE_START_SIZE))
                         continue;
-                    }
+                    // read size
+                    blkdat >> nSize;
+                    if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
+                        continue;
+                } catch (const std::exception&) {
+                    // no valid block header found; don't complain
+                    fScanDone = true;
+                    break;
+                }
+                if (!batch.empty() && blkdat.GetPos() + nSize - batch.front().nRewind > REINDEX_REWIND_LIMIT) {
+                    // Scanning may have to resume anywhere after the first block's
+                    // header, including any bytes skipped in between, so the whole
+                    // span has to stay within reach. Leave this block for the next batch.
+                    nRewind--;
+                    break;
+                }
+                try {
+                    // read block
+                    ReindexBlock item;
+                    item.nBlockPos = blkdat.GetPos();
+                    item.nRewind = nRewind;
+                    item.nSize = nSize;
+                    blkdat.SetLimit(item.nBlockPos + nSize);
+                    item.raw.resize(nSize);
+                    blkdat.read((char*)item.raw.data(), nSize);
+                    nRewind = blkdat.GetPos();
+                    batch.push_back(std::move(item));
+                } catch (const std::exception& e) {
+                    LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+                }
+            }
 
-                    // process in case the block isn't known yet
-                    CBlockIndex* pindex = LookupBlockIndex(hash);
-                    if (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0) {
-                      BlockValidationState state;
-                      if (::ChainstateActive().AcceptBlock(pblock, state, chainparams, nullptr, true, dbp, nullptr)) {
-                          nLoaded++;
-                      }
-                      if (state.IsError()) {
-                          break;
-                      }
-                    } else if (hash != chainparams.GetConsensus().hashGenesisBlock && pindex->nHeight % 1000 == 0) {
-                      LogPrint(BCLog::REINDEX, "Block Import: already had block %s at height %d\n", hash.ToString(), pindex->nHeight);
-                    }
+            // Decode and hash the batch in parallel, then accept in file order
+            DecodeReindexBlocks(batch, chainparams.GetConsensus());
+
+            bool fAbort = false;
+            for (ReindexBlock& item : batch) {
+                if (!item.pblock) {
+                    LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, item.strError);
+                    // rescan from just past this block's header, dropping the rest of the batch
+                    nRewind = item.nRewind;
+                    fScanDone = false;
+                    break;
+                }
+                // a block shorter than its recorded size: resume scanning right after it
+                const bool fResync = item.nUsed < item.nSize;
+                if (fResync) {
+                    nRewind = item.nBlockPos + item.nUsed;
+                    fScanDone = false;
                 }
+                try {
+                    if (dbp)
+                        dbp->nPos = item.nBlockPos;
+                    std::shared_ptr<CBlock> pblock = item.pblock;
+                    const CBlock& block = *pblock;
+                    const uint256& hash = item.hash;
+                    {
+                        LOCK(cs_main);
+                        // detect out of order blocks, and store them for later
+                        if (hash != chainparams.GetConsensus().hashGenesisBlock && !LookupBlockIndex(block.hashPrevBlock)) {
+                            LogPrint(BCLog::REINDEX, "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
+                                    block.hashPrevBlock.ToString());
+                            if (dbp)
+                                mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
+                            if (fResync) break;
+                            continue;
+                        }
 
-                // Activate the genesis block so normal node progress can continue
-                if (hash == chainparams.GetConsensus().hashGenesisBlock) {
-                    BlockValidationState state;
-                    if (!ActivateBestChain(state, chainparams, nullptr)) {
-                        break;
+                        // process in case the block isn't known yet
+                        CBlockIndex* pindex = LookupBlockIndex(hash);
+                        if (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0) {
+                          BlockValidationState state;
+                          if (::ChainstateActive().AcceptBlock(pblock, state, chainparams, nullptr, true, dbp, nullptr, &hash)) {
+                              nLoaded++;
+                          }
+                          if (state.IsError()) {
+                              fAbort = true;
+                              break;
+                          }
+                        } else if (hash != chainparams.GetConsensus().hashGenesisBlock && pindex->nHeight % 1000 == 0) {
+                          LogPrint(BCLog::REINDEX, "Block Import: already had block %s at height %d\n", hash.ToString(), pindex->nHeight);
+                        }
                     }
-                }
 
-                NotifyHeaderTip();
-
-                // Recursively process earlier encountered successors of this block
-                std::deque<uint256> queue;
-                queue.push_back(hash);
-                while (!queue.empty()) {
-                    uint256 head = queue.front();
-                    queue.pop_front();
-                    std::pair<std::multimap<uint256, FlatFilePos>::iterator, std::multimap<uint256, FlatFilePos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
-                    while (range.first != range.second) {
-                        std::multimap<uint256, FlatFilePos>::iterator it = range.first;
-                        std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
-                        if (ReadBlockFromDisk(*pblockrecursive, it->second, chainparams.GetConsensus()))
-                        {
-                            LogPrint(BCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
-                                    head.ToString());
-                            LOCK(cs_main);
-                            BlockValidationState dummy;
-                            if (::ChainstateActive().AcceptBlock(pblockrecursive, dummy, chainparams, nullptr, true, &it->second, nullptr))
+                    // Activate the genesis block so normal node progress can continue
+                    if (hash == chainparams.GetConsensus().hashGenesisBlock) {
+                        BlockValidationState state;
+                        if (!ActivateBestChain(state, chainparams, nullptr)) {
+                            fAbort = true;
+                            break;
+                        }
+                    }
+
+                    NotifyHeaderTip();
+
+                    // Recursively process earlier encountered successors of this block
+                    std::deque<uint256> queue;
+                    queue.push_back(hash);
+                    while (!queue.empty()) {
+                        uint256 head = queue.front();
+                        queue.pop_front();
+                        std::pair<std::multimap<uint256, FlatFilePos>::iterator, std::multimap<uint256, FlatFilePos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
+                        while (range.first != range.second) {
+                            std::multimap<uint256, FlatFilePos>::iterator it = range.first;
+                            std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
+                            if (ReadBlockFromDisk(*pblockrecursive, it->second, chainparams.GetConsensus()))
                             {
-                                nLoaded++;
-                                queue.push_back(pblockrecursive->GetHash());
+                                LogPrint(BCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
+                                        head.ToString());
+                                LOCK(cs_main);
+                                BlockValidationState dummy;
+                                if (::ChainstateActive().AcceptBlock(pblockrecursive, dummy, chainparams, nullptr, true, &it->second, nullptr))
+                                {
+                                    nLoaded++;
+                                    queue.push_back(pblockrecursive->GetHash());
+                                }
                             }
+                            range.first++;
+                            mapBlocksUnknownParent.erase(it);
+                            NotifyHeaderTip();
                         }
-                        range.first++;
-                        mapBlocksUnknownParent.erase(it);
-                        NotifyHeaderTip();
                     }
+                } catch (const std::exception& e) {
+                    LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
                 }
-            } catch (const std::exception& e) {
-                LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+                if (fResync) break;
             }
+            if (fAbort) break;
         }
     } catch (const std::runtime_error& e) {
         AbortNode(std::string("System error: ") + e.what());
@@ -5254,6 +5618,8 @@ bool CChainState::ResizeCoinsCaches(size_t coinstip_size, size_t coinsdb_size)
     size_t old_coinstip_size = m_coinstip_cache_size_bytes;
     m_coinstip_cache_size_bytes = coinstip_size;
     m_coinsdb_cache_size_bytes = coinsdb_size;
+    // Reopening the database must not race a background write.
+    CoinsFlushView().WaitForWrite();
     CoinsDB().ResizeCache(coinsdb_size);
 
     LogPrintf("[%s] resized coinsdb cache to %.1f MiB\n",
@@ -42,3 +42,8 @@ bool CZMQAbstractNotifier::NotifyTransactionRemoval(const CTransaction &/*transa
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyJournalEvent(const JournalEvent &/*event*/)
+{
+    return true;
+}
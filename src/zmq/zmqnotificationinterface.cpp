@@ -8,6 +8,7 @@
 
 #include <zmq.h>
 
+#include <node/eventjournal.h>
 #include <validation.h>
 #include <util/system.h>
 
@@ -37,6 +38,7 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubrawblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
     factories["pubsequence"] = CZMQAbstractNotifier::Create<CZMQPublishSequenceNotifier>;
+    factories["pubjournal"] = CZMQAbstractNotifier::Create<CZMQPublishJournalNotifier>;
 
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
     for (const auto& entry : factories)
@@ -92,6 +94,10 @@ bool CZMQNotificationInterface::Initialize()
         }
     }
 
+    if (g_event_journal) {
+        journal_connection = g_event_journal->EventAppended.connect([this](const JournalEvent& event) { JournalEventAppended(event); });
+    }
+
     return true;
 }
 
@@ -99,6 +105,7 @@ bool CZMQNotificationInterface::Initialize()
 void CZMQNotificationInterface::Shutdown()
 {
     LogPrint(BCLog::ZMQ, "zmq: Shutdown notification interface\n");
+    journal_connection.disconnect();
     if (pcontext)
     {
         for (auto& notifier : notifiers) {
@@ -188,4 +195,11 @@ void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const CB
     });
 }
 
+void CZMQNotificationInterface::JournalEventAppended(const JournalEvent& event)
+{
+    TryForEachAndRemoveFailed(notifiers, [&event](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyJournalEvent(event);
+    });
+}
+
 CZMQNotificationInterface* g_zmq_notification_interface = nullptr;
@@ -6,11 +6,15 @@
 #define BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 
 #include <validationinterface.h>
+
+#include <boost/signals2/connection.hpp>
+
 #include <list>
 #include <memory>
 
 class CBlockIndex;
 class CZMQAbstractNotifier;
+struct JournalEvent;
 
 class CZMQNotificationInterface final : public CValidationInterface
 {
@@ -35,8 +39,12 @@ protected:
 private:
     CZMQNotificationInterface();
 
+    void JournalEventAppended(const JournalEvent& event);
+
     void *pcontext;
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
+    //! Subscription to the event journal, if there is one
+    boost::signals2::scoped_connection journal_connection;
 };
 
 extern CZMQNotificationInterface* g_zmq_notification_interface;
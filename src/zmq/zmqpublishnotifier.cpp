@@ -6,6 +6,7 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <node/eventjournal.h>
 #include <rpc/server.h>
 #include <streams.h>
 #include <util/system.h>
@@ -27,6 +28,7 @@ static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
 static const char *MSG_SEQUENCE  = "sequence";
+static const char *MSG_JOURNAL   = "journal";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -201,21 +203,24 @@ bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawblock %s to %s\n", pindex->GetBlockHash().GetHex(), this->address);
 
-    const Consensus::Params& consensusParams = Params().GetConsensus();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    {
-        LOCK(cs_main);
+    // The block was just written to disk in its network serialization; publish
+    // those bytes unless witness data has to be stripped.
+    std::vector<uint8_t> block_data;
+    if (RPCSerializationFlags() == 0) {
+        if (!ReadRawBlockFromDisk(block_data, pindex, Params().MessageStart())) {
+            zmqError("Can't read block from disk");
+            return false;
+        }
+    } else {
         CBlock block;
-        if(!ReadBlockFromDisk(block, pindex, consensusParams))
-        {
+        if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
             zmqError("Can't read block from disk");
             return false;
         }
-
-        ss << block;
+        CVectorWriter(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags(), block_data, 0) << block;
     }
 
-    return SendZmqMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
+    return SendZmqMessage(MSG_RAWBLOCK, block_data.data(), block_data.size());
 }
 
 bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
@@ -274,3 +279,13 @@ bool CZMQPublishSequenceNotifier::NotifyTransactionRemoval(const CTransaction &t
     WriteLE64(data+sizeof(uint256)+1, mempool_sequence);
     return SendZmqMessage(MSG_SEQUENCE, data, sizeof(data));
 }
+
+bool CZMQPublishJournalNotifier::NotifyJournalEvent(const JournalEvent &event)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish journal event %u (%c %s) to %s\n", event.sequence, event.type, event.hash.GetHex(), this->address);
+    // The event as stored in the journal, so a consumer can tell from the
+    // sequence number whether it missed any and fetch those over REST.
+    std::vector<unsigned char> data;
+    CVectorWriter(SER_DISK, CLIENT_VERSION, data, 0) << event;
+    return SendZmqMessage(MSG_JOURNAL, data.data(), data.size());
+}
@@ -61,4 +61,10 @@ public:
     bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence) override;
 };
 
+class CZMQPublishJournalNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyJournalEvent(const JournalEvent &event) override;
+};
+
 #endif // BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+# Copyright (c) 2020 The SINOVATE developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the event journal and the /rest/events endpoint.
+
+- Reject an -eventjournal size below the minimum.
+- Journal block connects and disconnects, and read them back as JSON, binary and hex.
+- Check the request validation of /rest/events.
+- Restart without the journal, reorg and mine, then restart with it and check
+  that the missed disconnects and connects are journaled at startup.
+"""
+
+import http.client
+import json
+import struct
+import urllib.parse
+
+from test_framework.address import ADDRESS_BCRT1_UNSPENDABLE
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+EVENT_SIZE = 8 + 1 + 32 + 8
+JOURNAL_ARGS = ["-rest", "-eventjournal=7"]
+
+
+def parse_events(data):
+    assert_equal(len(data) % EVENT_SIZE, 0)
+    events = []
+    for pos in range(0, len(data), EVENT_SIZE):
+        sequence, type, hash, value = struct.unpack("<Qc32sQ", data[pos:pos + EVENT_SIZE])
+        events.append((sequence, type.decode(), hash[::-1].hex(), value))
+    return events
+
+
+class EventJournalTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 1
+        self.extra_args = [JOURNAL_ARGS]
+
+    def get_events(self, uri, status=200):
+        url = urllib.parse.urlparse(self.nodes[0].url)
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        conn.request('GET', '/rest/events/' + uri)
+        resp = conn.getresponse()
+        assert_equal(resp.status, status)
+        body = resp.read()
+        if status != 200:
+            return body.decode()
+        if uri.endswith('.json'):
+            return json.loads(body.decode())
+        if uri.endswith('.hex'):
+            return bytes.fromhex(body.decode().strip())
+        return body
+
+    def wait_for_events(self, next_sequence):
+        """Events are readable once synced, which happens in the background."""
+        self.wait_until(lambda: self.get_events("1/0.json")['next'] == next_sequence)
+
+    def check_block_events(self, events, expected):
+        assert_equal([(e['type'], e['hash'], e['height']) for e in events], expected)
+
+    def run_test(self):
+        node = self.nodes[0]
+        address = node.get_deterministic_priv_key().address
+
+        self.log.info("Reject a journal smaller than two segments")
+        self.stop_node(0)
+        node.assert_start_raises_init_error(["-eventjournal=6"], "Error: Event journal configured below the minimum of 7 MiB.  Please use a higher number.")
+        self.start_node(0, JOURNAL_ARGS)
+
+        self.log.info("Journal connected and disconnected blocks")
+        hashes = node.generatetoaddress(3, address)
+        node.invalidateblock(hashes[-1])
+        # The first event is the genesis block, connected at the first startup.
+        self.wait_for_events(5)
+        result = self.get_events("10/0.json")
+        assert_equal(result['oldest'], 0)
+        assert_equal(result['next'], 5)
+        assert_equal([e['sequence'] for e in result['events']], [0, 1, 2, 3, 4])
+        self.check_block_events(result['events'], [
+            ('blockconnect', node.getblockhash(0), 0),
+            ('blockconnect', hashes[0], 1),
+            ('blockconnect', hashes[1], 2),
+            ('blockconnect', hashes[2], 3),
+            ('blockdisconnect', hashes[2], 3),
+        ])
+
+        self.log.info("Read events in binary and hex")
+        events = parse_events(self.get_events("2/2.bin"))
+        assert_equal(events, [(2, 'C', hashes[1], 2), (3, 'C', hashes[2], 3)])
+        assert_equal(self.get_events("2/2.hex"), self.get_events("2/2.bin"))
+        assert_equal(self.get_events("10/5.json")['events'], [])
+
+        self.log.info("Check request validation")
+        assert "No event count specified" in self.get_events("10.json", status=400)
+        assert "Event count out of range" in self.get_events("0/0.json", status=400)
+        assert "Event count out of range" in self.get_events("10001/0.json", status=400)
+        assert "Invalid sequence number" in self.get_events("10/-1.json", status=400)
+        assert "Invalid sequence number" in self.get_events("10/x.json", status=400)
+
+        self.log.info("Journal the blocks missed while the journal was off at startup")
+        self.restart_node(0, ["-rest"])
+        assert "Event journal is disabled" in self.get_events("10/0.json", status=404)
+        node.reconsiderblock(hashes[-1])
+        node.invalidateblock(hashes[1])
+        new_hashes = node.generatetoaddress(2, ADDRESS_BCRT1_UNSPENDABLE)
+        self.restart_node(0, JOURNAL_ARGS)
+        self.wait_for_events(8)
+        result = self.get_events("10/5.json")
+        assert_equal(result['next'], 8)
+        self.check_block_events(result['events'], [
+            ('blockdisconnect', hashes[1], 2),
+            ('blockconnect', new_hashes[0], 2),
+            ('blockconnect', new_hashes[1], 3),
+        ])
+
+        self.log.info("Resume sequence numbers across restarts")
+        self.restart_node(0, JOURNAL_ARGS)
+        tip = node.generatetoaddress(1, address)[0]
+        self.wait_for_events(9)
+        result = self.get_events("10/8.json")
+        assert_equal(result['oldest'], 0)
+        assert_equal(result['next'], 9)
+        self.check_block_events(result['events'], [('blockconnect', tip, 4)])
+
+
+if __name__ == '__main__':
+    EventJournalTest().main()
@@ -281,6 +281,28 @@ class RESTTest (BitcoinTestFramework):
         json_obj = self.test_rest_request("/headers/5/{}".format(bb_hash))
         assert_equal(len(json_obj), 5)  # now we should have 5 header objects
 
+        # Block summaries are fixed-width records starting at a height
+        height = block_json_obj['height']
+        json_obj = self.test_rest_request("/blocksummaries/5/{}".format(height))
+        assert_equal([s['height'] for s in json_obj], list(range(height, height + 5)))
+        assert_equal(json_obj[0]['hash'], bb_hash)
+        response = self.test_rest_request("/blocksummaries/2000/{}".format(height), req_type=ReqType.BIN, ret_type=RetType.OBJ)
+        assert_equal(int(response.getheader('content-length')), 6 * 156)
+        response_bytes = response.read()
+        assert_equal(response_bytes[:BLOCK_HEADER_SIZE], response_header_bytes)
+        assert_equal(response_bytes[BLOCK_HEADER_SIZE:BLOCK_HEADER_SIZE + 32][::-1].hex(), bb_hash)
+        self.test_rest_request("/blocksummaries/1/{}".format(height + 6), status=404, ret_type=RetType.OBJ)
+        self.test_rest_request("/blocksummaries/50001/0", status=400, ret_type=RetType.OBJ)
+
+        # An unchanged range is answered with 304
+        conn = http.client.HTTPConnection(self.url.hostname, self.url.port)
+        conn.request('GET', '/rest/blocksummaries/5/{}.bin'.format(height), headers={'If-None-Match': response.getheader('etag')})
+        assert_equal(conn.getresponse().status, 200)
+        etag = self.test_rest_request("/blocksummaries/5/{}".format(height), req_type=ReqType.BIN, ret_type=RetType.OBJ).getheader('etag')
+        conn = http.client.HTTPConnection(self.url.hostname, self.url.port)
+        conn.request('GET', '/rest/blocksummaries/5/{}.bin'.format(height), headers={'If-None-Match': etag})
+        assert_equal(conn.getresponse().status, 304)
+
         self.log.info("Test tx inclusion in the /mempool and /block URIs")
 
         # Make 3 tx and mine them on node 1
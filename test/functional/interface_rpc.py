@@ -35,6 +35,27 @@ class RPCInterfaceTest(BitcoinTestFramework):
         assert_greater_than_or_equal(command['duration'], 0)
         assert_equal(info['logpath'], os.path.join(self.nodes[0].datadir, self.chain, 'debug.log'))
 
+        # One queue per priority, most urgent first. The default four RPC
+        # threads leave one for high priority work.
+        queues = info['work_queues']
+        assert_equal([q['priority'] for q in queues], ['high', 'normal', 'low'])
+        assert_equal([q['max_threads'] for q in queues], [4, 3, 2])
+        for q in queues:
+            assert_equal(q['max_depth'], 16)
+            assert_equal(q['queued'], 0)
+            assert_equal(q['rejected'], 0)
+            assert_equal(len(q['wait_histogram']), 7)
+            assert 'max_wait' not in q['wait_histogram'][-1]
+        # getrpcinfo itself is high priority
+        assert_equal([q['running'] for q in queues], [1, 0, 0])
+        assert_greater_than_or_equal(sum(b['count'] for b in queues[0]['wait_histogram']), 1)
+
+        self.restart_node(0, extra_args=['-rpcworkthreads=low:1', '-rpcmethodpriority=low:getrpcinfo'])
+        queues = self.nodes[0].getrpcinfo()['work_queues']
+        assert_equal([q['max_threads'] for q in queues], [4, 3, 1])
+        assert_equal([q['running'] for q in queues], [0, 0, 1])
+        self.restart_node(0)
+
     def test_batch_request(self):
         self.log.info("Testing basic JSON-RPC batch request...")
 
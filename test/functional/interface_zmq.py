@@ -3,7 +3,9 @@
 # Distributed under the MIT software license, see the accompanying
 # file COPYING or http://www.opensource.org/licenses/mit-license.php.
 """Test the ZMQ notification interface."""
+import http.client
 import struct
+import urllib.parse
 
 from test_framework.address import ADDRESS_BCRT1_UNSPENDABLE, ADDRESS_BCRT1_P2WSH_OP_TRUE
 from test_framework.blocktools import create_block, create_coinbase, add_witness_commitment
@@ -58,6 +60,13 @@ class ZMQSubscriber:
             assert label == "D" or label == "C"
         return (hash, label, mempool_sequence)
 
+    def receive_journal(self):
+        body = self.receive()
+        # The 49 byte event as stored in the event journal.
+        assert_equal(len(body), 8+1+32+8)
+        sequence, label, hash, value = struct.unpack("<Qc32sQ", body)
+        return (sequence, label.decode(), hash[::-1].hex(), value, body)
+
 
 class ZMQTest (BitcoinTestFramework):
     def set_test_params(self):
@@ -75,6 +84,7 @@ class ZMQTest (BitcoinTestFramework):
             self.test_mempool_sync()
             self.test_reorg()
             self.test_multiple_interfaces()
+            self.test_journal()
         finally:
             # Destroy the ZMQ context.
             self.log.debug("Destroying ZMQ context")
@@ -529,5 +539,50 @@ class ZMQTest (BitcoinTestFramework):
         assert_equal(self.nodes[0].getbestblockhash(), subscribers[0]['hashblock'].receive().hex())
         assert_equal(self.nodes[0].getbestblockhash(), subscribers[1]['hashblock'].receive().hex())
 
+    def test_journal(self):
+        self.log.info("Testing the journal notification")
+        address = 'tcp://127.0.0.1:28336'
+        socket = self.ctx.socket(zmq.SUB)
+        socket.set(zmq.RCVTIMEO, 60000)
+        journal = ZMQSubscriber(socket, b"journal")
+
+        self.restart_node(0, ["-rest", "-eventjournal=7", "-zmqpubjournal=%s" % address])
+        socket.connect(address)
+        # Relax so that the subscriber is ready before publishing zmq messages
+        sleep(0.2)
+
+        # Events carry on from those journaled before the subscriber connected.
+        height = self.nodes[0].getblockcount()
+        hashes = self.nodes[0].generatetoaddress(2, ADDRESS_BCRT1_UNSPENDABLE)
+        self.nodes[0].invalidateblock(hashes[1])
+        # Mempool events, e.g. from loading the mempool, may be interleaved.
+        events = []
+        while len([event for event in events if event[1] in "CD"]) < 3:
+            events.append(journal.receive_journal())
+        assert_equal([event[0] for event in events], list(range(events[0][0], events[0][0] + len(events))))
+        assert_equal([event[1:4] for event in events if event[1] in "CD"], [
+            ("C", hashes[0], height + 1),
+            ("C", hashes[1], height + 2),
+            ("D", hashes[1], height + 2),
+        ])
+
+        # The same events can be fetched over REST from their sequence number.
+        url = urllib.parse.urlparse(self.nodes[0].url)
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        conn.request('GET', '/rest/events/%d/%d.bin' % (len(events), events[0][0]))
+        resp = conn.getresponse()
+        assert_equal(resp.status, 200)
+        assert_equal(resp.read(), b"".join(event[4] for event in events))
+
+        self.nodes[0].reconsiderblock(hashes[1])
+        event = journal.receive_journal()
+        while event[1] not in "CD":
+            event = journal.receive_journal()
+        assert_equal(event[1:4], ("C", hashes[1], height + 2))
+
+        assert_equal(self.nodes[0].getzmqnotifications(), [
+            {"type": "pubjournal", "address": address, "hwm": 1000},
+        ])
+
 if __name__ == '__main__':
     ZMQTest().main()
@@ -275,6 +275,7 @@ BASE_SCRIPTS = [
     'p2p_node_network_limited.py',
     'p2p_permissions.py',
     'feature_blocksdir.py',
+    'feature_eventjournal.py',
     'wallet_startup.py',
     'feature_config_args.py',
     'feature_settings.py',